@@ -0,0 +1,16 @@
+// Dispatch benchmark: tight arithmetic loop over locals.
+// Nearly every instruction is cheap, so run time is dominated by dispatch.
+func work(n) {
+    var sum = 0
+    var i = 0
+    while i < n {
+        sum = sum + i - 3
+        if sum > 1000000 {
+            sum = sum - 1000000
+        }
+        i = i + 1
+    }
+    return sum
+}
+
+print(work(5000000))
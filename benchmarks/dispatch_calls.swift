@@ -0,0 +1,9 @@
+// Dispatch benchmark: call-heavy recursion (OP_CALL / OP_RETURN / comparisons).
+func fib(n) {
+    if n < 2 {
+        return n
+    }
+    return fib(n - 1) + fib(n - 2)
+}
+
+print(fib(30))
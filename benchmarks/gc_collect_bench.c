@@ -0,0 +1,190 @@
+/*
+ * Full-collection time against heap size.
+ *
+ * For each size N, builds a chain of N objects reachable from a global and
+ * times gc_collect() with everything live (mark-dominated), then drops the
+ * global and times the collection that frees the whole chain
+ * (sweep-dominated). Automatic collection is disabled while building so
+ * only the explicit collections are measured.
+ *
+ * A second table allocates a stream of short-lived objects next to a
+ * long-lived set, with and without the generational nursery, and reports the
+ * time spent in the collector.
+ *
+ * Another table frees an old generation of N dead objects, once with an
+ * explicit gc_collect() (swept inside the pause) and once from a collection
+ * triggered by allocation (swept lazily by the allocations after it).
+ *
+ * The last table times the live collection of a wide object graph with
+ * 1, 2, 4 and 8 marking threads.
+ *
+ * Usage: gc_collect_bench [N...]   (default: 10000 100000 1000000)
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "runtime/core/vm.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/object.h"
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void bench(size_t count) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_threshold(vm.gc, SIZE_MAX);
+
+    Object* head = object_create();
+    define_global(&vm, "head", OBJECT_VAL(head));
+    Object* tail = head;
+    for (size_t i = 1; i < count; i++) {
+        Object* next = object_create();
+        object_set_property(next, "value", NUMBER_VAL((double)i));
+        object_set_property(tail, "next", OBJECT_VAL(next));
+        tail = next;
+    }
+
+    double start = now_ms();
+    gc_collect(vm.gc);
+    double live_ms = now_ms() - start;
+
+    undefine_global(&vm, "head");
+    start = now_ms();
+    gc_collect(vm.gc);
+    double dead_ms = now_ms() - start;
+
+    GCStats stats = gc_get_stats(vm.gc);
+    printf("%10zu %14.2f %14.2f %12zu\n", count, live_ms, dead_ms, stats.objects_freed);
+
+    vm_free(&vm);
+}
+
+// Allocate `count` temporaries while 100k objects stay reachable
+static void bench_churn(size_t count, bool generational) {
+    VM vm;
+    vm_init(&vm);
+    vm.gc->config.generational = generational;
+
+    Object* live = array_create();
+    define_global(&vm, "live", OBJECT_VAL(live));
+    for (size_t i = 0; i < 100000; i++) {
+        array_push(live, OBJECT_VAL(object_create()));
+    }
+
+    GCStats before = gc_get_stats(vm.gc);
+    double start = now_ms();
+    for (size_t i = 0; i < count; i++) {
+        Object* temp = object_create();
+        object_set_property(temp, "value", NUMBER_VAL((double)i));
+        // Every 64th temporary replaces a live entry, so old objects keep
+        // getting young references
+        if (i % 64 == 0) {
+            array_set(live, i / 64 % 100000, OBJECT_VAL(temp));
+        }
+    }
+    double total_ms = now_ms() - start;
+    GCStats after = gc_get_stats(vm.gc);
+
+    printf("%10zu %14s %12.2f %12.2f %8zu %8zu\n", count, generational ? "generational" : "full only",
+           total_ms, after.total_gc_time - before.total_gc_time,
+           after.collections - before.collections,
+           after.minor_collections - before.minor_collections);
+
+    vm_free(&vm);
+}
+
+// Pause for freeing `count` dead old objects, eagerly or lazily
+static void bench_sweep(size_t count, bool lazy) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_threshold(vm.gc, SIZE_MAX);
+
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    for (size_t i = 0; i < count; i++) {
+        array_push(holder, OBJECT_VAL(object_create()));
+    }
+    gc_collect_minor(vm.gc);
+    undefine_global(&vm, "holder");
+
+    GCStats before = gc_get_stats(vm.gc);
+    if (lazy) {
+        gc_set_threshold(vm.gc, 0);
+        object_create();
+        while (vm.gc->phase == GC_PHASE_SWEEP) {
+            object_create();
+        }
+    } else {
+        gc_collect(vm.gc);
+    }
+    GCStats after = gc_get_stats(vm.gc);
+
+    printf("%10zu %8s %12.2f %12.2f %12zu\n", count, lazy ? "lazy" : "eager", after.last_gc_time,
+           after.total_sweep_time - before.total_sweep_time, after.lazy_sweep_steps - before.lazy_sweep_steps);
+    vm_free(&vm);
+}
+
+// Mark 1000 arrays of `count / 1000` objects with `threads` markers
+static void bench_parallel(size_t count, uint32_t threads) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_threshold(vm.gc, SIZE_MAX);
+    gc_set_mark_threads(vm.gc, threads);
+
+    Object* root = array_create();
+    define_global(&vm, "root", OBJECT_VAL(root));
+    for (size_t i = 0; i < 1000; i++) {
+        Object* row = array_create();
+        array_push(root, OBJECT_VAL(row));
+        for (size_t j = 0; j < count / 1000; j++) {
+            Object* obj = object_create();
+            object_set_property(obj, "value", NUMBER_VAL((double)j));
+            array_push(row, OBJECT_VAL(obj));
+        }
+    }
+
+    // The first collection promotes the nursery; time the second
+    gc_collect(vm.gc);
+    double start = now_ms();
+    gc_collect(vm.gc);
+    double live_ms = now_ms() - start;
+
+    printf("%10zu %8u %12.2f\n", count, threads, live_ms);
+    vm_free(&vm);
+}
+
+int main(int argc, char** argv) {
+    static const size_t default_sizes[] = {10000, 100000, 1000000};
+
+    printf("%10s %14s %14s %12s\n", "objects", "live (ms)", "dead (ms)", "freed");
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            bench((size_t)strtoull(argv[i], NULL, 10));
+        }
+    } else {
+        for (size_t i = 0; i < sizeof(default_sizes) / sizeof(default_sizes[0]); i++) {
+            bench(default_sizes[i]);
+        }
+    }
+
+    printf("\n%10s %14s %12s %12s %8s %8s\n", "allocated", "mode", "total (ms)", "gc (ms)", "full", "minor");
+    bench_churn(1000000, false);
+    bench_churn(1000000, true);
+
+    printf("\n%10s %8s %12s %12s %12s\n", "objects", "sweep", "pause (ms)", "sweep (ms)", "lazy steps");
+    bench_sweep(1000000, false);
+    bench_sweep(1000000, true);
+
+    printf("\n%10s %8s %12s\n", "objects", "threads", "live (ms)");
+    for (uint32_t threads = 1; threads <= 8; threads *= 2) {
+        bench_parallel(1000000, threads);
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#!/bin/bash
+
+# Compare threaded (computed goto) and switch dispatch in the VM loop.
+#
+# Builds two Release trees that differ only in SLANG_COMPUTED_GOTO, runs every
+# benchmarks/dispatch_*.swift script in both, and reports the best of N runs.
+#
+# Usage: benchmarks/run_dispatch_bench.sh [runs]
+#   CMAKE_ARGS="..."   extra arguments passed to both cmake configure steps
+
+set -e
+
+ROOT="$(cd "$(dirname "$0")/.." && pwd)"
+RUNS="${1:-5}"
+THREADED_DIR="$ROOT/build-bench-threaded"
+SWITCH_DIR="$ROOT/build-bench-switch"
+
+build() {
+    local dir="$1"
+    local goto="$2"
+    cmake -S "$ROOT" -B "$dir" -DCMAKE_BUILD_TYPE=Release -DSLANG_COMPUTED_GOTO="$goto" $CMAKE_ARGS > /dev/null
+    cmake --build "$dir" --target swift_like_lang -j"$(nproc 2>/dev/null || echo 4)" > /dev/null
+}
+
+# Best wall-clock time in seconds over $RUNS runs
+best_time() {
+    local bin="$1"
+    local script="$2"
+    local best=""
+    for _ in $(seq "$RUNS"); do
+        local start end elapsed
+        start=$(date +%s.%N)
+        "$bin" run "$script" > /dev/null 2>&1
+        end=$(date +%s.%N)
+        elapsed=$(awk -v s="$start" -v e="$end" 'BEGIN { printf "%.4f", e - s }')
+        if [ -z "$best" ] || awk -v a="$elapsed" -v b="$best" 'BEGIN { exit !(a < b) }'; then
+            best="$elapsed"
+        fi
+    done
+    echo "$best"
+}
+
+echo "Building threaded dispatch..."
+build "$THREADED_DIR" ON
+echo "Building switch dispatch..."
+build "$SWITCH_DIR" OFF
+
+echo
+printf "%-28s %12s %12s %10s\n" "benchmark" "switch (s)" "threaded (s)" "speedup"
+for script in "$ROOT"/benchmarks/dispatch_*.swift; do
+    name="$(basename "$script" .swift)"
+    t_switch=$(best_time "$SWITCH_DIR/swift_like_lang" "$script")
+    t_threaded=$(best_time "$THREADED_DIR/swift_like_lang" "$script")
+    speedup=$(awk -v s="$t_switch" -v t="$t_threaded" 'BEGIN { printf "%.1f", (s - t) * 100 / s }')
+    printf "%-28s %12.3f %12.3f %9s%%\n" "$name" "$t_switch" "$t_threaded" "$speedup"
+done
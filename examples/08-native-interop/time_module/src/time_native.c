@@ -18,7 +18,7 @@ static TaggedValue native_time_now(int arg_count, TaggedValue* args) {
 // Native function to format timestamp
 static TaggedValue native_time_format(int arg_count, TaggedValue* args) {
     if (arg_count < 1 || !IS_NUMBER(args[0])) {
-        return STRING_VAL(strdup("Invalid timestamp"));
+        return STRING_VAL(string_copy("Invalid timestamp"));
     }
     
     time_t timestamp = (time_t)AS_NUMBER(args[0]);
@@ -27,7 +27,7 @@ static TaggedValue native_time_format(int arg_count, TaggedValue* args) {
     struct tm* timeinfo = localtime(&timestamp);
     strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", timeinfo);
     
-    return STRING_VAL(strdup(buffer));
+    return STRING_VAL(string_copy(buffer));
 }
 
 // Native function to get milliseconds
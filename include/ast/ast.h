@@ -360,6 +360,7 @@ typedef struct {
 
 struct Stmt {
     StmtType type;
+    int line;  // Source line the statement starts on; 0 if unknown
     union {
         ExpressionStmt expression;
         VarDeclStmt var_decl;
@@ -0,0 +1,25 @@
+#ifndef STACK_DEPTH_H
+#define STACK_DEPTH_H
+
+#include <stddef.h>
+#include "runtime/core/vm.h"
+
+/**
+ * Post-compile pass finding how deep each chunk's code can take the value
+ * stack, so that entering a frame can make room for all of it at once and
+ * no push has to check. Every path through the code is followed, with the
+ * depth each instruction leaves; branches that meet always agree on it in
+ * code the compiler emits.
+ *
+ * Run it before chunk_fuse_superinstructions(): only the plain forms of the
+ * jumps are followed.
+ */
+
+// Most values the code of `chunk` has on the stack at once, above the
+// arguments it is called with; 0 if the code cannot be decoded
+size_t chunk_max_stack(const Chunk* chunk);
+
+// Set max_stack of `chunk` and of every function in its constant table
+void chunk_measure_stack(Chunk* chunk);
+
+#endif // STACK_DEPTH_H
@@ -0,0 +1,23 @@
+#ifndef SUPERINSTRUCTIONS_H
+#define SUPERINSTRUCTIONS_H
+
+#include <stddef.h>
+#include "runtime/core/vm.h"
+
+/**
+ * Post-compile pass fusing frequent instruction sequences into single
+ * superinstructions (OP_GET_LOCAL_PAIR and friends).
+ *
+ * Fusion is done in place: only the first opcode byte of a sequence is
+ * rewritten and the fused handler skips the rest, so code size, jump
+ * offsets, line info and inline cache offsets are unchanged and a jump into
+ * the middle of a sequence still lands on the original instructions.
+ */
+
+// Fuse sequences in `chunk` and in every function in its constant table
+void chunk_fuse_superinstructions(Chunk* chunk);
+
+// Size in bytes of the instruction at `offset`, or 0 if it cannot be decoded
+size_t chunk_instruction_length(const Chunk* chunk, size_t offset);
+
+#endif // SUPERINSTRUCTIONS_H
@@ -10,6 +10,9 @@
 void disassemble_chunk(Chunk* chunk, const char* name);
 int disassemble_instruction(Chunk* chunk, int offset);
 
+// Property instructions that have run, with their inline cache counters
+void disassemble_inline_caches(Chunk* chunk, const char* name);
+
 // Debug flags
 typedef struct {
     bool print_tokens;
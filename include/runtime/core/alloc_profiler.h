@@ -0,0 +1,42 @@
+#ifndef ALLOC_PROFILER_H
+#define ALLOC_PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef struct VM VM;
+
+/**
+ * Sampling profiler for where a running program allocates.
+ *
+ * While it runs, the objects and strings allocators report to it, and so
+ * does the collector for the nursery allocations it carves out itself.
+ * About once every `sample_bytes` allocated bytes (at random, so that no
+ * allocation pattern hides from it) the VM's call stack is recorded: each
+ * frame as its function and the source line of the instruction it is on.
+ * A sample stands for all the bytes allocated since the previous one, so
+ * per-stack totals estimate how much each call path allocates. With
+ * `sample_bytes` 0 every allocation is recorded and the totals are exact.
+ */
+typedef struct AllocProfiler AllocProfiler;
+
+// Start profiling `vm`'s allocations. Frames in functions that belong to no
+// module are attributed to `script_path`. Returns NULL if memory runs out.
+AllocProfiler* alloc_profiler_create(VM* vm, size_t sample_bytes, const char* script_path);
+// Stop recording; the samples stay until the profiler is destroyed
+void alloc_profiler_stop(AllocProfiler* profiler);
+void alloc_profiler_destroy(AllocProfiler* profiler);
+
+// Count an allocation of `size` bytes made by the VM's current instruction
+void alloc_profiler_record(AllocProfiler* profiler, size_t size, const char* tag);
+
+// Brendan Gregg's folded stacks, one "root;...;leaf bytes" line per stack,
+// for flamegraph.pl and most flame graph viewers. Both return false on
+// write errors.
+bool alloc_profiler_write_folded(AllocProfiler* profiler, FILE* out);
+// pprof's profile.proto, uncompressed, with alloc_objects and alloc_space
+// sample values; readable by `go tool pprof`
+bool alloc_profiler_write_pprof(AllocProfiler* profiler, FILE* out);
+
+#endif // ALLOC_PROFILER_H
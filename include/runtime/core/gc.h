@@ -5,14 +5,27 @@
 #include "runtime/core/vm.h"
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
 
 // GC colors for tri-color marking
 typedef enum {
     GC_WHITE = 0,  // Unvisited/garbage (candidate for collection)
     GC_GRAY  = 1,  // Visited but children not yet visited
-    GC_BLACK = 2   // Visited and all children visited
+    GC_BLACK = 2,  // Visited and all children visited
+    GC_FREE  = 3   // Freed; its bytes in a nursery block can be reused
 } GCColor;
 
+// Pause times in microseconds, bucketed log-linearly: exact below 16us,
+// then eight buckets per power of two, so percentiles are within 12.5%
+#define GC_PAUSE_BUCKETS (16 + 28 * 8)
+
+typedef struct {
+    uint32_t counts[GC_PAUSE_BUCKETS];
+    size_t count;
+    uint64_t max_us;
+} GCPauseHistogram;
+
 // GC statistics
 typedef struct {
     size_t total_allocated;
@@ -21,10 +34,50 @@ typedef struct {
     size_t peak_allocated;
     size_t collections;
     size_t objects_freed;
+    size_t minor_collections;     // Nursery-only collections (not in `collections`)
+    size_t objects_promoted;      // Nursery survivors moved to the old generation
+    size_t bytes_promoted;
+    size_t incremental_steps;     // Slices of incremental collection work
+    size_t objects_swept;         // Old-generation objects visited by full-collection sweeps
+    size_t lazy_sweep_steps;      // Sweep increments paid for by allocations
+    size_t blocks_recycled;       // Fragmented blocks whose holes were reopened for allocation
+    size_t bytes_released;        // Empty blocks handed back to the system
+    size_t emergency_collections; // Full collections forced by the heap limit
+    size_t heap_limit_exceeded;   // Times the heap stayed over the limit after one
+    size_t strings_freed;         // Interned strings swept from the VM's string pool
+    size_t string_bytes_freed;
     double total_gc_time;
     double last_gc_time;
+    double max_pause_time;        // Longest single collection or incremental step
+    double total_sweep_time;      // Time sweeping the old generation, in or out of pauses
+    GCPauseHistogram minor_pauses;
+    GCPauseHistogram full_pauses; // Stop-the-world full collections and incremental steps
 } GCStats;
 
+typedef enum {
+    GC_EVENT_MINOR,
+    GC_EVENT_FULL,
+    GC_EVENT_INCREMENTAL
+} GCEventKind;
+
+// One collection cycle, reported once it is over. A full cycle ends when
+// its sweep does, which may be well after its last pause.
+typedef struct {
+    GCEventKind kind;
+    size_t cycle;                 // Number among collections of its kind (minor or not)
+    uint64_t start_us;            // Since the collector was created
+    uint64_t duration_us;         // Wall time from start to end
+    uint64_t pause_us;            // Of that, time the program was stopped
+    size_t pauses;
+    size_t heap_before;           // bytes_allocated at the start
+    size_t heap_after;            // ... and at the end
+    size_t bytes_promoted;
+    size_t bytes_freed;
+    size_t objects_freed;
+} GCEvent;
+
+typedef void (*GCEventCallback)(const GCEvent* event, void* user_data);
+
 // GC configuration
 typedef struct {
     size_t heap_grow_factor;      // How much to grow heap (default 2)
@@ -32,9 +85,14 @@ typedef struct {
     size_t max_heap_size;         // Maximum heap size (0 = unlimited)
     size_t gc_threshold;          // Bytes allocated before triggering GC
     bool incremental;             // Enable incremental GC
-    size_t incremental_step_size; // Work done per incremental step
+    uint32_t max_pause_us;        // Time budget of one incremental step, in microseconds
     bool stress_test;             // Force GC on every allocation
     bool verbose;                 // Print GC debug info
+    bool generational;            // Allocate into a nursery with minor collections
+    size_t nursery_size;          // Bytes allocated between minor collections
+    uint32_t mark_threads;        // Threads marking during full collections (0 or 1 = serial)
+    double fragmentation_threshold; // Free share of held blocks that starts recycling (0 = never)
+    uint32_t target_pause_us;     // Pause goal that sizes the nursery, in microseconds (0 = fixed sizes)
 } GCConfig;
 
 // GC phase for incremental collection
@@ -45,19 +103,62 @@ typedef enum {
     GC_PHASE_SWEEP
 } GCPhase;
 
-// Forward declaration
+// Generation of an allocation. New objects start young when the collector
+// is generational; survivors of a minor collection are promoted in place.
+typedef enum {
+    GC_YOUNG = 0,
+    GC_OLD   = 1
+} GCGeneration;
+
+// Forward declarations
 typedef struct GarbageCollector GarbageCollector;
+typedef struct GCBlock GCBlock;
 
-// Object header for GC metadata
+// Object header for GC metadata. gc_alloc() places it directly in front of
+// the payload, so the header of an allocation is found by pointer arithmetic
+// instead of a search.
 typedef struct GCObjectHeader {
     struct GCObjectHeader* next;  // Next in allocation list
     struct GCObjectHeader* prev;  // Previous in allocation list
-    GCColor color;                // Current color
+    GarbageCollector* owner;      // Collector whose list holds this header
+    GCBlock* block;               // Nursery block holding it; NULL if allocated alone
+    size_t size;                  // Size of the payload
+    uint8_t color;                // GCColor
     bool is_pinned;              // Object cannot be collected
-    size_t size;                 // Size of allocation
-    void* object;                // Pointer to actual object
+    bool is_object;              // Allocation is an Object (traced and destroyed)
+    uint8_t generation;          // GCGeneration; selects young_objects or all_objects
+    uint32_t remembered;         // 1 + index in the remembered set, 0 if not in it
 } GCObjectHeader;
 
+// Payloads stay aligned for any type
+#define GC_ALIGNMENT 16
+#define GC_HEADER_SIZE ((sizeof(GCObjectHeader) + GC_ALIGNMENT - 1) & ~(size_t)(GC_ALIGNMENT - 1))
+
+#define GC_HEADER(payload) ((GCObjectHeader*)((char*)(payload) - GC_HEADER_SIZE))
+#define GC_PAYLOAD(header) ((void*)((char*)(header) + GC_HEADER_SIZE))
+
+// Nursery memory is carved from blocks of this size by bumping a pointer.
+// Objects are never moved, so a block goes back to the pool once every
+// allocation in it, promoted or not, has been freed. A block that is mostly
+// free before that is fragmented: once the heap as a whole is, the nursery
+// bump-allocates into its holes instead of taking new blocks.
+#define GC_BLOCK_SIZE (32 * 1024)
+// Tag of block allocations, which hold objects rather than being one
+#define GC_BLOCK_TAG "gc-block"
+// Larger allocations get a block of their own from the system allocator
+#define GC_LARGE_OBJECT_SIZE (GC_BLOCK_SIZE / 8)
+
+// Old arrays longer than this are remembered card by card: a minor
+// collection rescans only the runs of GC_CARD_ELEMENTS elements written since
+#define GC_CARD_ELEMENTS 64
+
+// Remembered-set entry: an old object that may reference young ones
+typedef struct {
+    GCObjectHeader* header;
+    uint8_t* cards;               // Dirty element cards; NULL to trace every element
+    size_t card_count;
+} GCRememberedEntry;
+
 // Gray object stack for marking
 typedef struct GrayStack {
     GCObjectHeader** items;
@@ -68,19 +169,61 @@ typedef struct GrayStack {
 // Garbage collector structure
 struct GarbageCollector {
     // Object tracking
-    GCObjectHeader* all_objects;   // All allocated objects
+    GCObjectHeader* all_objects;   // Old generation (every object when not generational)
+    GCObjectHeader* young_objects; // Nursery allocations since the last collection
     size_t object_count;           // Number of objects
     GrayStack gray_stack;          // Gray objects to process
     
+    // Nursery
+    GCBlock* nursery_block;        // Block being bump-allocated from
+    char* nursery_top;             // Next free byte in nursery_block
+    char* nursery_end;
+    GCBlock* free_blocks;          // Empty blocks kept for reuse
+    size_t free_block_count;
+    GCBlock* recycle_blocks;       // Fragmented blocks to allocate into before new ones
+    size_t block_count;            // Blocks holding allocations, including the nursery's
+    size_t block_live_bytes;       // Bytes of those blocks still allocated
+    size_t young_bytes;            // Bytes allocated young since the last collection
+    
+    // Old objects written with young references since the last collection
+    GCRememberedEntry* remembered;
+    size_t remembered_count;
+    size_t remembered_capacity;
+    Upvalue* remembered_upvalues;  // Closed upvalues holding young references
+    
+    // Roots registered from C, marked along with the VM's
+    TaggedValue** roots;           // gc_add_root() locations
+    size_t root_count;
+    size_t root_capacity;
+    TaggedValue* temp_roots;       // gc_push_temp_root() values, innermost last
+    size_t temp_root_count;
+    size_t temp_root_capacity;
+    
     // Memory tracking
     size_t bytes_allocated;        // Current bytes allocated
-    size_t bytes_allocated_since_gc; // Bytes since last GC
+    size_t bytes_allocated_since_gc; // Old-generation growth since the last full GC
     size_t next_gc_threshold;      // When to trigger next GC
+    size_t next_string_threshold;  // String pool bytes that trigger one; see gc_collect_strings()
     
     // GC state
     GCPhase phase;                 // Current GC phase
     bool is_collecting;            // GC in progress
+    bool is_minor;                 // Current collection only traces the nursery
     GCObjectHeader* sweep_cursor;  // Current position in sweep
+    size_t bytes_since_step;       // Allocated since the last incremental step
+    uint32_t mark_epoch;           // Closures traced in this cycle carry it
+    struct GCMarkPool* mark_pool;  // Parallel markers; NULL when marking serially
+    bool heap_exhausted;           // Over max_heap_size even after collecting; the VM raises it
+    double nursery_survival;       // Survival rate before the nursery last doubled; 0 once judged
+    bool nursery_settled;          // Doubling did not pay off; retried after a full collection
+    
+    // Telemetry
+    uint64_t created_us;           // platform_monotonic_us() at creation
+    GCEvent cycle;                 // Full cycle in progress, filled in as it goes
+    bool cycle_done;               // Its sweep has finished; reported after the pause it is in
+    GCEventCallback event_callback;
+    void* event_user_data;
+    struct AllocProfiler* alloc_profiler; // Sees nursery allocations; NULL when not profiling
     
     // Configuration
     GCConfig config;
@@ -94,39 +237,89 @@ struct GarbageCollector {
 
 // GC creation and destruction
 GarbageCollector* gc_create(VM* vm, const GCConfig* config);
+// Frees every object left, so anything that must outlive the collector's VM
+// has to be handed to another one with gc_adopt() first
 void gc_destroy(GarbageCollector* gc);
+// Move every object of `from`, and the blocks holding them, to `into`, to be
+// collected there once unreachable. A module's VM does this as it is freed:
+// its exports and globals outlive it.
+void gc_adopt(GarbageCollector* into, GarbageCollector* from);
 
-// Object allocation and tracking
+// Object allocation. Allocations tagged "object*" are Objects: they are
+// traced and passed to object_destroy() before being freed.
 void* gc_alloc(GarbageCollector* gc, size_t size, const char* tag);
-void gc_track_object(GarbageCollector* gc, void* object, size_t size);
-void gc_untrack_object(GarbageCollector* gc, void* object);
+// Free a gc_alloc() allocation now instead of at the next collection
+void gc_free(GarbageCollector* gc, void* object);
 
-// Manual GC control
+// Manual GC control. gc_collect() is a full collection; gc_collect_minor()
+// only reclaims the nursery, tracing old objects through the remembered set.
 void gc_collect(GarbageCollector* gc);
+void gc_collect_minor(GarbageCollector* gc);
 bool gc_should_collect(GarbageCollector* gc);
-void gc_incremental_step(GarbageCollector* gc, size_t work_units);
+// Collect because the VM's string pool has grown past next_string_threshold.
+// Strings are not allocated through gc_alloc(), so the VM calls this itself
+// at points where every string it holds is on its stack or in the heap.
+void gc_collect_strings(GarbageCollector* gc);
+// Run incremental collection work for at most config.max_pause_us, starting
+// a cycle if none is in progress. Returns true once the cycle has finished.
+// With config.incremental, gc_alloc() drives this itself.
+bool gc_incremental_step(GarbageCollector* gc);
 
-// Root management
+// Root management. gc_add_root() registers a location whose current value is
+// marked by every collection until gc_remove_root(); temporary roots keep a
+// value alive while C code holds it across allocations, and are popped in
+// reverse order of pushing.
 void gc_add_root(GarbageCollector* gc, TaggedValue* root);
 void gc_remove_root(GarbageCollector* gc, TaggedValue* root);
 void gc_push_temp_root(GarbageCollector* gc, TaggedValue value);
 void gc_pop_temp_root(GarbageCollector* gc);
 
-// Object pinning (prevent collection)
+// Ergonomics. With a pause goal the nursery is doubled when much of it
+// survives, kept that way if that lets more objects die young, and shrunk
+// when minor collections run over the goal; a full collection over it
+// switches to incremental marking.
+// With a heap limit, full collections are paced to finish before the heap
+// gets within an eighth of it, and an allocation that would cross it
+// collects everything first. If that is not enough the allocation still
+// succeeds but heap_exhausted is set for the VM to report.
+void gc_set_target_pause(GarbageCollector* gc, uint32_t target_pause_us);
+void gc_set_max_heap(GarbageCollector* gc, size_t max_heap_size);
+
+// Share of the memory in held nursery blocks that is free, 0.0 to 1.0
+double gc_fragmentation(GarbageCollector* gc);
+
+// Object pinning (prevent collection); `object` must come from gc_alloc()
 void gc_pin_object(GarbageCollector* gc, void* object);
 void gc_unpin_object(GarbageCollector* gc, void* object);
 
-// Write barrier for incremental GC
-void gc_write_barrier(GarbageCollector* gc, void* object, void* value);
+// Write barrier, called after `value` is stored into `object`. It records
+// old-to-young references for minor collections and keeps the incremental
+// marking invariant. gc_object_write() filters out the common cases inline.
+void gc_write_barrier(GarbageCollector* gc, Object* object, TaggedValue value);
+// Same for a store into element `index` of an array
+void gc_element_write_barrier(GarbageCollector* gc, Object* array, size_t index, TaggedValue value);
+// Upvalue counterpart, called after a closed upvalue is written
+void gc_remember_upvalue(GarbageCollector* gc, Upvalue* upvalue);
 
 // Statistics and debugging
 GCStats gc_get_stats(GarbageCollector* gc);
 void gc_print_stats(GarbageCollector* gc);
+// Smallest pause, in microseconds, that `percentile` (0-100) of the
+// histogram's pauses do not exceed; 0 if it is empty
+uint64_t gc_pause_percentile(const GCPauseHistogram* histogram, double percentile);
+// Call `callback` as each collection cycle ends; NULL to stop
+void gc_set_event_callback(GarbageCollector* gc, GCEventCallback callback, void* user_data);
+// JSON Lines output: one object per event, and a summary of the statistics
+void gc_write_event_json(FILE* out, const GCEvent* event);
+void gc_write_stats_json(GarbageCollector* gc, FILE* out);
 void gc_set_verbose(GarbageCollector* gc, bool verbose);
 
 // Configuration
 void gc_set_threshold(GarbageCollector* gc, size_t threshold);
 void gc_set_incremental(GarbageCollector* gc, bool incremental);
+void gc_set_max_pause(GarbageCollector* gc, uint32_t max_pause_us);
+void gc_set_mark_threads(GarbageCollector* gc, uint32_t threads);
+void gc_set_fragmentation_threshold(GarbageCollector* gc, double threshold);
 
 // Helper macros
 #define GC_ALLOC(gc, type, tag) ((type*)gc_alloc(gc, sizeof(type), tag))
@@ -138,4 +331,43 @@ void gc_set_incremental(GarbageCollector* gc, bool incremental);
     gc_write_barrier(gc, obj, value); \
 } while(0)
 
+// Could `value` reference a nursery object? Struct instances are copied by
+// value and may carry young objects in their fields.
+static inline bool gc_value_may_be_young(TaggedValue value) {
+    if (IS_OBJECT(value)) {
+        Object* object = AS_OBJECT(value);
+        return object && object->is_gc_managed && GC_HEADER(object)->generation == GC_YOUNG;
+    }
+    return IS_STRUCT(value);
+}
+
+static inline void gc_object_write(Object* object, TaggedValue value) {
+    if (!object->is_gc_managed) return;
+    GCObjectHeader* header = GC_HEADER(object);
+    GarbageCollector* gc = header->owner;
+    if (gc && (gc->is_collecting ||
+               (header->generation == GC_OLD && !header->remembered && gc_value_may_be_young(value)))) {
+        gc_write_barrier(gc, object, value);
+    }
+}
+
+static inline void gc_element_write(Object* array, size_t index, TaggedValue value) {
+    if (!array->is_gc_managed) return;
+    GCObjectHeader* header = GC_HEADER(array);
+    GarbageCollector* gc = header->owner;
+    if (gc && (gc->is_collecting || (header->generation == GC_OLD && gc_value_may_be_young(value)))) {
+        gc_element_write_barrier(gc, array, index, value);
+    }
+}
+
+// Closed upvalues are not traced again once their closure has been, so
+// they need a barrier of their own
+static inline void gc_upvalue_write(GarbageCollector* gc, Upvalue* upvalue) {
+    if (!gc || upvalue->location != &upvalue->closed) return;
+    if (gc->is_collecting ||
+        (!upvalue->is_remembered && IS_OBJECT(upvalue->closed) && gc_value_may_be_young(upvalue->closed))) {
+        gc_remember_upvalue(gc, upvalue);
+    }
+}
+
 #endif // GC_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef GC_PARALLEL_H
+#define GC_PARALLEL_H
+
+#include <stddef.h>
+
+typedef struct GarbageCollector GarbageCollector;
+
+/**
+ * Worker threads that share the mark phase of a stop-the-world collection.
+ *
+ * Each marker traces from a private gray stack and publishes part of it
+ * when its own share of work runs low for others; idle markers steal from
+ * those shares. Objects are shaded with a compare-and-swap on their color,
+ * so each one is blackened by exactly one marker.
+ *
+ * The collecting thread is one of the markers, so a pool of N threads starts
+ * N - 1 workers. They sleep between collections.
+ */
+typedef struct GCMarkPool GCMarkPool;
+
+// Returns NULL if `threads` < 2 or the workers could not be started
+GCMarkPool* gc_mark_pool_create(size_t threads);
+void gc_mark_pool_destroy(GCMarkPool* pool);
+
+// Markers including the collecting thread
+size_t gc_mark_pool_threads(const GCMarkPool* pool);
+
+// Trace everything reachable from gc->gray_stack, leaving it empty
+void gc_mark_pool_drain(GCMarkPool* pool, GarbageCollector* gc);
+
+#endif // GC_PARALLEL_H
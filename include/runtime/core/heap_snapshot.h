@@ -0,0 +1,91 @@
+#ifndef HEAP_SNAPSHOT_H
+#define HEAP_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct GarbageCollector GarbageCollector;
+
+/**
+ * The graph of everything reachable from a VM's roots at one point in time.
+ *
+ * Nodes are heap objects, plus the closures and struct instances values
+ * hold: those are not collected themselves, but they take memory and keep
+ * objects alive. Node 0 is a synthetic root whose children are the root
+ * categories (the stack, globals, each loaded module, ...). Edges are
+ * labeled with the property, element, field or global they go through.
+ *
+ * Names (struct types, functions, property keys) are indices into
+ * `strings`, so a snapshot stays small on disk and can be analyzed by a
+ * process other than the one that took it.
+ */
+typedef enum {
+    SNAPSHOT_ROOT,
+    SNAPSHOT_OBJECT,
+    SNAPSHOT_ARRAY,
+    SNAPSHOT_STRUCT,   // `name` is the struct type
+    SNAPSHOT_CLOSURE   // `name` is the function
+} SnapshotNodeKind;
+
+typedef enum {
+    SNAPSHOT_EDGE_NAMED,    // `label` is a string index
+    SNAPSHOT_EDGE_ELEMENT,  // `label` is an array index or stack slot
+    SNAPSHOT_EDGE_UPVALUE   // `label` is the closure's upvalue index
+} SnapshotEdgeKind;
+
+typedef struct {
+    uint8_t kind;          // SnapshotNodeKind
+    uint32_t name;
+    uint64_t self_size;    // Bytes this node holds itself, headers included
+} SnapshotNode;
+
+typedef struct {
+    uint32_t from;
+    uint32_t to;
+    uint8_t kind;          // SnapshotEdgeKind
+    uint32_t label;
+} SnapshotEdge;
+
+typedef struct {
+    SnapshotNode* nodes;
+    size_t node_count;
+    size_t node_capacity;
+    SnapshotEdge* edges;
+    size_t edge_count;
+    size_t edge_capacity;
+    char** strings;
+    size_t string_count;
+    size_t string_capacity;
+    uint64_t heap_bytes;   // Collector's bytes_allocated, garbage included
+} HeapSnapshot;
+
+// Walk the heap from the collector's roots, and from its VM's if it has
+// one. Nothing is collected or allocated on the collector's heap, so this
+// can run at any point between instructions. Returns NULL if memory runs out.
+HeapSnapshot* heap_snapshot_take(GarbageCollector* gc);
+void heap_snapshot_free(HeapSnapshot* snapshot);
+
+// Compact binary file; false on I/O errors or a malformed file
+bool heap_snapshot_write(const HeapSnapshot* snapshot, const char* path);
+HeapSnapshot* heap_snapshot_read(const char* path);
+
+// Dominator tree of a snapshot. Node `d` dominates `n` if every path from
+// the root to `n` goes through `d`; freeing `d` would free everything it
+// dominates, which is its retained size.
+typedef struct {
+    uint32_t* idom;        // Immediate dominator; the root is its own
+    uint64_t* retained;    // Self size plus that of every node dominated
+    uint32_t* parent_edge; // Edge a shortest path from the root arrives by
+    size_t node_count;
+} HeapDominators;
+
+HeapDominators* heap_snapshot_dominators(const HeapSnapshot* snapshot);
+void heap_dominators_free(HeapDominators* dominators);
+
+// Retained size by node type and name, then the `top` largest retainers
+// with the dominator path leading to each
+void heap_snapshot_report(const HeapSnapshot* snapshot, FILE* out, size_t top);
+
+#endif // HEAP_SNAPSHOT_H
@@ -3,28 +3,38 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Forward declarations
 typedef struct TaggedValue TaggedValue;
 typedef struct Object Object;
-typedef struct ObjectProperty ObjectProperty;
+typedef struct Shape Shape;
+typedef struct PropertyTable PropertyTable;
 typedef struct StructType StructType;
 typedef struct StructInstance StructInstance;
 typedef struct VM VM;
 
-// Object property - linked list node
-struct ObjectProperty {
-    char* key;
-    TaggedValue* value;
-    ObjectProperty* next;
-};
-
-// Object structure with prototype chain
+// Object structure with prototype chain.
+//
+// Property values live in the `slots` vector. Which key owns which slot is
+// described by `shape`, a hidden class shared with every object that gained
+// the same keys in the same order. Objects with more than SHAPE_MAX_SLOTS
+// keys, or that had a key deleted, switch to dictionary mode: `shape` is NULL
+// and a private `dictionary` maps keys to slots instead.
 struct Object {
-    ObjectProperty* properties;
+    Shape* shape;               // NULL in dictionary mode
+    PropertyTable* dictionary;  // Own key -> slot map in dictionary mode
+    TaggedValue* slots;
+    uint32_t slot_count;        // Slots in use (deleted keys leave holes)
+    uint32_t slot_capacity;
     Object* prototype;  // Prototype object for inheritance
     size_t property_count;
     bool is_array;  // Special flag for array objects
+    bool is_prototype;  // Some object inherits from this one
+    bool is_gc_managed;  // Allocated by gc_alloc() (a GCObjectHeader precedes it)
+    TaggedValue* elements;      // Dense element vector (arrays only)
+    size_t element_count;       // Array length
+    size_t element_capacity;
 };
 
 // Struct type definition
@@ -46,16 +56,35 @@ Object* object_create(void);
 Object* object_create_with_prototype(Object* prototype);
 void object_destroy(Object* obj);
 
-// Property access
+// Property access. Returned pointers point into the owner's slot vector and
+// are invalidated when a key is added to or deleted from that object.
 TaggedValue* object_get_property(Object* obj, const char* key);
+TaggedValue* object_get_own_property(Object* obj, const char* key);
 void object_set_property(Object* obj, const char* key, TaggedValue value);
+// Set a property whose key was computed at run time, as by a subscript. Such
+// keys come from data, so a new one sends the object to dictionary mode
+// instead of adding a shape transition.
+void object_set_keyed_property(Object* obj, const char* key, TaggedValue value);
+bool object_delete_property(Object* obj, const char* key);
 bool object_has_property(Object* obj, const char* key);
 bool object_has_own_property(Object* obj, const char* key);
 
+// Slot of an own key, for callers that cache lookups by shape
+bool object_find_slot(Object* obj, const char* key, uint32_t* slot);
+
+// Visit every own property (shape order, or table order in dictionary mode)
+typedef void (*PropertyIterator)(const char* key, TaggedValue* value, void* user_data);
+void object_iterate_properties(Object* obj, PropertyIterator iterator, void* user_data);
+
 // Prototype chain
 void object_set_prototype(Object* obj, Object* prototype);
 Object* object_get_prototype(Object* obj);
 
+// Bumped whenever a cached inherited lookup may have gone stale: a key is
+// added to or deleted from a prototype, an object becomes (or re-parents) a
+// prototype, or an object is destroyed.
+extern uint32_t object_cache_epoch;
+
 // Array-specific functions
 Object* array_create(void);
 Object* array_create_with_capacity(size_t capacity);
@@ -71,6 +100,7 @@ Object* get_array_prototype(void);
 Object* get_string_prototype(void);
 Object* get_function_prototype(void);
 Object* get_number_prototype(void);
+Object* get_string_builder_prototype(void);
 
 // Initialize built-in prototypes
 void init_builtin_prototypes(void);
@@ -78,6 +108,11 @@ void init_builtin_prototypes(void);
 // Get or create prototype for a struct type
 Object* get_struct_prototype(const char* struct_name);
 
+// Visit the process-wide prototypes (built-in and struct), which are reachable
+// from C statics rather than from any VM
+typedef void (*PrototypeVisitor)(Object* prototype, void* user_data);
+void object_iterate_shared_prototypes(PrototypeVisitor visitor, void* user_data);
+
 // Struct type functions
 StructType* struct_type_create(const char* name, char** field_names, size_t field_count);
 void struct_type_destroy(StructType* type);
@@ -94,5 +129,7 @@ void struct_instance_set_field_by_index(StructInstance* instance, size_t index,
 
 // Set the current VM for GC-aware object allocation
 void object_set_current_vm(VM* vm);
+// The VM objects are currently allocated for, or NULL
+VM* object_get_current_vm(void);
 
 #endif
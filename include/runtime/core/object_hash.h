@@ -1,61 +1,48 @@
 #ifndef OBJECT_HASH_H
 #define OBJECT_HASH_H
 
-#include "runtime/core/object.h"
-#include "runtime/core/vm.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 /**
- * Hash table-based object implementation for better performance.
- * These functions provide O(1) average case property access compared
- * to the O(n) linked list implementation.
+ * Open-addressing hash table from property names to slot indices.
+ *
+ * Objects never store values here; a table only says which slot of
+ * Object.slots holds a key. Large shapes use one as their lookup index
+ * (keys borrowed from the shape chain), and objects in dictionary mode own
+ * one privately (keys copied and freed by the table).
  */
 
-// Create an optimized object with hash table storage
-Object* object_create_optimized(void);
+typedef struct {
+    const char* key;    // NULL when empty or deleted
+    uint32_t hash;
+    uint32_t slot;
+    bool deleted;       // Tombstone left by property_table_delete()
+} PropertyTableEntry;
 
-// Optimized property access
-TaggedValue* object_get_property_optimized(Object* obj, const char* key);
-void object_set_property_optimized(Object* obj, const char* key, TaggedValue value);
+typedef struct PropertyTable {
+    PropertyTableEntry* entries;
+    size_t capacity;
+    size_t count;
+    size_t tombstones;
+    bool owns_keys;
+} PropertyTable;
 
-// Module-specific optimizations
+// Create a table sized to hold `expected` keys without resizing
+PropertyTable* property_table_create(size_t expected, bool owns_keys);
+void property_table_destroy(PropertyTable* table);
 
-/**
- * Create a module export object with pre-sized hash table.
- * This avoids resizing during module loading.
- * 
- * @param expected_exports Number of exports the module will have
- * @return Optimized object for module exports
- */
-Object* create_module_export_object(size_t expected_exports);
+// Look up `key`; on success stores its slot in *slot
+bool property_table_get(const PropertyTable* table, const char* key, uint32_t* slot);
 
-/**
- * Batch set multiple properties at once.
- * More efficient than setting properties one by one.
- * 
- * @param obj The object to set properties on
- * @param keys Array of property names
- * @param values Array of property values
- * @param count Number of properties to set
- */
-void object_set_properties_batch(Object* obj, const char** keys, TaggedValue* values, size_t count);
+// Map `key` to `slot`. Returns true if the key was not present before.
+bool property_table_set(PropertyTable* table, const char* key, uint32_t slot);
 
-/**
- * Iterator callback for property iteration.
- * 
- * @param key Property name
- * @param value Property value
- * @param user_data User-provided context
- */
-typedef void (*PropertyIterator)(const char* key, TaggedValue* value, void* user_data);
+// Remove `key`. Returns false if it was not present.
+bool property_table_delete(PropertyTable* table, const char* key);
 
-/**
- * Iterate over all properties of an object.
- * Useful for import * operations.
- * 
- * @param obj The object to iterate
- * @param iterator Callback function for each property
- * @param user_data Context passed to the iterator
- */
-void object_iterate_properties(Object* obj, PropertyIterator iterator, void* user_data);
+// FNV-1a, shared with the shape transition tables
+uint32_t property_key_hash(const char* key);
 
-#endif // OBJECT_HASH_H
\ No newline at end of file
+#endif // OBJECT_HASH_H
@@ -14,8 +14,6 @@
 
 // Object system
 #define SIZE_OBJECT             sizeof(Object)
-#define SIZE_OBJECT_PROPERTY    sizeof(ObjectProperty)
-#define SIZE_ARRAY              sizeof(Array)
 
 // String sizes
 #define SIZE_STRING(len)        ((len) + 1)  // Include null terminator
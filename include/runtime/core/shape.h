@@ -0,0 +1,56 @@
+#ifndef SHAPE_H
+#define SHAPE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct PropertyTable PropertyTable;
+
+// Objects growing past this many slots leave the shape tree for dictionary mode
+#define SHAPE_MAX_SLOTS 32
+
+// Shapes up to this size are searched by walking the parent chain
+#define SHAPE_LINEAR_LOOKUP 8
+
+// Transitions out of one shape. An object adding a key its shape has no
+// transition for, once it has this many, goes to dictionary mode instead.
+#define SHAPE_MAX_TRANSITIONS 1024
+
+/**
+ * Hidden class shared by every object that gained the same keys in the same
+ * order. Each shape adds one key (at slot == parent->slot_count) to its
+ * parent; the root shape has no keys. Shapes are interned in a process-wide
+ * transition tree and are never freed, so the tree is kept to the keys a
+ * program names: SHAPE_MAX_SLOTS deep, SHAPE_MAX_TRANSITIONS wide, and
+ * no transitions for keys computed at run time (object_set_keyed_property).
+ */
+typedef struct Shape {
+    struct Shape* parent;
+    const char* key;             // Key added by this shape; NULL for the root
+    uint32_t key_hash;           // property_key_hash(key)
+    uint32_t slot;               // Slot holding `key`
+    uint32_t slot_count;         // Slots used by objects with this shape
+
+    struct Shape** transitions;  // Child shapes by key hash, open-addressed
+    uint32_t transition_count;
+    uint32_t transition_capacity;  // A power of two, at least twice the count
+
+    PropertyTable* table;        // key -> slot index for large shapes, built lazily
+} Shape;
+
+// The empty shape every new object starts with
+Shape* shape_root(void);
+
+// Shape reached by adding `key`; shared with every other object doing the
+// same. NULL if that would be a transition past SHAPE_MAX_TRANSITIONS, or
+// memory runs out.
+Shape* shape_add_key(Shape* shape, const char* key);
+
+// Slot of `key` in objects of this shape
+bool shape_lookup(Shape* shape, const char* key, uint32_t* slot);
+
+// Fill keys[slot] for every slot of the shape (keys has slot_count entries)
+void shape_collect_keys(const Shape* shape, const char** keys);
+
+#endif // SHAPE_H
@@ -0,0 +1,127 @@
+#ifndef STRING_OBJECT_H
+#define STRING_OBJECT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * String values. A value holds a plain `char*` to NUL-terminated characters,
+ * so C code reads a string as it always has, but every string the runtime
+ * makes is preceded by a header with its length and hash. STRING_HEADER()
+ * finds it by pointer arithmetic, as GC_HEADER() does for collected objects,
+ * so the length of a string is never recounted and its hash never redone.
+ *
+ * A string stored in a value must come from the functions below or from a
+ * StringPool. A C literal or strdup() copy has no header; natives have to
+ * copy those with string_copy() before returning them.
+ */
+typedef struct {
+    uint32_t length;   // Bytes before the terminator, at most STRING_MAX_LENGTH
+    uint32_t hash;     // string_hash_bytes() of the characters
+    uint32_t pool;     // Id of the StringPool that owns it
+    uint8_t flags;     // StringFlags
+    uint8_t marked;    // Reached by the collection in progress (pooled strings)
+} StringHeader;
+
+// A 32-bit length keeps the header at 16 bytes with a pool id that does
+// not wrap around
+#define STRING_MAX_LENGTH UINT32_MAX
+
+typedef enum {
+    STRING_INTERNED = 1 << 0,  // Owned by a StringPool, the only copy of its characters there
+    STRING_ROPE = 1 << 1,      // A StringRope follows the header, not characters; see below
+    STRING_ADOPTED = 1 << 2    // Owned by a StringPool that had an equal string interned
+                               // when it took this one over from another pool
+} StringFlags;
+
+/**
+ * Ropes. Appending to a long string in a loop would copy it every time, so
+ * a pool can make a concatenation that only records its two halves; the
+ * characters are copied out, once, when something first reads them. Its
+ * header has the full length, but no hash. Only the left half can be a
+ * rope, so the halves of an accumulator form a chain down the left.
+ *
+ * A rope is never STRING_INTERNED: nothing stops two equal ropes existing.
+ * Its pool, which owns it until it is swept, is the one its header names.
+ * AS_STRING() gives a rope as it is, so code that reads the characters of a
+ * string value must go through string_chars() (string_pool.h) first.
+ */
+struct StringPool;
+
+typedef struct {
+    const char* left;          // NULL once flattened
+    const char* right;         // Never a rope
+    char* flat;                // The characters, after the first read
+    struct StringPool* pool;   // Owner, or NULL once the pool let go of it
+} StringRope;
+
+#define STRING_HEADER(chars) ((StringHeader*)((char*)(chars) - sizeof(StringHeader)))
+
+static inline size_t string_length(const char* chars) {
+    return STRING_HEADER(chars)->length;
+}
+
+static inline uint32_t string_hash(const char* chars) {
+    return STRING_HEADER(chars)->hash;
+}
+
+static inline bool string_is_interned(const char* chars) {
+    return (STRING_HEADER(chars)->flags & STRING_INTERNED) != 0;
+}
+
+static inline bool string_is_rope(const char* chars) {
+    return (STRING_HEADER(chars)->flags & STRING_ROPE) != 0;
+}
+
+// Whether the pool with id `pool` owns the string: interned it, made it as
+// a rope or adopted it
+static inline bool string_is_owned_by(const char* chars, uint32_t pool) {
+    const StringHeader* header = STRING_HEADER(chars);
+    return (header->flags & (STRING_INTERNED | STRING_ROPE | STRING_ADOPTED)) &&
+           header->pool == pool;
+}
+
+#define STRING_ROPE_DATA(chars) ((StringRope*)(chars))
+
+// Equality of two runtime strings. A pool holds one copy of each distinct
+// string, so two strings interned by the same pool are equal only if they
+// are the same pointer. Module VMs have pools of their own, hence the pool
+// check. Otherwise the cached lengths and hashes rule out most unequal
+// pairs before the characters are compared. Neither may be a rope.
+static inline bool string_equals(const char* a, const char* b) {
+    if (a == b) return true;
+    const StringHeader* header_a = STRING_HEADER(a);
+    const StringHeader* header_b = STRING_HEADER(b);
+    if ((header_a->flags & header_b->flags & STRING_INTERNED) &&
+        header_a->pool == header_b->pool) {
+        return false;
+    }
+    return header_a->length == header_b->length &&
+           header_a->hash == header_b->hash &&
+           memcmp(a, b, header_a->length) == 0;
+}
+
+// FNV-1a, the hash every string header caches
+uint32_t string_hash_bytes(const char* chars, size_t length);
+
+// A new string holding `length` bytes of `chars`
+char* string_new(const char* chars, size_t length);
+// A new string holding a NUL-terminated C string
+char* string_copy(const char* chars);
+// A new, uninterned copy of a runtime string, keeping its hash
+char* string_clone(const char* string);
+
+// A string of `length` uninitialized bytes, terminator included, for the
+// caller to fill in. string_seal() then hashes it; until then it must not
+// be used as a value. NULL if `length` is over STRING_MAX_LENGTH or the
+// allocation fails, as for the functions above.
+char* string_alloc(size_t length);
+char* string_seal(char* chars);
+
+// Bytes the string takes in the strings allocator, header included
+size_t string_allocation_size(const char* chars);
+void string_free(char* chars);
+
+#endif // STRING_OBJECT_H
@@ -3,20 +3,23 @@
 
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include "runtime/core/string_object.h"
 
 typedef struct StringEntry {
-    char* string;
-    size_t length;
+    char* string;                  // Interned string; its header has the length and hash
     struct StringEntry* next;      // For hash table chaining
     struct StringEntry* all_next;  // For all strings list
-    bool marked;  // For future GC
 } StringEntry;
 
-typedef struct {
+typedef struct StringPool {
     StringEntry** buckets;
     size_t bucket_count;
-    size_t entry_count;
-    StringEntry* all_strings;  // Linked list of all strings for cleanup
+    size_t entry_count;        // Interned strings, not counting ropes or adopted ones
+    StringEntry* all_strings;  // Linked list of all strings for cleanup; ropes and
+                               // adopted strings are only here
+    size_t bytes;              // Taken by the strings, headers included
+    uint32_t id;               // Stamped on the strings it owns
 } StringPool;
 
 // Initialize the string pool
@@ -28,16 +31,67 @@ void string_pool_free(StringPool* pool);
 // Intern a string (returns a pointer that the pool owns)
 char* string_pool_intern(StringPool* pool, const char* string, size_t length);
 
+// Intern a string value, using the length and hash its header caches. A
+// string this pool interned is returned as is, and a rope is flattened.
+char* string_pool_intern_string(StringPool* pool, const char* string);
+
+// Intern a string made with string_new() or string_alloc(), taking it over:
+// it becomes the interned copy, or is freed if an equal one already is
+char* string_pool_take(StringPool* pool, char* string);
+
 // Create a new string in the pool
 char* string_pool_create(StringPool* pool, const char* string, size_t length);
 
-// Mark all strings as unreachable (for GC)
+// Whether an equal string is interned
+bool string_pool_contains(StringPool* pool, const char* string);
+
+// A rope of `left` followed by `right`, both owned by the pool and `right`
+// not a rope; see StringRope. Nothing is copied.
+char* string_pool_rope(StringPool* pool, const char* left, const char* right);
+
+// The characters of a rope. The first call copies them out, into a string
+// the rope's pool interns, and lets go of the halves. NULL if that copy
+// cannot be allocated.
+char* string_flatten(char* rope);
+
+// The characters of any runtime string: the string itself, or a rope
+// flattened. Flattening allocates, so this can return NULL for a rope.
+static inline char* string_chars(char* string) {
+    return string_is_rope(string) ? string_flatten(string) : string;
+}
+
+// Move every string of `from` to `into`, to be swept there once unreachable,
+// and leave `from` empty. A module's VM does this as it is freed: its exports
+// and globals outlive it. Strings `into` already has an equal of are kept as
+// STRING_ADOPTED copies, since the pointers to them stay as they are.
+void string_pool_adopt(StringPool* into, StringPool* from);
+
+// Give up the strings without freeing them: they stay valid, as ordinary
+// uninterned strings, for whoever still holds them. The pool is left empty.
+void string_pool_release(StringPool* pool);
+
+// Mark-sweep. The collector of the VM owning the pool marks every string of
+// the pool it reaches, then sweeps; string_pool_sweep() also clears the marks
+// of the survivors, so string_pool_mark_sweep_begin() is only needed when
+// marking was abandoned halfway.
 void string_pool_mark_sweep_begin(StringPool* pool);
 
-// Mark a string as reachable
-void string_pool_mark(StringPool* pool, char* string);
+// Mark the halves of a rope that has just been marked
+void string_pool_mark_rope(StringPool* pool, const char* rope);
+
+// Mark a string as reachable, and what a rope is made of. Strings this pool
+// does not own are ignored.
+static inline void string_pool_mark(StringPool* pool, const char* string) {
+    StringHeader* header = STRING_HEADER(string);
+    if (string_is_owned_by(string, pool->id) && !header->marked) {
+        header->marked = 1;
+        if (header->flags & STRING_ROPE) {
+            string_pool_mark_rope(pool, string);
+        }
+    }
+}
 
-// Sweep unmarked strings
-void string_pool_sweep(StringPool* pool);
+// Free the unmarked strings; returns the bytes freed
+size_t string_pool_sweep(StringPool* pool);
 
 #endif
@@ -7,11 +7,18 @@
 #include "runtime/core/string_pool.h"
 #include "runtime/core/object.h"
 
-#define STACK_MAX 256
-#define FRAMES_MAX 64
+// Initial sizes of the value stack and call-frame stack; both grow on demand
+#define VM_STACK_INITIAL 256
+#define VM_FRAMES_INITIAL 64
 
-#define STACK_MAX 256
-#define FRAMES_MAX 64
+// Default depth limits (override with vm_set_stack_limits)
+#define VM_STACK_LIMIT (1024 * 1024)
+#define VM_FRAMES_LIMIT 16384
+
+// Free value slots guaranteed above stack_top when a frame is entered, on
+// top of the chunk's max_stack; handlers may push a value or two the
+// compiler does not count, and chunks of unknown depth get only this
+#define VM_STACK_HEADROOM 256
 
 typedef enum {
     // Constants
@@ -143,7 +150,57 @@ typedef enum {
     OP_OBJECT_LITERAL = 79,
 
     // Misc
-    OP_HALT = 80
+    OP_HALT = 80,
+
+    // Globals resolved to a per-chunk slot (the name constant's index)
+    OP_GET_GLOBAL_SLOT = 81,
+    OP_SET_GLOBAL_SLOT = 82,
+
+    // Quickened forms: the interpreter rewrites a generic arithmetic or
+    // comparison instruction into these once it sees two number operands.
+    // If the guard ever fails the site becomes the matching _GENERIC form
+    // below. Never emitted by the compiler.
+    OP_ADD_NUM = 83,
+    OP_SUBTRACT_NUM = 84,
+    OP_MULTIPLY_NUM = 85,
+    OP_GREATER_NUM = 86,
+    OP_GREATER_EQUAL_NUM = 87,
+    OP_LESS_NUM = 88,
+    OP_LESS_EQUAL_NUM = 89,
+
+    // Superinstructions fused in place by chunk_fuse_superinstructions();
+    // each keeps the original operands and skips the instructions it covers
+    OP_GET_LOCAL_PAIR = 90,      // GET_LOCAL a; GET_LOCAL b
+    OP_GET_LOCAL_CONSTANT = 91,  // GET_LOCAL a; CONSTANT k
+    OP_SET_LOCAL_POP = 92,       // SET_LOCAL a; POP
+    OP_JUMP_IF_FALSE_POP = 93,   // JUMP_IF_FALSE off; POP (target is a POP)
+
+    // Call in return position: a closure callee takes over the caller's
+    // frame, anything else is called like OP_CALL. Always followed by OP_RETURN.
+    OP_TAIL_CALL = 94,
+
+    // The strings of a + b + ... past its first string literal, joined in
+    // one allocation; the operand is how many values it takes off the stack.
+    OP_ADD_CHAIN = 95,
+
+    // Append the values above an array to it; the operand is how many.
+    // Array literals of more than 255 elements are built in batches.
+    OP_ARRAY_APPEND = 96,
+
+    // Fail as OP_ADD would unless the top of the stack is a string; guards
+    // each OP_ADD_CHAIN operand before the next one is evaluated.
+    OP_EXPECT_STRING = 97,
+
+    // Sites whose quickened form saw a non-number: they run the generic
+    // handler and are never quickened again, so polymorphic sites do not
+    // flip back and forth. Must stay the highest opcodes.
+    OP_ADD_GENERIC = 98,
+    OP_SUBTRACT_GENERIC = 99,
+    OP_MULTIPLY_GENERIC = 100,
+    OP_GREATER_GENERIC = 101,
+    OP_GREATER_EQUAL_GENERIC = 102,
+    OP_LESS_GENERIC = 103,
+    OP_LESS_EQUAL_GENERIC = 104
 } OpCode;
 
 // Forward declarations
@@ -176,34 +233,104 @@ typedef union {
     NativeFn native;
 } Value;
 
+#ifdef SLANG_NAN_BOXING
+/*
+ * NaN-boxed value: a single 64-bit word.
+ *
+ * Any bit pattern that is not a quiet NaN with bit 50 set is a plain double.
+ * Everything else is boxed inside that NaN space:
+ *
+ *   nil / false / true   QNAN | 1, 2, 3
+ *   pointers             QNAN | tag | 48-bit address
+ *
+ * The 3-bit pointer tag is split across the sign bit and bits 48-49 (see
+ * NANBOX_TAG). Values must only be built and inspected through the IS_*,
+ * AS_*, *_VAL and VALUE_TYPE macros below.
+ */
+typedef struct TaggedValue {
+    uint64_t bits;
+} TaggedValue;
+#else
 typedef struct TaggedValue {
     ValueType type;
     Value as;
 } TaggedValue;
+#endif
+
+// Late-bound storage for one global slot. Valid only while vm, module and
+// the VM's epoch all match; see vm_invalidate_global_caches().
+typedef struct GlobalCache {
+    TaggedValue* value;
+    struct VM* vm;
+    struct Module* module;
+    uint32_t epoch;
+    bool module_owned;      // value lives in module->globals, not vm->globals
+} GlobalCache;
+
+// Inline cache for one OP_GET_PROPERTY / OP_METHOD_CALL site, keyed on the
+// receiver's shape. An own entry reads the receiver's slot directly. An
+// inherited entry also matches the receiver's prototype (the builtin
+// prototype for strings and numbers, which have no shape) and reads the
+// slot of the holder further up the chain while object_cache_epoch is
+// unchanged; the shape proves the receiver has no shadowing own key.
+#define INLINE_CACHE_WAYS 4
+
+typedef struct {
+    struct Shape* shape;    // Receiver shape; NULL for string and number receivers
+    struct Object* proto;   // Receiver's prototype (inherited entries)
+    struct Object* holder;  // Object owning the slot; NULL for own entries
+    uint32_t slot;
+    uint32_t epoch;         // object_cache_epoch when filled (inherited entries)
+} InlineCacheEntry;
+
+typedef struct InlineCache {
+    const char* name;       // Property the entries were filled for
+    InlineCacheEntry entries[INLINE_CACHE_WAYS];
+    uint8_t count;
+    uint8_t next_victim;
+    uint32_t hits;
+    uint32_t misses;
+} InlineCache;
 
 typedef struct {
     uint8_t* code;
     size_t count;
     size_t capacity;
     int* lines;
+    size_t max_stack;  // Deepest the code takes the stack (chunk_measure_stack), 0 if unknown
     
     struct {
         TaggedValue* values;
         size_t count;
         size_t capacity;
     } constants;
+    
+    // Indexed like constants; allocated on first slot access
+    GlobalCache* global_cache;
+    size_t global_cache_count;
+    
+    // Property lookup caches, found through inline_cache_index[offset] - 1
+    // for the instruction at that code offset; allocated on first use
+    InlineCache* inline_caches;
+    size_t inline_cache_count;
+    size_t inline_cache_capacity;
+    uint16_t* inline_cache_index;
+    size_t inline_cache_index_count;
 } Chunk;
 
 typedef struct Upvalue {
     TaggedValue* location;
     TaggedValue closed;
     struct Upvalue* next;
+    struct Upvalue* next_remembered;  // In the collector's remembered upvalues
+    bool is_remembered;
 } Upvalue;
 
 struct Closure {
     Function* function;
     Upvalue** upvalues;
     int upvalue_count;
+    uint32_t gc_epoch;  // Last collection that traced the captured values
 };
 
 struct Function {
@@ -221,6 +348,14 @@ typedef struct {
     struct Module* saved_module; // Saved module context from caller
 } CallFrame;
 
+// A value stack replaced by growth while a native call held its args
+// pointer into it; kept readable until vm_free
+typedef struct RetiredStack {
+    TaggedValue* values;
+    size_t capacity;
+    struct RetiredStack* next;
+} RetiredStack;
+
 // Forward declaration
 typedef struct ModuleLoader ModuleLoader;
 
@@ -231,11 +366,18 @@ typedef struct VM {
     Chunk* chunk;
     uint8_t* ip;
     
-    TaggedValue stack[STACK_MAX];
+    TaggedValue* stack;
     TaggedValue* stack_top;
+    size_t stack_capacity;
+    size_t stack_limit;           // Largest stack_capacity allowed
     
-    CallFrame frames[FRAMES_MAX];
+    CallFrame* frames;
     int frame_count;
+    int frame_capacity;
+    int frame_limit;              // Deepest call nesting allowed
+    
+    struct RetiredStack* retired_stacks; // Outgrown stacks natives may still read
+    int native_depth;             // Native calls currently on the C stack
     
     struct {
         char** names;
@@ -243,6 +385,8 @@ typedef struct VM {
         size_t count;
         size_t capacity;
     } globals;
+    // Bumped whenever a globals table this VM reads changes shape
+    uint32_t global_cache_epoch;
     
     struct {
         char** names;
@@ -284,6 +428,10 @@ int chunk_add_constant(Chunk* chunk, TaggedValue value);
 void vm_init(VM* vm);
 void vm_init_with_loader(VM* vm, ModuleLoader* loader);
 void vm_free(VM* vm);
+// Free the VM a module ran in, handing the objects its exports and globals
+// may reference over to `importer`, the VM that imported the module
+void vm_free_into(VM* vm, VM* importer);
+void vm_set_stack_limits(VM* vm, size_t max_stack, int max_frames);
 VM* vm_create(void);
 void vm_destroy(VM* vm);
 InterpretResult vm_interpret(VM* vm, Chunk* chunk);
@@ -291,7 +439,92 @@ InterpretResult vm_interpret_function(VM* vm, Function* function);
 void vm_push(VM* vm, TaggedValue value);
 TaggedValue vm_pop(VM* vm);
 
-// Value helpers
+// Value helpers. AS_STRING() gives the string as stored, which may be a
+// rope; string_chars() has its characters.
+#ifdef SLANG_NAN_BOXING
+
+_Static_assert(sizeof(void*) == 8, "NaN boxing requires 64-bit pointers");
+
+#define NANBOX_SIGN_BIT   ((uint64_t)0x8000000000000000)
+#define NANBOX_QNAN       ((uint64_t)0x7ffc000000000000)
+#define NANBOX_TAG_MASK   (NANBOX_SIGN_BIT | ((uint64_t)3 << 48))
+#define NANBOX_PTR_MASK   ((uint64_t)0x0000ffffffffffff)
+#define NANBOX_TAG(tag)   ((((uint64_t)(tag) & 4) << 61) | (((uint64_t)(tag) & 3) << 48))
+
+#define NANBOX_NIL        (NANBOX_QNAN | 1)
+#define NANBOX_FALSE      (NANBOX_QNAN | 2)
+#define NANBOX_TRUE       (NANBOX_QNAN | 3)
+
+// Pointer tags (0 is reserved for nil/false/true)
+#define NANBOX_TAG_STRING   1
+#define NANBOX_TAG_OBJECT   2
+#define NANBOX_TAG_FUNCTION 3
+#define NANBOX_TAG_CLOSURE  4
+#define NANBOX_TAG_NATIVE   5
+#define NANBOX_TAG_STRUCT   6
+
+static inline TaggedValue nanbox_number(double number) {
+    union { double number; uint64_t bits; } u = { .number = number };
+    return (TaggedValue){u.bits};
+}
+
+static inline double nanbox_as_number(TaggedValue value) {
+    union { uint64_t bits; double number; } u = { .bits = value.bits };
+    return u.number;
+}
+
+#define NANBOX_PTR(tag, ptr) \
+    ((TaggedValue){NANBOX_QNAN | NANBOX_TAG(tag) | ((uint64_t)(uintptr_t)(ptr) & NANBOX_PTR_MASK)})
+#define NANBOX_IS_PTR(value, tag) \
+    (((value).bits & (NANBOX_QNAN | NANBOX_TAG_MASK)) == (NANBOX_QNAN | NANBOX_TAG(tag)))
+#define NANBOX_AS_PTR(value) ((uintptr_t)((value).bits & NANBOX_PTR_MASK))
+
+#define IS_BOOL(value)    (((value).bits | 1) == NANBOX_TRUE)
+#define IS_NIL(value)     ((value).bits == NANBOX_NIL)
+#define IS_NUMBER(value)  (((value).bits & NANBOX_QNAN) != NANBOX_QNAN)
+#define IS_STRING(value)  NANBOX_IS_PTR(value, NANBOX_TAG_STRING)
+#define IS_OBJECT(value)  NANBOX_IS_PTR(value, NANBOX_TAG_OBJECT)
+#define IS_FUNCTION(value) NANBOX_IS_PTR(value, NANBOX_TAG_FUNCTION)
+#define IS_CLOSURE(value)  NANBOX_IS_PTR(value, NANBOX_TAG_CLOSURE)
+#define IS_NATIVE(value)  NANBOX_IS_PTR(value, NANBOX_TAG_NATIVE)
+#define IS_STRUCT(value)  NANBOX_IS_PTR(value, NANBOX_TAG_STRUCT)
+
+#define AS_BOOL(value)    ((value).bits == NANBOX_TRUE)
+#define AS_NUMBER(value)  nanbox_as_number(value)
+#define AS_STRING(value)  ((char*)NANBOX_AS_PTR(value))
+#define AS_OBJECT(value)  ((Object*)NANBOX_AS_PTR(value))
+#define AS_FUNCTION(value) ((Function*)NANBOX_AS_PTR(value))
+#define AS_CLOSURE(value)  ((Closure*)NANBOX_AS_PTR(value))
+#define AS_NATIVE(value)  ((NativeFn)NANBOX_AS_PTR(value))
+#define AS_STRUCT(value)  ((StructInstance*)NANBOX_AS_PTR(value))
+
+#define BOOL_VAL(value)   ((TaggedValue){(value) ? NANBOX_TRUE : NANBOX_FALSE})
+#define NIL_VAL           ((TaggedValue){NANBOX_NIL})
+#define NUMBER_VAL(value) nanbox_number((double)(value))
+#define STRING_VAL(value) NANBOX_PTR(NANBOX_TAG_STRING, value)
+#define OBJECT_VAL(value) NANBOX_PTR(NANBOX_TAG_OBJECT, value)
+#define FUNCTION_VAL(value) NANBOX_PTR(NANBOX_TAG_FUNCTION, value)
+#define CLOSURE_VAL(value) NANBOX_PTR(NANBOX_TAG_CLOSURE, value)
+#define NATIVE_VAL(value) NANBOX_PTR(NANBOX_TAG_NATIVE, value)
+#define STRUCT_VAL(value) NANBOX_PTR(NANBOX_TAG_STRUCT, value)
+
+static inline ValueType nanbox_type(TaggedValue value) {
+    if (IS_NUMBER(value)) return VAL_NUMBER;
+    switch ((((value.bits & NANBOX_SIGN_BIT) >> 61) | ((value.bits >> 48) & 3))) {
+        case NANBOX_TAG_STRING: return VAL_STRING;
+        case NANBOX_TAG_OBJECT: return VAL_OBJECT;
+        case NANBOX_TAG_FUNCTION: return VAL_FUNCTION;
+        case NANBOX_TAG_CLOSURE: return VAL_CLOSURE;
+        case NANBOX_TAG_NATIVE: return VAL_NATIVE;
+        case NANBOX_TAG_STRUCT: return VAL_STRUCT;
+        default: return IS_NIL(value) ? VAL_NIL : VAL_BOOL;
+    }
+}
+
+#define VALUE_TYPE(value) nanbox_type(value)
+
+#else
+
 #define IS_BOOL(value)    ((value).type == VAL_BOOL)
 #define IS_NIL(value)     ((value).type == VAL_NIL)
 #define IS_NUMBER(value)  ((value).type == VAL_NUMBER)
@@ -317,12 +550,21 @@ TaggedValue vm_pop(VM* vm);
 #define STRING_VAL(value) ((TaggedValue){VAL_STRING, {.string = value}})
 #define OBJECT_VAL(value) ((TaggedValue){VAL_OBJECT, {.object = value}})
 #define FUNCTION_VAL(value) ((TaggedValue){VAL_FUNCTION, {.function = value}})
+#define CLOSURE_VAL(value) ((TaggedValue){VAL_CLOSURE, {.closure = value}})
 #define NATIVE_VAL(value) ((TaggedValue){VAL_NATIVE, {.native = value}})
 #define STRUCT_VAL(value) ((TaggedValue){VAL_STRUCT, {.object = value}})
 
+#define VALUE_TYPE(value) ((value).type)
+
+#endif
+
 void print_value(TaggedValue value);
 bool values_equal(TaggedValue a, TaggedValue b);
 
+// Replace the ropes among `values` by their characters, as natives expect
+// of their arguments. False if memory runs out.
+bool values_flatten(TaggedValue* values, int count);
+
 // Function helpers
 Function* function_create(const char* name, int arity);
 void function_free(Function* function);
@@ -341,4 +583,9 @@ TaggedValue vm_call_closure(VM* vm, Closure* closure, int arg_count, TaggedValue
 void define_global(VM* vm, const char* name, TaggedValue value);
 void undefine_global(VM* vm, const char* name);
 
+// Drop the global slots chunks have cached for this VM. Call after adding,
+// removing or reallocating entries of a globals table it reads (its own
+// or a module's). NULL-safe.
+void vm_invalidate_global_caches(VM* vm);
+
 #endif
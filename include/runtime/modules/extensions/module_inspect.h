@@ -187,6 +187,13 @@ Module** module_find_by_export(ModuleLoader* loader, const char* symbol_name, si
  */
 char* module_to_json(Module* module, bool include_exports, bool include_stats);
 
+/**
+ * Free a JSON string returned by module_to_json() or module_loader_to_json().
+ * 
+ * @param json The string to free, or NULL
+ */
+void module_json_free(char* json);
+
 /**
  * Serialize all loaded modules to JSON.
  * 
@@ -10,9 +10,12 @@
 #define MODULES_NEW_ZERO(type) ((type*)MODULE_ALLOC_ZERO(sizeof(type), "module"))
 #define MODULES_NEW_ARRAY(type, count) ((type*)MODULE_ALLOC(sizeof(type) * (count), "module-array"))
 #define MODULES_NEW_ARRAY_ZERO(type, count) ((type*)MODULE_ALLOC_ZERO(sizeof(type) * (count), "module-array"))
+// Module metadata strings are plain C strings. They come from the modules
+// allocator, like STRINGS_STRDUP() copies, so that either can be freed with
+// STRINGS_FREE(); the strings allocator frees by size class.
 #define STRINGS_STRDUP(str) MODULE_DUP(str)
-#define STRINGS_ALLOC(size) STR_ALLOC(size)
-#define STRINGS_FREE(ptr, size) STR_FREE(ptr, size)
+#define STRINGS_ALLOC(size) MODULE_ALLOC(size, "module-string")
+#define STRINGS_FREE(ptr, size) MODULE_FREE(ptr, size)
 
 // Bytecode allocator macros
 #define BYTECODE_NEW(type) MEM_NEW(allocators_get(ALLOC_SYSTEM_BYTECODE), type)
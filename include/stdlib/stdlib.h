@@ -41,4 +41,10 @@ TaggedValue string_toLowerCase_method(int arg_count, TaggedValue* args);
 TaggedValue string_split_method(int arg_count, TaggedValue* args);
 TaggedValue string_trim_method(int arg_count, TaggedValue* args);
 
+// StringBuilder: StringBuilder() makes one; append(value) adds a piece and
+// returns the builder, toString() joins the pieces in a single allocation,
+// length() and clear() do what they say. Defines the StringBuilder global,
+// so it is set up for every VM rather than by stdlib_init().
+void stdlib_init_string_builder(VM* vm);
+
 #endif // STDLIB_H
\ No newline at end of file
@@ -24,7 +24,7 @@ typedef struct {
     bool enable_trace;        // Enable trace allocator for debugging
     bool enable_stats;        // Enable statistics collection
     size_t arena_size;        // Default arena size
-    size_t object_pool_size;  // Object pool block size
+    size_t object_pool_size;  // Bytes per object pool chunk
 } AllocatorConfig;
 
 // Global allocator management
@@ -34,6 +34,11 @@ Allocator* allocators_get(AllocatorSystem system);
 void allocators_print_stats(void);
 void allocators_check_leaks(void);
 
+// Report every allocation of a subsystem to `hook` until it is replaced;
+// NULL removes it. Pointers from allocators_get() must not be kept across
+// a change, since the hook is a separate allocator in front of the old one.
+void allocators_set_hook(AllocatorSystem system, MemAllocHook hook, void* user_data);
+
 // Convenience macros for each subsystem
 #define VM_ALLOC(size) MEM_ALLOC_TAGGED(allocators_get(ALLOC_SYSTEM_VM), size, "vm-core")
 #define VM_ALLOC_ZERO(size) MEM_ALLOC_ZERO_TAGGED(allocators_get(ALLOC_SYSTEM_VM), size, "vm-core")
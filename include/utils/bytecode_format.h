@@ -20,7 +20,7 @@
 //   Debug section (optional)
 
 #define BYTECODE_MAGIC "SWBC"
-#define BYTECODE_VERSION 1
+#define BYTECODE_VERSION 2
 
 typedef struct {
     char magic[4];
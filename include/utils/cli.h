@@ -2,6 +2,7 @@
 #define CLI_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "utils/logger.h"
 
 // Command handler function type
@@ -52,8 +53,14 @@ typedef struct {
     
     // Runtime options
     size_t stack_size;
-    size_t heap_size;
+    size_t heap_size;      // Heap limit in bytes (0 = unlimited)
+    uint32_t gc_pause_ms;  // Collector pause goal (0 = fixed sizing)
+    const char* gc_stats;  // Collector report: NULL, "text" or "json"
     bool gc_stress_test;
+    const char* heap_snapshot; // Where to save the reachable heap at exit
+    size_t heap_top;       // Entries per list in the heap report
+    const char* alloc_profile; // Where to save sampled allocation sites at exit
+    size_t alloc_rate;     // Mean bytes between allocation samples (0 = all)
     
     // Other options
     bool quiet;
@@ -85,6 +92,7 @@ int cli_cmd_bundle(int argc, char* argv[]);
 int cli_cmd_list(int argc, char* argv[]);
 int cli_cmd_update(int argc, char* argv[]);
 int cli_cmd_cache(int argc, char* argv[]);
+int cli_cmd_heap(int argc, char* argv[]);
 
 // Main CLI entry point
 int cli_main(int argc, char* argv[]);
@@ -14,7 +14,9 @@ typedef enum {
     ALLOCATOR_PLATFORM,  // Standard malloc/free
     ALLOCATOR_ARENA,     // Arena/linear allocator
     ALLOCATOR_FREELIST,  // Freelist allocator
-    ALLOCATOR_TRACE      // Tracing allocator for debugging
+    ALLOCATOR_SIZE_CLASS,// Freelists per size class, platform above
+    ALLOCATOR_TRACE,     // Tracing allocator for debugging
+    ALLOCATOR_HOOK       // Reports allocations to a callback, backing allocator below
 } AllocatorType;
 
 // Allocation flags
@@ -110,8 +112,16 @@ Allocator* mem_get_default_allocator(void);
 Allocator* mem_create_platform_allocator(void);
 Allocator* mem_create_arena_allocator(size_t initial_size);
 Allocator* mem_create_freelist_allocator(size_t block_size, size_t initial_blocks);
+Allocator* mem_create_size_class_allocator(size_t chunk_size);
 Allocator* mem_create_trace_allocator(Allocator* backing_allocator);
 
+// Calls `hook` with the size of every allocation, and of every realloc that
+// grows a block, before passing it on. Destroying it leaves the backing
+// allocator alone.
+typedef void (*MemAllocHook)(size_t size, const char* tag, void* user_data);
+Allocator* mem_create_hook_allocator(Allocator* backing_allocator, MemAllocHook hook, void* user_data);
+Allocator* mem_hook_allocator_backing(Allocator* allocator);
+
 // Core allocation functions
 void* mem_alloc(Allocator* allocator, size_t size, AllocFlags flags, const char* file, int line, const char* tag);
 void* mem_realloc(Allocator* allocator, void* ptr, size_t old_size, size_t new_size, const char* file, int line, const char* tag);
@@ -5,6 +5,8 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
 
 #ifdef _WIN32
     #include <windows.h>
@@ -94,6 +96,9 @@
     #include <strings.h>
     #include <sys/stat.h>
     #include <limits.h>
+    #ifdef __GLIBC__
+        #include <malloc.h>
+    #endif
     
     // Directory separator
     #define PATH_SEPARATOR "/"
@@ -131,4 +136,27 @@ static inline char* platform_mkdtemp(char* template_str) {
 #endif
 }
 
+// Monotonic wall-clock time in microseconds, for measuring intervals
+static inline uint64_t platform_monotonic_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000u +
+           (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000u / (uint64_t)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+#endif
+}
+
+// Return free memory held by the C heap to the system, where the allocator
+// supports it
+static inline void platform_trim_heap(void) {
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
+
 #endif /* PLATFORM_COMPAT_H */
\ No newline at end of file
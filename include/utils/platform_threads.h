@@ -1,6 +1,8 @@
 #ifndef PLATFORM_THREADS_H
 #define PLATFORM_THREADS_H
 
+#include <stdint.h>
+
 #ifdef _WIN32
     #include <windows.h>
     #include <process.h>
@@ -9,6 +11,18 @@
     typedef HANDLE platform_thread_t;
     typedef CRITICAL_SECTION platform_mutex_t;
     typedef SRWLOCK platform_rwlock_t;
+    typedef CONDITION_VARIABLE platform_cond_t;
+    
+    // Thread entry points are declared with PLATFORM_THREAD_FUNC(name, arg)
+    // and return 0
+    #define PLATFORM_THREAD_FUNC(name, arg) unsigned __stdcall name(void* arg)
+    
+    // Thread operations (create returns 0 on success)
+    #define platform_thread_create(thread, func, arg) \
+        ((*(thread) = (HANDLE)_beginthreadex(NULL, 0, func, arg, 0, NULL)) != NULL ? 0 : -1)
+    #define platform_thread_join(thread) \
+        (WaitForSingleObject(thread, INFINITE), CloseHandle(thread))
+    #define platform_thread_yield() SwitchToThread()
     
     // Mutex operations
     #define platform_mutex_init(mutex) InitializeCriticalSection(mutex)
@@ -16,6 +30,21 @@
     #define platform_mutex_lock(mutex) EnterCriticalSection(mutex)
     #define platform_mutex_unlock(mutex) LeaveCriticalSection(mutex)
     
+    // Condition variable operations
+    #define platform_cond_init(cond) InitializeConditionVariable(cond)
+    #define platform_cond_destroy(cond) /* No-op on Windows */
+    #define platform_cond_wait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+    #define platform_cond_broadcast(cond) WakeAllConditionVariable(cond)
+    
+    // Relaxed atomic access and compare-and-swap on plain fields
+    #define platform_atomic_load_u8(ptr) (*(volatile uint8_t*)(ptr))
+    #define platform_atomic_store_u8(ptr, value) (*(volatile uint8_t*)(ptr) = (uint8_t)(value))
+    #define platform_atomic_load_u32(ptr) (*(volatile uint32_t*)(ptr))
+    #define platform_atomic_cas_u8(ptr, expected, desired) \
+        (_InterlockedCompareExchange8((volatile char*)(ptr), (char)(desired), (char)(expected)) == (char)(expected))
+    #define platform_atomic_cas_u32(ptr, expected, desired) \
+        (InterlockedCompareExchange((volatile LONG*)(ptr), (LONG)(desired), (LONG)(expected)) == (LONG)(expected))
+    
     // Read-write lock operations
     #define platform_rwlock_init(rwlock) InitializeSRWLock(rwlock)
     #define platform_rwlock_destroy(rwlock) /* No-op on Windows */
@@ -33,11 +62,22 @@
     
 #else
     #include <pthread.h>
+    #include <sched.h>
     
     // Thread types
     typedef pthread_t platform_thread_t;
     typedef pthread_mutex_t platform_mutex_t;
     typedef pthread_rwlock_t platform_rwlock_t;
+    typedef pthread_cond_t platform_cond_t;
+    
+    // Thread entry points are declared with PLATFORM_THREAD_FUNC(name, arg)
+    // and return 0
+    #define PLATFORM_THREAD_FUNC(name, arg) void* name(void* arg)
+    
+    // Thread operations (create returns 0 on success)
+    #define platform_thread_create(thread, func, arg) pthread_create(thread, NULL, func, arg)
+    #define platform_thread_join(thread) pthread_join(thread, NULL)
+    #define platform_thread_yield() sched_yield()
     
     // Mutex operations
     #define platform_mutex_init(mutex) pthread_mutex_init(mutex, NULL)
@@ -45,6 +85,21 @@
     #define platform_mutex_lock(mutex) pthread_mutex_lock(mutex)
     #define platform_mutex_unlock(mutex) pthread_mutex_unlock(mutex)
     
+    // Condition variable operations
+    #define platform_cond_init(cond) pthread_cond_init(cond, NULL)
+    #define platform_cond_destroy(cond) pthread_cond_destroy(cond)
+    #define platform_cond_wait(cond, mutex) pthread_cond_wait(cond, mutex)
+    #define platform_cond_broadcast(cond) pthread_cond_broadcast(cond)
+    
+    // Relaxed atomic access and compare-and-swap on plain fields
+    #define platform_atomic_load_u8(ptr) __atomic_load_n((uint8_t*)(ptr), __ATOMIC_RELAXED)
+    #define platform_atomic_store_u8(ptr, value) __atomic_store_n((uint8_t*)(ptr), (uint8_t)(value), __ATOMIC_RELAXED)
+    #define platform_atomic_load_u32(ptr) __atomic_load_n((uint32_t*)(ptr), __ATOMIC_RELAXED)
+    #define platform_atomic_cas_u8(ptr, expected, desired) \
+        __sync_bool_compare_and_swap((uint8_t*)(ptr), (uint8_t)(expected), (uint8_t)(desired))
+    #define platform_atomic_cas_u32(ptr, expected, desired) \
+        __sync_bool_compare_and_swap((uint32_t*)(ptr), (uint32_t)(expected), (uint32_t)(desired))
+    
     // Read-write lock operations
     #define platform_rwlock_init(rwlock) pthread_rwlock_init(rwlock, NULL)
     #define platform_rwlock_destroy(rwlock) pthread_rwlock_destroy(rwlock)
@@ -5,46 +5,11 @@
 #include <stdbool.h>
 #include <unistd.h>
 
-// SwiftLang's actual value types from vm.h
-typedef enum {
-    VAL_BOOL,
-    VAL_NIL,
-    VAL_NUMBER,
-    VAL_STRING,
-    VAL_OBJECT,
-    VAL_FUNCTION,
-    VAL_CLOSURE,
-    VAL_NATIVE,
-    VAL_STRUCT,
-    VAL_MODULE
-} ValueType;
-
-typedef union {
-    bool boolean;
-    double number;
-    char* string;
-    void* object;
-    void* function;
-    void* closure;
-    void* native;
-    void* module;
-} Value;
-
-typedef struct {
-    ValueType type;
-    Value as;
-} TaggedValue;
-
-// Value creation macros
-#define NUMBER_VAL(value) ((TaggedValue){VAL_NUMBER, {.number = value}})
-#define STRING_VAL(value) ((TaggedValue){VAL_STRING, {.string = value}})
-#define NATIVE_VAL(value) ((TaggedValue){VAL_NATIVE, {.native = value}})
-
-// Forward declaration
-typedef struct Module Module;
-
-// Module export function declaration
-extern void module_export(Module* module, const char* name, TaggedValue value);
+// Values cross into the VM as they are, so the module must share its
+// TaggedValue layout (boxed or NaN-boxed) and build with the same flags
+#include "runtime/core/vm.h"
+#include "runtime/core/string_object.h"
+#include "runtime/modules/loader/module_loader.h"
 
 // Native function: get current time as number
 static TaggedValue native_time_now(int arg_count, TaggedValue* args) {
@@ -66,16 +31,16 @@ static TaggedValue native_time_format(int arg_count, TaggedValue* args) {
     static char time_buffer[64];
     strftime(time_buffer, sizeof(time_buffer), "%Y-%m-%d %H:%M:%S", time_info);
     
-    return STRING_VAL(time_buffer);
+    return STRING_VAL(string_copy(time_buffer));
 }
 
 // Native function: sleep for specified seconds
 static TaggedValue native_time_sleep(int arg_count, TaggedValue* args) {
-    if (arg_count < 1 || args[0].type != VAL_NUMBER) {
+    if (arg_count < 1 || !IS_NUMBER(args[0])) {
         return NUMBER_VAL(0.0); // Return 0 on error
     }
     
-    int seconds = (int)args[0].as.number;
+    int seconds = (int)AS_NUMBER(args[0]);
     sleep(seconds);
     
     return NUMBER_VAL((double)seconds);
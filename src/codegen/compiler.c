@@ -1,4 +1,6 @@
 #include "codegen/compiler.h"
+#include "codegen/superinstructions.h"
+#include "codegen/stack_depth.h"
 #include "semantic/visitor.h"
 #include "ast/ast.h"
 #include "runtime/core/vm.h"
@@ -9,6 +11,8 @@
 #include <stdlib.h>
 
 static Compiler* current = NULL;
+static int current_line = 1;  // Line of the statement being compiled
+static bool had_error = false;
 
 // Forward declarations
 static void emit_byte(uint8_t byte);
@@ -19,9 +23,19 @@ static void free_compiler(Compiler* compiler);
 static void init_loop(Loop* loop);
 static void free_loop(Loop* loop);
 static void add_break_jump(Loop* loop, int jump);
+static void compile_return_value(ASTVisitor* visitor, Expr* value);
 
 static void emit_byte(uint8_t byte) {
-    chunk_write(current->current_chunk, byte, 1);
+    chunk_write(current->current_chunk, byte, current_line);
+}
+
+// Compile a statement, attributing its bytecode to the line it is on.
+// Statements the parser did not make keep their enclosing one's.
+static void compile_stmt(Stmt* stmt, ASTVisitor* visitor) {
+    int saved_line = current_line;
+    if (stmt && stmt->line > 0) current_line = stmt->line;
+    ast_accept_stmt(stmt, visitor);
+    current_line = saved_line;
 }
 
 static void emit_bytes(uint8_t byte1, uint8_t byte2) {
@@ -64,6 +78,22 @@ static void emit_loop(int loop_start) {
     emit_short(offset);
 }
 
+// Report an error the program cannot be compiled past; compile() fails
+static void compile_error(const char* message) {
+    fprintf(stderr, "[line %d] Error: %s\n", current_line, message);
+    had_error = true;
+}
+
+// Add a constant that is referred to by a one-byte index
+static int add_constant(TaggedValue value) {
+    int constant = chunk_add_constant(current->current_chunk, value);
+    if (constant > UINT8_MAX) {
+        compile_error("Too many constants in one chunk.");
+        return 0;
+    }
+    return constant;
+}
+
 static void emit_constant(TaggedValue value) {
     if (!current || !current->current_chunk) {
         fprintf(stderr, "ERROR: emit_constant called with NULL current or current_chunk\n");
@@ -72,21 +102,13 @@ static void emit_constant(TaggedValue value) {
     int constant = chunk_add_constant(current->current_chunk, value);
     if (constant < 256) {
         emit_bytes(OP_CONSTANT, constant);
-    } else {
+    } else if (constant <= UINT16_MAX) {
+        // Two-byte index, high byte first, as the VM reads it
         emit_byte(OP_CONSTANT_LONG);
-        emit_byte(constant & 0xff);
-        emit_byte((constant >> 8) & 0xff);
-        emit_byte((constant >> 16) & 0xff);
-    }
-}
-
-static uint8_t make_constant(TaggedValue value) {
-    int constant = chunk_add_constant(current->current_chunk, value);
-    if (constant > UINT8_MAX) {
-        // TODO: Error handling
-        return 0;
+        emit_short((uint16_t)constant);
+    } else {
+        compile_error("Too many constants in one chunk.");
     }
-    return (uint8_t)constant;
 }
 
 static void begin_scope(void) {
@@ -224,11 +246,34 @@ static int resolve_upvalue(Compiler* compiler, const char* name) {
     return -1;
 }
 
-// String creation helpers using string allocator
+// String constants carry a header like every runtime string
 static TaggedValue create_string_value(const char* str) {
-    // Use the string-specific allocator and macro
-    char* vm_str = STR_DUP(str);
-    return (TaggedValue){.type = VAL_STRING, .as.string = vm_str};
+    return STRING_VAL(string_copy(str));
+}
+
+// Names are addressed by a two-byte constant index. Every reference to the
+// same name in a chunk shares one constant, which for a global is also its
+// slot, so the VM binds it once per chunk.
+static uint16_t name_constant(const char* name) {
+    Chunk* chunk = current->current_chunk;
+    for (size_t i = 0; i < chunk->constants.count && i <= UINT16_MAX; i++) {
+        TaggedValue constant = chunk->constants.values[i];
+        if (IS_STRING(constant) && strcmp(AS_STRING(constant), name) == 0) {
+            return (uint16_t)i;
+        }
+    }
+    int constant = chunk_add_constant(chunk, create_string_value(name));
+    if (constant > UINT16_MAX) {
+        compile_error("Too many constants in one chunk.");
+        return 0;
+    }
+    return (uint16_t)constant;
+}
+
+// Emit an instruction whose operand is a name, high byte first
+static void emit_name(uint8_t instruction, const char* name) {
+    emit_byte(instruction);
+    emit_short(name_constant(name));
 }
 
 // Loop tracking with allocator
@@ -279,12 +324,12 @@ static void* compile_literal_expr(ASTVisitor* visitor, Expr* expr) {
             emit_byte(lit->value.boolean ? OP_TRUE : OP_FALSE);
             break;
         case LITERAL_INT: {
-            TaggedValue value = {.type = VAL_NUMBER, .as.number = (double)lit->value.integer};
+            TaggedValue value = NUMBER_VAL((double)lit->value.integer);
             emit_constant(value);
             break;
         }
         case LITERAL_FLOAT: {
-            TaggedValue value = {.type = VAL_NUMBER, .as.number = lit->value.floating};
+            TaggedValue value = NUMBER_VAL(lit->value.floating);
             emit_constant(value);
             break;
         }
@@ -298,9 +343,63 @@ static void* compile_literal_expr(ASTVisitor* visitor, Expr* expr) {
     return NULL;
 }
 
+// Collect the operands of a left-leaning a + b + c ... into `operands`, in
+// order. Returns how many there are, or 0 if the chain has more than `max`.
+static int add_chain_operands(Expr* expr, Expr** operands, int max) {
+    int count = 0;
+    Expr* rest = expr;
+    while (rest->type == EXPR_BINARY && rest->binary.operator.type == TOKEN_PLUS) {
+        if (count == max - 1) return 0;
+        operands[count++] = rest->binary.right;
+        rest = rest->binary.left;
+    }
+    operands[count++] = rest;
+    
+    for (int i = 0, j = count - 1; i < j; i++, j--) {
+        Expr* swap = operands[i];
+        operands[i] = operands[j];
+        operands[j] = swap;
+    }
+    return count;
+}
+
+static bool is_string_expr(Expr* expr) {
+    return (expr->type == EXPR_LITERAL && expr->literal.type == LITERAL_STRING) ||
+           expr->type == EXPR_STRING_INTERP;
+}
+
 static void* compile_binary_expr(ASTVisitor* visitor, Expr* expr) {
     BinaryExpr* bin = &expr->binary;
     
+    // Building a string from three or more pieces: join them all at once
+    // instead of copying the growing prefix at every +. Everything up to the
+    // first string literal is added pairwise (it may be numeric); past it
+    // the sum can only be a string, and each piece not known to be one is
+    // checked before the next is evaluated, as a pairwise + would fail there.
+    if (bin->operator.type == TOKEN_PLUS && bin->left->type == EXPR_BINARY &&
+        bin->left->binary.operator.type == TOKEN_PLUS) {
+        Expr* operands[UINT8_MAX];
+        int count = add_chain_operands(expr, operands, UINT8_MAX);
+        int first = 0;
+        while (first < count && !(operands[first]->type == EXPR_LITERAL &&
+                                  operands[first]->literal.type == LITERAL_STRING)) {
+            first++;
+        }
+        if (count > 0 && count - first >= 3) {
+            ast_accept_expr(operands[0], visitor);
+            for (int i = 1; i <= first; i++) {
+                ast_accept_expr(operands[i], visitor);
+                emit_byte(OP_ADD);
+            }
+            for (int i = first + 1; i < count; i++) {
+                ast_accept_expr(operands[i], visitor);
+                if (!is_string_expr(operands[i])) emit_byte(OP_EXPECT_STRING);
+            }
+            emit_bytes(OP_ADD_CHAIN, (uint8_t)(count - first));
+            return NULL;
+        }
+    }
+    
     // Compile left operand
     ast_accept_expr(bin->left, visitor);
     
@@ -383,9 +482,7 @@ static void* compile_variable_expr(ASTVisitor* visitor, Expr* expr) {
     }
     
     // Must be global
-    int name_constant = chunk_add_constant(current->current_chunk, 
-        create_string_value(var->name));
-    emit_bytes(OP_GET_GLOBAL, name_constant);
+    emit_name(OP_GET_GLOBAL_SLOT, var->name);
     
     return NULL;
 }
@@ -411,9 +508,7 @@ static void* compile_assignment_expr(ASTVisitor* visitor, Expr* expr) {
                 emit_bytes(OP_SET_UPVALUE, (uint8_t)upvalue);
             } else {
                 // Must be global
-                int name_constant = chunk_add_constant(current->current_chunk,
-                    create_string_value(var->name));
-                emit_bytes(OP_SET_GLOBAL, name_constant);
+                emit_name(OP_SET_GLOBAL_SLOT, var->name);
             }
         }
     } else if (assign->target->type == EXPR_SUBSCRIPT) {
@@ -457,13 +552,18 @@ static void* compile_assignment_expr(ASTVisitor* visitor, Expr* expr) {
 static void* compile_array_literal_expr(ASTVisitor* visitor, Expr* expr) {
     ArrayLiteralExpr* array = &expr->array_literal;
     
-    // Compile all elements
-    for (size_t i = 0; i < array->element_count; i++) {
-        ast_accept_expr(array->elements[i], visitor);
-    }
-    
-    // Emit array creation instruction
-    emit_bytes(OP_ARRAY, array->element_count);
+    // The count is a byte, so longer literals are built 255 elements at a
+    // time: the first batch makes the array, the rest are appended to it
+    size_t done = 0;
+    do {
+        size_t batch = array->element_count - done;
+        if (batch > UINT8_MAX) batch = UINT8_MAX;
+        for (size_t i = done; i < done + batch; i++) {
+            ast_accept_expr(array->elements[i], visitor);
+        }
+        emit_bytes(done == 0 ? OP_ARRAY : OP_ARRAY_APPEND, (uint8_t)batch);
+        done += batch;
+    } while (done < array->element_count);
     
     return NULL;
 }
@@ -523,14 +623,14 @@ static void* compile_closure_expr(ASTVisitor* visitor, Expr* expr) {
             // Single expression statement - we'll add implicit return
             needs_implicit_return = true;
             // Compile the expression
-            ast_accept_expr(block->statements[0]->expression.expression, visitor);
+            compile_return_value(visitor, block->statements[0]->expression.expression);
         } else {
             // Multiple statements or non-expression - compile normally
-            ast_accept_stmt(closure->body, visitor);
+            compile_stmt(closure->body, visitor);
         }
     } else {
         // Not a block statement, compile normally
-        ast_accept_stmt(closure->body, visitor);
+        compile_stmt(closure->body, visitor);
     }
     
     // Emit return
@@ -548,7 +648,7 @@ static void* compile_closure_expr(ASTVisitor* visitor, Expr* expr) {
     current = enclosing;
     
     // Add the function as a constant
-    TaggedValue func_val = {.type = VAL_FUNCTION, .as.function = closure_compiler.function};
+    TaggedValue func_val = FUNCTION_VAL(closure_compiler.function);
     int constant = chunk_add_constant(current->current_chunk, func_val);
     
     // Emit closure creation instruction with the function constant
@@ -593,6 +693,10 @@ static void* compile_closure_expr(ASTVisitor* visitor, Expr* expr) {
 static void* compile_call_expr(ASTVisitor* visitor, Expr* expr) {
     CallExpr* call = &expr->call;
     
+    if (call->argument_count > UINT8_MAX) {
+        fprintf(stderr, "Can't have more than 255 arguments.\n");
+    }
+    
     // Check if this is a method call (callee is a member expression)
     if (call->callee->type == EXPR_MEMBER) {
         MemberExpr* member = &call->callee->member;
@@ -600,28 +704,15 @@ static void* compile_call_expr(ASTVisitor* visitor, Expr* expr) {
         // Compile the object (this will be the first argument)
         ast_accept_expr(member->object, visitor);
         
-        // Duplicate the object on the stack
-        emit_byte(OP_DUP);
-        
-        // Push property name
-        TaggedValue prop = create_string_value(member->property);
-        emit_constant(prop);
-        
-        // Get the method
-        emit_byte(OP_GET_PROPERTY);
-        
-        // Now we have: [object, method] on stack
-        // We need: [method, object, ...args]
-        // So we swap them
-        emit_byte(OP_SWAP);
-        
-        // Compile remaining arguments
+        // Compile arguments
         for (size_t i = 0; i < call->argument_count; i++) {
             ast_accept_expr(call->arguments[i], visitor);
         }
         
-        // Call as a method (the VM will handle binding 'self')
+        // Look up and call the method in one instruction: the VM places the
+        // method below the receiver, which becomes the first argument
         emit_bytes(OP_METHOD_CALL, call->argument_count);
+        emit_short(name_constant(member->property));
     } else {
         // Regular function call
         ast_accept_expr(call->callee, visitor);
@@ -660,17 +751,7 @@ static void* compile_member_expr(ASTVisitor* visitor, Expr* expr) {
     ast_accept_expr(member->object, visitor);
     
     // Push property name as constant
-    TaggedValue prop = create_string_value(member->property);
-    int prop_const = chunk_add_constant(current->current_chunk, prop);
-    
-    // Emit the constant
-    if (prop_const < 256) {
-        emit_bytes(OP_CONSTANT, prop_const);
-    } else {
-        emit_byte(OP_CONSTANT_LONG);
-        emit_byte(prop_const & 0xff);
-        emit_byte((prop_const >> 8) & 0xff);
-    }
+    emit_constant(create_string_value(member->property));
     
     // Emit property get instruction
     emit_byte(OP_GET_PROPERTY);
@@ -910,9 +991,7 @@ static void* compile_var_decl_stmt(ASTVisitor* visitor, Stmt* stmt) {
         mark_initialized();
     } else {
         // Define global variable
-        int name_constant = chunk_add_constant(current->current_chunk,
-            create_string_value(var_decl->name));
-        emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+        emit_name(OP_DEFINE_GLOBAL, var_decl->name);
     }
     
     return NULL;
@@ -925,7 +1004,7 @@ static void* compile_block_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Compile all statements in the block
     for (size_t i = 0; i < block->statement_count; i++) {
-        ast_accept_stmt(block->statements[i], visitor);
+        compile_stmt(block->statements[i], visitor);
     }
     
     end_scope();
@@ -944,7 +1023,7 @@ static void* compile_if_stmt(ASTVisitor* visitor, Stmt* stmt) {
     emit_byte(OP_POP);  // Pop condition
     
     // Compile then branch
-    ast_accept_stmt(if_stmt->then_branch, visitor);
+    compile_stmt(if_stmt->then_branch, visitor);
     
     int else_jump = emit_jump(OP_JUMP);
     
@@ -953,7 +1032,7 @@ static void* compile_if_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Compile else branch if present
     if (if_stmt->else_branch) {
-        ast_accept_stmt(if_stmt->else_branch, visitor);
+        compile_stmt(if_stmt->else_branch, visitor);
     }
     
     patch_jump(else_jump);
@@ -978,7 +1057,7 @@ static void* compile_while_stmt(ASTVisitor* visitor, Stmt* stmt) {
     emit_byte(OP_POP);  // Pop condition
     
     // Compile body
-    ast_accept_stmt(while_stmt->body, visitor);
+    compile_stmt(while_stmt->body, visitor);
     
     // Loop back
     emit_loop(loop_start);
@@ -1032,7 +1111,7 @@ static void* compile_for_in_stmt(ASTVisitor* visitor, Stmt* stmt) {
     mark_initialized();
     
     // Execute body
-    ast_accept_stmt(for_in->body, visitor);
+    compile_stmt(for_in->body, visitor);
     
     // End scope (pops loop variable)
     end_scope();
@@ -1072,7 +1151,7 @@ static void* compile_for_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Compile initializer
     if (for_stmt->initializer) {
-        ast_accept_stmt(for_stmt->initializer, visitor);
+        compile_stmt(for_stmt->initializer, visitor);
     }
     
     // Loop start (for continue statements)
@@ -1088,7 +1167,7 @@ static void* compile_for_stmt(ASTVisitor* visitor, Stmt* stmt) {
     }
     
     // Execute body
-    ast_accept_stmt(for_stmt->body, visitor);
+    compile_stmt(for_stmt->body, visitor);
     
     // Continue target (increment expression)
     loop.start = current->current_chunk->count;
@@ -1123,11 +1202,24 @@ static void* compile_for_stmt(ASTVisitor* visitor, Stmt* stmt) {
     return NULL;
 }
 
+// Compile the value of a return. A plain call in this position becomes
+// OP_TAIL_CALL, which reuses the returning frame for the callee; the
+// OP_RETURN after it still runs when the callee turns out to be native.
+static void compile_return_value(ASTVisitor* visitor, Expr* value) {
+    ast_accept_expr(value, visitor);
+
+    if (current->type == FUNC_TYPE_FUNCTION && value->type == EXPR_CALL &&
+        value->call.callee->type != EXPR_MEMBER) {
+        Chunk* chunk = current->current_chunk;
+        chunk->code[chunk->count - 2] = OP_TAIL_CALL;
+    }
+}
+
 static void* compile_return_stmt(ASTVisitor* visitor, Stmt* stmt) {
     ReturnStmt* ret = &stmt->return_stmt;
     
     if (ret->expression) {
-        ast_accept_expr(ret->expression, visitor);
+        compile_return_value(visitor, ret->expression);
     } else {
         emit_byte(OP_NIL);
     }
@@ -1233,7 +1325,7 @@ static void* compile_function_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Compile the function body
     if (func->body) {
-        ast_accept_stmt(func->body, visitor);
+        compile_stmt(func->body, visitor);
     }
     
     // Emit return if not already present
@@ -1284,17 +1376,12 @@ static void* compile_function_stmt(ASTVisitor* visitor, Stmt* stmt) {
         // fprintf(stderr, "DEBUG: In module compilation mode\n");
         // Store in module scope but don't make global
         // The module execution will handle storing in module scope
-        int name_constant = chunk_add_constant(current->current_chunk,
-            create_string_value(func->name));
-        // fprintf(stderr, "DEBUG: Added name constant: %d\n", name_constant);
         // Use SET_GLOBAL which will be intercepted by module execution
-        emit_bytes(OP_SET_GLOBAL, name_constant);
+        emit_name(OP_SET_GLOBAL, func->name);
         // fprintf(stderr, "DEBUG: Emitted SET_GLOBAL\n");
     } else {
         // In scripts, functions are global
-        int name_constant = chunk_add_constant(current->current_chunk,
-            create_string_value(func->name));
-        emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+        emit_name(OP_DEFINE_GLOBAL, func->name);
     }
     
     // Check if this is an extension method (name contains "_ext_")
@@ -1344,9 +1431,9 @@ static void* compile_function_stmt(ASTVisitor* visitor, Stmt* stmt) {
         fprintf(stderr, "[DEBUG] About to emit method name constant: %s\n", method_name);
         emit_constant(create_string_value(method_name));
         
-        // Push the function value again
+        // Push the closure that was just stored under the function's name
         fprintf(stderr, "[DEBUG] About to emit function value constant\n");
-        emit_constant(func_val);
+        emit_name(OP_GET_GLOBAL_SLOT, func->name);
         
         // Set property on prototype
         fprintf(stderr, "[DEBUG] About to emit OP_SET_PROPERTY\n");
@@ -1458,7 +1545,7 @@ static void* compile_class_stmt(ASTVisitor* visitor, Stmt* stmt) {
             }
             
             // Compile method body
-            ast_accept_stmt(method->body, visitor);
+            compile_stmt(method->body, visitor);
             
             // Emit return if needed
             if (method_compiler.function->chunk.count == 0 || 
@@ -1495,9 +1582,7 @@ static void* compile_class_stmt(ASTVisitor* visitor, Stmt* stmt) {
     TaggedValue ctor_val = FUNCTION_VAL(ctor_compiler.function);
     emit_constant(ctor_val);
     
-    int name_constant = chunk_add_constant(current->current_chunk,
-        create_string_value(class->name));
-    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+    emit_name(OP_DEFINE_GLOBAL, class->name);
     
     // Clean up constructor compiler
     free_compiler(&ctor_compiler);
@@ -1531,7 +1616,7 @@ static void* compile_struct_stmt(ASTVisitor* visitor, Stmt* stmt) {
     emit_byte(OP_DEFINE_STRUCT);
     
     // Add struct name as a constant
-    int name_const = chunk_add_constant(current->current_chunk, 
+    int name_const = add_constant(
         create_string_value(struct_decl->name));
     emit_byte(name_const);
     
@@ -1540,7 +1625,7 @@ static void* compile_struct_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Emit field names as inline constants
     for (size_t i = 0; i < field_count; i++) {
-        int field_const = chunk_add_constant(current->current_chunk,
+        int field_const = add_constant(
             create_string_value(field_names[i]));
         emit_byte(field_const);
     }
@@ -1570,7 +1655,7 @@ static void* compile_struct_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Create struct instance
     emit_byte(OP_CREATE_STRUCT);
-    int struct_name_const = chunk_add_constant(current->current_chunk,
+    int struct_name_const = add_constant(
         create_string_value(struct_decl->name));
     emit_byte(struct_name_const);
     
@@ -1582,9 +1667,7 @@ static void* compile_struct_stmt(ASTVisitor* visitor, Stmt* stmt) {
     
     // Define the constructor as a global function
     emit_constant(FUNCTION_VAL(struct_compiler.function));
-    int name_constant = chunk_add_constant(current->current_chunk,
-        create_string_value(struct_decl->name));
-    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+    emit_name(OP_DEFINE_GLOBAL, struct_decl->name);
     
     // Clean up
     SLANG_MEM_FREE(alloc, field_names, sizeof(char*) * field_count);
@@ -1640,9 +1723,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     emit_byte(OP_LOAD_BUILTIN);
                     
                     // Define as global
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(local_name));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, local_name);
                 }
                 break;
                 
@@ -1661,9 +1742,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     
                     emit_byte(OP_LOAD_BUILTIN);
                     
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(import->default_name));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, import->default_name);
                 }
                 break;
                 
@@ -1675,7 +1754,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
         // Handle file-based modules
         // First, add module path as a constant
         TaggedValue module_path_val = create_string_value(module_name);
-        int path_constant = chunk_add_constant(current->current_chunk, module_path_val);
+        int path_constant = add_constant(module_path_val);
         
         // Emit OP_LOAD_MODULE with the constant index
         emit_bytes(OP_LOAD_MODULE, path_constant);
@@ -1694,15 +1773,13 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     
                     // Add export name as constant and emit OP_IMPORT_FROM with index
                     TaggedValue export_str = create_string_value(export_name);
-                    int export_constant = chunk_add_constant(current->current_chunk, export_str);
+                    int export_constant = add_constant(export_str);
                     
                     // Get export from module
                     emit_bytes(OP_IMPORT_FROM, export_constant);
                     
                     // Define as global
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(local_name));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, local_name);
                 }
                 // Pop the module object
                 emit_byte(OP_POP);
@@ -1712,14 +1789,10 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                 // import module or import module as alias or import * from module
                 if (import->alias) {
                     // import module as alias
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(import->alias));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, import->alias);
                 } else if (import->namespace_alias) {
                     // Old style: import * as name from module
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(import->namespace_alias));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, import->namespace_alias);
                 } else if (import->import_all_to_scope) {
                     // import * from module - import all exports into current scope
                     emit_byte(OP_IMPORT_ALL_FROM);
@@ -1748,9 +1821,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                         module_simple_name = slash + 1;
                     }
                     
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(module_simple_name));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, module_simple_name);
                 }
                 break;
                 
@@ -1765,9 +1836,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     emit_byte(OP_IMPORT_FROM);
                     
                     // Define as global
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(import->default_name));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, import->default_name);
                 } else {
                     // Pop the module if no default name
                     emit_byte(OP_POP);
@@ -1777,9 +1846,7 @@ static void* compile_import_stmt(ASTVisitor* visitor, Stmt* stmt) {
             case IMPORT_NAMESPACE:
                 // import * as namespace from 'module'
                 if (import->namespace_alias) {
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(import->namespace_alias));
-                    emit_bytes(OP_DEFINE_GLOBAL, name_constant);
+                    emit_name(OP_DEFINE_GLOBAL, import->namespace_alias);
                 } else {
                     emit_byte(OP_POP);
                 }
@@ -1803,22 +1870,15 @@ static void* compile_export_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     const char* export_name = export->named_export.specifiers[i].alias ? 
                         export->named_export.specifiers[i].alias : export->named_export.specifiers[i].name;
                     
-                    // Push the export name
-                    TaggedValue export_str = create_string_value(export_name);
-                    emit_constant(export_str);
-                    
                     // Get the local value
                     int local = resolve_local(current, local_name);
                     if (local != -1) {
                         emit_bytes(OP_GET_LOCAL, (uint8_t)local);
                     } else {
-                        int name_constant = chunk_add_constant(current->current_chunk,
-                            create_string_value(local_name));
-                        emit_bytes(OP_GET_GLOBAL, name_constant);
+                        emit_name(OP_GET_GLOBAL, local_name);
                     }
                     
-                    // Use the new MODULE_EXPORT opcode
-                    emit_byte(OP_MODULE_EXPORT);
+                    emit_name(OP_MODULE_EXPORT, export_name);
                 }
             }
             break;
@@ -1826,22 +1886,15 @@ static void* compile_export_stmt(ASTVisitor* visitor, Stmt* stmt) {
         case EXPORT_DEFAULT:
             // export default expression
             if (export->default_export.name) {
-                // Push "default" as export name
-                TaggedValue default_str = create_string_value("default");
-                emit_constant(default_str);
-                
                 // Get the value to export
                 int local = resolve_local(current, export->default_export.name);
                 if (local != -1) {
                     emit_bytes(OP_GET_LOCAL, (uint8_t)local);
                 } else {
-                    int name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(export->default_export.name));
-                    emit_bytes(OP_GET_GLOBAL, name_constant);
+                    emit_name(OP_GET_GLOBAL, export->default_export.name);
                 }
                 
-                // Use the new MODULE_EXPORT opcode
-                emit_byte(OP_MODULE_EXPORT);
+                emit_name(OP_MODULE_EXPORT, "default");
             }
             break;
             
@@ -1856,7 +1909,7 @@ static void* compile_export_stmt(ASTVisitor* visitor, Stmt* stmt) {
                 Stmt* decl = (Stmt*)export->decl_export.declaration;
                 
                 // First compile the declaration
-                ast_accept_stmt(decl, visitor);
+                compile_stmt(decl, visitor);
                 
                 // Extract the name from the declaration and export it
                 const char* export_name = NULL;
@@ -1873,15 +1926,10 @@ static void* compile_export_stmt(ASTVisitor* visitor, Stmt* stmt) {
                     if (local != -1) {
                         emit_bytes(OP_GET_LOCAL, (uint8_t)local);
                     } else {
-                        int name_constant = chunk_add_constant(current->current_chunk,
-                            create_string_value(export_name));
-                        emit_bytes(OP_GET_GLOBAL, name_constant);
+                        emit_name(OP_GET_GLOBAL, export_name);
                     }
                     
-                    // Add export name as constant for OP_MODULE_EXPORT
-                    int export_name_constant = chunk_add_constant(current->current_chunk,
-                        create_string_value(export_name));
-                    emit_bytes(OP_MODULE_EXPORT, export_name_constant);
+                    emit_name(OP_MODULE_EXPORT, export_name);
                 }
             }
             break;
@@ -1910,6 +1958,8 @@ bool compile(ProgramNode* program, Chunk* chunk) {
     compiler.upvalues.capacity = 8;
     compiler.upvalues.values = MEM_NEW_ARRAY(alloc, CompilerUpvalue, compiler.upvalues.capacity);
     
+    had_error = false;
+    
     // Create function - but DON'T initialize its chunk, use the provided one
     Allocator* vm_alloc = allocators_get(ALLOC_SYSTEM_VM);
     compiler.function = MEM_NEW(vm_alloc, Function);
@@ -1987,7 +2037,7 @@ bool compile(ProgramNode* program, Chunk* chunk) {
             program->statements[i]->type == STMT_EXPRESSION) {
             compiler.is_last_expr_stmt = true;
         }
-        ast_accept_stmt(program->statements[i], &visitor);
+        compile_stmt(program->statements[i], &visitor);
         // Ensure we're still using the right chunk after each statement
         compiler.current_chunk = chunk;
         current->current_chunk = chunk;
@@ -2005,6 +2055,11 @@ bool compile(ProgramNode* program, Chunk* chunk) {
     free_compiler(&compiler);
     
     current = NULL;
+    if (had_error) {
+        return false;
+    }
+    chunk_measure_stack(chunk);
+    chunk_fuse_superinstructions(chunk);
     return true;
 }
 
@@ -2028,6 +2083,8 @@ bool compile_module(ProgramNode* program, Chunk* chunk, Module* module) {
     compiler.upvalues.capacity = 8;
     compiler.upvalues.values = MEM_NEW_ARRAY(alloc, CompilerUpvalue, compiler.upvalues.capacity);
     
+    had_error = false;
+    
     // Create function - but DON'T initialize its chunk, use the provided one
     Allocator* vm_alloc = allocators_get(ALLOC_SYSTEM_VM);
     compiler.function = MEM_NEW(vm_alloc, Function);
@@ -2104,7 +2161,7 @@ bool compile_module(ProgramNode* program, Chunk* chunk, Module* module) {
             program->statements[i]->type == STMT_EXPRESSION) {
             compiler.is_last_expr_stmt = true;
         }
-        ast_accept_stmt(program->statements[i], &visitor);
+        compile_stmt(program->statements[i], &visitor);
         // Ensure we're still using the right chunk after each statement
         compiler.current_chunk = chunk;
         current->current_chunk = chunk;
@@ -2122,5 +2179,10 @@ bool compile_module(ProgramNode* program, Chunk* chunk, Module* module) {
     free_compiler(&compiler);
     
     current = NULL;
+    if (had_error) {
+        return false;
+    }
+    chunk_measure_stack(chunk);
+    chunk_fuse_superinstructions(chunk);
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,217 @@
+#include "codegen/stack_depth.h"
+#include "codegen/superinstructions.h"
+#include "utils/allocators.h"
+#include <stdbool.h>
+
+// Values the instruction at `offset` leaves on the stack, less those it takes
+static int stack_effect(const Chunk* chunk, size_t offset) {
+    switch (chunk->code[offset]) {
+        case OP_CONSTANT:
+        case OP_CONSTANT_LONG:
+        case OP_NIL:
+        case OP_TRUE:
+        case OP_FALSE:
+        case OP_DUP:
+        case OP_GET_LOCAL:
+        case OP_GET_GLOBAL:
+        case OP_GET_GLOBAL_SLOT:
+        case OP_GET_UPVALUE:
+        case OP_CLOSURE:
+        case OP_CLOSURE_LONG:
+        case OP_CREATE_OBJECT:
+        case OP_LOAD_MODULE:
+        case OP_GET_OBJECT_PROTO:
+        case OP_GET_STRUCT_PROTO:
+            return 1;
+
+        case OP_GET_LOCAL_PAIR:
+        case OP_GET_LOCAL_CONSTANT:
+            return 2;
+
+        case OP_POP:
+        case OP_ADD:
+        case OP_SUBTRACT:
+        case OP_MULTIPLY:
+        case OP_DIVIDE:
+        case OP_MODULO:
+        case OP_POWER:
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_ADD_NUM:
+        case OP_SUBTRACT_NUM:
+        case OP_MULTIPLY_NUM:
+        case OP_GREATER_NUM:
+        case OP_GREATER_EQUAL_NUM:
+        case OP_LESS_NUM:
+        case OP_LESS_EQUAL_NUM:
+        case OP_ADD_GENERIC:
+        case OP_SUBTRACT_GENERIC:
+        case OP_MULTIPLY_GENERIC:
+        case OP_GREATER_GENERIC:
+        case OP_GREATER_EQUAL_GENERIC:
+        case OP_LESS_GENERIC:
+        case OP_LESS_EQUAL_GENERIC:
+        case OP_AND:
+        case OP_OR:
+        case OP_BIT_AND:
+        case OP_BIT_OR:
+        case OP_BIT_XOR:
+        case OP_SHIFT_LEFT:
+        case OP_SHIFT_RIGHT:
+        case OP_STRING_CONCAT:
+        case OP_DEFINE_GLOBAL:
+        case OP_CLOSE_UPVALUE:
+        case OP_GET_SUBSCRIPT:
+        case OP_GET_PROPERTY:
+        case OP_SET_LOCAL_POP:
+        case OP_JUMP_IF_FALSE_POP:
+        case OP_RETURN:
+            return -1;
+
+        case OP_SET_SUBSCRIPT:
+        case OP_SET_PROPERTY:
+            return -2;
+
+        // The callee, or the receiver, is replaced by the result
+        case OP_CALL:
+        case OP_TAIL_CALL:
+        case OP_METHOD_CALL:
+        case OP_ARRAY_APPEND:
+            return -(int)chunk->code[offset + 1];
+
+        case OP_ARRAY:
+        case OP_BUILD_ARRAY:
+        case OP_ADD_CHAIN:
+        case OP_STRING_INTERP:
+            return 1 - (int)chunk->code[offset + 1];
+
+        case OP_OBJECT_LITERAL:
+            return 1 - 2 * (int)chunk->code[offset + 1];
+
+        // Replace the top value, only look at it, or have no handler
+        default:
+            return 0;
+    }
+}
+
+static uint16_t jump_offset(const Chunk* chunk, size_t offset) {
+    return (uint16_t)((chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+}
+
+// Record `depth` for the instruction at `target`, queueing it if that is
+// deeper than any path there so far. False if the code is not well formed.
+static bool reach(int* depths, size_t* pending, size_t* pending_count,
+                  size_t count, size_t target, int depth) {
+    if (target == count) {
+        return true;  // Falls off the end; the VM never gets here
+    }
+    if (target > count || depth > (int)VM_STACK_LIMIT) {
+        return false;
+    }
+    if (depths[target] >= depth) {
+        return true;
+    }
+    // First reached, or deeper than before so that its successors need
+    // another look
+    depths[target] = depth;
+    pending[(*pending_count)++] = target;
+    return true;
+}
+
+size_t chunk_max_stack(const Chunk* chunk) {
+    size_t count = chunk->count;
+    if (count == 0) {
+        return 0;
+    }
+
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_COMPILER);
+    int* depths = MEM_ALLOC(alloc, count * sizeof(int));
+    // An instruction is queued once per increase of its depth, which in
+    // well-formed code means once; the bound keeps the rest from overrunning
+    size_t pending_capacity = 4 * count;
+    size_t* pending = MEM_ALLOC(alloc, pending_capacity * sizeof(size_t));
+    if (!depths || !pending) {
+        if (depths) SLANG_MEM_FREE(alloc, depths, count * sizeof(int));
+        if (pending) SLANG_MEM_FREE(alloc, pending, pending_capacity * sizeof(size_t));
+        return 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        depths[i] = -1;
+    }
+
+    size_t pending_count = 0;
+    int max_depth = 0;
+    bool ok = reach(depths, pending, &pending_count, count, 0, 0);
+
+    while (ok && pending_count > 0) {
+        size_t offset = pending[--pending_count];
+        int depth = depths[offset];
+        size_t length = chunk_instruction_length(chunk, offset);
+        if (length == 0 || offset + length > count) {
+            ok = false;
+            break;
+        }
+
+        int after = depth + stack_effect(chunk, offset);
+        if (after < 0) {
+            after = 0;
+        }
+        if (after > max_depth) {
+            max_depth = after;
+        }
+
+        // Leave room for two pushes before the queue could overflow
+        if (pending_count + 2 > pending_capacity) {
+            ok = false;
+            break;
+        }
+
+        size_t next = offset + length;
+        switch (chunk->code[offset]) {
+            case OP_RETURN:
+            case OP_HALT:
+                break;
+            case OP_JUMP:
+                ok = reach(depths, pending, &pending_count, count,
+                           next + jump_offset(chunk, offset), after);
+                break;
+            case OP_LOOP:
+                ok = reach(depths, pending, &pending_count, count,
+                           next - jump_offset(chunk, offset), after);
+                break;
+            case OP_JUMP_IF_FALSE:
+            case OP_JUMP_IF_TRUE:
+                ok = reach(depths, pending, &pending_count, count, next, after) &&
+                     reach(depths, pending, &pending_count, count,
+                           offset + 3 + jump_offset(chunk, offset), after);
+                break;
+            case OP_JUMP_IF_FALSE_POP:
+                // Both paths skip a POP: the next instruction and the target
+                ok = reach(depths, pending, &pending_count, count, next, after) &&
+                     reach(depths, pending, &pending_count, count,
+                           offset + 3 + jump_offset(chunk, offset) + 1, after);
+                break;
+            default:
+                ok = reach(depths, pending, &pending_count, count, next, after);
+                break;
+        }
+    }
+
+    SLANG_MEM_FREE(alloc, depths, count * sizeof(int));
+    SLANG_MEM_FREE(alloc, pending, pending_capacity * sizeof(size_t));
+    return ok ? (size_t)max_depth : 0;
+}
+
+void chunk_measure_stack(Chunk* chunk) {
+    chunk->max_stack = chunk_max_stack(chunk);
+
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        if (IS_FUNCTION(chunk->constants.values[i])) {
+            chunk_measure_stack(&AS_FUNCTION(chunk->constants.values[i])->chunk);
+        }
+    }
+}
@@ -0,0 +1,229 @@
+#include "codegen/superinstructions.h"
+#include <stdbool.h>
+
+/*
+ * The fused sequences were picked from opcode traces (--debug-trace) of
+ * recursive and loop-heavy functions, where they account for most of the
+ * executed pairs:
+ *
+ *   GET_LOCAL a; GET_LOCAL b       -> OP_GET_LOCAL_PAIR      (a + b, i < n)
+ *   GET_LOCAL a; CONSTANT k        -> OP_GET_LOCAL_CONSTANT  (i + 1, n < 2)
+ *   SET_LOCAL a; POP               -> OP_SET_LOCAL_POP       (assignment statements)
+ *   JUMP_IF_FALSE off; POP         -> OP_JUMP_IF_FALSE_POP   (if/while conditions)
+ *
+ * Script-level code is dominated by global slot accesses whose cache checks
+ * would have to be duplicated into every fused form, so globals are left alone.
+ */
+
+static size_t closure_length(const Chunk* chunk, size_t offset, size_t header) {
+    uint32_t index;
+    if (chunk->code[offset] == OP_CLOSURE) {
+        index = chunk->code[offset + 1];
+    } else {
+        index = ((uint32_t)chunk->code[offset + 1] << 16) |
+                ((uint32_t)chunk->code[offset + 2] << 8) |
+                chunk->code[offset + 3];
+    }
+    if (index >= chunk->constants.count || !IS_FUNCTION(chunk->constants.values[index])) {
+        return 0;
+    }
+    return header + 2 * (size_t)AS_FUNCTION(chunk->constants.values[index])->upvalue_count;
+}
+
+size_t chunk_instruction_length(const Chunk* chunk, size_t offset) {
+    switch (chunk->code[offset]) {
+        case OP_NIL:
+        case OP_TRUE:
+        case OP_FALSE:
+        case OP_POP:
+        case OP_DUP:
+        case OP_SWAP:
+        case OP_ADD:
+        case OP_SUBTRACT:
+        case OP_MULTIPLY:
+        case OP_DIVIDE:
+        case OP_MODULO:
+        case OP_POWER:
+        case OP_NEGATE:
+        case OP_EQUAL:
+        case OP_NOT_EQUAL:
+        case OP_GREATER:
+        case OP_GREATER_EQUAL:
+        case OP_LESS:
+        case OP_LESS_EQUAL:
+        case OP_NOT:
+        case OP_AND:
+        case OP_OR:
+        case OP_BIT_AND:
+        case OP_BIT_OR:
+        case OP_BIT_XOR:
+        case OP_BIT_NOT:
+        case OP_SHIFT_LEFT:
+        case OP_SHIFT_RIGHT:
+        case OP_CLOSE_UPVALUE:
+        case OP_RETURN:
+        case OP_LOAD_BUILTIN:
+        case OP_GET_SUBSCRIPT:
+        case OP_SET_SUBSCRIPT:
+        case OP_CREATE_OBJECT:
+        case OP_GET_PROPERTY:
+        case OP_SET_PROPERTY:
+        case OP_SET_PROTOTYPE:
+        case OP_OPTIONAL_CHAIN:
+        case OP_FORCE_UNWRAP:
+        case OP_GET_ITER:
+        case OP_FOR_ITER:
+        case OP_AWAIT:
+        case OP_IMPORT_ALL_FROM:
+        case OP_LOAD_NATIVE_MODULE:
+        case OP_TO_STRING:
+        case OP_STRING_CONCAT:
+        case OP_INTERN_STRING:
+        case OP_EXPECT_STRING:
+        case OP_LENGTH:
+        case OP_HALT:
+        case OP_ADD_NUM:
+        case OP_SUBTRACT_NUM:
+        case OP_MULTIPLY_NUM:
+        case OP_GREATER_NUM:
+        case OP_GREATER_EQUAL_NUM:
+        case OP_LESS_NUM:
+        case OP_LESS_EQUAL_NUM:
+        case OP_ADD_GENERIC:
+        case OP_SUBTRACT_GENERIC:
+        case OP_MULTIPLY_GENERIC:
+        case OP_GREATER_GENERIC:
+        case OP_GREATER_EQUAL_GENERIC:
+        case OP_LESS_GENERIC:
+        case OP_LESS_EQUAL_GENERIC:
+            return 1;
+
+        case OP_CONSTANT:
+        case OP_GET_LOCAL:
+        case OP_SET_LOCAL:
+        case OP_GET_UPVALUE:
+        case OP_SET_UPVALUE:
+        case OP_CALL:
+        case OP_TAIL_CALL:
+        case OP_ARRAY:
+        case OP_BUILD_ARRAY:
+        case OP_CREATE_STRUCT:
+        case OP_GET_FIELD:
+        case OP_SET_FIELD:
+        case OP_GET_OBJECT_PROTO:
+        case OP_GET_STRUCT_PROTO:
+        case OP_DEFINE_LOCAL:
+        case OP_LOAD_MODULE:
+        case OP_IMPORT_FROM:
+        case OP_STRING_INTERP:
+        case OP_ADD_CHAIN:
+        case OP_ARRAY_APPEND:
+        case OP_OBJECT_LITERAL:
+            return 2;
+
+        case OP_JUMP:
+        case OP_JUMP_IF_FALSE:
+        case OP_JUMP_IF_TRUE:
+        case OP_LOOP:
+        case OP_CONSTANT_LONG:
+        case OP_GET_GLOBAL:
+        case OP_SET_GLOBAL:
+        case OP_DEFINE_GLOBAL:
+        case OP_GET_GLOBAL_SLOT:
+        case OP_SET_GLOBAL_SLOT:
+        case OP_MODULE_EXPORT:
+        case OP_SET_LOCAL_POP:
+            return 3;
+
+        case OP_METHOD_CALL:
+        case OP_GET_LOCAL_PAIR:
+        case OP_GET_LOCAL_CONSTANT:
+        case OP_JUMP_IF_FALSE_POP:
+            return 4;
+
+        case OP_DEFINE_STRUCT:
+            return 3 + (size_t)chunk->code[offset + 2];
+        case OP_CLOSURE:
+            return closure_length(chunk, offset, 2);
+        case OP_CLOSURE_LONG:
+            return closure_length(chunk, offset, 4);
+
+        default:
+            return 0;
+    }
+}
+
+// Rewrite the sequence starting at `offset`; returns the bytes it covers
+static size_t fuse_at(Chunk* chunk, size_t offset) {
+    uint8_t* code = chunk->code;
+    size_t remaining = chunk->count - offset;
+
+    switch (code[offset]) {
+        case OP_GET_LOCAL:
+            if (remaining >= 4 && code[offset + 2] == OP_GET_LOCAL) {
+                code[offset] = OP_GET_LOCAL_PAIR;
+                return 4;
+            }
+            if (remaining >= 4 && code[offset + 2] == OP_CONSTANT) {
+                code[offset] = OP_GET_LOCAL_CONSTANT;
+                return 4;
+            }
+            break;
+
+        case OP_SET_LOCAL:
+            if (remaining >= 3 && code[offset + 2] == OP_POP) {
+                code[offset] = OP_SET_LOCAL_POP;
+                return 3;
+            }
+            break;
+
+        case OP_JUMP_IF_FALSE: {
+            // The fused form pops the condition on both paths, so the jump
+            // target must be the POP the compiler emits for the false branch
+            if (remaining < 4 || code[offset + 3] != OP_POP) {
+                break;
+            }
+            size_t target = offset + 3 + (((size_t)code[offset + 1] << 8) | code[offset + 2]);
+            if (target < chunk->count && code[target] == OP_POP) {
+                code[offset] = OP_JUMP_IF_FALSE_POP;
+                return 4;
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+    return 0;
+}
+
+// True if the chunk decodes instruction by instruction to exactly its end
+static bool chunk_decodes(const Chunk* chunk) {
+    size_t offset = 0;
+    while (offset < chunk->count) {
+        size_t length = chunk_instruction_length(chunk, offset);
+        if (length == 0) {
+            return false;
+        }
+        offset += length;
+    }
+    return offset == chunk->count;
+}
+
+void chunk_fuse_superinstructions(Chunk* chunk) {
+    // Fusing reads opcodes at instruction boundaries, so leave chunks with
+    // anything undecodable untouched rather than guess
+    if (chunk_decodes(chunk)) {
+        size_t offset = 0;
+        while (offset < chunk->count) {
+            size_t fused = fuse_at(chunk, offset);
+            offset += fused ? fused : chunk_instruction_length(chunk, offset);
+        }
+    }
+
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        if (IS_FUNCTION(chunk->constants.values[i])) {
+            chunk_fuse_superinstructions(&AS_FUNCTION(chunk->constants.values[i])->chunk);
+        }
+    }
+}
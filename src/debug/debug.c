@@ -35,6 +35,26 @@ static int simple_instruction(const char* name, int offset) {
     return offset + 1;
 }
 
+// Opcodes the interpreter specialized in place, shown with their generic form
+static int quickened_instruction(const char* name, const char* generic, int offset) {
+    printf("%-16s [quickened %s]\n", name, generic);
+    return offset + 1;
+}
+
+// Superinstructions print the sequence they stand for
+static int fused_local_instruction(const char* name, Chunk* chunk, int offset) {
+    uint8_t slot = chunk->code[offset + 1];
+    uint8_t operand = chunk->code[offset + 3];
+    printf("%-16s %4d %4d", name, slot, operand);
+    if (chunk->code[offset] == OP_GET_LOCAL_CONSTANT && operand < chunk->constants.count) {
+        printf(" '");
+        print_value(chunk->constants.values[operand]);
+        printf("'");
+    }
+    printf("\n");
+    return offset + 4;
+}
+
 static int constant_instruction(const char* name, Chunk* chunk, int offset) {
     uint8_t constant = chunk->code[offset + 1];
     printf("%-16s %4d '", name, constant);
@@ -47,6 +67,19 @@ static int constant_instruction(const char* name, Chunk* chunk, int offset) {
     return offset + 2;
 }
 
+// A two-byte constant index, high byte first
+static int long_constant_instruction(const char* name, Chunk* chunk, int offset) {
+    uint16_t constant = (uint16_t)((chunk->code[offset + 1] << 8) | chunk->code[offset + 2]);
+    printf("%-16s %4d '", name, constant);
+    if (constant < chunk->constants.count) {
+        print_value(chunk->constants.values[constant]);
+    } else {
+        printf("<invalid constant>");
+    }
+    printf("'\n");
+    return offset + 3;
+}
+
 static int byte_instruction(const char* name, Chunk* chunk, int offset) {
     uint8_t slot = chunk->code[offset + 1];
     printf("%-16s %4d\n", name, slot);
@@ -60,6 +93,44 @@ static int jump_instruction(const char* name, int sign, Chunk* chunk, int offset
     return offset + 3;
 }
 
+// Inline cache attached to the instruction at offset, if it has run
+static InlineCache* inline_cache_at(Chunk* chunk, int offset) {
+    if (!chunk->inline_cache_index || (size_t)offset >= chunk->inline_cache_index_count) {
+        return NULL;
+    }
+    uint16_t index = chunk->inline_cache_index[offset];
+    return index ? &chunk->inline_caches[index - 1] : NULL;
+}
+
+static void print_inline_cache(Chunk* chunk, int offset) {
+    InlineCache* ic = inline_cache_at(chunk, offset);
+    if (ic) {
+        printf("  [ic %s hits=%u misses=%u]", ic->count > 1 ? "poly" : "mono", ic->hits, ic->misses);
+    }
+}
+
+static int property_instruction(const char* name, Chunk* chunk, int offset) {
+    printf("%-16s", name);
+    print_inline_cache(chunk, offset);
+    printf("\n");
+    return offset + 1;
+}
+
+static int method_call_instruction(Chunk* chunk, int offset) {
+    uint8_t arg_count = chunk->code[offset + 1];
+    uint16_t constant = (uint16_t)((chunk->code[offset + 2] << 8) | chunk->code[offset + 3]);
+    printf("%-16s %4d '", "OP_METHOD_CALL", constant);
+    if (constant < chunk->constants.count) {
+        print_value(chunk->constants.values[constant]);
+    } else {
+        printf("<invalid constant>");
+    }
+    printf("' (%d args)", arg_count);
+    print_inline_cache(chunk, offset);
+    printf("\n");
+    return offset + 4;
+}
+
 int disassemble_instruction(Chunk* chunk, int offset) {
     printf("%04d ", offset);
     if (offset > 0 && chunk->lines[offset] == chunk->lines[offset - 1]) {
@@ -87,11 +158,15 @@ int disassemble_instruction(Chunk* chunk, int offset) {
         case OP_SET_LOCAL:
             return byte_instruction("OP_SET_LOCAL", chunk, offset);
         case OP_GET_GLOBAL:
-            return byte_instruction("OP_GET_GLOBAL", chunk, offset);
+            return long_constant_instruction("OP_GET_GLOBAL", chunk, offset);
         case OP_SET_GLOBAL:
-            return byte_instruction("OP_SET_GLOBAL", chunk, offset);
+            return long_constant_instruction("OP_SET_GLOBAL", chunk, offset);
         case OP_DEFINE_GLOBAL:
-            return byte_instruction("OP_DEFINE_GLOBAL", chunk, offset);
+            return long_constant_instruction("OP_DEFINE_GLOBAL", chunk, offset);
+        case OP_GET_GLOBAL_SLOT:
+            return long_constant_instruction("OP_GET_GLOBAL_SLOT", chunk, offset);
+        case OP_SET_GLOBAL_SLOT:
+            return long_constant_instruction("OP_SET_GLOBAL_SLOT", chunk, offset);
         case OP_EQUAL:
             return simple_instruction("OP_EQUAL", offset);
         case OP_NOT_EQUAL:
@@ -112,6 +187,20 @@ int disassemble_instruction(Chunk* chunk, int offset) {
             return simple_instruction("OP_MULTIPLY", offset);
         case OP_DIVIDE:
             return simple_instruction("OP_DIVIDE", offset);
+        case OP_ADD_NUM:
+            return quickened_instruction("OP_ADD_NUM", "OP_ADD", offset);
+        case OP_SUBTRACT_NUM:
+            return quickened_instruction("OP_SUBTRACT_NUM", "OP_SUBTRACT", offset);
+        case OP_MULTIPLY_NUM:
+            return quickened_instruction("OP_MULTIPLY_NUM", "OP_MULTIPLY", offset);
+        case OP_GREATER_NUM:
+            return quickened_instruction("OP_GREATER_NUM", "OP_GREATER", offset);
+        case OP_GREATER_EQUAL_NUM:
+            return quickened_instruction("OP_GREATER_EQUAL_NUM", "OP_GREATER_EQUAL", offset);
+        case OP_LESS_NUM:
+            return quickened_instruction("OP_LESS_NUM", "OP_LESS", offset);
+        case OP_LESS_EQUAL_NUM:
+            return quickened_instruction("OP_LESS_EQUAL_NUM", "OP_LESS_EQUAL", offset);
         case OP_MODULO:
             return simple_instruction("OP_MODULO", offset);
         case OP_NOT:
@@ -140,12 +229,28 @@ int disassemble_instruction(Chunk* chunk, int offset) {
             return jump_instruction("OP_JUMP_IF_FALSE", 1, chunk, offset);
         case OP_JUMP_IF_TRUE:
             return jump_instruction("OP_JUMP_IF_TRUE", 1, chunk, offset);
+        case OP_JUMP_IF_FALSE_POP: {
+            uint16_t jump = (uint16_t)(chunk->code[offset + 1] << 8);
+            jump |= chunk->code[offset + 2];
+            printf("%-16s %4d -> %d\n", "OP_JUMP_IF_FALSE_POP", offset, offset + 3 + jump + 1);
+            return offset + 4;
+        }
+        case OP_GET_LOCAL_PAIR:
+            return fused_local_instruction("OP_GET_LOCAL_PAIR", chunk, offset);
+        case OP_GET_LOCAL_CONSTANT:
+            return fused_local_instruction("OP_GET_LOCAL_CONSTANT", chunk, offset);
+        case OP_SET_LOCAL_POP: {
+            printf("%-16s %4d\n", "OP_SET_LOCAL_POP", chunk->code[offset + 1]);
+            return offset + 3;
+        }
         case OP_LOOP:
             return jump_instruction("OP_LOOP", -1, chunk, offset);
         case OP_CALL:
             return byte_instruction("OP_CALL", chunk, offset);
+        case OP_TAIL_CALL:
+            return byte_instruction("OP_TAIL_CALL", chunk, offset);
         case OP_METHOD_CALL:
-            return byte_instruction("OP_METHOD_CALL", chunk, offset);
+            return method_call_instruction(chunk, offset);
         case OP_CLOSURE: {
             offset++;
             uint8_t constant = chunk->code[offset++];
@@ -197,7 +302,7 @@ int disassemble_instruction(Chunk* chunk, int offset) {
         case OP_HALT:
             return simple_instruction("OP_HALT", offset);
         case OP_MODULE_EXPORT:
-            return simple_instruction("OP_MODULE_EXPORT", offset);
+            return long_constant_instruction("OP_MODULE_EXPORT", chunk, offset);
         case OP_IMPORT_ALL_FROM:
             return simple_instruction("OP_IMPORT_ALL_FROM", offset);
         case OP_LOAD_MODULE:
@@ -226,8 +331,9 @@ int disassemble_instruction(Chunk* chunk, int offset) {
         case OP_SET_FIELD:
             return constant_instruction(instruction == OP_GET_FIELD ? "OP_GET_FIELD" : "OP_SET_FIELD", chunk, offset);
         case OP_GET_PROPERTY:
+            return property_instruction("OP_GET_PROPERTY", chunk, offset);
         case OP_SET_PROPERTY:
-            return constant_instruction(instruction == OP_GET_PROPERTY ? "OP_GET_PROPERTY" : "OP_SET_PROPERTY", chunk, offset);
+            return simple_instruction("OP_SET_PROPERTY", offset);
         case OP_GET_SUBSCRIPT:
             return simple_instruction("OP_GET_SUBSCRIPT", offset);
         case OP_SET_SUBSCRIPT:
@@ -236,6 +342,26 @@ int disassemble_instruction(Chunk* chunk, int offset) {
             return simple_instruction("OP_STRING_CONCAT", offset);
         case OP_STRING_INTERP:
             return byte_instruction("OP_STRING_INTERP", chunk, offset);
+        case OP_ADD_CHAIN:
+            return byte_instruction("OP_ADD_CHAIN", chunk, offset);
+        case OP_ARRAY_APPEND:
+            return byte_instruction("OP_ARRAY_APPEND", chunk, offset);
+        case OP_EXPECT_STRING:
+            return simple_instruction("OP_EXPECT_STRING", offset);
+        case OP_ADD_GENERIC:
+            return simple_instruction("OP_ADD_GENERIC", offset);
+        case OP_SUBTRACT_GENERIC:
+            return simple_instruction("OP_SUBTRACT_GENERIC", offset);
+        case OP_MULTIPLY_GENERIC:
+            return simple_instruction("OP_MULTIPLY_GENERIC", offset);
+        case OP_GREATER_GENERIC:
+            return simple_instruction("OP_GREATER_GENERIC", offset);
+        case OP_GREATER_EQUAL_GENERIC:
+            return simple_instruction("OP_GREATER_EQUAL_GENERIC", offset);
+        case OP_LESS_GENERIC:
+            return simple_instruction("OP_LESS_GENERIC", offset);
+        case OP_LESS_EQUAL_GENERIC:
+            return simple_instruction("OP_LESS_EQUAL_GENERIC", offset);
         case OP_INTERN_STRING:
             return simple_instruction("OP_INTERN_STRING", offset);
         case OP_POWER:
@@ -253,7 +379,7 @@ int disassemble_instruction(Chunk* chunk, int offset) {
         case OP_CLOSE_UPVALUE:
             return simple_instruction("OP_CLOSE_UPVALUE", offset);
         case OP_CONSTANT_LONG:
-            return constant_instruction("OP_CONSTANT_LONG", chunk, offset);
+            return long_constant_instruction("OP_CONSTANT_LONG", chunk, offset);
         default:
             printf("Unknown opcode %d\n", instruction);
             return offset + 1;
@@ -266,4 +392,17 @@ void disassemble_chunk(Chunk* chunk, const char* name) {
     for (size_t offset = 0; offset < chunk->count;) {
         offset = disassemble_instruction(chunk, offset);
     }
+}
+
+void disassemble_inline_caches(Chunk* chunk, const char* name) {
+    if (!chunk->inline_cache_count) {
+        return;
+    }
+    printf("== %s ==\n", name);
+    
+    for (size_t offset = 0; offset < chunk->inline_cache_index_count; offset++) {
+        if (inline_cache_at(chunk, (int)offset)) {
+            disassemble_instruction(chunk, (int)offset);
+        }
+    }
 }
\ No newline at end of file
@@ -1283,17 +1283,25 @@ static Stmt* continue_statement(Parser* parser)
     return stmt_create_continue();
 }
 
+// Stamp a statement with the line it started on, for the bytecode's line table
+static Stmt* at_line(Stmt* stmt, size_t line)
+{
+    if (stmt && stmt->line == 0) stmt->line = (int)line;
+    return stmt;
+}
+
 static Stmt* statement(Parser* parser)
 {
-    if (match(parser, TOKEN_IF)) return if_statement(parser);
-    if (match(parser, TOKEN_WHILE)) return while_statement(parser);
-    if (match(parser, TOKEN_FOR)) return for_statement(parser);
-    if (match(parser, TOKEN_RETURN)) return return_statement(parser);
-    if (match(parser, TOKEN_BREAK)) return break_statement(parser);
-    if (match(parser, TOKEN_CONTINUE)) return continue_statement(parser);
-    if (match(parser, TOKEN_LEFT_BRACE)) return block_statement(parser);
-
-    return expression_statement(parser);
+    size_t line = parser->current.line;
+    if (match(parser, TOKEN_IF)) return at_line(if_statement(parser), line);
+    if (match(parser, TOKEN_WHILE)) return at_line(while_statement(parser), line);
+    if (match(parser, TOKEN_FOR)) return at_line(for_statement(parser), line);
+    if (match(parser, TOKEN_RETURN)) return at_line(return_statement(parser), line);
+    if (match(parser, TOKEN_BREAK)) return at_line(break_statement(parser), line);
+    if (match(parser, TOKEN_CONTINUE)) return at_line(continue_statement(parser), line);
+    if (match(parser, TOKEN_LEFT_BRACE)) return at_line(block_statement(parser), line);
+
+    return at_line(expression_statement(parser), line);
 }
 
 // Forward declarations
@@ -2289,44 +2297,45 @@ static Stmt* extension_declaration(Parser* parser)
 
 static Stmt* declaration(Parser* parser)
 {
+    size_t line = parser->current.line;
     if (match(parser, TOKEN_IMPORT))
     {
-        return import_declaration(parser);
+        return at_line(import_declaration(parser), line);
     }
     if (match(parser, TOKEN_EXPORT))
     {
-        return export_declaration(parser);
+        return at_line(export_declaration(parser), line);
     }
     if (match(parser, TOKEN_MOD))
     {
-        return module_declaration(parser);
+        return at_line(module_declaration(parser), line);
     }
     if (match(parser, TOKEN_FUNC))
     {
-        return function_declaration(parser);
+        return at_line(function_declaration(parser), line);
     }
     if (match(parser, TOKEN_CLASS))
     {
-        return class_declaration(parser);
+        return at_line(class_declaration(parser), line);
     }
     if (match(parser, TOKEN_STRUCT))
     {
-        return struct_declaration(parser);
+        return at_line(struct_declaration(parser), line);
     }
     if (match(parser, TOKEN_PROTOCOL))
     {
-        return protocol_declaration(parser);
+        return at_line(protocol_declaration(parser), line);
     }
     if (match(parser, TOKEN_EXTENSION))
     {
-        return extension_declaration(parser);
+        return at_line(extension_declaration(parser), line);
     }
     if (match(parser, TOKEN_VAR) || match(parser, TOKEN_LET))
     {
-        return var_statement(parser);
+        return at_line(var_statement(parser), line);
     }
 
-    return statement(parser);
+    return at_line(statement(parser), line);
 }
 
 ProgramNode* parser_parse_program(Parser* parser)
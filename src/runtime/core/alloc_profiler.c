@@ -0,0 +1,509 @@
+#include "runtime/core/alloc_profiler.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/vm.h"
+#include "runtime/modules/loader/module_loader.h"
+#include "utils/allocators.h"
+#include "utils/bytecode_format.h"
+#include "utils/hash_map.h"
+#include "utils/platform_compat.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// A function and source line a sampled stack passed through
+typedef struct {
+    uint32_t function;   // Index in functions
+    int32_t line;
+} ProfileLocation;
+
+typedef struct {
+    uint32_t name;       // Indices in strings
+    uint32_t filename;
+    int32_t start_line;
+} ProfileFunction;
+
+// Every sample taken with the same stack and tag, added up
+typedef struct {
+    size_t first;        // Location indices in stack_locations, leaf first
+    uint32_t depth;
+    uint32_t tag;        // String index
+    uint64_t hash;
+    double count;        // Estimated allocations
+    double bytes;        // Estimated bytes
+} ProfileStack;
+
+struct AllocProfiler {
+    VM* vm;
+    size_t sample_bytes;           // Mean bytes between samples; 0 for all
+    double until_sample;           // Bytes left before the next sample
+    uint64_t rng;
+    bool running;
+    uint32_t script_file;          // String index of the script path
+    uint64_t start_ns;             // Wall clock when profiling started
+    uint64_t start_us;             // platform_monotonic_us() then
+    uint64_t duration_us;          // Set when stopped
+
+    char** strings;                // strings[0] is "", as pprof requires
+    size_t string_count;
+    size_t string_capacity;
+    HashMap* string_ids;           // String -> index + 1
+
+    ProfileFunction* functions;
+    size_t function_count;
+    size_t function_capacity;
+    HashMap* function_ids;         // "name\nfile" -> index + 1
+
+    ProfileLocation* locations;
+    size_t location_count;
+    size_t location_capacity;
+    uint32_t* location_table;      // Open addressing, location index + 1
+    size_t location_table_capacity;
+
+    uint32_t* stack_locations;     // Frames of every stack, back to back
+    size_t stack_location_count;
+    size_t stack_location_capacity;
+    ProfileStack* stacks;
+    size_t stack_count;
+    size_t stack_capacity;
+    uint32_t* stack_table;         // Open addressing, stack index + 1
+    size_t stack_table_capacity;
+
+    uint32_t* scratch;             // Stack being sampled
+    size_t scratch_capacity;
+};
+
+// Grow a VM-allocated array so it can hold `needed` items. The VM allocator
+// is not one the profiler hooks, so this never reports to itself.
+static bool reserve(void** items, size_t* capacity, size_t needed, size_t item_size) {
+    if (needed <= *capacity) return true;
+    size_t new_capacity = *capacity ? *capacity : 64;
+    while (new_capacity < needed) new_capacity *= 2;
+    void* grown = VM_REALLOC(*items, *capacity * item_size, new_capacity * item_size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static uint64_t hash_mix(uint64_t hash, uint64_t value) {
+    hash ^= value;
+    hash *= 0x100000001b3ULL;
+    return hash ^ (hash >> 29);
+}
+
+// Uniform in (0, 1]
+static double next_random(AllocProfiler* profiler) {
+    uint64_t x = profiler->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    profiler->rng = x;
+    return ((x >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+// Sample intervals are exponentially distributed, so each allocated byte
+// is equally likely to be the one sampled whatever the allocation sizes
+static void schedule_sample(AllocProfiler* profiler) {
+    profiler->until_sample = -log(next_random(profiler)) * (double)profiler->sample_bytes;
+}
+
+static uint32_t intern(AllocProfiler* profiler, const char* str) {
+    if (!str) str = "";
+    void* found = hash_map_get(profiler->string_ids, str);
+    if (found) return (uint32_t)((uintptr_t)found - 1);
+
+    if (!reserve((void**)&profiler->strings, &profiler->string_capacity,
+                 profiler->string_count + 1, sizeof(char*))) {
+        return 0;
+    }
+    size_t len = strlen(str);
+    char* copy = VM_ALLOC(len + 1);
+    if (!copy) return 0;
+    memcpy(copy, str, len + 1);
+    uint32_t id = (uint32_t)profiler->string_count++;
+    profiler->strings[id] = copy;
+    hash_map_put(profiler->string_ids, copy, (void*)(uintptr_t)(id + 1));
+    return id;
+}
+
+// Functions are told apart by name and file rather than address: a REPL
+// frees each line's functions, and a later one may reuse the memory
+static uint32_t function_id(AllocProfiler* profiler, Function* function) {
+    const char* name = function->name ? function->name : "<anonymous>";
+    uint32_t filename = profiler->script_file;
+    if (function->module && function->module->path) {
+        filename = intern(profiler, function->module->path);
+    }
+
+    char key[512];
+    snprintf(key, sizeof(key), "%s\n%u", name, filename);
+    void* found = hash_map_get(profiler->function_ids, key);
+    if (found) return (uint32_t)((uintptr_t)found - 1);
+
+    if (!reserve((void**)&profiler->functions, &profiler->function_capacity,
+                 profiler->function_count + 1, sizeof(ProfileFunction))) {
+        return UINT32_MAX;
+    }
+    ProfileFunction* entry = &profiler->functions[profiler->function_count];
+    entry->name = intern(profiler, name);
+    entry->filename = filename;
+    entry->start_line = function->chunk.count > 0 && function->chunk.lines ? function->chunk.lines[0] : 0;
+    uint32_t id = (uint32_t)profiler->function_count++;
+    hash_map_put(profiler->function_ids, key, (void*)(uintptr_t)(id + 1));
+    return id;
+}
+
+static bool grow_table(uint32_t** table, size_t* capacity, size_t count,
+                       uint64_t (*hash_of)(AllocProfiler*, uint32_t), AllocProfiler* profiler) {
+    if ((count + 1) * 2 <= *capacity) return true;
+    size_t new_capacity = *capacity ? *capacity * 2 : 256;
+    uint32_t* grown = VM_ALLOC_ZERO(new_capacity * sizeof(uint32_t));
+    if (!grown) return false;
+    for (size_t i = 0; i < *capacity; i++) {
+        uint32_t entry = (*table)[i];
+        if (!entry) continue;
+        size_t slot = hash_of(profiler, entry - 1) & (new_capacity - 1);
+        while (grown[slot]) slot = (slot + 1) & (new_capacity - 1);
+        grown[slot] = entry;
+    }
+    if (*table) VM_FREE(*table, *capacity * sizeof(uint32_t));
+    *table = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static uint64_t location_hash(AllocProfiler* profiler, uint32_t index) {
+    ProfileLocation* location = &profiler->locations[index];
+    return hash_mix(hash_mix(0xcbf29ce484222325ULL, location->function), (uint32_t)location->line);
+}
+
+static uint64_t stack_hash(AllocProfiler* profiler, uint32_t index) {
+    return profiler->stacks[index].hash;
+}
+
+static uint32_t location_id(AllocProfiler* profiler, uint32_t function, int line) {
+    if (!grow_table(&profiler->location_table, &profiler->location_table_capacity,
+                    profiler->location_count, location_hash, profiler) ||
+        !reserve((void**)&profiler->locations, &profiler->location_capacity,
+                 profiler->location_count + 1, sizeof(ProfileLocation))) {
+        return UINT32_MAX;
+    }
+    ProfileLocation key = { function, line };
+    uint64_t hash = hash_mix(hash_mix(0xcbf29ce484222325ULL, function), (uint32_t)line);
+    size_t mask = profiler->location_table_capacity - 1;
+    size_t slot = hash & mask;
+    while (profiler->location_table[slot]) {
+        ProfileLocation* location = &profiler->locations[profiler->location_table[slot] - 1];
+        if (location->function == key.function && location->line == key.line) {
+            return profiler->location_table[slot] - 1;
+        }
+        slot = (slot + 1) & mask;
+    }
+    uint32_t id = (uint32_t)profiler->location_count++;
+    profiler->locations[id] = key;
+    profiler->location_table[slot] = id + 1;
+    return id;
+}
+
+// Find or add the stack in `scratch`
+static ProfileStack* find_stack(AllocProfiler* profiler, uint32_t depth, uint32_t tag) {
+    uint64_t hash = hash_mix(0xcbf29ce484222325ULL, tag);
+    for (uint32_t i = 0; i < depth; i++) {
+        hash = hash_mix(hash, profiler->scratch[i]);
+    }
+    if (!grow_table(&profiler->stack_table, &profiler->stack_table_capacity,
+                    profiler->stack_count, stack_hash, profiler)) {
+        return NULL;
+    }
+
+    size_t mask = profiler->stack_table_capacity - 1;
+    size_t slot = hash & mask;
+    while (profiler->stack_table[slot]) {
+        ProfileStack* stack = &profiler->stacks[profiler->stack_table[slot] - 1];
+        if (stack->hash == hash && stack->depth == depth && stack->tag == tag &&
+            memcmp(profiler->stack_locations + stack->first, profiler->scratch,
+                   depth * sizeof(uint32_t)) == 0) {
+            return stack;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    if (!reserve((void**)&profiler->stacks, &profiler->stack_capacity,
+                 profiler->stack_count + 1, sizeof(ProfileStack)) ||
+        !reserve((void**)&profiler->stack_locations, &profiler->stack_location_capacity,
+                 profiler->stack_location_count + depth, sizeof(uint32_t))) {
+        return NULL;
+    }
+    ProfileStack* stack = &profiler->stacks[profiler->stack_count];
+    stack->first = profiler->stack_location_count;
+    stack->depth = depth;
+    stack->tag = tag;
+    stack->hash = hash;
+    stack->count = 0;
+    stack->bytes = 0;
+    memcpy(profiler->stack_locations + stack->first, profiler->scratch, depth * sizeof(uint32_t));
+    profiler->stack_location_count += depth;
+    profiler->stack_table[slot] = (uint32_t)++profiler->stack_count;
+    return stack;
+}
+
+// Allocations made outside any call, while loading modules for instance
+static uint32_t runtime_function(AllocProfiler* profiler) {
+    const char* key = "<runtime>";
+    void* found = hash_map_get(profiler->function_ids, key);
+    if (found) return (uint32_t)((uintptr_t)found - 1);
+
+    if (!reserve((void**)&profiler->functions, &profiler->function_capacity,
+                 profiler->function_count + 1, sizeof(ProfileFunction))) {
+        return UINT32_MAX;
+    }
+    uint32_t id = (uint32_t)profiler->function_count++;
+    profiler->functions[id] = (ProfileFunction){ intern(profiler, key), 0, 0 };
+    hash_map_put(profiler->function_ids, key, (void*)(uintptr_t)(id + 1));
+    return id;
+}
+
+static void take_sample(AllocProfiler* profiler, double count, double bytes, const char* tag) {
+    VM* vm = profiler->vm;
+    size_t depth = vm->frame_count > 0 ? (size_t)vm->frame_count : 1;
+    if (!reserve((void**)&profiler->scratch, &profiler->scratch_capacity, depth, sizeof(uint32_t))) {
+        return;
+    }
+
+    if (vm->frame_count == 0) {
+        uint32_t function = runtime_function(profiler);
+        if (function == UINT32_MAX) return;
+        profiler->scratch[0] = location_id(profiler, function, 0);
+    }
+    // Leaf first, as pprof lists them
+    for (int i = 0; i < vm->frame_count; i++) {
+        CallFrame* frame = &vm->frames[vm->frame_count - 1 - i];
+        if (!frame->closure) {
+            uint32_t runtime = runtime_function(profiler);
+            profiler->scratch[i] = runtime == UINT32_MAX ? UINT32_MAX : location_id(profiler, runtime, 0);
+            continue;
+        }
+        Function* function = frame->closure->function;
+        Chunk* chunk = &function->chunk;
+        int line = 0;
+        if (frame->ip >= chunk->code && frame->ip <= chunk->code + chunk->count && chunk->count > 0) {
+            line = chunk->lines[frame->ip > chunk->code ? frame->ip - chunk->code - 1 : 0];
+        }
+        uint32_t id = function_id(profiler, function);
+        profiler->scratch[i] = id == UINT32_MAX ? UINT32_MAX : location_id(profiler, id, line);
+    }
+    for (size_t i = 0; i < depth; i++) {
+        if (profiler->scratch[i] == UINT32_MAX) return;
+    }
+
+    ProfileStack* stack = find_stack(profiler, (uint32_t)depth,
+                                     intern(profiler, tag && *tag ? tag : "untagged"));
+    if (stack) {
+        stack->count += count;
+        stack->bytes += bytes;
+    }
+}
+
+void alloc_profiler_record(AllocProfiler* profiler, size_t size, const char* tag) {
+    if (!profiler->running) return;
+    // Blocks hold nursery objects, which the collector reports one by one
+    if (tag && strcmp(tag, GC_BLOCK_TAG) == 0) return;
+
+    if (profiler->sample_bytes == 0) {
+        take_sample(profiler, 1.0, (double)size, tag);
+        return;
+    }
+    profiler->until_sample -= (double)size;
+    if (profiler->until_sample > 0) return;
+
+    // An allocation of `size` bytes is sampled with probability
+    // 1 - e^(-size/rate); weighting by the inverse keeps totals unbiased
+    double rate = (double)profiler->sample_bytes;
+    double count = 1.0 / (1.0 - exp(-(double)size / rate));
+    take_sample(profiler, count, count * (double)size, tag);
+    schedule_sample(profiler);
+}
+
+static void profiler_hook(size_t size, const char* tag, void* user_data) {
+    alloc_profiler_record((AllocProfiler*)user_data, size, tag);
+}
+
+AllocProfiler* alloc_profiler_create(VM* vm, size_t sample_bytes, const char* script_path) {
+    AllocProfiler* profiler = VM_ALLOC_ZERO(sizeof(AllocProfiler));
+    if (!profiler) return NULL;
+    profiler->vm = vm;
+    profiler->sample_bytes = sample_bytes;
+    profiler->rng = 0x9e3779b97f4a7c15ULL;
+    profiler->string_ids = hash_map_create();
+    profiler->function_ids = hash_map_create();
+    if (!profiler->string_ids || !profiler->function_ids) {
+        alloc_profiler_destroy(profiler);
+        return NULL;
+    }
+    intern(profiler, "");
+    profiler->script_file = intern(profiler, script_path);
+    if (sample_bytes > 0) schedule_sample(profiler);
+
+    profiler->start_ns = (uint64_t)time(NULL) * 1000000000ULL;
+    profiler->start_us = platform_monotonic_us();
+    profiler->running = true;
+    allocators_set_hook(ALLOC_SYSTEM_OBJECTS, profiler_hook, profiler);
+    allocators_set_hook(ALLOC_SYSTEM_STRINGS, profiler_hook, profiler);
+    if (vm->gc) vm->gc->alloc_profiler = profiler;
+    return profiler;
+}
+
+void alloc_profiler_stop(AllocProfiler* profiler) {
+    if (!profiler || !profiler->running) return;
+    profiler->running = false;
+    profiler->duration_us = platform_monotonic_us() - profiler->start_us;
+    allocators_set_hook(ALLOC_SYSTEM_OBJECTS, NULL, NULL);
+    allocators_set_hook(ALLOC_SYSTEM_STRINGS, NULL, NULL);
+    if (profiler->vm->gc && profiler->vm->gc->alloc_profiler == profiler) {
+        profiler->vm->gc->alloc_profiler = NULL;
+    }
+}
+
+void alloc_profiler_destroy(AllocProfiler* profiler) {
+    if (!profiler) return;
+    alloc_profiler_stop(profiler);
+    for (size_t i = 0; i < profiler->string_count; i++) {
+        VM_FREE(profiler->strings[i], strlen(profiler->strings[i]) + 1);
+    }
+    if (profiler->strings) VM_FREE(profiler->strings, profiler->string_capacity * sizeof(char*));
+    if (profiler->string_ids) hash_map_destroy(profiler->string_ids);
+    if (profiler->function_ids) hash_map_destroy(profiler->function_ids);
+    if (profiler->functions) VM_FREE(profiler->functions, profiler->function_capacity * sizeof(ProfileFunction));
+    if (profiler->locations) VM_FREE(profiler->locations, profiler->location_capacity * sizeof(ProfileLocation));
+    if (profiler->location_table) VM_FREE(profiler->location_table, profiler->location_table_capacity * sizeof(uint32_t));
+    if (profiler->stack_locations) VM_FREE(profiler->stack_locations, profiler->stack_location_capacity * sizeof(uint32_t));
+    if (profiler->stacks) VM_FREE(profiler->stacks, profiler->stack_capacity * sizeof(ProfileStack));
+    if (profiler->stack_table) VM_FREE(profiler->stack_table, profiler->stack_table_capacity * sizeof(uint32_t));
+    if (profiler->scratch) VM_FREE(profiler->scratch, profiler->scratch_capacity * sizeof(uint32_t));
+    VM_FREE(profiler, sizeof(AllocProfiler));
+}
+
+// Output
+
+bool alloc_profiler_write_folded(AllocProfiler* profiler, FILE* out) {
+    for (size_t i = 0; i < profiler->stack_count; i++) {
+        ProfileStack* stack = &profiler->stacks[i];
+        uint32_t* locations = profiler->stack_locations + stack->first;
+        for (uint32_t j = stack->depth; j-- > 0;) {
+            ProfileLocation* location = &profiler->locations[locations[j]];
+            fprintf(out, "%s:%d;", profiler->strings[profiler->functions[location->function].name],
+                    location->line);
+        }
+        fprintf(out, "[%s] %.0f\n", profiler->strings[stack->tag], stack->bytes);
+    }
+    return !ferror(out);
+}
+
+// profile.proto is written with the helpers bytecode files use; a nested
+// message is built in its own buffer and copied in with its length
+
+static void pb_varint(BytecodeBuffer* buffer, uint64_t value) {
+    while (value >= 0x80) {
+        bytecode_write_u8(buffer, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    bytecode_write_u8(buffer, (uint8_t)value);
+}
+
+static void pb_uint(BytecodeBuffer* buffer, uint32_t field, uint64_t value) {
+    pb_varint(buffer, (uint64_t)field << 3);
+    pb_varint(buffer, value);
+}
+
+static void pb_bytes(BytecodeBuffer* buffer, uint32_t field, const void* data, size_t len) {
+    pb_varint(buffer, ((uint64_t)field << 3) | 2);
+    pb_varint(buffer, len);
+    bytecode_write_bytes(buffer, (const uint8_t*)data, len);
+}
+
+// Append `message` as field `field` of `buffer` and empty it for reuse
+static void pb_message(BytecodeBuffer* buffer, uint32_t field, BytecodeBuffer* message) {
+    pb_bytes(buffer, field, message->data, message->size);
+    message->size = 0;
+}
+
+static void pb_value_type(BytecodeBuffer* buffer, uint32_t field, BytecodeBuffer* scratch,
+                          uint32_t type, uint32_t unit) {
+    pb_uint(scratch, 1, type);
+    pb_uint(scratch, 2, unit);
+    pb_message(buffer, field, scratch);
+}
+
+bool alloc_profiler_write_pprof(AllocProfiler* profiler, FILE* out) {
+    BytecodeBuffer* buffer = bytecode_buffer_create(4096);
+    BytecodeBuffer* message = bytecode_buffer_create(256);
+    BytecodeBuffer* inner = bytecode_buffer_create(256);
+    if (!buffer || !message || !inner) {
+        if (buffer) bytecode_buffer_destroy(buffer);
+        if (message) bytecode_buffer_destroy(message);
+        return false;
+    }
+
+    uint32_t alloc_objects = intern(profiler, "alloc_objects");
+    uint32_t count = intern(profiler, "count");
+    uint32_t alloc_space = intern(profiler, "alloc_space");
+    uint32_t bytes = intern(profiler, "bytes");
+    uint32_t space = intern(profiler, "space");
+    uint32_t tag = intern(profiler, "tag");
+
+    pb_value_type(buffer, 1, message, alloc_objects, count);
+    pb_value_type(buffer, 1, message, alloc_space, bytes);
+
+    for (size_t i = 0; i < profiler->stack_count; i++) {
+        ProfileStack* stack = &profiler->stacks[i];
+        for (uint32_t j = 0; j < stack->depth; j++) {
+            pb_varint(inner, profiler->stack_locations[stack->first + j] + 1);
+        }
+        pb_message(message, 1, inner);
+        pb_varint(inner, (uint64_t)llround(stack->count));
+        pb_varint(inner, (uint64_t)llround(stack->bytes));
+        pb_message(message, 2, inner);
+        pb_uint(inner, 1, tag);
+        pb_uint(inner, 2, stack->tag);
+        pb_message(message, 3, inner);
+        pb_message(buffer, 2, message);
+    }
+
+    for (size_t i = 0; i < profiler->location_count; i++) {
+        ProfileLocation* location = &profiler->locations[i];
+        pb_uint(message, 1, i + 1);
+        pb_uint(inner, 1, location->function + 1);
+        pb_uint(inner, 2, (uint64_t)(int64_t)location->line);
+        pb_message(message, 4, inner);
+        pb_message(buffer, 4, message);
+    }
+
+    for (size_t i = 0; i < profiler->function_count; i++) {
+        ProfileFunction* function = &profiler->functions[i];
+        pb_uint(message, 1, i + 1);
+        pb_uint(message, 2, function->name);
+        pb_uint(message, 3, function->name);
+        pb_uint(message, 4, function->filename);
+        pb_uint(message, 5, (uint64_t)(int64_t)function->start_line);
+        pb_message(buffer, 5, message);
+    }
+
+    // Strings last: writing the rest may have added some
+    for (size_t i = 0; i < profiler->string_count; i++) {
+        pb_bytes(buffer, 6, profiler->strings[i], strlen(profiler->strings[i]));
+    }
+
+    uint64_t duration_us = profiler->running
+        ? platform_monotonic_us() - profiler->start_us : profiler->duration_us;
+    pb_uint(buffer, 9, profiler->start_ns);
+    pb_uint(buffer, 10, duration_us * 1000);
+    pb_value_type(buffer, 11, message, space, bytes);
+    pb_uint(buffer, 12, profiler->sample_bytes ? profiler->sample_bytes : 1);
+
+    bool ok = fwrite(buffer->data, 1, buffer->size, out) == buffer->size && !ferror(out);
+    bytecode_buffer_destroy(buffer);
+    bytecode_buffer_destroy(message);
+    bytecode_buffer_destroy(inner);
+    return ok;
+}
@@ -17,22 +17,24 @@ static TaggedValue native_print(int arg_count, TaggedValue* args) {
 }
 
 static TaggedValue native_typeof(int arg_count, TaggedValue* args) {
+    const char* name;
     if (arg_count != 1) {
-        return STRING_VAL("error: typeof expects 1 argument");
-    }
-    
-    switch (args[0].type) {
-        case VAL_BOOL:     return STRING_VAL("bool");
-        case VAL_NIL:      return STRING_VAL("nil");
-        case VAL_NUMBER:   return STRING_VAL("number");
-        case VAL_STRING:   return STRING_VAL("string");
-        case VAL_FUNCTION: return STRING_VAL("function");
-        case VAL_NATIVE:   return STRING_VAL("native");
-        case VAL_CLOSURE:  return STRING_VAL("closure");
-        case VAL_OBJECT:   return STRING_VAL("object");
-        case VAL_STRUCT:   return STRING_VAL("struct");
-        default:           return STRING_VAL("unknown");
+        name = "error: typeof expects 1 argument";
+    } else {
+        switch (VALUE_TYPE(args[0])) {
+            case VAL_BOOL:     name = "bool"; break;
+            case VAL_NIL:      name = "nil"; break;
+            case VAL_NUMBER:   name = "number"; break;
+            case VAL_STRING:   name = "string"; break;
+            case VAL_FUNCTION: name = "function"; break;
+            case VAL_NATIVE:   name = "native"; break;
+            case VAL_CLOSURE:  name = "closure"; break;
+            case VAL_OBJECT:   name = "object"; break;
+            case VAL_STRUCT:   name = "struct"; break;
+            default:           name = "unknown"; break;
+        }
     }
+    return STRING_VAL(string_copy(name));
 }
 
 static TaggedValue native_assert(int arg_count, TaggedValue* args) {
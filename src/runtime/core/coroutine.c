@@ -83,7 +83,7 @@ bool coroutine_resume(Coroutine* coro) {
 
 TaggedValue coroutine_await(Coroutine* coro, Promise* promise) {
     if (!coro || !promise) {
-        return (TaggedValue){.type = VAL_NIL};
+        return NIL_VAL;
     }
     
     if (promise_is_resolved(promise)) {
@@ -100,7 +100,7 @@ TaggedValue coroutine_await(Coroutine* coro, Promise* promise) {
     
     promise->waiting[promise->waiting_count++] = coro;
     
-    return (TaggedValue){.type = VAL_NIL};
+    return NIL_VAL;
 }
 
 void coroutine_yield(Coroutine* coro, TaggedValue value) {
@@ -297,11 +297,11 @@ bool executor_has_work(const Executor* executor) {
 TaggedValue async_function_call(VM* vm, const char* name, TaggedValue* args, size_t arg_count) {
     (void)name;  // Unused parameter
     Coroutine* coro = coroutine_create(NULL, vm);
-    if (!coro) return (TaggedValue){.type = VAL_NIL};
+    if (!coro) return NIL_VAL;
     
     if (!coroutine_start(coro, args, arg_count)) {
         coroutine_destroy(coro);
-        return (TaggedValue){.type = VAL_NIL};
+        return NIL_VAL;
     }
     
     TaggedValue result = coro->result;
@@ -1,6 +1,10 @@
 #include "runtime/core/gc.h"
+#include "runtime/core/alloc_profiler.h"
+#include "runtime/core/gc_parallel.h"
 #include "runtime/core/object.h"
 #include "runtime/core/vm.h"
+#include "runtime/modules/loader/module_cache.h"
+#include "runtime/modules/loader/module_loader.h"
 #include "utils/allocators.h"
 #include "utils/logger.h"
 #include "utils/platform_compat.h"
@@ -16,11 +20,56 @@ static const GCConfig default_config = {
     .max_heap_size = 0,               // Unlimited
     .gc_threshold = 1024 * 1024,      // 1MB
     .incremental = false,
-    .incremental_step_size = 1024,    // 1KB worth of work
+    .max_pause_us = 1000,             // 1ms
     .stress_test = false,
-    .verbose = false
+    .verbose = false,
+    .generational = true,
+    .nursery_size = 256 * 1024,       // 256KB
+    .mark_threads = 1,
+    .fragmentation_threshold = 0.25,
+    .target_pause_us = 10000          // 10ms
 };
 
+// Nursery block; allocations start GC_BLOCK_DATA bytes in
+struct GCBlock {
+    GCBlock* next;       // Next free or recyclable block
+    size_t live;         // Allocations carved from this block and not yet freed
+    size_t live_bytes;   // Bytes those allocations take, headers included
+    bool recyclable;     // On gc->recycle_blocks
+};
+
+#define GC_ROUND_UP(size) (((size) + GC_ALIGNMENT - 1) & ~(size_t)(GC_ALIGNMENT - 1))
+#define GC_BLOCK_DATA GC_ROUND_UP(sizeof(GCBlock))
+#define GC_BLOCK_USABLE (GC_BLOCK_SIZE - GC_BLOCK_DATA)
+
+// Bytes a header and its payload take in a block. Retired blocks are tiled
+// with headers, live or GC_FREE, so stepping by this walks every allocation.
+#define GC_BLOCK_SPAN(header) (GC_HEADER_SIZE + GC_ROUND_UP((header)->size))
+
+// Closure marks compare against this, so every cycle of every collector
+// needs its own value
+static uint32_t gc_epoch_counter = 0;
+
+// While an incremental cycle runs, a step is taken every this many bytes
+// allocated
+#define GC_STEP_INTERVAL (64 * 1024)
+
+// Incremental steps look at the clock after this many objects
+#define GC_STEP_CHECK 32
+
+// Objects each allocation sweeps while a lazy sweep is pending
+#define GC_SWEEP_BATCH 64
+
+// Range the pause goal resizes the nursery in
+#define GC_NURSERY_MIN (64 * 1024)
+#define GC_NURSERY_MAX (1024 * 1024)
+
+// Share of a minor collection's nursery surviving it above which objects
+// may be promoted before they had time to die
+#define GC_SURVIVAL_HIGH 0.10
+// A doubled nursery is kept if survival falls below this share of before
+#define GC_GROWTH_PAYOFF 0.75
+
 // Gray stack operations
 static void gray_stack_init(GrayStack* stack) {
     stack->capacity = 128;
@@ -68,18 +117,53 @@ GarbageCollector* gc_create(VM* vm, const GCConfig* config) {
     
     // Initialize object tracking
     gc->all_objects = NULL;
+    gc->young_objects = NULL;
     gc->object_count = 0;
     gray_stack_init(&gc->gray_stack);
     
+    // Initialize the nursery; blocks are allocated on first use
+    gc->nursery_block = NULL;
+    gc->nursery_top = NULL;
+    gc->nursery_end = NULL;
+    gc->free_blocks = NULL;
+    gc->free_block_count = 0;
+    gc->recycle_blocks = NULL;
+    gc->block_count = 0;
+    gc->block_live_bytes = 0;
+    gc->young_bytes = 0;
+    gc->remembered = NULL;
+    gc->remembered_count = 0;
+    gc->remembered_capacity = 0;
+    gc->remembered_upvalues = NULL;
+    gc->roots = NULL;
+    gc->root_count = 0;
+    gc->root_capacity = 0;
+    gc->temp_roots = NULL;
+    gc->temp_root_count = 0;
+    gc->temp_root_capacity = 0;
+    
     // Initialize memory tracking
     gc->bytes_allocated = 0;
     gc->bytes_allocated_since_gc = 0;
     gc->next_gc_threshold = gc->config.gc_threshold;
+    gc->next_string_threshold = gc->config.gc_threshold;
     
     // Initialize GC state
     gc->phase = GC_PHASE_NONE;
     gc->is_collecting = false;
+    gc->is_minor = false;
     gc->sweep_cursor = NULL;
+    gc->bytes_since_step = 0;
+    gc->mark_epoch = 0;
+    gc->mark_pool = gc_mark_pool_create(gc->config.mark_threads);
+    gc->heap_exhausted = false;
+    gc->nursery_survival = 0.0;
+    gc->nursery_settled = false;
+    gc->created_us = platform_monotonic_us();
+    memset(&gc->cycle, 0, sizeof(GCEvent));
+    gc->cycle_done = false;
+    gc->event_callback = NULL;
+    gc->event_user_data = NULL;
     
     // Initialize statistics
     memset(&gc->stats, 0, sizeof(GCStats));
@@ -92,87 +176,113 @@ GarbageCollector* gc_create(VM* vm, const GCConfig* config) {
     return gc;
 }
 
+static void release_block(GarbageCollector* gc, GCBlock* block) {
+    // A recyclable block stays on its list; the nursery starts it over
+    // from scratch when it gets there
+    if (block->recyclable) return;
+    
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+    gc->block_count--;
+    
+    // Keep about one nursery's worth of empty blocks around
+    if (gc->free_block_count * GC_BLOCK_SIZE < gc->config.nursery_size) {
+        block->next = gc->free_blocks;
+        gc->free_blocks = block;
+        gc->free_block_count++;
+    } else {
+        SLANG_MEM_FREE(alloc, block, GC_BLOCK_SIZE);
+    }
+}
+
+static void free_header(GarbageCollector* gc, GCObjectHeader* header);
+static void clear_remembered(GarbageCollector* gc);
+
 // Destroy garbage collector
 void gc_destroy(GarbageCollector* gc) {
     if (!gc) return;
     
-    // Collect everything one last time
-    gc_collect(gc);
+    // Free everything, reachable or not: what has to outlive the VM was
+    // handed to another collector by gc_adopt(). A cycle in progress is
+    // abandoned.
+    clear_remembered(gc);
+    gc->phase = GC_PHASE_NONE;
+    gc->sweep_cursor = NULL;
+    while (gc->young_objects) {
+        free_header(gc, gc->young_objects);
+    }
+    while (gc->all_objects) {
+        free_header(gc, gc->all_objects);
+    }
     
-    // Free remaining objects (should be none after collection)
-    GCObjectHeader* obj = gc->all_objects;
-    while (obj) {
-        GCObjectHeader* next = obj->next;
-        Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-        
-        // Destroy the object
-        if (obj->object) {
-            object_destroy((Object*)obj->object);
-        }
-        
-        // Free the header
-        SLANG_MEM_FREE(alloc, obj, sizeof(GCObjectHeader));
-        obj = next;
+    // Emptied blocks went to the free list unless they were recyclable or
+    // the nursery's
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+    if (gc->nursery_block) {
+        SLANG_MEM_FREE(alloc, gc->nursery_block, GC_BLOCK_SIZE);
+    }
+    while (gc->recycle_blocks) {
+        GCBlock* next = gc->recycle_blocks->next;
+        SLANG_MEM_FREE(alloc, gc->recycle_blocks, GC_BLOCK_SIZE);
+        gc->recycle_blocks = next;
+    }
+    while (gc->free_blocks) {
+        GCBlock* next = gc->free_blocks->next;
+        SLANG_MEM_FREE(alloc, gc->free_blocks, GC_BLOCK_SIZE);
+        gc->free_blocks = next;
     }
     
-    // Free gray stack
+    // Free gray stack, markers and remembered set
     gray_stack_free(&gc->gray_stack);
+    gc_mark_pool_destroy(gc->mark_pool);
+    Allocator* vm_alloc = allocators_get(ALLOC_SYSTEM_VM);
+    if (gc->remembered) {
+        SLANG_MEM_FREE(vm_alloc, gc->remembered, gc->remembered_capacity * sizeof(GCRememberedEntry));
+    }
+    if (gc->roots) {
+        SLANG_MEM_FREE(vm_alloc, gc->roots, gc->root_capacity * sizeof(TaggedValue*));
+    }
+    if (gc->temp_roots) {
+        SLANG_MEM_FREE(vm_alloc, gc->temp_roots, gc->temp_root_capacity * sizeof(TaggedValue));
+    }
     
     // Free GC itself
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
-    SLANG_MEM_FREE(alloc, gc, sizeof(GarbageCollector));
+    SLANG_MEM_FREE(vm_alloc, gc, sizeof(GarbageCollector));
 }
 
-// Allocate memory with GC tracking
-void* gc_alloc(GarbageCollector* gc, size_t size, const char* tag) {
-    // Check if we need to collect
-    if (gc->config.stress_test || gc_should_collect(gc)) {
-        gc_collect(gc);
-    }
-    
-    // Allocate object
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    void* object = MEM_ALLOC_TAGGED(alloc, size, tag);
-    if (!object) {
-        // Try collecting and retry
-        gc_collect(gc);
-        object = MEM_ALLOC_TAGGED(alloc, size, tag);
-        if (!object) return NULL;
+static GCObjectHeader** list_for(GarbageCollector* gc, GCObjectHeader* header) {
+    return header->generation == GC_YOUNG ? &gc->young_objects : &gc->all_objects;
+}
+
+static void link_header(GCObjectHeader** list, GCObjectHeader* header) {
+    header->prev = NULL;
+    header->next = *list;
+    if (*list) {
+        (*list)->prev = header;
     }
-    
-    // Track the object
-    gc_track_object(gc, object, size);
-    
-    return object;
+    *list = header;
 }
 
-// Track an object in the GC
-void gc_track_object(GarbageCollector* gc, void* object, size_t size) {
-    if (!object) return;
-    
-    // Create header
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    GCObjectHeader* header = MEM_NEW(alloc, GCObjectHeader);
-    if (!header) return;
-    
-    // Initialize header
-    header->object = object;
+// Link a new header into its generation's list and account for it
+static void track_header(GarbageCollector* gc, GCObjectHeader* header, size_t size,
+                         GCGeneration generation) {
+    header->owner = gc;
     header->size = size;
-    header->color = GC_WHITE;
+    // Objects allocated while an incremental cycle is marking are already live
+    header->color = gc->phase == GC_PHASE_NONE || gc->phase == GC_PHASE_SWEEP ? GC_WHITE : GC_BLACK;
     header->is_pinned = false;
-    header->prev = NULL;
-    header->next = gc->all_objects;
-    
-    // Add to list
-    if (gc->all_objects) {
-        gc->all_objects->prev = header;
-    }
-    gc->all_objects = header;
+    header->generation = (uint8_t)generation;
+    header->remembered = 0;
+    link_header(list_for(gc, header), header);
     gc->object_count++;
     
-    // Update memory tracking
+    // Update memory tracking. Young bytes only count towards a full
+    // collection once they survive into the old generation.
     gc->bytes_allocated += size;
-    gc->bytes_allocated_since_gc += size;
+    if (generation == GC_YOUNG) {
+        gc->young_bytes += size;
+    } else {
+        gc->bytes_allocated_since_gc += size;
+    }
     
     // Update statistics
     gc->stats.total_allocated += size;
@@ -180,64 +290,367 @@ void gc_track_object(GarbageCollector* gc, void* object, size_t size) {
     if (gc->stats.current_allocated > gc->stats.peak_allocated) {
         gc->stats.peak_allocated = gc->stats.current_allocated;
     }
+}
+
+static void unlink_header(GarbageCollector* gc, GCObjectHeader* header) {
+    if (header->prev) {
+        header->prev->next = header->next;
+    } else {
+        *list_for(gc, header) = header->next;
+    }
+    if (header->next) {
+        header->next->prev = header->prev;
+    }
+}
+
+// Small heaps are left alone: the nursery's own turnover keeps them compact
+static bool heap_fragmented(GarbageCollector* gc) {
+    return gc->config.fragmentation_threshold > 0 &&
+           gc->block_count * GC_BLOCK_SIZE >= gc->config.nursery_size &&
+           gc_fragmentation(gc) >= gc->config.fragmentation_threshold;
+}
+
+// Unlink a header from its list and free its memory
+static void free_header(GarbageCollector* gc, GCObjectHeader* header) {
+    unlink_header(gc, header);
+    
+    gc->bytes_allocated -= header->size;
+    gc->stats.current_allocated -= header->size;
+    gc->object_count--;
+    
+    if (header->is_object) {
+        object_destroy((Object*)GC_PAYLOAD(header));
+    }
+    
+    GCBlock* block = header->block;
+    if (block) {
+        // The bytes stay in the block as a hole until it is recycled or released
+        header->color = GC_FREE;
+        block->live_bytes -= GC_BLOCK_SPAN(header);
+        gc->block_live_bytes -= GC_BLOCK_SPAN(header);
+        
+        if (--block->live == 0) {
+            if (block != gc->nursery_block) {
+                release_block(gc, block);
+            }
+        } else if (block != gc->nursery_block && !block->recyclable &&
+                   block->live_bytes <= GC_BLOCK_USABLE / 2 && heap_fragmented(gc)) {
+            block->recyclable = true;
+            block->next = gc->recycle_blocks;
+            gc->recycle_blocks = block;
+            gc->stats.blocks_recycled++;
+        }
+        return;
+    }
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+    SLANG_MEM_FREE(alloc, header, GC_HEADER_SIZE + header->size);
+}
+
+// Move a nursery survivor to the old generation
+static void promote_header(GarbageCollector* gc, GCObjectHeader* header) {
+    unlink_header(gc, header);
+    header->generation = GC_OLD;
+    header->color = GC_WHITE;
+    link_header(&gc->all_objects, header);
+    
+    gc->bytes_allocated_since_gc += header->size;
+    gc->stats.objects_promoted++;
+    gc->stats.bytes_promoted += header->size;
+}
+
+// Whether the current run has room for `total` bytes. A run is never left
+// with less than a header's worth of space, so whatever remains of it can
+// always be covered by a free header.
+static inline bool nursery_fits(GarbageCollector* gc, size_t total) {
+    size_t available = (size_t)(gc->nursery_end - gc->nursery_top);
+    return available == total || available >= total + GC_HEADER_SIZE;
+}
+
+// Cover the rest of the current run with a free header, keeping the block
+// tiled for later hole searches
+static void retire_run(GarbageCollector* gc) {
+    if (gc->nursery_top && gc->nursery_top < gc->nursery_end) {
+        GCObjectHeader* filler = (GCObjectHeader*)gc->nursery_top;
+        filler->size = (size_t)(gc->nursery_end - gc->nursery_top) - GC_HEADER_SIZE;
+        filler->color = GC_FREE;
+        gc->nursery_top = gc->nursery_end;
+    }
+}
+
+// Make the next run of freed allocations at or after `from` in the nursery
+// block the current run. Returns false when the block has no hole left.
+static bool find_hole(GarbageCollector* gc, char* from) {
+    char* end = (char*)gc->nursery_block + GC_BLOCK_SIZE;
+    char* scan = from;
+    while (scan < end && ((GCObjectHeader*)scan)->color != GC_FREE) {
+        scan += GC_BLOCK_SPAN((GCObjectHeader*)scan);
+    }
+    if (scan >= end) return false;
+    
+    char* hole = scan;
+    while (scan < end && ((GCObjectHeader*)scan)->color == GC_FREE) {
+        scan += GC_BLOCK_SPAN((GCObjectHeader*)scan);
+    }
+    gc->nursery_top = hole;
+    gc->nursery_end = scan;
+    return true;
+}
+
+// Move the nursery to another block: a recyclable one with a hole if there
+// is one, otherwise an empty block. Returns false if none could be allocated.
+static bool next_nursery_block(GarbageCollector* gc) {
+    // Retire the current block; it is released once its last allocation goes
+    GCBlock* old_block = gc->nursery_block;
+    gc->nursery_block = NULL;
+    gc->nursery_top = gc->nursery_end = NULL;
+    if (old_block && old_block->live == 0) {
+        release_block(gc, old_block);
+    }
+    
+    while (gc->recycle_blocks) {
+        GCBlock* block = gc->recycle_blocks;
+        gc->recycle_blocks = block->next;
+        block->next = NULL;
+        block->recyclable = false;
+        gc->nursery_block = block;
+        
+        // Emptied while it waited: start it over
+        if (block->live == 0) {
+            gc->nursery_top = (char*)block + GC_BLOCK_DATA;
+            gc->nursery_end = (char*)block + GC_BLOCK_SIZE;
+            return true;
+        }
+        if (find_hole(gc, (char*)block + GC_BLOCK_DATA)) {
+            return true;
+        }
+        gc->nursery_block = NULL;
+    }
+    
+    GCBlock* block = gc->free_blocks;
+    if (block) {
+        gc->free_blocks = block->next;
+        gc->free_block_count--;
+    } else {
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+        block = MEM_ALLOC_TAGGED(alloc, GC_BLOCK_SIZE, GC_BLOCK_TAG);
+        if (!block) return false;
+    }
+    block->next = NULL;
+    block->live = 0;
+    block->live_bytes = 0;
+    block->recyclable = false;
+    gc->block_count++;
+    gc->nursery_block = block;
+    gc->nursery_top = (char*)block + GC_BLOCK_DATA;
+    gc->nursery_end = (char*)block + GC_BLOCK_SIZE;
+    return true;
+}
+
+// Bump-allocate `total` bytes from the nursery, moving on to the next hole
+// or block when the current run is full. Returns NULL if no block could be
+// allocated.
+static GCObjectHeader* nursery_alloc(GarbageCollector* gc, size_t total) {
+    while (!gc->nursery_top || !nursery_fits(gc, total)) {
+        retire_run(gc);
+        if (gc->nursery_block && find_hole(gc, gc->nursery_end)) {
+            continue;
+        }
+        if (!next_nursery_block(gc)) {
+            return NULL;
+        }
+    }
+    
+    GCObjectHeader* header = (GCObjectHeader*)gc->nursery_top;
+    gc->nursery_top += total;
+    gc->nursery_block->live++;
+    gc->nursery_block->live_bytes += total;
+    gc->block_live_bytes += total;
+    header->block = gc->nursery_block;
+    return header;
+}
+
+static bool sweep_step(GarbageCollector* gc, size_t budget);
+static void collect_full(GarbageCollector* gc, bool lazy);
+static void report_cycle(GarbageCollector* gc);
+
+// Allocate memory with GC tracking
+void* gc_alloc(GarbageCollector* gc, size_t size, const char* tag) {
+    // Each allocation pays for a slice of the last full collection's sweep
+    if (gc->phase == GC_PHASE_SWEEP && !gc->is_collecting) {
+        gc->stats.lazy_sweep_steps++;
+        if (sweep_step(gc, GC_SWEEP_BATCH)) {
+            report_cycle(gc);
+        }
+    }
+    
+    // About to cross the heap limit: collect everything first, once per
+    // time the VM reports running out
+    size_t limit = gc->config.max_heap_size;
+    if (limit > 0 && gc->bytes_allocated + size > limit && !gc->heap_exhausted && !gc->is_collecting) {
+        gc->stats.emergency_collections++;
+        collect_full(gc, false);
+        if (gc->bytes_allocated + size > limit) {
+            gc->heap_exhausted = true;
+            gc->stats.heap_limit_exceeded++;
+            LOG_WARN(LOG_MODULE_GC, "Heap limit of %zu bytes exceeded (%zu bytes live)",
+                     limit, gc->bytes_allocated);
+        }
+    }
+    
+    // Check if we need to collect. Incremental cycles advance in steps paced
+    // by allocation instead of stopping the world.
+    bool marking = gc->phase == GC_PHASE_MARK_ROOTS || gc->phase == GC_PHASE_MARK;
+    if (gc->config.incremental && (marking || gc_should_collect(gc))) {
+        if (!marking || gc->config.stress_test || gc->bytes_since_step >= GC_STEP_INTERVAL) {
+            gc_incremental_step(gc);
+        }
+    } else if (gc_should_collect(gc)) {
+        collect_full(gc, true);
+    } else if (gc->config.stress_test) {
+        if (gc->config.generational) {
+            gc_collect_minor(gc);
+        } else {
+            collect_full(gc, true);
+        }
+    } else if (gc->config.generational && gc->young_bytes >= gc->config.nursery_size) {
+        gc_collect_minor(gc);
+    }
+    
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+    size_t total = GC_HEADER_SIZE + GC_ROUND_UP(size);
+    bool in_nursery = gc->config.generational && total <= GC_LARGE_OBJECT_SIZE;
+    
+    GCObjectHeader* header = NULL;
+    if (in_nursery) {
+        header = nursery_alloc(gc, total);
+    } else {
+        // Allocate header and object as one block
+        header = MEM_ALLOC_TAGGED(alloc, GC_HEADER_SIZE + size, tag);
+        if (header) header->block = NULL;
+    }
+    if (!header) {
+        // Try collecting and retry
+        gc_collect(gc);
+        header = in_nursery ? nursery_alloc(gc, total)
+                            : MEM_ALLOC_TAGGED(alloc, GC_HEADER_SIZE + size, tag);
+        if (!header) return NULL;
+        if (!in_nursery) header->block = NULL;
+    }
+    
+    // Other GC allocations share this allocator; only "object*" ones may be
+    // traced or passed to object_destroy()
+    header->is_object = tag && strncmp(tag, "object", 6) == 0;
+    track_header(gc, header, size, gc->config.generational ? GC_YOUNG : GC_OLD);
+    gc->bytes_since_step += size;
+    
+    // Large objects reach the profiler through the allocator they come from;
+    // nursery ones only pass through here
+    if (in_nursery && gc->alloc_profiler) {
+        alloc_profiler_record(gc->alloc_profiler, total, tag);
+    }
     
     if (gc->config.verbose) {
-        LOG_DEBUG(LOG_MODULE_GC, "Tracked object %p (size %zu, total %zu bytes)", 
-                  object, size, gc->bytes_allocated);
+        LOG_DEBUG(LOG_MODULE_GC, "Allocated %p (size %zu, total %zu bytes)", 
+                  GC_PAYLOAD(header), size, gc->bytes_allocated);
     }
+    
+    return GC_PAYLOAD(header);
 }
 
-// Untrack an object (manual free)
-void gc_untrack_object(GarbageCollector* gc, void* object) {
-    if (!object) return;
+static void free_cards(GCRememberedEntry* entry) {
+    if (entry->cards) {
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        SLANG_MEM_FREE(alloc, entry->cards, entry->card_count);
+        entry->cards = NULL;
+        entry->card_count = 0;
+    }
+}
+
+// Add an old object to the remembered set
+static GCRememberedEntry* remember(GarbageCollector* gc, GCObjectHeader* header) {
+    if (gc->remembered_count == gc->remembered_capacity) {
+        size_t old_capacity = gc->remembered_capacity;
+        size_t new_capacity = old_capacity < 64 ? 64 : old_capacity * 2;
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        GCRememberedEntry* entries = MEM_REALLOC(alloc, gc->remembered,
+                                                 old_capacity * sizeof(GCRememberedEntry),
+                                                 new_capacity * sizeof(GCRememberedEntry));
+        if (!entries) return NULL;
+        gc->remembered = entries;
+        gc->remembered_capacity = new_capacity;
+    }
     
-    // Find the header
-    GCObjectHeader* header = gc->all_objects;
-    while (header) {
-        if (header->object == object) {
-            // Remove from list
-            if (header->prev) {
-                header->prev->next = header->next;
-            } else {
-                gc->all_objects = header->next;
-            }
-            if (header->next) {
-                header->next->prev = header->prev;
-            }
-            
-            // Update tracking
-            gc->bytes_allocated -= header->size;
-            gc->stats.current_allocated -= header->size;
-            gc->object_count--;
-            
-            // Free header
-            Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-            SLANG_MEM_FREE(alloc, header, sizeof(GCObjectHeader));
-            
+    GCRememberedEntry* entry = &gc->remembered[gc->remembered_count++];
+    entry->header = header;
+    entry->cards = NULL;
+    entry->card_count = 0;
+    header->remembered = (uint32_t)gc->remembered_count;
+    return entry;
+}
+
+static void forget_entry(GarbageCollector* gc, size_t index) {
+    GCRememberedEntry* entry = &gc->remembered[index];
+    entry->header->remembered = 0;
+    free_cards(entry);
+    
+    *entry = gc->remembered[--gc->remembered_count];
+    if (index < gc->remembered_count) {
+        entry->header->remembered = (uint32_t)index + 1;
+    }
+}
+
+// Mark the card holding element `index` dirty, growing the card table with
+// the array
+static void mark_card(GCRememberedEntry* entry, Object* array, size_t index) {
+    size_t card = index / GC_CARD_ELEMENTS;
+    if (card >= entry->card_count) {
+        size_t capacity = array->element_capacity > index ? array->element_capacity : index + 1;
+        size_t count = capacity / GC_CARD_ELEMENTS + 1;
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        uint8_t* cards = MEM_REALLOC(alloc, entry->cards, entry->card_count, count);
+        if (!cards) {
+            // Fall back to tracing the whole array
+            free_cards(entry);
             return;
         }
-        header = header->next;
+        memset(cards + entry->card_count, 0, count - entry->card_count);
+        entry->cards = cards;
+        entry->card_count = count;
     }
+    entry->cards[card] = 1;
 }
 
-// Find object header
-static GCObjectHeader* find_header(GarbageCollector* gc, void* object) {
-    GCObjectHeader* header = gc->all_objects;
-    while (header) {
-        if (header->object == object) {
-            return header;
-        }
-        header = header->next;
+// Free an allocation without waiting for a collection
+void gc_free(GarbageCollector* gc, void* object) {
+    if (!object) return;
+    
+    GCObjectHeader* header = GC_HEADER(object);
+    if (header->owner != gc) return;
+    
+    // The gray stack may still hold it; leave it to the sweep
+    if (gc->phase == GC_PHASE_MARK) return;
+    if (header == gc->sweep_cursor) {
+        gc->sweep_cursor = header->next;
     }
-    return NULL;
+    
+    // Drop it from the remembered set before its memory goes
+    if (header->remembered) {
+        forget_entry(gc, header->remembered - 1);
+    }
+    
+    gc->stats.total_freed += header->size;
+    free_header(gc, header);
 }
 
 // Mark a single object
-static void mark_object(GarbageCollector* gc, void* ptr) {
-    if (!ptr) return;
+static void mark_object(GarbageCollector* gc, Object* object) {
+    if (!object || !object->is_gc_managed) return;
     
-    GCObjectHeader* header = find_header(gc, ptr);
-    if (!header) return;
+    // Objects owned by another VM's collector are left to that collector,
+    // and a minor collection takes every old object to be live
+    GCObjectHeader* header = GC_HEADER(object);
+    if (header->owner != gc) return;
+    if (gc->is_minor && header->generation == GC_OLD) return;
     
     // Already marked?
     if (header->color != GC_WHITE) return;
@@ -247,68 +660,136 @@ static void mark_object(GarbageCollector* gc, void* ptr) {
     gray_stack_push(&gc->gray_stack, header);
     
     if (gc->config.verbose) {
-        LOG_DEBUG(LOG_MODULE_GC, "Marked object %p as gray", ptr);
+        LOG_DEBUG(LOG_MODULE_GC, "Marked object %p as gray", (void*)object);
     }
 }
 
+static void mark_value(GarbageCollector* gc, TaggedValue value);
+
+// Closures are not heap objects, but the values they captured must survive
+static void mark_closure(GarbageCollector* gc, Closure* closure) {
+    if (!closure || closure->gc_epoch == gc->mark_epoch) return;
+    closure->gc_epoch = gc->mark_epoch;
+    
+    for (int i = 0; i < closure->upvalue_count; i++) {
+        Upvalue* upvalue = closure->upvalues[i];
+        if (upvalue) {
+            mark_value(gc, *upvalue->location);
+        }
+    }
+}
+
+// Struct instances are copied by value, so their fields cannot form cycles
+static void mark_struct(GarbageCollector* gc, StructInstance* instance) {
+    if (!instance || !instance->type) return;
+    
+    for (size_t i = 0; i < instance->type->field_count; i++) {
+        mark_value(gc, instance->fields[i]);
+    }
+    mark_object(gc, instance->type->methods);
+}
+
 // Mark a value
 static void mark_value(GarbageCollector* gc, TaggedValue value) {
-    switch (value.type) {
+    switch (VALUE_TYPE(value)) {
         case VAL_OBJECT:
             mark_object(gc, AS_OBJECT(value));
             break;
         case VAL_STRING:
-            // Strings are in string pool, not GC managed
+            // Interned strings are swept from the pool after full
+            // collections; minor ones leave them alone
+            if (!gc->is_minor && gc->vm) {
+                string_pool_mark(&gc->vm->strings, AS_STRING(value));
+            }
             break;
         case VAL_CLOSURE:
-            mark_object(gc, AS_CLOSURE(value));
+            mark_closure(gc, AS_CLOSURE(value));
             break;
-        case VAL_FUNCTION:
-            mark_object(gc, AS_FUNCTION(value));
+        case VAL_STRUCT:
+            mark_struct(gc, AS_STRUCT(value));
             break;
         default:
-            // Primitive values don't need marking
+            // Primitive values, functions and natives don't need marking
             break;
     }
 }
 
-// Process gray objects
+// Mark the children of a gray object and turn it black
+static void blacken_object(GarbageCollector* gc, GCObjectHeader* header) {
+    header->color = GC_BLACK;
+    
+    // Mark children based on object type
+    if (!header->is_object) return;
+    Object* obj = (Object*)GC_PAYLOAD(header);
+    
+    // Mark object properties (deleted slots hold nil)
+    for (uint32_t i = 0; i < obj->slot_count; i++) {
+        mark_value(gc, obj->slots[i]);
+    }
+    for (size_t i = 0; i < obj->element_count; i++) {
+        mark_value(gc, obj->elements[i]);
+    }
+    
+    // Mark prototype
+    mark_object(gc, obj->prototype);
+    
+    if (gc->config.verbose) {
+        LOG_DEBUG(LOG_MODULE_GC, "Marked object %p as black", (void*)obj);
+    }
+}
+
+// Process gray objects. Full collections hand the work to the parallel
+// markers when there are any; the nursery is too small to be worth waking them.
 static void process_gray_objects(GarbageCollector* gc) {
+    if (gc->mark_pool && !gc->is_minor) {
+        gc_mark_pool_drain(gc->mark_pool, gc);
+        return;
+    }
     while (gc->gray_stack.count > 0) {
-        GCObjectHeader* header = gray_stack_pop(&gc->gray_stack);
-        if (!header) continue;
-        
-        // Mark as black
-        header->color = GC_BLACK;
-        
-        // Mark children based on object type
-        Object* obj = (Object*)header->object;
-        if (!obj) continue;
-        
-        // Mark object properties
-        ObjectProperty* prop = obj->properties;
-        while (prop) {
-            if (prop->value) {
-                mark_value(gc, *prop->value);
-            }
-            prop = prop->next;
-        }
-        
-        // Mark prototype
-        if (obj->prototype) {
-            mark_object(gc, obj->prototype);
-        }
-        
-        // Arrays are handled through their properties (indices as keys)
-        
-        if (gc->config.verbose) {
-            LOG_DEBUG(LOG_MODULE_GC, "Marked object %p as black", obj);
+        blacken_object(gc, gray_stack_pop(&gc->gray_stack));
+    }
+}
+
+// Shared prototypes belong to no collector, so each one traces what they hold
+static void mark_prototype_root(Object* prototype, void* user_data) {
+    GarbageCollector* gc = (GarbageCollector*)user_data;
+    
+    for (uint32_t i = 0; i < prototype->slot_count; i++) {
+        mark_value(gc, prototype->slots[i]);
+    }
+    for (size_t i = 0; i < prototype->element_count; i++) {
+        mark_value(gc, prototype->elements[i]);
+    }
+}
+
+// Module objects, exports and globals outlive the VM that ran the module
+static void mark_module_root(const char* name, Module* module, void* user_data) {
+    (void)name;
+    GarbageCollector* gc = (GarbageCollector*)user_data;
+    
+    mark_object(gc, module->module_object);
+    for (size_t i = 0; i < module->exports.count; i++) {
+        mark_value(gc, module->exports.values[i]);
+    }
+    for (size_t i = 0; i < module->globals.count; i++) {
+        mark_value(gc, module->globals.values[i]);
+    }
+    if (module->scope) {
+        for (size_t i = 0; i < module->scope->count; i++) {
+            mark_value(gc, module->scope->entries[i].value);
         }
     }
 }
 
 // Mark roots
 static void mark_roots(GarbageCollector* gc) {
+    for (size_t i = 0; i < gc->root_count; i++) {
+        mark_value(gc, *gc->roots[i]);
+    }
+    for (size_t i = 0; i < gc->temp_root_count; i++) {
+        mark_value(gc, gc->temp_roots[i]);
+    }
+    
     if (!gc->vm) return;
     
     // Mark VM stack
@@ -321,17 +802,21 @@ static void mark_roots(GarbageCollector* gc) {
         mark_value(gc, gc->vm->globals.values[i]);
     }
     
-    // Mark call frames
-    for (int i = 0; i < gc->vm->frame_count; i++) {
-        CallFrame* frame = &gc->vm->frames[i];
-        if (frame->closure) {
-            mark_object(gc, frame->closure);
+    // Mark struct method tables
+    for (size_t i = 0; i < gc->vm->struct_types.count; i++) {
+        if (gc->vm->struct_types.types[i]) {
+            mark_object(gc, gc->vm->struct_types.types[i]->methods);
         }
     }
     
-    // Mark open upvalues
-    for (Upvalue* upvalue = gc->vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
-        mark_object(gc, upvalue);
+    // Mark prototypes held in C statics
+    object_iterate_shared_prototypes(mark_prototype_root, gc);
+    
+    // Mark loaded modules
+    for (ModuleLoader* loader = gc->vm->module_loader; loader; loader = loader->parent) {
+        if (loader->cache) {
+            module_cache_iterate(loader->cache, mark_module_root, gc);
+        }
     }
     
     if (gc->config.verbose) {
@@ -339,58 +824,34 @@ static void mark_roots(GarbageCollector* gc) {
     }
 }
 
-// Sweep unmarked objects
-static size_t sweep(GarbageCollector* gc) {
-    GCObjectHeader* header = gc->all_objects;
-    GCObjectHeader* previous = NULL;
+// Sweep one generation's list. Survivors of the nursery are promoted.
+static size_t sweep_list(GarbageCollector* gc, GCObjectHeader** list, bool promote) {
+    GCObjectHeader* header = *list;
     size_t freed_count = 0;
     size_t freed_bytes = 0;
     
     while (header) {
+        GCObjectHeader* next = header->next;
+        
         if (header->color == GC_WHITE && !header->is_pinned) {
             // This object is garbage
-            GCObjectHeader* garbage = header;
-            
-            // Unlink from list
-            if (previous) {
-                previous->next = header->next;
-            } else {
-                gc->all_objects = header->next;
-            }
-            if (header->next) {
-                header->next->prev = previous;
-            }
-            
-            // Move to next before freeing
-            header = header->next;
-            
-            // Update stats
             freed_count++;
-            freed_bytes += garbage->size;
-            gc->bytes_allocated -= garbage->size;
-            gc->stats.current_allocated -= garbage->size;
-            gc->stats.total_freed += garbage->size;
-            gc->object_count--;
+            freed_bytes += header->size;
+            gc->stats.total_freed += header->size;
             
             if (gc->config.verbose) {
                 LOG_DEBUG(LOG_MODULE_GC, "Sweeping object %p (size %zu)", 
-                         garbage->object, garbage->size);
-            }
-            
-            // Destroy the object
-            if (garbage->object) {
-                object_destroy((Object*)garbage->object);
+                         GC_PAYLOAD(header), header->size);
             }
             
-            // Free the header
-            Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-            SLANG_MEM_FREE(alloc, garbage, sizeof(GCObjectHeader));
+            free_header(gc, header);
+        } else if (promote) {
+            promote_header(gc, header);
         } else {
             // Reset color for next GC
             header->color = GC_WHITE;
-            previous = header;
-            header = header->next;
         }
+        header = next;
     }
     
     gc->stats.objects_freed += freed_count;
@@ -402,13 +863,323 @@ static size_t sweep(GarbageCollector* gc) {
     return freed_bytes;
 }
 
-// Perform garbage collection
-void gc_collect(GarbageCollector* gc) {
-    if (gc->is_collecting) return;
+// Trace the old-to-young references recorded by the write barriers, then
+// forget them: once the nursery is empty there are none left
+static void mark_remembered(GarbageCollector* gc) {
+    for (size_t i = 0; i < gc->remembered_count; i++) {
+        GCRememberedEntry* entry = &gc->remembered[i];
+        if (!entry->cards) {
+            // Keep the color: an object the pending sweep has not reached
+            // yet must stay black
+            uint8_t color = entry->header->color;
+            blacken_object(gc, entry->header);
+            entry->header->color = color;
+            continue;
+        }
+        
+        // Carded arrays: named properties and the prototype are always
+        // traced, elements only in dirty cards
+        Object* array = (Object*)GC_PAYLOAD(entry->header);
+        for (uint32_t slot = 0; slot < array->slot_count; slot++) {
+            mark_value(gc, array->slots[slot]);
+        }
+        mark_object(gc, array->prototype);
+        for (size_t card = 0; card < entry->card_count; card++) {
+            if (!entry->cards[card]) continue;
+            size_t end = (card + 1) * GC_CARD_ELEMENTS;
+            if (end > array->element_count) end = array->element_count;
+            for (size_t e = card * GC_CARD_ELEMENTS; e < end; e++) {
+                mark_value(gc, array->elements[e]);
+            }
+        }
+    }
+    for (Upvalue* upvalue = gc->remembered_upvalues; upvalue; upvalue = upvalue->next_remembered) {
+        mark_value(gc, *upvalue->location);
+    }
+}
+
+static void clear_remembered(GarbageCollector* gc) {
+    for (size_t i = 0; i < gc->remembered_count; i++) {
+        gc->remembered[i].header->remembered = 0;
+        free_cards(&gc->remembered[i]);
+    }
+    gc->remembered_count = 0;
     
-    clock_t start_time = clock();
+    Upvalue* upvalue = gc->remembered_upvalues;
+    while (upvalue) {
+        Upvalue* next = upvalue->next_remembered;
+        upvalue->is_remembered = false;
+        upvalue->next_remembered = NULL;
+        upvalue = next;
+    }
+    gc->remembered_upvalues = NULL;
+}
+
+static size_t pause_bucket(uint64_t us) {
+    if (us < 16) return (size_t)us;
+    
+    size_t exponent = 4;
+    while (us >> (exponent + 1)) {
+        exponent++;
+    }
+    if (exponent >= 4 + 28) return GC_PAUSE_BUCKETS - 1;
+    size_t sub = (size_t)(us >> (exponent - 3)) & 7;
+    return 16 + (exponent - 4) * 8 + sub;
+}
+
+// Largest pause that falls in `bucket`
+static uint64_t pause_bucket_limit(size_t bucket) {
+    if (bucket < 16) return bucket;
+    
+    size_t exponent = 4 + (bucket - 16) / 8;
+    uint64_t sub = (bucket - 16) % 8;
+    return ((8 + sub + 1) << (exponent - 3)) - 1;
+}
+
+static void histogram_add(GCPauseHistogram* histogram, uint64_t us) {
+    histogram->counts[pause_bucket(us)]++;
+    histogram->count++;
+    if (us > histogram->max_us) {
+        histogram->max_us = us;
+    }
+}
+
+// Full cycles are reported when their sweep ends, but no sooner than the
+// end of the pause that ended it, so that the pause is counted in
+static void report_cycle(GarbageCollector* gc) {
+    if (!gc->cycle_done) return;
+    gc->cycle_done = false;
+    if (!gc->event_callback) return;
+    
+    gc->cycle.duration_us = platform_monotonic_us() - gc->created_us - gc->cycle.start_us;
+    gc->cycle.heap_after = gc->bytes_allocated;
+    gc->event_callback(&gc->cycle, gc->event_user_data);
+}
+
+static void begin_cycle(GarbageCollector* gc, GCEventKind kind) {
+    memset(&gc->cycle, 0, sizeof(GCEvent));
+    gc->cycle.kind = kind;
+    gc->cycle.cycle = gc->stats.collections;
+    gc->cycle.start_us = platform_monotonic_us() - gc->created_us;
+    gc->cycle.heap_before = gc->bytes_allocated;
+    // Turned into the difference once marking is over
+    gc->cycle.bytes_promoted = gc->stats.bytes_promoted;
+}
+
+static void record_pause(GarbageCollector* gc, uint64_t pause_us, bool minor) {
+    double elapsed = (double)pause_us / 1000.0;
+    gc->stats.last_gc_time = elapsed;
+    gc->stats.total_gc_time += elapsed;
+    if (elapsed > gc->stats.max_pause_time) {
+        gc->stats.max_pause_time = elapsed;
+    }
+    
+    if (minor) {
+        histogram_add(&gc->stats.minor_pauses, pause_us);
+    } else {
+        histogram_add(&gc->stats.full_pauses, pause_us);
+        gc->cycle.pause_us += pause_us;
+        gc->cycle.pauses++;
+        report_cycle(gc);
+    }
+}
+
+// Largest nursery the pause goal may grow to; a limited heap keeps most of
+// itself for the old generation
+static size_t nursery_limit(GarbageCollector* gc) {
+    size_t limit = GC_NURSERY_MAX;
+    if (gc->config.max_heap_size > 0 && gc->config.max_heap_size / 8 < limit) {
+        limit = gc->config.max_heap_size / 8;
+    }
+    return limit < GC_NURSERY_MIN ? GC_NURSERY_MIN : limit;
+}
+
+// Everything surviving a minor collection is promoted. When much of the
+// nursery does, objects may be outliving it only to die in the old
+// generation, so it is doubled while collecting stays well inside the pause
+// goal. If no fewer survive the next collection they are long-lived: it is
+// halved again and left alone until the next full collection. A nursery
+// that outgrows the cache costs more per byte to collect, so it never grows
+// just to collect less often. A collection over the goal shrinks it.
+static void adapt_nursery(GarbageCollector* gc, uint64_t pause_us, size_t young, size_t survived) {
+    uint32_t goal = gc->config.target_pause_us;
+    if (goal == 0 || young == 0 || gc->config.stress_test) return;
+    
+    double survival = (double)survived / (double)young;
+    size_t size = gc->config.nursery_size;
+    if (pause_us > goal) {
+        size = (size_t)((double)size * goal / (double)pause_us);
+    } else if (gc->nursery_survival > 0.0) {
+        if (survival > gc->nursery_survival * GC_GROWTH_PAYOFF) {
+            size /= 2;
+            gc->nursery_settled = true;
+        }
+        gc->nursery_survival = 0.0;
+    } else if (!gc->nursery_settled && pause_us * 2 < goal && survival > GC_SURVIVAL_HIGH &&
+               size < nursery_limit(gc)) {
+        gc->nursery_survival = survival;
+        size *= 2;
+    }
+    size_t limit = nursery_limit(gc);
+    if (size > limit) size = limit;
+    if (size < GC_NURSERY_MIN) size = GC_NURSERY_MIN;
+    
+    if (size != gc->config.nursery_size && gc->config.verbose) {
+        LOG_INFO(LOG_MODULE_GC, "Nursery resized to %zu bytes (pause %llu us, %zu of %zu bytes survived)",
+                 size, (unsigned long long)pause_us, survived, young);
+    }
+    gc->config.nursery_size = size;
+}
+
+// Collecting more often does not make marking the live heap any shorter, so
+// a full collection over the goal moves marking into steps that fit in it
+static void adapt_marking(GarbageCollector* gc, uint64_t pause_us) {
+    uint32_t goal = gc->config.target_pause_us;
+    if (goal == 0 || gc->config.incremental || pause_us <= goal) return;
+    
+    gc->config.incremental = true;
+    if (gc->config.max_pause_us == 0 || gc->config.max_pause_us > goal) {
+        gc->config.max_pause_us = goal;
+    }
+    if (gc->config.verbose) {
+        LOG_INFO(LOG_MODULE_GC, "Full collection took %llu us; marking incrementally from now on",
+                 (unsigned long long)pause_us);
+    }
+}
+
+// Set the next full collection trigger from what survived this one
+static void update_threshold(GarbageCollector* gc) {
+    gc->next_gc_threshold = gc->bytes_allocated * gc->config.heap_grow_factor;
+    if (gc->next_gc_threshold < gc->config.min_heap_size) {
+        gc->next_gc_threshold = gc->config.min_heap_size;
+    }
+    
+    // Under a heap limit, collect again before the old generation and a
+    // full nursery reach the last eighth of it
+    size_t max_heap = gc->config.max_heap_size;
+    if (max_heap > 0) {
+        size_t target = max_heap - max_heap / 8;
+        size_t used = gc->bytes_allocated + gc->config.nursery_size;
+        size_t room = used < target ? target - used : 0;
+        if (room < max_heap / 64) {
+            room = max_heap / 64;
+        }
+        if (gc->next_gc_threshold > room) {
+            gc->next_gc_threshold = room;
+        }
+    }
+    gc->nursery_settled = false;
+    if (gc->heap_exhausted && (max_heap == 0 || gc->bytes_allocated <= max_heap)) {
+        gc->heap_exhausted = false;
+    }
+}
+
+// Free the interned strings marking did not reach. The pool is swept as
+// soon as marking ends: strings made after that start out unmarked.
+static void sweep_strings(GarbageCollector* gc) {
+    if (!gc->vm) return;
+    StringPool* pool = &gc->vm->strings;
+    
+    size_t count = pool->entry_count;
+    size_t freed = string_pool_sweep(pool);
+    gc->stats.strings_freed += count - pool->entry_count;
+    gc->stats.string_bytes_freed += freed;
+    
+    gc->next_string_threshold = pool->bytes * gc->config.heap_grow_factor;
+    if (gc->next_string_threshold < gc->config.min_heap_size) {
+        gc->next_string_threshold = gc->config.min_heap_size;
+    }
+    if (gc->config.stress_test) {
+        gc->next_string_threshold = 0;
+    }
+}
+
+// Marking is over and the nursery is empty: what is left is to sweep the old
+// generation from `cursor` on. Everything linked in ahead of the cursor is
+// live or newer than the collection.
+static void begin_sweep(GarbageCollector* gc, GCObjectHeader* cursor) {
+    gc->phase = GC_PHASE_SWEEP;
+    gc->sweep_cursor = cursor;
+    gc->bytes_allocated_since_gc = 0;
+    gc->cycle.bytes_promoted = gc->stats.bytes_promoted - gc->cycle.bytes_promoted;
+}
+
+// Sweep up to `budget` objects from the cursor. Returns true, with the
+// collection complete, once the cursor has run off the end of the list.
+// Once the heap is fragmented the nursery reuses holes rather than taking
+// new blocks, so give the cached empty blocks back to the system
+static void release_memory(GarbageCollector* gc) {
+    if (!gc->free_blocks || !heap_fragmented(gc)) return;
+    
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
+    while (gc->free_blocks) {
+        GCBlock* next = gc->free_blocks->next;
+        SLANG_MEM_FREE(alloc, gc->free_blocks, GC_BLOCK_SIZE);
+        gc->free_blocks = next;
+        gc->stats.bytes_released += GC_BLOCK_SIZE;
+    }
+    gc->free_block_count = 0;
+    platform_trim_heap();
+}
+
+static bool sweep_step(GarbageCollector* gc, size_t budget) {
+    uint64_t start = platform_monotonic_us();
+    size_t visited = 0;
+    
+    while (gc->sweep_cursor && visited < budget) {
+        GCObjectHeader* header = gc->sweep_cursor;
+        gc->sweep_cursor = header->next;
+        visited++;
+        
+        if (header->color == GC_WHITE && !header->is_pinned) {
+            gc->stats.objects_freed++;
+            gc->stats.total_freed += header->size;
+            gc->cycle.objects_freed++;
+            gc->cycle.bytes_freed += header->size;
+            free_header(gc, header);
+        } else {
+            // Reset color for next cycle
+            header->color = GC_WHITE;
+        }
+    }
+    
+    bool done = gc->sweep_cursor == NULL;
+    if (done) {
+        gc->phase = GC_PHASE_NONE;
+        gc->cycle_done = true;
+        update_threshold(gc);
+        release_memory(gc);
+        
+        if (gc->config.verbose) {
+            LOG_INFO(LOG_MODULE_GC, "Collection #%zu swept (remaining: %zu bytes)", 
+                     gc->stats.collections, gc->bytes_allocated);
+        }
+    }
+    
+    gc->stats.objects_swept += visited;
+    gc->stats.total_sweep_time += (double)(platform_monotonic_us() - start) / 1000.0;
+    return done;
+}
+
+static bool incremental_run(GarbageCollector* gc, uint64_t deadline);
+
+// Stop-the-world full collection. With `lazy`, the old generation is left
+// for allocations to sweep, so the pause covers marking and the nursery only.
+static void collect_full(GarbageCollector* gc, bool lazy) {
+    // Called back from inside a collection
+    if (gc->is_collecting && gc->phase != GC_PHASE_MARK) return;
+    
+    // Marking needs an all-white heap: finish the incremental cycle or the
+    // sweep in progress, then collect what it allocated black
+    if (gc->phase != GC_PHASE_NONE) {
+        incremental_run(gc, UINT64_MAX);
+        report_cycle(gc);
+    }
+    
+    uint64_t start = platform_monotonic_us();
     gc->is_collecting = true;
     gc->stats.collections++;
+    begin_cycle(gc, GC_EVENT_FULL);
     
     if (gc->config.verbose) {
         LOG_INFO(LOG_MODULE_GC, "Starting collection #%zu (allocated: %zu bytes)", 
@@ -416,36 +1187,188 @@ void gc_collect(GarbageCollector* gc) {
     }
     
     // Mark phase
+    gc->mark_epoch = ++gc_epoch_counter;
     mark_roots(gc);
     process_gray_objects(gc);
+    sweep_strings(gc);
+    
+    // Sweep phase. Remembered objects may be among the dead, so forget them
+    // first; nothing young is left afterwards anyway. The nursery is swept
+    // right away, and its survivors are promoted ahead of the sweep cursor.
+    clear_remembered(gc);
+    GCObjectHeader* old_objects = gc->all_objects;
+    size_t objects_freed = gc->stats.objects_freed;
+    size_t freed = sweep_list(gc, &gc->young_objects, true);
+    gc->cycle.objects_freed = gc->stats.objects_freed - objects_freed;
+    gc->cycle.bytes_freed = freed;
+    gc->young_bytes = 0;
+    begin_sweep(gc, old_objects);
+    if (!lazy) {
+        sweep_step(gc, SIZE_MAX);
+    }
+    gc->is_collecting = false;
     
-    // Sweep phase
-    size_t freed = sweep(gc);
+    uint64_t pause_us = platform_monotonic_us() - start;
+    double elapsed = (double)pause_us / 1000.0;
+    record_pause(gc, pause_us, false);
+    if (lazy) {
+        adapt_marking(gc, pause_us);
+    }
     
-    // Update threshold
-    gc->bytes_allocated_since_gc = 0;
-    gc->next_gc_threshold = gc->bytes_allocated * gc->config.heap_grow_factor;
-    if (gc->next_gc_threshold < gc->config.min_heap_size) {
-        gc->next_gc_threshold = gc->config.min_heap_size;
+    if (gc->config.verbose) {
+        LOG_INFO(LOG_MODULE_GC, "Collection complete in %.2f ms: freed %zu nursery bytes%s (remaining: %zu bytes)", 
+                 elapsed, freed, lazy ? ", old generation left to sweep" : "", gc->bytes_allocated);
+    }
+}
+
+// Perform garbage collection; everything unreachable is freed on return
+void gc_collect(GarbageCollector* gc) {
+    collect_full(gc, false);
+}
+
+void gc_adopt(GarbageCollector* into, GarbageCollector* from) {
+    if (!into || !from || into == from) return;
+    
+    // The adoptees are new to a cycle `into` has in progress, so finish it.
+    // Whatever `from` was in the middle of is dropped: its marks miss what
+    // only objects of `into` reference, such as a module's exports.
+    if (into->phase != GC_PHASE_NONE) {
+        incremental_run(into, UINT64_MAX);
+        report_cycle(into);
+    }
+    clear_remembered(from);
+    from->gray_stack.count = 0;
+    from->phase = GC_PHASE_NONE;
+    from->sweep_cursor = NULL;
+    
+    // Adoptees join the old generation. What of `into` they can reference
+    // (module objects, exports, shared prototypes) is reachable from its
+    // roots anyway, so minor collections need not trace them.
+    GCObjectHeader* lists[] = {from->young_objects, from->all_objects};
+    for (size_t i = 0; i < sizeof(lists) / sizeof(lists[0]); i++) {
+        GCObjectHeader* header = lists[i];
+        while (header) {
+            GCObjectHeader* next = header->next;
+            header->owner = into;
+            header->generation = GC_OLD;
+            header->color = GC_WHITE;
+            header->remembered = 0;
+            link_header(&into->all_objects, header);
+            
+            into->object_count++;
+            into->bytes_allocated += header->size;
+            into->bytes_allocated_since_gc += header->size;
+            into->stats.current_allocated += header->size;
+            header = next;
+        }
+    }
+    if (into->stats.current_allocated > into->stats.peak_allocated) {
+        into->stats.peak_allocated = into->stats.current_allocated;
     }
-    if (gc->config.max_heap_size > 0 && gc->next_gc_threshold > gc->config.max_heap_size) {
-        gc->next_gc_threshold = gc->config.max_heap_size;
+    from->young_objects = NULL;
+    from->all_objects = NULL;
+    from->object_count = 0;
+    from->bytes_allocated = 0;
+    from->young_bytes = 0;
+    from->stats.current_allocated = 0;
+    
+    // The blocks holding adoptees go with them, the nursery block as a
+    // full one; empty blocks are left for gc_destroy()
+    retire_run(from);
+    GCBlock* nursery = from->nursery_block;
+    from->nursery_block = NULL;
+    from->nursery_top = from->nursery_end = NULL;
+    if (nursery && nursery->live == 0) {
+        from->block_count--;
+        nursery->next = from->free_blocks;
+        from->free_blocks = nursery;
+        from->free_block_count++;
+    }
+    GCBlock* recycle = from->recycle_blocks;
+    from->recycle_blocks = NULL;
+    while (recycle) {
+        GCBlock* next = recycle->next;
+        if (recycle->live == 0) {
+            from->block_count--;
+            recycle->next = from->free_blocks;
+            from->free_blocks = recycle;
+            from->free_block_count++;
+        } else {
+            recycle->next = into->recycle_blocks;
+            into->recycle_blocks = recycle;
+        }
+        recycle = next;
     }
+    into->block_count += from->block_count;
+    into->block_live_bytes += from->block_live_bytes;
+    from->block_count = 0;
+    from->block_live_bytes = 0;
+}
+
+// Collect the nursery only. Old objects are not traced, except the ones the
+// write barriers remembered; everything that survives is promoted.
+void gc_collect_minor(GarbageCollector* gc) {
+    if (gc->is_collecting) return;
     
+    uint64_t start = platform_monotonic_us();
+    size_t young = gc->young_bytes;
+    GCEvent event = {
+        .kind = GC_EVENT_MINOR,
+        .cycle = ++gc->stats.minor_collections,
+        .start_us = start - gc->created_us,
+        .pauses = 1,
+        .heap_before = gc->bytes_allocated,
+        .bytes_promoted = gc->stats.bytes_promoted,
+        .objects_freed = gc->stats.objects_freed
+    };
+    gc->is_collecting = true;
+    gc->is_minor = true;
+    
+    gc->mark_epoch = ++gc_epoch_counter;
+    mark_roots(gc);
+    mark_remembered(gc);
+    process_gray_objects(gc);
+    
+    size_t freed = sweep_list(gc, &gc->young_objects, true);
+    clear_remembered(gc);
+    gc->young_bytes = 0;
+    
+    gc->is_minor = false;
     gc->is_collecting = false;
     
-    // Update timing
-    clock_t end_time = clock();
-    double elapsed = ((double)(end_time - start_time)) / CLOCKS_PER_SEC * 1000.0;
-    gc->stats.last_gc_time = elapsed;
-    gc->stats.total_gc_time += elapsed;
+    uint64_t pause_us = platform_monotonic_us() - start;
+    double elapsed = (double)pause_us / 1000.0;
+    record_pause(gc, pause_us, true);
+    adapt_nursery(gc, pause_us, young, young > freed ? young - freed : 0);
+    
+    if (gc->event_callback) {
+        event.duration_us = pause_us;
+        event.pause_us = pause_us;
+        event.heap_after = gc->bytes_allocated;
+        event.bytes_promoted = gc->stats.bytes_promoted - event.bytes_promoted;
+        event.bytes_freed = freed;
+        event.objects_freed = gc->stats.objects_freed - event.objects_freed;
+        gc->event_callback(&event, gc->event_user_data);
+    }
     
     if (gc->config.verbose) {
-        LOG_INFO(LOG_MODULE_GC, "Collection complete: freed %zu bytes in %.2f ms (remaining: %zu bytes)", 
+        LOG_INFO(LOG_MODULE_GC, "Minor collection complete: freed %zu bytes in %.2f ms (old generation: %zu bytes)", 
                  freed, elapsed, gc->bytes_allocated);
     }
 }
 
+void gc_collect_strings(GarbageCollector* gc) {
+    if (!gc) return;
+    
+    // Until the cycle's marking is done and the pool swept, each call
+    // takes another step
+    if (gc->config.incremental) {
+        gc_incremental_step(gc);
+    } else if (!gc->is_collecting) {
+        collect_full(gc, true);
+    }
+}
+
 // Should we collect?
 bool gc_should_collect(GarbageCollector* gc) {
     return gc->bytes_allocated_since_gc > gc->next_gc_threshold;
@@ -453,38 +1376,96 @@ bool gc_should_collect(GarbageCollector* gc) {
 
 // Pin an object (prevent collection)
 void gc_pin_object(GarbageCollector* gc, void* object) {
-    GCObjectHeader* header = find_header(gc, object);
-    if (header) {
-        header->is_pinned = true;
+    if (object && GC_HEADER(object)->owner == gc) {
+        GC_HEADER(object)->is_pinned = true;
     }
 }
 
 // Unpin an object
 void gc_unpin_object(GarbageCollector* gc, void* object) {
-    GCObjectHeader* header = find_header(gc, object);
-    if (header) {
-        header->is_pinned = false;
+    if (object && GC_HEADER(object)->owner == gc) {
+        GC_HEADER(object)->is_pinned = false;
     }
 }
 
-// Write barrier for incremental GC
-void gc_write_barrier(GarbageCollector* gc, void* object, void* value) {
-    if (!gc->config.incremental) return;
-    if (!gc->is_collecting) return;
+// Write barrier
+void gc_write_barrier(GarbageCollector* gc, Object* object, TaggedValue value) {
+    if (!gc || !object || !object->is_gc_managed) return;
     
-    GCObjectHeader* obj_header = find_header(gc, object);
-    GCObjectHeader* val_header = find_header(gc, value);
+    GCObjectHeader* obj_header = GC_HEADER(object);
+    if (obj_header->owner != gc) return;
     
-    // If we're writing a white object into a black object during marking,
-    // we need to gray the black object again
-    if (obj_header && val_header && 
-        obj_header->color == GC_BLACK && 
-        val_header->color == GC_WHITE) {
-        obj_header->color = GC_GRAY;
-        gray_stack_push(&gc->gray_stack, obj_header);
+    Object* target = IS_OBJECT(value) ? AS_OBJECT(value) : NULL;
+    GCObjectHeader* val_header = target && target->is_gc_managed ? GC_HEADER(target) : NULL;
+    if (val_header && val_header->owner != gc) {
+        val_header = NULL;
+    }
+    
+    // Old object now pointing into the nursery. A carded entry already
+    // traces every named property, so only new entries matter here.
+    if (obj_header->generation == GC_OLD && !obj_header->remembered &&
+        ((val_header && val_header->generation == GC_YOUNG) || IS_STRUCT(value))) {
+        remember(gc, obj_header);
+    }
+    
+    // A black object is not scanned again in this cycle, so whatever is
+    // stored into it while marking must be shaded now
+    if (gc->phase == GC_PHASE_MARK && obj_header->color == GC_BLACK) {
+        mark_value(gc, value);
     }
 }
 
+void gc_element_write_barrier(GarbageCollector* gc, Object* array, size_t index, TaggedValue value) {
+    if (!gc || !array || !array->is_gc_managed) return;
+    
+    GCObjectHeader* header = GC_HEADER(array);
+    if (header->owner != gc || header->generation != GC_OLD) {
+        gc_write_barrier(gc, array, value);
+        return;
+    }
+    
+    Object* target = IS_OBJECT(value) ? AS_OBJECT(value) : NULL;
+    bool young = IS_STRUCT(value) ||
+                 (target && target->is_gc_managed && GC_HEADER(target)->owner == gc &&
+                  GC_HEADER(target)->generation == GC_YOUNG);
+    if (young) {
+        // An entry that started out tracing the whole array stays that way
+        if (header->remembered) {
+            GCRememberedEntry* entry = &gc->remembered[header->remembered - 1];
+            if (entry->cards) {
+                mark_card(entry, array, index);
+            }
+        } else {
+            GCRememberedEntry* entry = remember(gc, header);
+            if (entry && array->element_count > GC_CARD_ELEMENTS) {
+                mark_card(entry, array, index);
+            }
+        }
+    }
+    
+    if (gc->phase == GC_PHASE_MARK) {
+        gc_write_barrier(gc, array, value);
+    }
+}
+
+void gc_remember_upvalue(GarbageCollector* gc, Upvalue* upvalue) {
+    TaggedValue value = upvalue->closed;
+    
+    // The closure holding it may already be traced
+    if (gc->phase == GC_PHASE_MARK) {
+        mark_value(gc, value);
+    }
+    
+    // Minor collections find young values through the collector that owns
+    // them
+    if (upvalue->is_remembered || !IS_OBJECT(value) || !gc_value_may_be_young(value)) return;
+    GarbageCollector* owner = GC_HEADER(AS_OBJECT(value))->owner;
+    if (!owner) return;
+    upvalue->is_remembered = true;
+    upvalue->next_remembered = owner->remembered_upvalues;
+    owner->remembered_upvalues = upvalue;
+}
+
 // Get statistics
 GCStats gc_get_stats(GarbageCollector* gc) {
     return gc->stats;
@@ -499,17 +1480,101 @@ void gc_print_stats(GarbageCollector* gc) {
     printf("Current allocated:   %llu bytes\n", (unsigned long long)gc->stats.current_allocated);
     printf("Peak allocated:      %llu bytes\n", (unsigned long long)gc->stats.peak_allocated);
     printf("Objects freed:       %llu\n", (unsigned long long)gc->stats.objects_freed);
+    printf("Minor collections:   %llu\n", (unsigned long long)gc->stats.minor_collections);
+    printf("Objects promoted:    %llu (%llu bytes)\n", (unsigned long long)gc->stats.objects_promoted,
+           (unsigned long long)gc->stats.bytes_promoted);
     printf("Total GC time:       %.2f ms\n", gc->stats.total_gc_time);
     if (gc->stats.collections > 0) {
         printf("Average GC time:     %.2f ms\n", 
                gc->stats.total_gc_time / gc->stats.collections);
     }
     printf("Last GC time:        %.2f ms\n", gc->stats.last_gc_time);
+    const GCPauseHistogram* pauses[] = { &gc->stats.minor_pauses, &gc->stats.full_pauses };
+    const char* labels[] = { "Minor pauses:", "Full pauses:" };
+    for (size_t i = 0; i < 2; i++) {
+        if (pauses[i]->count == 0) continue;
+        printf("%-20s p50 %llu us, p99 %llu us, max %llu us\n", labels[i],
+               (unsigned long long)gc_pause_percentile(pauses[i], 50.0),
+               (unsigned long long)gc_pause_percentile(pauses[i], 99.0),
+               (unsigned long long)pauses[i]->max_us);
+    }
+    printf("Objects swept:       %llu (%llu lazy steps, %.2f ms)\n", (unsigned long long)gc->stats.objects_swept,
+           (unsigned long long)gc->stats.lazy_sweep_steps, gc->stats.total_sweep_time);
+    printf("Fragmentation:       %.1f%% (%llu blocks recycled, %llu bytes released)\n",
+           gc_fragmentation(gc) * 100.0, (unsigned long long)gc->stats.blocks_recycled,
+           (unsigned long long)gc->stats.bytes_released);
     printf("Current threshold:   %llu bytes\n", (unsigned long long)gc->next_gc_threshold);
+    printf("Nursery size:        %llu bytes\n", (unsigned long long)gc->config.nursery_size);
+    if (gc->config.max_heap_size > 0) {
+        printf("Heap limit:          %llu bytes (%llu emergency collections, exceeded %llu times)\n",
+               (unsigned long long)gc->config.max_heap_size,
+               (unsigned long long)gc->stats.emergency_collections,
+               (unsigned long long)gc->stats.heap_limit_exceeded);
+    }
+    printf("Strings freed:       %llu (%llu bytes)\n", (unsigned long long)gc->stats.strings_freed,
+           (unsigned long long)gc->stats.string_bytes_freed);
     printf("Live objects:        %llu\n", (unsigned long long)gc->object_count);
     printf("===================================\n");
 }
 
+uint64_t gc_pause_percentile(const GCPauseHistogram* histogram, double percentile) {
+    if (histogram->count == 0) return 0;
+    
+    size_t rank = (size_t)((double)histogram->count * percentile / 100.0 + 0.999999);
+    if (rank < 1) rank = 1;
+    size_t seen = 0;
+    for (size_t i = 0; i < GC_PAUSE_BUCKETS; i++) {
+        seen += histogram->counts[i];
+        if (seen >= rank) {
+            uint64_t limit = pause_bucket_limit(i);
+            return limit < histogram->max_us ? limit : histogram->max_us;
+        }
+    }
+    return histogram->max_us;
+}
+
+void gc_set_event_callback(GarbageCollector* gc, GCEventCallback callback, void* user_data) {
+    gc->event_callback = callback;
+    gc->event_user_data = user_data;
+}
+
+void gc_write_event_json(FILE* out, const GCEvent* event) {
+    static const char* kinds[] = { "minor", "full", "incremental" };
+    fprintf(out, "{\"event\":\"gc\",\"kind\":\"%s\",\"cycle\":%zu,\"start_us\":%llu,"
+                 "\"duration_us\":%llu,\"pause_us\":%llu,\"pauses\":%zu,"
+                 "\"heap_before\":%zu,\"heap_after\":%zu,\"promoted\":%zu,"
+                 "\"freed\":%zu,\"objects_freed\":%zu}\n",
+            kinds[event->kind], event->cycle, (unsigned long long)event->start_us,
+            (unsigned long long)event->duration_us, (unsigned long long)event->pause_us,
+            event->pauses, event->heap_before, event->heap_after, event->bytes_promoted,
+            event->bytes_freed, event->objects_freed);
+}
+
+static void write_histogram_json(FILE* out, const char* name, const GCPauseHistogram* histogram) {
+    fprintf(out, "\"%s\":{\"count\":%zu,\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,\"max_us\":%llu}",
+            name, histogram->count,
+            (unsigned long long)gc_pause_percentile(histogram, 50.0),
+            (unsigned long long)gc_pause_percentile(histogram, 90.0),
+            (unsigned long long)gc_pause_percentile(histogram, 99.0),
+            (unsigned long long)histogram->max_us);
+}
+
+void gc_write_stats_json(GarbageCollector* gc, FILE* out) {
+    const GCStats* stats = &gc->stats;
+    fprintf(out, "{\"event\":\"gc_summary\",\"collections\":%zu,\"minor_collections\":%zu,"
+                 "\"incremental_steps\":%zu,\"total_allocated\":%zu,\"total_freed\":%zu,"
+                 "\"peak_allocated\":%zu,\"current_allocated\":%zu,\"bytes_promoted\":%zu,"
+                 "\"strings_freed\":%zu,\"string_bytes_freed\":%zu,\"total_gc_ms\":%.3f,",
+            stats->collections, stats->minor_collections, stats->incremental_steps,
+            stats->total_allocated, stats->total_freed, stats->peak_allocated,
+            stats->current_allocated, stats->bytes_promoted, stats->strings_freed,
+            stats->string_bytes_freed, stats->total_gc_time);
+    write_histogram_json(out, "minor_pauses", &stats->minor_pauses);
+    fputc(',', out);
+    write_histogram_json(out, "full_pauses", &stats->full_pauses);
+    fputs("}\n", out);
+}
+
 // Set verbose mode
 void gc_set_verbose(GarbageCollector* gc, bool verbose) {
     gc->config.verbose = verbose;
@@ -523,136 +1588,201 @@ void gc_set_threshold(GarbageCollector* gc, size_t threshold) {
 
 // Set incremental mode
 void gc_set_incremental(GarbageCollector* gc, bool incremental) {
+    if (!incremental && gc->phase != GC_PHASE_NONE) {
+        incremental_run(gc, UINT64_MAX);
+        report_cycle(gc);
+    }
     gc->config.incremental = incremental;
 }
 
-// Perform incremental GC work
-void gc_incremental_step(GarbageCollector* gc, size_t work_units) {
-    if (!gc || gc->is_collecting || !gc->config.incremental) return;
+void gc_set_max_pause(GarbageCollector* gc, uint32_t max_pause_us) {
+    gc->config.max_pause_us = max_pause_us;
+}
+
+void gc_set_fragmentation_threshold(GarbageCollector* gc, double threshold) {
+    gc->config.fragmentation_threshold = threshold;
+}
+
+void gc_set_target_pause(GarbageCollector* gc, uint32_t target_pause_us) {
+    gc->config.target_pause_us = target_pause_us;
+}
+
+void gc_set_max_heap(GarbageCollector* gc, size_t max_heap_size) {
+    gc->config.max_heap_size = max_heap_size;
+    gc->heap_exhausted = false;
+    if (max_heap_size > 0 && gc->config.nursery_size > nursery_limit(gc)) {
+        gc->config.nursery_size = nursery_limit(gc);
+    }
+    update_threshold(gc);
+}
+
+// Not to be called during a collection
+void gc_set_mark_threads(GarbageCollector* gc, uint32_t threads) {
+    if (threads == gc->config.mark_threads) return;
+    gc_mark_pool_destroy(gc->mark_pool);
+    gc->mark_pool = gc_mark_pool_create(threads);
+    gc->config.mark_threads = gc->mark_pool ? threads : 1;
+}
+
+// Marking is finished once a rescan of the roots finds nothing new: stores
+// into the stack, globals and module tables have no barrier. The nursery then
+// joins the old generation, keeping its colors, so one cursor sweeps it all.
+static bool finish_marking(GarbageCollector* gc) {
+    mark_roots(gc);
+    if (gc->gray_stack.count > 0) return false;
+    sweep_strings(gc);
     
-    // Start a new incremental cycle if needed
-    if (gc->phase == GC_PHASE_NONE && gc_should_collect(gc)) {
-        gc->is_collecting = true;
-        gc->stats.collections++;
-        gc->phase = GC_PHASE_MARK_ROOTS;
-        
-        if (gc->config.verbose) {
-            LOG_INFO(LOG_MODULE_GC, "Starting incremental collection #%zu", 
-                     gc->stats.collections);
-        }
+    while (gc->young_objects) {
+        GCObjectHeader* header = gc->young_objects;
+        uint8_t color = header->color;
+        promote_header(gc, header);
+        header->color = color;
     }
+    clear_remembered(gc);
+    gc->young_bytes = 0;
+    begin_sweep(gc, gc->all_objects);
     
-    size_t work_done = 0;
-    clock_t start_time = clock();
+    // Sweeping needs no barriers, and minor collections may run again
+    gc->is_collecting = false;
+    return true;
+}
+
+// Advance the current cycle until it finishes or `deadline` passes. Returns
+// true if the cycle finished.
+static bool incremental_run(GarbageCollector* gc, uint64_t deadline) {
+    size_t work = 0;
     
-    while (work_done < work_units && gc->phase != GC_PHASE_NONE) {
+    while (gc->phase != GC_PHASE_NONE) {
         switch (gc->phase) {
             case GC_PHASE_MARK_ROOTS:
                 mark_roots(gc);
                 gc->phase = GC_PHASE_MARK;
-                work_done += 100; // Arbitrary cost for marking roots
                 break;
                 
             case GC_PHASE_MARK:
-                // Process some gray objects
-                while (work_done < work_units && gc->gray_stack.count > 0) {
-                    GCObjectHeader* header = gray_stack_pop(&gc->gray_stack);
-                    if (header) {
-                        // Mark children (simplified - real implementation in process_gray_objects)
-                        header->color = GC_BLACK;
-                        work_done += 10; // Arbitrary cost per object
+                while (gc->gray_stack.count > 0) {
+                    blacken_object(gc, gray_stack_pop(&gc->gray_stack));
+                    if (++work % GC_STEP_CHECK == 0 && platform_monotonic_us() >= deadline) {
+                        return false;
                     }
                 }
-                
-                if (gc->gray_stack.count == 0) {
-                    gc->phase = GC_PHASE_SWEEP;
-                    gc->sweep_cursor = gc->all_objects;
-                }
+                finish_marking(gc);
                 break;
                 
             case GC_PHASE_SWEEP:
-                // Sweep some objects
-                size_t swept = 0;
-                while (work_done < work_units && gc->sweep_cursor) {
-                    GCObjectHeader* next = gc->sweep_cursor->next;
-                    if (gc->sweep_cursor->color == GC_WHITE && !gc->sweep_cursor->is_pinned) {
-                        // Free this object
-                        size_t freed = gc->sweep_cursor->size;
-                        Object* obj = (Object*)gc->sweep_cursor->object;
-                        if (obj) {
-                            object_destroy(obj);
-                        }
-                        gc_untrack_object(gc, gc->sweep_cursor->object);
-                        gc->stats.objects_freed++;
-                        gc->stats.total_freed += freed;
-                        swept += freed;
-                    } else {
-                        // Reset color for next cycle
-                        gc->sweep_cursor->color = GC_WHITE;
-                    }
-                    gc->sweep_cursor = next;
-                    work_done += 5; // Arbitrary cost per object
-                }
-                
-                if (!gc->sweep_cursor) {
-                    // Collection complete
-                    gc->phase = GC_PHASE_NONE;
-                    gc->is_collecting = false;
-                    gc->bytes_allocated_since_gc = 0;
-                    gc->next_gc_threshold = gc->bytes_allocated * gc->config.heap_grow_factor;
-                    
-                    clock_t end_time = clock();
-                    double elapsed = ((double)(end_time - start_time)) / CLOCKS_PER_SEC * 1000.0;
-                    gc->stats.last_gc_time = elapsed;
-                    gc->stats.total_gc_time += elapsed;
-                    
-                    if (gc->config.verbose) {
-                        LOG_INFO(LOG_MODULE_GC, "Incremental collection complete: freed %zu bytes", 
-                                 swept);
+                while (!sweep_step(gc, GC_STEP_CHECK)) {
+                    if (platform_monotonic_us() >= deadline) {
+                        return false;
                     }
                 }
                 break;
                 
             default:
                 gc->phase = GC_PHASE_NONE;
+                gc->is_collecting = false;
                 break;
         }
     }
+    return true;
+}
+
+// Perform incremental GC work
+bool gc_incremental_step(GarbageCollector* gc) {
+    if (!gc) return true;
+    
+    // Start a new incremental cycle if needed
+    if (gc->phase == GC_PHASE_NONE) {
+        if (gc->is_collecting) return true;
+        gc->is_collecting = true;
+        gc->stats.collections++;
+        begin_cycle(gc, GC_EVENT_INCREMENTAL);
+        gc->phase = GC_PHASE_MARK_ROOTS;
+        gc->mark_epoch = ++gc_epoch_counter;
+        
+        if (gc->config.verbose) {
+            LOG_INFO(LOG_MODULE_GC, "Starting incremental collection #%zu", 
+                     gc->stats.collections);
+        }
+    }
+    
+    uint64_t start = platform_monotonic_us();
+    bool finished = incremental_run(gc, start + gc->config.max_pause_us);
+    gc->bytes_since_step = 0;
+    gc->stats.incremental_steps++;
+    record_pause(gc, platform_monotonic_us() - start, false);
+    return finished;
 }
 
 // Root management functions
 void gc_add_root(GarbageCollector* gc, TaggedValue* root) {
     if (!gc || !root) return;
     
-    // This would require a root set data structure
-    // For now, roots are discovered dynamically from the VM
-    // This function is a placeholder for future explicit root management
-    LOG_WARN(LOG_MODULE_GC, "gc_add_root not fully implemented - roots are managed by VM");
+    if (gc->root_count == gc->root_capacity) {
+        size_t old_capacity = gc->root_capacity;
+        size_t new_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        TaggedValue** roots = MEM_REALLOC(alloc, gc->roots,
+                                          old_capacity * sizeof(TaggedValue*),
+                                          new_capacity * sizeof(TaggedValue*));
+        if (!roots) {
+            LOG_ERROR(LOG_MODULE_GC, "Out of memory registering a GC root");
+            return;
+        }
+        gc->roots = roots;
+        gc->root_capacity = new_capacity;
+    }
+    gc->roots[gc->root_count++] = root;
 }
 
 void gc_remove_root(GarbageCollector* gc, TaggedValue* root) {
     if (!gc || !root) return;
     
-    // This would require a root set data structure
-    // For now, roots are discovered dynamically from the VM
-    // This function is a placeholder for future explicit root management
-    LOG_WARN(LOG_MODULE_GC, "gc_remove_root not fully implemented - roots are managed by VM");
+    // Roots tend to be removed soon after they are added, so search from the end
+    for (size_t i = gc->root_count; i > 0; i--) {
+        if (gc->roots[i - 1] == root) {
+            gc->roots[i - 1] = gc->roots[--gc->root_count];
+            return;
+        }
+    }
 }
 
 // Temporary root stack for protecting values during allocation
 void gc_push_temp_root(GarbageCollector* gc, TaggedValue value) {
     if (!gc) return;
     
-    // This would require a temporary root stack
-    // For now, we rely on the VM stack for protection
-    // A full implementation would maintain a separate stack of temporary roots
-    LOG_WARN(LOG_MODULE_GC, "gc_push_temp_root not fully implemented - use VM stack for protection");
+    if (gc->temp_root_count == gc->temp_root_capacity) {
+        size_t old_capacity = gc->temp_root_capacity;
+        size_t new_capacity = old_capacity < 16 ? 16 : old_capacity * 2;
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        TaggedValue* temp_roots = MEM_REALLOC(alloc, gc->temp_roots,
+                                              old_capacity * sizeof(TaggedValue),
+                                              new_capacity * sizeof(TaggedValue));
+        if (!temp_roots) {
+            LOG_ERROR(LOG_MODULE_GC, "Out of memory pushing a temporary GC root");
+            return;
+        }
+        gc->temp_roots = temp_roots;
+        gc->temp_root_capacity = new_capacity;
+    }
+    gc->temp_roots[gc->temp_root_count++] = value;
 }
 
 void gc_pop_temp_root(GarbageCollector* gc) {
     if (!gc) return;
     
-    // This would require a temporary root stack
-    // For now, we rely on the VM stack for protection
-    LOG_WARN(LOG_MODULE_GC, "gc_pop_temp_root not fully implemented - use VM stack for protection");
-}
\ No newline at end of file
+    if (gc->temp_root_count == 0) {
+        LOG_WARN(LOG_MODULE_GC, "gc_pop_temp_root called with no temporary roots");
+        return;
+    }
+    gc->temp_root_count--;
+}
+
+double gc_fragmentation(GarbageCollector* gc) {
+    // The untouched end of the run being filled is not a hole
+    size_t held = gc->block_count * GC_BLOCK_USABLE;
+    if (gc->nursery_top) {
+        held -= (size_t)(gc->nursery_end - gc->nursery_top);
+    }
+    if (held == 0 || gc->block_live_bytes >= held) return 0.0;
+    return 1.0 - (double)gc->block_live_bytes / (double)held;
+}
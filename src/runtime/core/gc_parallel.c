@@ -0,0 +1,407 @@
+#include "runtime/core/gc_parallel.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/object.h"
+#include "runtime/core/vm.h"
+#include "utils/allocators.h"
+#include "utils/platform_threads.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+
+// A marker holding more than this many grays publishes half of them once
+// its shared stack has been emptied
+#define GC_SHARE_THRESHOLD 64
+
+typedef struct {
+    GCObjectHeader** items;
+    size_t count;
+    size_t capacity;
+} MarkStack;
+
+typedef struct {
+    struct GCMarkPool* pool;
+    size_t index;
+    MarkStack local;               // Only touched by this marker
+    MarkStack shared;              // Stealable, guarded by `lock`
+    atomic_size_t shared_count;    // Read without the lock to find victims
+    platform_mutex_t lock;
+} GCMarker;
+
+struct GCMarkPool {
+    size_t thread_count;
+    GCMarker* markers;
+    platform_thread_t* threads;    // thread_count - 1 workers
+
+    platform_mutex_t lock;
+    platform_cond_t start_cond;
+    platform_cond_t done_cond;
+    uint64_t round;                // Bumped to start each drain
+    size_t running;                // Workers still in the current round
+    bool shutdown;
+
+    GarbageCollector* gc;          // Collector of the current round
+    atomic_size_t idle;            // Markers out of work
+
+    // Allocators are not thread-safe; stacks grow under this lock
+    platform_mutex_t alloc_lock;
+};
+
+static void mark_stack_free(MarkStack* stack) {
+    if (stack->items) {
+        Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+        SLANG_MEM_FREE(alloc, stack->items, stack->capacity * sizeof(GCObjectHeader*));
+    }
+    stack->items = NULL;
+    stack->count = 0;
+    stack->capacity = 0;
+}
+
+static void mark_stack_reserve(GCMarkPool* pool, MarkStack* stack, size_t needed) {
+    if (needed <= stack->capacity) return;
+
+    size_t old_capacity = stack->capacity;
+    size_t capacity = old_capacity < 128 ? 128 : old_capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+
+    platform_mutex_lock(&pool->alloc_lock);
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+    stack->items = MEM_REALLOC(alloc, stack->items,
+                               old_capacity * sizeof(GCObjectHeader*),
+                               capacity * sizeof(GCObjectHeader*));
+    platform_mutex_unlock(&pool->alloc_lock);
+    stack->capacity = capacity;
+}
+
+static void marker_push(GCMarker* marker, GCObjectHeader* header) {
+    MarkStack* stack = &marker->local;
+    if (stack->count == stack->capacity) {
+        mark_stack_reserve(marker->pool, stack, stack->count + 1);
+    }
+    stack->items[stack->count++] = header;
+}
+
+// Move the oldest half of the local stack, the roots of the largest
+// untraced subgraphs, to where other markers can take it
+static void marker_share(GCMarker* marker) {
+    MarkStack* local = &marker->local;
+    size_t count = local->count / 2;
+
+    platform_mutex_lock(&marker->lock);
+    mark_stack_reserve(marker->pool, &marker->shared, marker->shared.count + count);
+    memcpy(marker->shared.items + marker->shared.count, local->items, count * sizeof(GCObjectHeader*));
+    marker->shared.count += count;
+    atomic_store(&marker->shared_count, marker->shared.count);
+    platform_mutex_unlock(&marker->lock);
+
+    memmove(local->items, local->items + count, (local->count - count) * sizeof(GCObjectHeader*));
+    local->count -= count;
+}
+
+// Take half of `victim`'s shared grays (all of them if it is the caller)
+static bool marker_take(GCMarker* marker, GCMarker* victim) {
+    platform_mutex_lock(&victim->lock);
+    size_t available = victim->shared.count;
+    size_t count = victim == marker ? available : (available + 1) / 2;
+    if (count == 0) {
+        platform_mutex_unlock(&victim->lock);
+        return false;
+    }
+
+    mark_stack_reserve(marker->pool, &marker->local, marker->local.count + count);
+    victim->shared.count -= count;
+    memcpy(marker->local.items + marker->local.count,
+           victim->shared.items + victim->shared.count, count * sizeof(GCObjectHeader*));
+    marker->local.count += count;
+    atomic_store(&victim->shared_count, victim->shared.count);
+    platform_mutex_unlock(&victim->lock);
+    return true;
+}
+
+// Tracing mirrors the serial marker in gc.c; the only difference is that
+// shading an object or a closure has to win a race with the other markers
+static void par_mark_value(GCMarker* marker, TaggedValue value);
+
+static void par_mark_object(GCMarker* marker, Object* object) {
+    if (!object || !object->is_gc_managed) return;
+
+    GarbageCollector* gc = marker->pool->gc;
+    GCObjectHeader* header = GC_HEADER(object);
+    if (header->owner != gc) return;
+    if (gc->is_minor && header->generation == GC_OLD) return;
+
+    if (platform_atomic_load_u8(&header->color) == GC_WHITE &&
+        platform_atomic_cas_u8(&header->color, GC_WHITE, GC_GRAY)) {
+        marker_push(marker, header);
+    }
+}
+
+static void par_mark_closure(GCMarker* marker, Closure* closure) {
+    if (!closure) return;
+    uint32_t epoch = marker->pool->gc->mark_epoch;
+    uint32_t seen = platform_atomic_load_u32(&closure->gc_epoch);
+    if (seen == epoch || !platform_atomic_cas_u32(&closure->gc_epoch, seen, epoch)) return;
+
+    for (int i = 0; i < closure->upvalue_count; i++) {
+        Upvalue* upvalue = closure->upvalues[i];
+        if (upvalue) {
+            par_mark_value(marker, *upvalue->location);
+        }
+    }
+}
+
+static void par_mark_struct(GCMarker* marker, StructInstance* instance) {
+    if (!instance || !instance->type) return;
+
+    for (size_t i = 0; i < instance->type->field_count; i++) {
+        par_mark_value(marker, instance->fields[i]);
+    }
+    par_mark_object(marker, instance->type->methods);
+}
+
+// Only the marker that marks a rope goes on to its halves, left spine in a
+// loop as string_pool_mark_rope() does
+static void par_mark_string(GCMarker* marker, const char* string) {
+    VM* vm = marker->pool->gc->vm;
+    if (!vm) return;
+    
+    while (string) {
+        StringHeader* header = STRING_HEADER(string);
+        if (!string_is_owned_by(string, vm->strings.id) ||
+            !platform_atomic_cas_u8(&header->marked, 0, 1) ||
+            !(header->flags & STRING_ROPE)) {
+            return;
+        }
+        
+        const StringRope* rope = STRING_ROPE_DATA(string);
+        if (rope->flat) {
+            string = rope->flat;
+            continue;
+        }
+        par_mark_string(marker, rope->right);
+        string = rope->left;
+    }
+}
+
+static void par_mark_value(GCMarker* marker, TaggedValue value) {
+    switch (VALUE_TYPE(value)) {
+        case VAL_OBJECT:
+            par_mark_object(marker, AS_OBJECT(value));
+            break;
+        case VAL_STRING:
+            par_mark_string(marker, AS_STRING(value));
+            break;
+        case VAL_CLOSURE:
+            par_mark_closure(marker, AS_CLOSURE(value));
+            break;
+        case VAL_STRUCT:
+            par_mark_struct(marker, AS_STRUCT(value));
+            break;
+        default:
+            break;
+    }
+}
+
+static void par_blacken(GCMarker* marker, GCObjectHeader* header) {
+    // Only the marker that shaded it gets here, and other markers only
+    // compare against white
+    platform_atomic_store_u8(&header->color, GC_BLACK);
+    if (!header->is_object) return;
+    Object* obj = (Object*)GC_PAYLOAD(header);
+
+    for (uint32_t i = 0; i < obj->slot_count; i++) {
+        par_mark_value(marker, obj->slots[i]);
+    }
+    for (size_t i = 0; i < obj->element_count; i++) {
+        par_mark_value(marker, obj->elements[i]);
+    }
+    par_mark_object(marker, obj->prototype);
+}
+
+// Steal from any marker with shared work. Returns false once every marker
+// is idle, which can only happen when all shared stacks are empty: a marker
+// goes idle only after emptying its own, and only its owner adds to one.
+static bool marker_steal(GCMarker* marker) {
+    GCMarkPool* pool = marker->pool;
+    atomic_fetch_add(&pool->idle, 1);
+
+    for (;;) {
+        if (atomic_load(&pool->idle) == pool->thread_count) {
+            return false;
+        }
+
+        for (size_t i = 1; i < pool->thread_count; i++) {
+            GCMarker* victim = &pool->markers[(marker->index + i) % pool->thread_count];
+            if (atomic_load(&victim->shared_count) == 0) continue;
+
+            // Count as busy before taking anything so nobody sees the pool
+            // idle while this marker holds stolen grays
+            atomic_fetch_sub(&pool->idle, 1);
+            if (marker_take(marker, victim)) {
+                return true;
+            }
+            atomic_fetch_add(&pool->idle, 1);
+        }
+        platform_thread_yield();
+    }
+}
+
+static void marker_run(GCMarker* marker) {
+    for (;;) {
+        while (marker->local.count > 0 || marker_take(marker, marker)) {
+            par_blacken(marker, marker->local.items[--marker->local.count]);
+
+            if (marker->local.count > GC_SHARE_THRESHOLD &&
+                atomic_load(&marker->shared_count) == 0) {
+                marker_share(marker);
+            }
+        }
+        if (!marker_steal(marker)) {
+            return;
+        }
+    }
+}
+
+static PLATFORM_THREAD_FUNC(mark_worker_main, arg) {
+    GCMarker* marker = (GCMarker*)arg;
+    GCMarkPool* pool = marker->pool;
+    uint64_t seen_round = 0;
+
+    platform_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && pool->round == seen_round) {
+            platform_cond_wait(&pool->start_cond, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        seen_round = pool->round;
+        platform_mutex_unlock(&pool->lock);
+
+        marker_run(marker);
+
+        platform_mutex_lock(&pool->lock);
+        if (--pool->running == 0) {
+            platform_cond_broadcast(&pool->done_cond);
+        }
+    }
+    platform_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+static void destroy_markers(GCMarkPool* pool) {
+    for (size_t i = 0; i < pool->thread_count; i++) {
+        GCMarker* marker = &pool->markers[i];
+        mark_stack_free(&marker->local);
+        mark_stack_free(&marker->shared);
+        platform_mutex_destroy(&marker->lock);
+    }
+}
+
+GCMarkPool* gc_mark_pool_create(size_t threads) {
+    if (threads < 2) return NULL;
+
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+    GCMarkPool* pool = MEM_NEW(alloc, GCMarkPool);
+    if (!pool) return NULL;
+
+    pool->markers = MEM_NEW_ARRAY(alloc, GCMarker, threads);
+    pool->threads = MEM_NEW_ARRAY(alloc, platform_thread_t, threads - 1);
+    if (!pool->markers || !pool->threads) {
+        if (pool->markers) SLANG_MEM_FREE(alloc, pool->markers, threads * sizeof(GCMarker));
+        if (pool->threads) SLANG_MEM_FREE(alloc, pool->threads, (threads - 1) * sizeof(platform_thread_t));
+        SLANG_MEM_FREE(alloc, pool, sizeof(GCMarkPool));
+        return NULL;
+    }
+
+    pool->thread_count = threads;
+    platform_mutex_init(&pool->lock);
+    platform_mutex_init(&pool->alloc_lock);
+    platform_cond_init(&pool->start_cond);
+    platform_cond_init(&pool->done_cond);
+    atomic_init(&pool->idle, 0);
+    for (size_t i = 0; i < threads; i++) {
+        GCMarker* marker = &pool->markers[i];
+        marker->pool = pool;
+        marker->index = i;
+        atomic_init(&marker->shared_count, 0);
+        platform_mutex_init(&marker->lock);
+    }
+
+    // Marker 0 is whichever thread collects
+    size_t started = 0;
+    while (started < threads - 1 &&
+           platform_thread_create(&pool->threads[started], mark_worker_main, &pool->markers[started + 1]) == 0) {
+        started++;
+    }
+    if (started < threads - 1) {
+        platform_mutex_lock(&pool->lock);
+        pool->shutdown = true;
+        platform_cond_broadcast(&pool->start_cond);
+        platform_mutex_unlock(&pool->lock);
+        for (size_t i = 0; i < started; i++) {
+            platform_thread_join(pool->threads[i]);
+        }
+        gc_mark_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void gc_mark_pool_destroy(GCMarkPool* pool) {
+    if (!pool) return;
+
+    if (!pool->shutdown) {
+        platform_mutex_lock(&pool->lock);
+        pool->shutdown = true;
+        platform_cond_broadcast(&pool->start_cond);
+        platform_mutex_unlock(&pool->lock);
+        for (size_t i = 0; i < pool->thread_count - 1; i++) {
+            platform_thread_join(pool->threads[i]);
+        }
+    }
+
+    destroy_markers(pool);
+    platform_cond_destroy(&pool->start_cond);
+    platform_cond_destroy(&pool->done_cond);
+    platform_mutex_destroy(&pool->alloc_lock);
+    platform_mutex_destroy(&pool->lock);
+
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_VM);
+    SLANG_MEM_FREE(alloc, pool->markers, pool->thread_count * sizeof(GCMarker));
+    SLANG_MEM_FREE(alloc, pool->threads, (pool->thread_count - 1) * sizeof(platform_thread_t));
+    SLANG_MEM_FREE(alloc, pool, sizeof(GCMarkPool));
+}
+
+size_t gc_mark_pool_threads(const GCMarkPool* pool) {
+    return pool ? pool->thread_count : 1;
+}
+
+void gc_mark_pool_drain(GCMarkPool* pool, GarbageCollector* gc) {
+    // The seed grays go to the collecting marker's shared stack, where the
+    // workers start by stealing them
+    GCMarker* self = &pool->markers[0];
+    GrayStack* seed = &gc->gray_stack;
+    mark_stack_reserve(pool, &self->shared, seed->count);
+    memcpy(self->shared.items, seed->items, seed->count * sizeof(GCObjectHeader*));
+    self->shared.count = seed->count;
+    atomic_store(&self->shared_count, seed->count);
+    seed->count = 0;
+
+    platform_mutex_lock(&pool->lock);
+    pool->gc = gc;
+    atomic_store(&pool->idle, 0);
+    pool->running = pool->thread_count - 1;
+    pool->round++;
+    platform_cond_broadcast(&pool->start_cond);
+    platform_mutex_unlock(&pool->lock);
+
+    marker_run(self);
+
+    // Workers may still be on their way out of marker_steal()
+    platform_mutex_lock(&pool->lock);
+    while (pool->running > 0) {
+        platform_cond_wait(&pool->done_cond, &pool->lock);
+    }
+    pool->gc = NULL;
+    platform_mutex_unlock(&pool->lock);
+}
@@ -0,0 +1,958 @@
+#include "runtime/core/heap_snapshot.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/object.h"
+#include "runtime/core/vm.h"
+#include "runtime/modules/loader/module_cache.h"
+#include "runtime/modules/loader/module_loader.h"
+#include "utils/allocators.h"
+#include "utils/bytecode_format.h"
+#include "utils/hash_map.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SNAPSHOT_MAGIC "SLHS"
+#define SNAPSHOT_VERSION 1
+
+#define NO_NODE UINT32_MAX
+
+// Grow a VM-allocated array so it can hold one more item
+static bool reserve(void** items, size_t* capacity, size_t count, size_t item_size) {
+    if (count < *capacity) return true;
+    size_t new_capacity = *capacity ? *capacity * 2 : 64;
+    void* grown = VM_REALLOC(*items, *capacity * item_size, new_capacity * item_size);
+    if (!grown) return false;
+    *items = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+static HeapSnapshot* snapshot_create(void) {
+    HeapSnapshot* snapshot = VM_ALLOC_ZERO(sizeof(HeapSnapshot));
+    return snapshot;
+}
+
+void heap_snapshot_free(HeapSnapshot* snapshot) {
+    if (!snapshot) return;
+    for (size_t i = 0; i < snapshot->string_count; i++) {
+        VM_FREE(snapshot->strings[i], strlen(snapshot->strings[i]) + 1);
+    }
+    if (snapshot->strings) VM_FREE(snapshot->strings, snapshot->string_capacity * sizeof(char*));
+    if (snapshot->nodes) VM_FREE(snapshot->nodes, snapshot->node_capacity * sizeof(SnapshotNode));
+    if (snapshot->edges) VM_FREE(snapshot->edges, snapshot->edge_capacity * sizeof(SnapshotEdge));
+    VM_FREE(snapshot, sizeof(HeapSnapshot));
+}
+
+static bool append_string(HeapSnapshot* snapshot, const char* str, size_t len) {
+    if (!reserve((void**)&snapshot->strings, &snapshot->string_capacity,
+                 snapshot->string_count, sizeof(char*))) {
+        return false;
+    }
+    char* copy = VM_ALLOC(len + 1);
+    if (!copy) return false;
+    memcpy(copy, str, len);
+    copy[len] = '\0';
+    snapshot->strings[snapshot->string_count++] = copy;
+    return true;
+}
+
+static bool append_node(HeapSnapshot* snapshot, SnapshotNode node) {
+    if (!reserve((void**)&snapshot->nodes, &snapshot->node_capacity,
+                 snapshot->node_count, sizeof(SnapshotNode))) {
+        return false;
+    }
+    snapshot->nodes[snapshot->node_count++] = node;
+    return true;
+}
+
+static bool append_edge(HeapSnapshot* snapshot, SnapshotEdge edge) {
+    if (!reserve((void**)&snapshot->edges, &snapshot->edge_capacity,
+                 snapshot->edge_count, sizeof(SnapshotEdge))) {
+        return false;
+    }
+    snapshot->edges[snapshot->edge_count++] = edge;
+    return true;
+}
+
+// Taking a snapshot
+
+typedef struct {
+    HeapSnapshot* snapshot;
+    HashMap* string_ids;           // String -> index + 1
+    const void** addresses;        // Per node; NULL for root categories
+    size_t address_capacity;
+    uint32_t* table;               // Open addressing on address: node index + 1
+    size_t table_capacity;
+    bool failed;
+} SnapshotBuilder;
+
+static uint32_t intern(SnapshotBuilder* builder, const char* str) {
+    if (!str) str = "";
+    void* found = hash_map_get(builder->string_ids, str);
+    if (found) return (uint32_t)((uintptr_t)found - 1);
+
+    HeapSnapshot* snapshot = builder->snapshot;
+    if (!append_string(snapshot, str, strlen(str))) {
+        builder->failed = true;
+        return 0;
+    }
+    uint32_t id = (uint32_t)(snapshot->string_count - 1);
+    hash_map_put(builder->string_ids, str, (void*)(uintptr_t)(id + 1));
+    return id;
+}
+
+static size_t address_slot(const void* address, size_t capacity) {
+    uint64_t hash = (uint64_t)(uintptr_t)address * 0x9E3779B97F4A7C15ull;
+    return (size_t)(hash >> 32) & (capacity - 1);
+}
+
+static uint32_t find_address(SnapshotBuilder* builder, const void* address) {
+    if (builder->table_capacity == 0) return NO_NODE;
+    size_t mask = builder->table_capacity - 1;
+    for (size_t i = address_slot(address, builder->table_capacity);; i = (i + 1) & mask) {
+        uint32_t entry = builder->table[i];
+        if (entry == 0) return NO_NODE;
+        if (builder->addresses[entry - 1] == address) return entry - 1;
+    }
+}
+
+static void insert_address(uint32_t* table, size_t capacity, const void* address, uint32_t node) {
+    size_t mask = capacity - 1;
+    size_t i = address_slot(address, capacity);
+    while (table[i] != 0) i = (i + 1) & mask;
+    table[i] = node + 1;
+}
+
+// Kept at most half full
+static bool index_address(SnapshotBuilder* builder, const void* address, uint32_t node) {
+    if ((node + 1) * 2 > builder->table_capacity) {
+        size_t capacity = builder->table_capacity ? builder->table_capacity * 2 : 1024;
+        uint32_t* table = VM_ALLOC_ZERO(capacity * sizeof(uint32_t));
+        if (!table) return false;
+        for (size_t i = 0; i < builder->table_capacity; i++) {
+            uint32_t entry = builder->table[i];
+            if (entry) insert_address(table, capacity, builder->addresses[entry - 1], entry - 1);
+        }
+        if (builder->table) VM_FREE(builder->table, builder->table_capacity * sizeof(uint32_t));
+        builder->table = table;
+        builder->table_capacity = capacity;
+    }
+    insert_address(builder->table, builder->table_capacity, address, node);
+    return true;
+}
+
+static uint32_t add_node(SnapshotBuilder* builder, SnapshotNodeKind kind, uint32_t name,
+                         uint64_t self_size, const void* address) {
+    HeapSnapshot* snapshot = builder->snapshot;
+    uint32_t id = (uint32_t)snapshot->node_count;
+    SnapshotNode node = {.kind = (uint8_t)kind, .name = name, .self_size = self_size};
+    if (!reserve((void**)&builder->addresses, &builder->address_capacity,
+                 snapshot->node_count, sizeof(void*)) ||
+        !append_node(snapshot, node) ||
+        (address && !index_address(builder, address, id))) {
+        builder->failed = true;
+        return NO_NODE;
+    }
+    builder->addresses[id] = address;
+    return id;
+}
+
+static uint32_t add_category(SnapshotBuilder* builder, const char* name) {
+    uint32_t node = add_node(builder, SNAPSHOT_ROOT, intern(builder, name), 0, NULL);
+    if (node != NO_NODE) {
+        SnapshotEdge edge = {.from = 0, .to = node, .kind = SNAPSHOT_EDGE_NAMED, .label = intern(builder, name)};
+        if (!append_edge(builder->snapshot, edge)) builder->failed = true;
+    }
+    return node;
+}
+
+static uint64_t object_self_size(Object* object) {
+    uint64_t size = object->is_gc_managed ? GC_HEADER_SIZE + GC_HEADER(object)->size : sizeof(Object);
+    size += (uint64_t)object->slot_capacity * sizeof(TaggedValue);
+    size += (uint64_t)object->element_capacity * sizeof(TaggedValue);
+    return size;
+}
+
+// Node of a value, added on first sight; NO_NODE for values holding nothing
+static uint32_t node_for_value(SnapshotBuilder* builder, TaggedValue value) {
+    const void* address;
+    switch (VALUE_TYPE(value)) {
+        case VAL_OBJECT: address = AS_OBJECT(value); break;
+        case VAL_CLOSURE: address = AS_CLOSURE(value); break;
+        case VAL_STRUCT: address = AS_STRUCT(value); break;
+        default: return NO_NODE;
+    }
+    if (!address) return NO_NODE;
+
+    uint32_t node = find_address(builder, address);
+    if (node != NO_NODE) return node;
+
+    switch (VALUE_TYPE(value)) {
+        case VAL_OBJECT: {
+            Object* object = AS_OBJECT(value);
+            return add_node(builder, object->is_array ? SNAPSHOT_ARRAY : SNAPSHOT_OBJECT,
+                            intern(builder, ""), object_self_size(object), object);
+        }
+        case VAL_CLOSURE: {
+            Closure* closure = AS_CLOSURE(value);
+            const char* name = closure->function && closure->function->name
+                ? closure->function->name : "<anonymous>";
+            return add_node(builder, SNAPSHOT_CLOSURE, intern(builder, name),
+                            sizeof(Closure) + (uint64_t)closure->upvalue_count * sizeof(Upvalue*),
+                            closure);
+        }
+        default: {
+            StructInstance* instance = AS_STRUCT(value);
+            size_t field_count = instance->type ? instance->type->field_count : 0;
+            return add_node(builder, SNAPSHOT_STRUCT,
+                            intern(builder, instance->type ? instance->type->name : ""),
+                            sizeof(StructInstance) + (uint64_t)field_count * sizeof(TaggedValue),
+                            instance);
+        }
+    }
+}
+
+static void link_value(SnapshotBuilder* builder, uint32_t from, SnapshotEdgeKind kind,
+                       uint32_t label, TaggedValue value) {
+    uint32_t to = node_for_value(builder, value);
+    if (to == NO_NODE) return;
+    SnapshotEdge edge = {.from = from, .to = to, .kind = (uint8_t)kind, .label = label};
+    if (!append_edge(builder->snapshot, edge)) builder->failed = true;
+}
+
+static void link_named(SnapshotBuilder* builder, uint32_t from, const char* name, TaggedValue value) {
+    if (node_for_value(builder, value) == NO_NODE) return;
+    link_value(builder, from, SNAPSHOT_EDGE_NAMED, intern(builder, name), value);
+}
+
+static void link_object(SnapshotBuilder* builder, uint32_t from, const char* name, Object* object) {
+    if (object) link_named(builder, from, name, OBJECT_VAL(object));
+}
+
+typedef struct {
+    SnapshotBuilder* builder;
+    uint32_t from;
+} PropertyLinker;
+
+static void link_property(const char* key, TaggedValue* value, void* user_data) {
+    PropertyLinker* linker = (PropertyLinker*)user_data;
+    link_named(linker->builder, linker->from, key, *value);
+}
+
+// Add the edges out of a heap node, discovering the nodes they lead to
+static void expand_node(SnapshotBuilder* builder, uint32_t node) {
+    const void* address = builder->addresses[node];
+    switch (builder->snapshot->nodes[node].kind) {
+        case SNAPSHOT_OBJECT:
+        case SNAPSHOT_ARRAY: {
+            Object* object = (Object*)address;
+            PropertyLinker linker = {builder, node};
+            object_iterate_properties(object, link_property, &linker);
+            for (size_t i = 0; i < object->element_count; i++) {
+                link_value(builder, node, SNAPSHOT_EDGE_ELEMENT, (uint32_t)i, object->elements[i]);
+            }
+            link_object(builder, node, "__proto__", object->prototype);
+            break;
+        }
+        case SNAPSHOT_STRUCT: {
+            StructInstance* instance = (StructInstance*)address;
+            if (!instance->type) break;
+            for (size_t i = 0; i < instance->type->field_count; i++) {
+                link_named(builder, node, instance->type->field_names[i], instance->fields[i]);
+            }
+            link_object(builder, node, "<methods>", instance->type->methods);
+            break;
+        }
+        case SNAPSHOT_CLOSURE: {
+            Closure* closure = (Closure*)address;
+            for (int i = 0; i < closure->upvalue_count; i++) {
+                Upvalue* upvalue = closure->upvalues[i];
+                if (upvalue) {
+                    link_value(builder, node, SNAPSHOT_EDGE_UPVALUE, (uint32_t)i, *upvalue->location);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+typedef struct {
+    SnapshotBuilder* builder;
+    uint32_t from;
+    uint32_t index;
+} PrototypeLinker;
+
+static void add_prototype_root(Object* prototype, void* user_data) {
+    PrototypeLinker* linker = (PrototypeLinker*)user_data;
+    if (!prototype) return;
+    link_value(linker->builder, linker->from, SNAPSHOT_EDGE_ELEMENT, linker->index++,
+               OBJECT_VAL(prototype));
+}
+
+static void add_module_root(const char* name, Module* module, void* user_data) {
+    SnapshotBuilder* builder = (SnapshotBuilder*)user_data;
+    char label[256];
+    snprintf(label, sizeof(label), "module %s", name ? name : module->path);
+    uint32_t category = add_category(builder, label);
+    if (category == NO_NODE) return;
+
+    link_object(builder, category, "<module>", module->module_object);
+    for (size_t i = 0; i < module->exports.count; i++) {
+        link_named(builder, category, module->exports.names[i], module->exports.values[i]);
+    }
+    for (size_t i = 0; i < module->globals.count; i++) {
+        link_named(builder, category, module->globals.names[i], module->globals.values[i]);
+    }
+    if (module->scope) {
+        for (size_t i = 0; i < module->scope->count; i++) {
+            link_named(builder, category, module->scope->entries[i].name,
+                       module->scope->entries[i].value);
+        }
+    }
+}
+
+// The same roots mark_roots() traces, one category node each
+static void add_roots(SnapshotBuilder* builder, GarbageCollector* gc) {
+    uint32_t category = add_category(builder, "C roots");
+    if (category == NO_NODE) return;
+    for (size_t i = 0; i < gc->root_count; i++) {
+        link_value(builder, category, SNAPSHOT_EDGE_ELEMENT, (uint32_t)i, *gc->roots[i]);
+    }
+    for (size_t i = 0; i < gc->temp_root_count; i++) {
+        link_value(builder, category, SNAPSHOT_EDGE_ELEMENT, (uint32_t)(gc->root_count + i),
+                   gc->temp_roots[i]);
+    }
+
+    VM* vm = gc->vm;
+    if (!vm) return;
+
+    if ((category = add_category(builder, "stack")) == NO_NODE) return;
+    for (TaggedValue* slot = vm->stack; slot < vm->stack_top; slot++) {
+        link_value(builder, category, SNAPSHOT_EDGE_ELEMENT, (uint32_t)(slot - vm->stack), *slot);
+    }
+
+    if ((category = add_category(builder, "open upvalues")) == NO_NODE) return;
+    uint32_t index = 0;
+    for (Upvalue* upvalue = vm->open_upvalues; upvalue; upvalue = upvalue->next) {
+        link_value(builder, category, SNAPSHOT_EDGE_ELEMENT, index++, *upvalue->location);
+    }
+
+    if ((category = add_category(builder, "globals")) == NO_NODE) return;
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        link_named(builder, category, vm->globals.names[i], vm->globals.values[i]);
+    }
+
+    if ((category = add_category(builder, "struct types")) == NO_NODE) return;
+    for (size_t i = 0; i < vm->struct_types.count; i++) {
+        StructType* type = vm->struct_types.types[i];
+        if (type) link_object(builder, category, type->name, type->methods);
+    }
+
+    PrototypeLinker prototypes = {builder, add_category(builder, "shared prototypes"), 0};
+    if (prototypes.from == NO_NODE) return;
+    object_iterate_shared_prototypes(add_prototype_root, &prototypes);
+
+    for (ModuleLoader* loader = vm->module_loader; loader; loader = loader->parent) {
+        if (loader->cache) {
+            module_cache_iterate(loader->cache, add_module_root, builder);
+        }
+    }
+}
+
+HeapSnapshot* heap_snapshot_take(GarbageCollector* gc) {
+    SnapshotBuilder builder = {0};
+    builder.snapshot = snapshot_create();
+    builder.string_ids = hash_map_create();
+    if (!builder.snapshot || !builder.string_ids) {
+        builder.failed = true;
+    } else {
+        builder.snapshot->heap_bytes = gc->bytes_allocated;
+        add_node(&builder, SNAPSHOT_ROOT, intern(&builder, "<root>"), 0, NULL);
+        add_roots(&builder, gc);
+
+        // Breadth first: nodes are expanded in the order they were found
+        for (size_t i = 0; i < builder.snapshot->node_count && !builder.failed; i++) {
+            if (builder.addresses[i]) expand_node(&builder, (uint32_t)i);
+        }
+    }
+
+    if (builder.string_ids) hash_map_destroy(builder.string_ids);
+    if (builder.addresses) VM_FREE(builder.addresses, builder.address_capacity * sizeof(void*));
+    if (builder.table) VM_FREE(builder.table, builder.table_capacity * sizeof(uint32_t));
+    if (builder.failed) {
+        heap_snapshot_free(builder.snapshot);
+        return NULL;
+    }
+    return builder.snapshot;
+}
+
+// File format: magic, version and heap size, then the string table, nodes
+// and edges, each a count followed by the entries. Integers past the header
+// are LEB128 varints, which keeps most node and edge fields to a byte or two.
+
+static void write_varint(BytecodeBuffer* buffer, uint64_t value) {
+    while (value >= 0x80) {
+        bytecode_write_u8(buffer, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    bytecode_write_u8(buffer, (uint8_t)value);
+}
+
+static bool read_varint(BytecodeBuffer* buffer, uint64_t* value) {
+    *value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (buffer->position >= buffer->size) return false;
+        uint8_t byte = buffer->data[buffer->position++];
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static bool read_index(BytecodeBuffer* buffer, size_t limit, uint32_t* index) {
+    uint64_t value;
+    if (!read_varint(buffer, &value) || value >= limit) return false;
+    *index = (uint32_t)value;
+    return true;
+}
+
+bool heap_snapshot_write(const HeapSnapshot* snapshot, const char* path) {
+    BytecodeBuffer* buffer = bytecode_buffer_create(4096);
+    if (!buffer) return false;
+
+    bytecode_write_bytes(buffer, (const uint8_t*)SNAPSHOT_MAGIC, 4);
+    bytecode_write_u32(buffer, SNAPSHOT_VERSION);
+    bytecode_write_u64(buffer, snapshot->heap_bytes);
+
+    write_varint(buffer, snapshot->string_count);
+    for (size_t i = 0; i < snapshot->string_count; i++) {
+        size_t len = strlen(snapshot->strings[i]);
+        write_varint(buffer, len);
+        bytecode_write_bytes(buffer, (const uint8_t*)snapshot->strings[i], len);
+    }
+    write_varint(buffer, snapshot->node_count);
+    for (size_t i = 0; i < snapshot->node_count; i++) {
+        const SnapshotNode* node = &snapshot->nodes[i];
+        bytecode_write_u8(buffer, node->kind);
+        write_varint(buffer, node->name);
+        write_varint(buffer, node->self_size);
+    }
+    write_varint(buffer, snapshot->edge_count);
+    for (size_t i = 0; i < snapshot->edge_count; i++) {
+        const SnapshotEdge* edge = &snapshot->edges[i];
+        write_varint(buffer, edge->from);
+        write_varint(buffer, edge->to);
+        bytecode_write_u8(buffer, edge->kind);
+        write_varint(buffer, edge->label);
+    }
+
+    FILE* file = fopen(path, "wb");
+    bool ok = file && fwrite(buffer->data, 1, buffer->size, file) == buffer->size;
+    if (file && fclose(file) != 0) ok = false;
+    bytecode_buffer_destroy(buffer);
+    return ok;
+}
+
+static bool parse_snapshot(BytecodeBuffer* buffer, HeapSnapshot* snapshot) {
+    char magic[4];
+    if (!bytecode_read_bytes(buffer, (uint8_t*)magic, 4) ||
+        memcmp(magic, SNAPSHOT_MAGIC, 4) != 0 ||
+        buffer->size < 16 ||
+        bytecode_read_u32(buffer) != SNAPSHOT_VERSION) {
+        return false;
+    }
+    snapshot->heap_bytes = bytecode_read_u64(buffer);
+
+    // Counts are checked against the bytes left so a corrupt one cannot
+    // make us allocate more than the file could describe
+    uint64_t count;
+    if (!read_varint(buffer, &count) || count > buffer->size - buffer->position) return false;
+    for (uint64_t i = 0; i < count; i++) {
+        uint64_t len;
+        if (!read_varint(buffer, &len) || len > buffer->size - buffer->position) return false;
+        if (!append_string(snapshot, (const char*)buffer->data + buffer->position, (size_t)len)) {
+            return false;
+        }
+        buffer->position += len;
+    }
+
+    if (!read_varint(buffer, &count) || count == 0 || count > buffer->size - buffer->position) {
+        return false;
+    }
+    size_t node_count = (size_t)count;
+    for (size_t i = 0; i < node_count; i++) {
+        SnapshotNode node;
+        if (buffer->position >= buffer->size) return false;
+        node.kind = bytecode_read_u8(buffer);
+        if (node.kind > SNAPSHOT_CLOSURE ||
+            !read_index(buffer, snapshot->string_count, &node.name) ||
+            !read_varint(buffer, &node.self_size) ||
+            !append_node(snapshot, node)) {
+            return false;
+        }
+    }
+
+    if (!read_varint(buffer, &count) || count > buffer->size - buffer->position) return false;
+    for (uint64_t i = 0; i < count; i++) {
+        SnapshotEdge edge;
+        if (!read_index(buffer, node_count, &edge.from) ||
+            !read_index(buffer, node_count, &edge.to) ||
+            buffer->position >= buffer->size) {
+            return false;
+        }
+        edge.kind = bytecode_read_u8(buffer);
+        uint64_t label;
+        if (edge.kind > SNAPSHOT_EDGE_UPVALUE || !read_varint(buffer, &label) ||
+            label > UINT32_MAX ||
+            (edge.kind == SNAPSHOT_EDGE_NAMED && label >= snapshot->string_count)) {
+            return false;
+        }
+        edge.label = (uint32_t)label;
+        if (!append_edge(snapshot, edge)) return false;
+    }
+    return buffer->position == buffer->size;
+}
+
+HeapSnapshot* heap_snapshot_read(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    BytecodeBuffer* buffer = NULL;
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (size = ftell(file)) >= 0 && fseek(file, 0, SEEK_SET) == 0) {
+        buffer = bytecode_buffer_create(size > 0 ? (size_t)size : 1);
+    }
+    if (buffer) {
+        buffer->size = fread(buffer->data, 1, (size_t)size, file);
+    }
+    fclose(file);
+    if (!buffer) return NULL;
+
+    HeapSnapshot* snapshot = snapshot_create();
+    if (snapshot && (buffer->size != (size_t)size || !parse_snapshot(buffer, snapshot))) {
+        heap_snapshot_free(snapshot);
+        snapshot = NULL;
+    }
+    bytecode_buffer_destroy(buffer);
+    return snapshot;
+}
+
+// Dominators, by the iterative algorithm of Cooper, Harvey and Kennedy
+// ("A Simple, Fast Dominance Algorithm"): repeatedly intersect the
+// dominators of each node's predecessors in reverse postorder until
+// nothing changes. Heap graphs are shallow and nearly trees, so it settles
+// in a few passes.
+
+// Edges grouped by node: the ones of node n are items[offsets[n]..offsets[n + 1])
+typedef struct {
+    uint32_t* offsets;
+    uint32_t* items;
+    size_t node_count;
+    size_t item_count;
+} Adjacency;
+
+static bool build_adjacency(Adjacency* adjacency, const HeapSnapshot* snapshot, bool incoming) {
+    size_t n = snapshot->node_count;
+    size_t m = snapshot->edge_count;
+    adjacency->node_count = n;
+    adjacency->item_count = m;
+    adjacency->offsets = VM_ALLOC_ZERO((n + 1) * sizeof(uint32_t));
+    adjacency->items = VM_ALLOC((m ? m : 1) * sizeof(uint32_t));
+    if (!adjacency->offsets || !adjacency->items) return false;
+
+    for (size_t i = 0; i < m; i++) {
+        const SnapshotEdge* edge = &snapshot->edges[i];
+        adjacency->offsets[(incoming ? edge->to : edge->from) + 1]++;
+    }
+    for (size_t i = 0; i < n; i++) {
+        adjacency->offsets[i + 1] += adjacency->offsets[i];
+    }
+    // Filled back to front so each group keeps edge order. That moves the
+    // end of each group back to its start, one slot late.
+    for (size_t i = m; i-- > 0;) {
+        const SnapshotEdge* edge = &snapshot->edges[i];
+        uint32_t node = incoming ? edge->to : edge->from;
+        adjacency->items[--adjacency->offsets[node + 1]] = (uint32_t)i;
+    }
+    for (size_t i = 0; i < n; i++) {
+        adjacency->offsets[i] = adjacency->offsets[i + 1];
+    }
+    adjacency->offsets[n] = (uint32_t)m;
+    return true;
+}
+
+static void free_adjacency(Adjacency* adjacency) {
+    if (adjacency->offsets) VM_FREE(adjacency->offsets, (adjacency->node_count + 1) * sizeof(uint32_t));
+    if (adjacency->items) VM_FREE(adjacency->items, (adjacency->item_count ? adjacency->item_count : 1) * sizeof(uint32_t));
+}
+
+static uint32_t intersect(const uint32_t* idom, const uint32_t* postorder_number, uint32_t a, uint32_t b) {
+    while (a != b) {
+        while (postorder_number[a] < postorder_number[b]) a = idom[a];
+        while (postorder_number[b] < postorder_number[a]) b = idom[b];
+    }
+    return a;
+}
+
+void heap_dominators_free(HeapDominators* dominators) {
+    if (!dominators) return;
+    size_t n = dominators->node_count;
+    if (dominators->idom) VM_FREE(dominators->idom, n * sizeof(uint32_t));
+    if (dominators->retained) VM_FREE(dominators->retained, n * sizeof(uint64_t));
+    if (dominators->parent_edge) VM_FREE(dominators->parent_edge, n * sizeof(uint32_t));
+    VM_FREE(dominators, sizeof(HeapDominators));
+}
+
+HeapDominators* heap_snapshot_dominators(const HeapSnapshot* snapshot) {
+    size_t n = snapshot->node_count;
+    if (n == 0) return NULL;
+
+    HeapDominators* dominators = VM_ALLOC_ZERO(sizeof(HeapDominators));
+    if (!dominators) return NULL;
+    dominators->node_count = n;
+    dominators->idom = VM_ALLOC(n * sizeof(uint32_t));
+    dominators->retained = VM_ALLOC(n * sizeof(uint64_t));
+    dominators->parent_edge = VM_ALLOC(n * sizeof(uint32_t));
+
+    Adjacency out = {0}, in = {0};
+    uint32_t* postorder = VM_ALLOC(n * sizeof(uint32_t));
+    uint32_t* postorder_number = VM_ALLOC(n * sizeof(uint32_t));
+    uint32_t* cursor = VM_ALLOC(n * sizeof(uint32_t));
+    uint32_t* stack = VM_ALLOC(n * sizeof(uint32_t));
+    bool ok = dominators->idom && dominators->retained && dominators->parent_edge &&
+              postorder && postorder_number && cursor && stack &&
+              build_adjacency(&out, snapshot, false) && build_adjacency(&in, snapshot, true);
+
+    uint32_t* idom = dominators->idom;
+    size_t reached = 0;
+    if (ok) {
+        for (size_t i = 0; i < n; i++) {
+            idom[i] = NO_NODE;
+            postorder_number[i] = NO_NODE;
+            dominators->parent_edge[i] = NO_NODE;
+        }
+
+        // Depth-first postorder from the root; cursor[] is the next edge
+        // to follow out of each node on the stack
+        size_t depth = 0;
+        stack[depth++] = 0;
+        cursor[0] = out.offsets[0];
+        postorder_number[0] = 0;  // Visited; renumbered when it finishes
+        while (depth > 0) {
+            uint32_t node = stack[depth - 1];
+            if (cursor[node] < out.offsets[node + 1]) {
+                uint32_t to = snapshot->edges[out.items[cursor[node]++]].to;
+                if (postorder_number[to] == NO_NODE) {
+                    postorder_number[to] = 0;
+                    cursor[to] = out.offsets[to];
+                    stack[depth++] = to;
+                }
+            } else {
+                postorder_number[node] = (uint32_t)reached;
+                postorder[reached++] = node;
+                depth--;
+            }
+        }
+
+        // Breadth first for the shortest path to each node; `stack` is the queue
+        size_t head = 0, tail = 0;
+        for (size_t i = 0; i < n; i++) cursor[i] = 0;
+        cursor[0] = 1;
+        stack[tail++] = 0;
+        while (head < tail) {
+            uint32_t node = stack[head++];
+            for (uint32_t i = out.offsets[node]; i < out.offsets[node + 1]; i++) {
+                uint32_t to = snapshot->edges[out.items[i]].to;
+                if (!cursor[to]) {
+                    cursor[to] = 1;
+                    dominators->parent_edge[to] = out.items[i];
+                    stack[tail++] = to;
+                }
+            }
+        }
+
+        idom[0] = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            // Reverse postorder, skipping the root (last in postorder)
+            for (size_t i = reached - 1; i-- > 0;) {
+                uint32_t node = postorder[i];
+                uint32_t new_idom = NO_NODE;
+                for (uint32_t j = in.offsets[node]; j < in.offsets[node + 1]; j++) {
+                    uint32_t pred = snapshot->edges[in.items[j]].from;
+                    if (idom[pred] == NO_NODE) continue;
+                    new_idom = new_idom == NO_NODE ? pred : intersect(idom, postorder_number, pred, new_idom);
+                }
+                if (idom[node] != new_idom) {
+                    idom[node] = new_idom;
+                    changed = true;
+                }
+            }
+        }
+
+        // Nodes the root cannot reach (only in files written by hand) are
+        // charged to the root
+        for (size_t i = 0; i < n; i++) {
+            dominators->retained[i] = snapshot->nodes[i].self_size;
+            if (idom[i] == NO_NODE) idom[i] = 0;
+        }
+        // A node finishes before its dominators in postorder
+        for (size_t i = 0; i < reached; i++) {
+            uint32_t node = postorder[i];
+            if (node != 0) dominators->retained[idom[node]] += dominators->retained[node];
+        }
+        for (size_t i = 1; i < n; i++) {
+            if (postorder_number[i] == NO_NODE) dominators->retained[0] += dominators->retained[i];
+        }
+    }
+
+    free_adjacency(&out);
+    free_adjacency(&in);
+    if (postorder) VM_FREE(postorder, n * sizeof(uint32_t));
+    if (postorder_number) VM_FREE(postorder_number, n * sizeof(uint32_t));
+    if (cursor) VM_FREE(cursor, n * sizeof(uint32_t));
+    if (stack) VM_FREE(stack, n * sizeof(uint32_t));
+    if (!ok) {
+        heap_dominators_free(dominators);
+        return NULL;
+    }
+    return dominators;
+}
+
+// Report
+
+typedef struct {
+    uint64_t retained;
+    uint64_t self_size;
+    size_t count;
+    uint32_t node;                 // One of the class, for its name
+} ClassTotal;
+
+typedef struct {
+    uint64_t retained;
+    uint32_t node;
+} Retainer;
+
+static int compare_classes(const void* a, const void* b) {
+    uint64_t x = ((const ClassTotal*)a)->retained, y = ((const ClassTotal*)b)->retained;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static int compare_retainers(const void* a, const void* b) {
+    const Retainer* x = (const Retainer*)a;
+    const Retainer* y = (const Retainer*)b;
+    if (x->retained != y->retained) return x->retained < y->retained ? 1 : -1;
+    return x->node < y->node ? -1 : x->node > y->node;
+}
+
+static void describe_node(const HeapSnapshot* snapshot, uint32_t node, char* out, size_t size) {
+    const SnapshotNode* n = &snapshot->nodes[node];
+    const char* name = snapshot->strings[n->name];
+    switch (n->kind) {
+        case SNAPSHOT_OBJECT: snprintf(out, size, "Object"); break;
+        case SNAPSHOT_ARRAY: snprintf(out, size, "Array"); break;
+        case SNAPSHOT_STRUCT: snprintf(out, size, "struct %s", name); break;
+        case SNAPSHOT_CLOSURE: snprintf(out, size, "closure %s", name); break;
+        default: snprintf(out, size, "%s", name); break;
+    }
+}
+
+static void describe_edge(const HeapSnapshot* snapshot, uint32_t edge, char* out, size_t size) {
+    const SnapshotEdge* e = &snapshot->edges[edge];
+    switch (e->kind) {
+        case SNAPSHOT_EDGE_ELEMENT: snprintf(out, size, "[%u]", e->label); break;
+        case SNAPSHOT_EDGE_UPVALUE: snprintf(out, size, "upvalue %u", e->label); break;
+        default:
+            if (snapshot->nodes[e->from].kind == SNAPSHOT_ROOT) {
+                snprintf(out, size, "%s", snapshot->strings[e->label]);
+            } else {
+                snprintf(out, size, ".%s", snapshot->strings[e->label]);
+            }
+            break;
+    }
+}
+
+// Each class is charged the retained size of its instances not dominated by
+// another instance of it, so a linked list counts once and not once per link
+static bool total_classes(const HeapSnapshot* snapshot, const HeapDominators* dominators,
+                          ClassTotal* classes, uint32_t* class_of, size_t* class_count) {
+    size_t n = snapshot->node_count;
+    size_t key_count = (size_t)(SNAPSHOT_CLOSURE + 1) * snapshot->string_count;
+    uint32_t* class_of_key = VM_ALLOC(key_count * sizeof(uint32_t));
+    Adjacency tree = {0};
+    tree.node_count = n;
+    tree.item_count = n;
+    tree.offsets = VM_ALLOC_ZERO((n + 1) * sizeof(uint32_t));
+    tree.items = VM_ALLOC(n * sizeof(uint32_t));
+    size_t* active = VM_ALLOC_ZERO(n * sizeof(size_t));
+    uint64_t* stack = VM_ALLOC(2 * n * sizeof(uint64_t));
+    bool ok = class_of_key && tree.offsets && tree.items && active && stack;
+
+    if (ok) {
+        for (size_t i = 0; i < key_count; i++) class_of_key[i] = NO_NODE;
+        *class_count = 0;
+        for (size_t i = 0; i < n; i++) {
+            const SnapshotNode* node = &snapshot->nodes[i];
+            class_of[i] = NO_NODE;
+            if (node->kind == SNAPSHOT_ROOT) continue;
+            size_t key = (size_t)node->kind * snapshot->string_count + node->name;
+            if (class_of_key[key] == NO_NODE) {
+                class_of_key[key] = (uint32_t)(*class_count)++;
+                classes[class_of_key[key]] = (ClassTotal){0, 0, 0, (uint32_t)i};
+            }
+            ClassTotal* total = &classes[class_of_key[key]];
+            class_of[i] = class_of_key[key];
+            total->self_size += node->self_size;
+            total->count++;
+        }
+
+        // Children of each node in the dominator tree
+        for (size_t i = 1; i < n; i++) tree.offsets[dominators->idom[i] + 1]++;
+        for (size_t i = 0; i < n; i++) tree.offsets[i + 1] += tree.offsets[i];
+        for (size_t i = n; i-- > 1;) {
+            tree.items[--tree.offsets[dominators->idom[i] + 1]] = (uint32_t)i;
+        }
+        for (size_t i = 0; i < n; i++) tree.offsets[i] = tree.offsets[i + 1];
+        tree.offsets[n] = (uint32_t)(n - 1);
+
+        // Depth first; an entry with the low bit set leaves its node
+        size_t depth = 0;
+        stack[depth++] = 0;
+        while (depth > 0) {
+            uint64_t entry = stack[--depth];
+            uint32_t node = (uint32_t)(entry >> 1);
+            uint32_t class_id = class_of[node];
+            if (entry & 1) {
+                if (class_id != NO_NODE) active[class_id]--;
+                continue;
+            }
+            if (class_id != NO_NODE) {
+                if (active[class_id]++ == 0) classes[class_id].retained += dominators->retained[node];
+            }
+            stack[depth++] = ((uint64_t)node << 1) | 1;
+            for (uint32_t i = tree.offsets[node]; i < tree.offsets[node + 1]; i++) {
+                stack[depth++] = (uint64_t)tree.items[i] << 1;
+            }
+        }
+    }
+
+    if (class_of_key) VM_FREE(class_of_key, key_count * sizeof(uint32_t));
+    if (tree.offsets) VM_FREE(tree.offsets, (n + 1) * sizeof(uint32_t));
+    if (tree.items) VM_FREE(tree.items, n * sizeof(uint32_t));
+    if (active) VM_FREE(active, n * sizeof(size_t));
+    if (stack) VM_FREE(stack, 2 * n * sizeof(uint64_t));
+    return ok;
+}
+
+// Text of one step of a dominator path, into `out`
+static void describe_step(const HeapSnapshot* snapshot, const HeapDominators* dominators,
+                          uint32_t previous, uint32_t node, char* out, size_t size) {
+    char label[256], name[256];
+    const char* via = "";
+    uint32_t edge = dominators->parent_edge[node];
+    if (edge == NO_NODE) {
+        snprintf(label, sizeof(label), "?");
+    } else {
+        // A dominator need not be the node its shortest path came from
+        uint32_t from = snapshot->edges[edge].from;
+        if (from != previous) {
+            via = snapshot->nodes[from].kind == SNAPSHOT_ROOT
+                ? snapshot->strings[snapshot->nodes[from].name] : "...";
+        }
+        describe_edge(snapshot, edge, label, sizeof(label));
+    }
+    if (snapshot->nodes[node].kind == SNAPSHOT_ROOT) {
+        name[0] = '\0';
+    } else {
+        describe_node(snapshot, node, name, sizeof(name));
+    }
+    snprintf(out, size, "%s%s > %s%s%s%s", *via ? " > " : "", via, label,
+             *name ? " (" : "", name, *name ? ")" : "");
+}
+
+// Repeated steps, like the links of a list, are printed once with a count
+static void print_path(const HeapSnapshot* snapshot, const HeapDominators* dominators,
+                       uint32_t node, FILE* out) {
+    size_t depth = 0;
+    for (uint32_t d = node; d != 0; d = dominators->idom[d]) depth++;
+    uint32_t* chain = VM_ALLOC((depth ? depth : 1) * sizeof(uint32_t));
+    if (!chain) return;
+    size_t i = depth;
+    for (uint32_t d = node; d != 0; d = dominators->idom[d]) chain[--i] = d;
+
+    char step[600], last[600] = "";
+    size_t repeats = 0;
+    fprintf(out, "      <root>");
+    for (i = 0; i < depth; i++) {
+        describe_step(snapshot, dominators, i > 0 ? chain[i - 1] : 0, chain[i], step, sizeof(step));
+        if (strcmp(step, last) == 0) {
+            repeats++;
+            continue;
+        }
+        if (repeats > 0) fprintf(out, " (x%zu)", repeats + 1);
+        fprintf(out, "%s", step);
+        memcpy(last, step, sizeof(step));
+        repeats = 0;
+    }
+    if (repeats > 0) fprintf(out, " (x%zu)", repeats + 1);
+    fprintf(out, "\n");
+    VM_FREE(chain, (depth ? depth : 1) * sizeof(uint32_t));
+}
+
+void heap_snapshot_report(const HeapSnapshot* snapshot, FILE* out, size_t top) {
+    HeapDominators* dominators = heap_snapshot_dominators(snapshot);
+    if (!dominators) {
+        fprintf(out, "Heap snapshot is empty\n");
+        return;
+    }
+    size_t n = snapshot->node_count;
+    ClassTotal* classes = VM_ALLOC(n * sizeof(ClassTotal));
+    uint32_t* class_of = VM_ALLOC(n * sizeof(uint32_t));
+    Retainer* retainers = VM_ALLOC(n * sizeof(Retainer));
+    size_t class_count = 0;
+    if (!classes || !class_of || !retainers ||
+        !total_classes(snapshot, dominators, classes, class_of, &class_count)) {
+        fprintf(out, "Out of memory analyzing heap snapshot\n");
+        goto done;
+    }
+
+    // Retainers exclude nodes whose immediate dominator is of their own
+    // type: those are inside a structure already listed at its top
+    size_t heap_nodes = 0, retainer_count = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (snapshot->nodes[i].kind == SNAPSHOT_ROOT) continue;
+        heap_nodes++;
+        if (class_of[i] != class_of[dominators->idom[i]]) {
+            retainers[retainer_count++] = (Retainer){dominators->retained[i], (uint32_t)i};
+        }
+    }
+    fprintf(out, "Heap snapshot: %zu nodes, %zu references\n", heap_nodes, snapshot->edge_count);
+    fprintf(out, "  Reachable: %llu bytes; collector heap: %llu bytes\n\n",
+            (unsigned long long)dominators->retained[0], (unsigned long long)snapshot->heap_bytes);
+
+    char name[256];
+    qsort(classes, class_count, sizeof(ClassTotal), compare_classes);
+    fprintf(out, "Retained size by type:\n");
+    fprintf(out, "  %14s %14s %10s  %s\n", "retained", "self", "count", "type");
+    for (size_t i = 0; i < class_count && i < top; i++) {
+        describe_node(snapshot, classes[i].node, name, sizeof(name));
+        fprintf(out, "  %14llu %14llu %10zu  %s\n", (unsigned long long)classes[i].retained,
+                (unsigned long long)classes[i].self_size, classes[i].count, name);
+    }
+
+    qsort(retainers, retainer_count, sizeof(Retainer), compare_retainers);
+    fprintf(out, "\nLargest retainers:\n");
+    for (size_t i = 0; i < retainer_count && i < top; i++) {
+        describe_node(snapshot, retainers[i].node, name, sizeof(name));
+        fprintf(out, "  %14llu  %s\n", (unsigned long long)retainers[i].retained, name);
+        print_path(snapshot, dominators, retainers[i].node, out);
+    }
+
+done:
+    if (classes) VM_FREE(classes, n * sizeof(ClassTotal));
+    if (class_of) VM_FREE(class_of, n * sizeof(uint32_t));
+    if (retainers) VM_FREE(retainers, n * sizeof(Retainer));
+    heap_dominators_free(dominators);
+}
@@ -1,5 +1,7 @@
 #include "runtime/core/object.h"
 #include "runtime/core/object_sizes.h"
+#include "runtime/core/object_hash.h"
+#include "runtime/core/shape.h"
 #include "runtime/core/vm.h"
 #include "runtime/core/gc.h"
 #include "utils/allocators.h"
@@ -18,12 +20,17 @@ void object_set_current_vm(VM* vm) {
     current_vm = vm;
 }
 
+VM* object_get_current_vm(void) {
+    return current_vm;
+}
+
 // Global prototype objects
 static Object* object_prototype = NULL;
 static Object* array_prototype = NULL;
 static Object* string_prototype = NULL;
 static Object* function_prototype = NULL;
 static Object* number_prototype = NULL;
+static Object* string_builder_prototype = NULL;
 
 // Struct prototype registry
 typedef struct StructPrototype {
@@ -34,72 +41,92 @@ typedef struct StructPrototype {
 
 static StructPrototype* struct_prototypes = NULL;
 
-// Helper to create a property node
-static ObjectProperty* property_create(const char* key, TaggedValue value)
+uint32_t object_cache_epoch = 1;
+
+// Flag an object as some other object's prototype
+static void mark_prototype(Object* prototype)
 {
-    ObjectProperty* prop;
-    
-    // Use GC if available
-    if (current_vm && current_vm->gc) {
-        prop = GC_ALLOC(current_vm->gc, ObjectProperty, "property");
-    } else {
-        prop = OBJ_NEW(ObjectProperty, "property");
+    if (prototype && !prototype->is_prototype) {
+        prototype->is_prototype = true;
+        object_cache_epoch++;
     }
-    if (!prop) return NULL;
-    
-    size_t key_size = strlen(key) + 1;
+}
+
+// Make room for `needed` slots, doubling the slot vector as it fills
+static bool ensure_slot_capacity(Object* obj, uint32_t needed)
+{
+    if (needed <= obj->slot_capacity) return true;
     
-    // Allocate key string
-    if (current_vm && current_vm->gc) {
-        prop->key = GC_ALLOC_ARRAY(current_vm->gc, char, key_size, "prop-key");
-    } else {
-        prop->key = STR_ALLOC(key_size);
+    uint32_t new_capacity = obj->slot_capacity < 4 ? 4 : obj->slot_capacity * 2;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
     }
-    if (!prop->key) {
-        if (!(current_vm && current_vm->gc)) {
-            OBJ_FREE(prop, SIZE_OBJECT_PROPERTY);
-        }
-        return NULL;
+    
+    TaggedValue* slots = OBJ_ALLOC(new_capacity * sizeof(TaggedValue), "object-slots");
+    if (!slots) return false;
+    if (obj->slots) {
+        memcpy(slots, obj->slots, obj->slot_count * sizeof(TaggedValue));
+        OBJ_FREE(obj->slots, obj->slot_capacity * sizeof(TaggedValue));
     }
-    strcpy(prop->key, key);
+    obj->slots = slots;
+    obj->slot_capacity = new_capacity;
+    return true;
+}
+
+// Leave the shape tree: give the object a private copy of its key -> slot map
+static bool object_to_dictionary(Object* obj)
+{
+    if (!obj->shape) return true;
     
-    // Allocate value holder
-    if (current_vm && current_vm->gc) {
-        prop->value = GC_ALLOC(current_vm->gc, TaggedValue, "prop-value");
-    } else {
-        prop->value = OBJ_NEW(TaggedValue, "prop-value");
+    PropertyTable* table = property_table_create(obj->slot_count + 1, true);
+    if (!table) return false;
+    for (Shape* s = obj->shape; s->key; s = s->parent) {
+        property_table_set(table, s->key, s->slot);
     }
-    if (!prop->value) {
-        if (!(current_vm && current_vm->gc)) {
-            STR_FREE(prop->key, key_size);
-            OBJ_FREE(prop, SIZE_OBJECT_PROPERTY);
+    obj->dictionary = table;
+    obj->shape = NULL;
+    return true;
+}
+
+// Close the holes deleted keys left in a dictionary-mode slot vector
+static void dictionary_compact(Object* obj)
+{
+    PropertyTable* table = obj->dictionary;
+    uint32_t capacity = table->count < 4 ? 4 : (uint32_t)table->count;
+    TaggedValue* slots = OBJ_ALLOC(capacity * sizeof(TaggedValue), "object-slots");
+    if (!slots) return;
+    
+    uint32_t next = 0;
+    for (size_t i = 0; i < table->capacity; i++) {
+        PropertyTableEntry* entry = &table->entries[i];
+        if (entry->key) {
+            slots[next] = obj->slots[entry->slot];
+            entry->slot = next++;
         }
-        return NULL;
     }
-    *prop->value = value;
-    prop->next = NULL;
     
-    return prop;
+    OBJ_FREE(obj->slots, obj->slot_capacity * sizeof(TaggedValue));
+    obj->slots = slots;
+    obj->slot_count = next;
+    obj->slot_capacity = capacity;
 }
 
-// Helper to destroy a property node
-static void property_destroy(ObjectProperty* prop)
+// Fields of a new, empty object
+static void object_init(Object* obj, bool gc_managed)
 {
-    if (prop)
-    {
-        // If GC is active, it will handle memory cleanup
-        if (!(current_vm && current_vm->gc)) {
-            // Manual cleanup only when GC is not active
-            if (prop->key) {
-                STR_FREE(prop->key, strlen(prop->key) + 1);
-            }
-            if (prop->value) {
-                OBJ_FREE(prop->value, sizeof(TaggedValue));
-            }
-            OBJ_FREE(prop, SIZE_OBJECT_PROPERTY);
-        }
-        // With GC, we don't free - GC will handle it
-    }
+    obj->is_gc_managed = gc_managed;
+    obj->shape = shape_root();
+    obj->dictionary = NULL;
+    obj->slots = NULL;
+    obj->slot_count = 0;
+    obj->slot_capacity = 0;
+    obj->prototype = object_prototype;  // Default to Object.prototype
+    obj->property_count = 0;
+    obj->is_array = false;
+    obj->is_prototype = false;
+    obj->elements = NULL;
+    obj->element_count = 0;
+    obj->element_capacity = 0;
 }
 
 // Create a new object
@@ -108,7 +135,8 @@ Object* object_create(void)
     Object* obj;
     
     // Use GC if available, otherwise fall back to direct allocation
-    if (current_vm && current_vm->gc) {
+    bool gc_managed = current_vm && current_vm->gc;
+    if (gc_managed) {
         obj = GC_ALLOC(current_vm->gc, Object, "object");
     } else {
         obj = OBJ_NEW(Object, "object");
@@ -116,10 +144,21 @@ Object* object_create(void)
     
     if (!obj) return NULL;
     
-    obj->properties = NULL;
-    obj->prototype = object_prototype;  // Default to Object.prototype
-    obj->property_count = 0;
-    obj->is_array = false;
+    object_init(obj, gc_managed);
+    return obj;
+}
+
+// Prototypes held in this file's statics are shared by every VM and outlive
+// each of them, so no collector owns them; every collector traces what they
+// hold as roots
+static Object* shared_prototype_create(Object* prototype)
+{
+    Object* obj = OBJ_NEW(Object, "shared-prototype");
+    if (!obj) return NULL;
+    
+    object_init(obj, false);
+    obj->prototype = prototype;
+    mark_prototype(prototype);
     return obj;
 }
 
@@ -129,6 +168,7 @@ Object* object_create_with_prototype(Object* prototype)
     Object* obj = object_create();
     if (obj) {
         obj->prototype = prototype;
+        mark_prototype(prototype);
     }
     return obj;
 }
@@ -138,55 +178,64 @@ void object_destroy(Object* obj)
 {
     if (!obj) return;
     
-    // If GC is active, it will handle the memory - we just need to clean up resources
-    if (current_vm && current_vm->gc) {
-        // GC will free the memory, but we still need to clean up property chains
-        // to prevent leaks in the property linked list
-        ObjectProperty* prop = obj->properties;
-        while (prop)
-        {
-            ObjectProperty* next = prop->next;
-            // Only free the property structure, not the object itself
-            property_destroy(prop);
-            prop = next;
-        }
-        // Don't free the object - GC will handle it
-    } else {
-        // No GC, manual cleanup
-        ObjectProperty* prop = obj->properties;
-        while (prop)
-        {
-            ObjectProperty* next = prop->next;
-            property_destroy(prop);
-            prop = next;
-        }
+    object_cache_epoch++;
+    
+    // Slot and element storage is never GC-managed. Reset the fields so a later sweep of
+    // the same object finds nothing left to free.
+    if (obj->slots) {
+        OBJ_FREE(obj->slots, obj->slot_capacity * sizeof(TaggedValue));
+    }
+    if (obj->dictionary) {
+        property_table_destroy(obj->dictionary);
+    }
+    if (obj->elements) {
+        OBJ_FREE(obj->elements, obj->element_capacity * sizeof(TaggedValue));
+    }
+    obj->shape = shape_root();
+    obj->dictionary = NULL;
+    obj->slots = NULL;
+    obj->slot_count = 0;
+    obj->slot_capacity = 0;
+    obj->property_count = 0;
+    obj->elements = NULL;
+    obj->element_count = 0;
+    obj->element_capacity = 0;
+    
+    // The collector frees the memory of the objects it allocated
+    if (!obj->is_gc_managed) {
         OBJ_FREE(obj, SIZE_OBJECT);
     }
 }
 
+// Find the slot of an own property
+bool object_find_slot(Object* obj, const char* key, uint32_t* slot)
+{
+    if (obj->shape) {
+        return shape_lookup(obj->shape, key, slot);
+    }
+    return property_table_get(obj->dictionary, key, slot);
+}
+
+// Get own property, ignoring the prototype chain
+TaggedValue* object_get_own_property(Object* obj, const char* key)
+{
+    uint32_t slot;
+    if (!obj || !object_find_slot(obj, key, &slot)) return NULL;
+    return &obj->slots[slot];
+}
+
 // Get property, checking prototype chain
 // This implements JavaScript-style prototypal inheritance
 // Properties are looked up in order: own properties -> prototype -> prototype's prototype -> etc.
 TaggedValue* object_get_property(Object* obj, const char* key)
 {
-    if (!obj) return NULL;
-    
-    // Check own properties first (properties directly on this object)
-    ObjectProperty* prop = obj->properties;
-    while (prop)
+    for (; obj; obj = obj->prototype)
     {
-        if (strcmp(prop->key, key) == 0)
+        uint32_t slot;
+        if (object_find_slot(obj, key, &slot))
         {
-            return prop->value;
+            return &obj->slots[slot];
         }
-        prop = prop->next;
-    }
-    
-    // Property not found on object itself - check prototype chain
-    // This allows objects to inherit methods and properties from their prototype
-    if (obj->prototype)
-    {
-        return object_get_property(obj->prototype, key);
     }
     
     return NULL;  // Property not found anywhere in the chain
@@ -207,31 +256,89 @@ void object_set_property(Object* obj, const char* key, TaggedValue value)
     // Debug for stdlib init
     if (strstr(key, "push") || strstr(key, "map")) {
         fprintf(stderr, "[DEBUG] object_set_property: obj=%p, key='%s', value.type=%d\n", 
-                (void*)obj, key, value.type);
+                (void*)obj, key, VALUE_TYPE(value));
     }
     
     // Check if property already exists
-    ObjectProperty* prop = obj->properties;
-    while (prop)
+    uint32_t slot;
+    if (object_find_slot(obj, key, &slot))
     {
-        if (strcmp(prop->key, key) == 0)
-        {
-            *prop->value = value;
+        obj->slots[slot] = value;
+        gc_object_write(obj, value);
+        return;
+    }
+    
+    // Add new property: follow (or create) the shape transition, unless the
+    // object has outgrown the shape tree or its shape has no room for
+    // another transition
+    Shape* shape = NULL;
+    if (obj->shape && obj->shape->slot_count < SHAPE_MAX_SLOTS) {
+        shape = shape_add_key(obj->shape, key);
+    }
+    if (!shape && !object_to_dictionary(obj)) {
+        fprintf(stderr, "[ERROR] object_set_property: Failed to create property for key='%s'\n", key);
+        return;
+    }
+    if (!ensure_slot_capacity(obj, obj->slot_count + 1)) {
+        fprintf(stderr, "[ERROR] object_set_property: Failed to create property for key='%s'\n", key);
+        return;
+    }
+    
+    if (shape) {
+        obj->shape = shape;
+        slot = shape->slot;
+    } else {
+        slot = obj->slot_count;
+        if (!property_table_set(obj->dictionary, key, slot)) {
+            fprintf(stderr, "[ERROR] object_set_property: Failed to create property for key='%s'\n", key);
             return;
         }
-        prop = prop->next;
     }
     
-    // Add new property
-    ObjectProperty* new_prop = property_create(key, value);
-    if (!new_prop) {
+    obj->slots[slot] = value;
+    gc_object_write(obj, value);
+    obj->slot_count++;
+    obj->property_count++;
+    if (obj->is_prototype) {
+        object_cache_epoch++;
+    }
+}
+
+void object_set_keyed_property(Object* obj, const char* key, TaggedValue value)
+{
+    uint32_t slot;
+    if (obj && key && obj->shape && !object_find_slot(obj, key, &slot) &&
+        !object_to_dictionary(obj)) {
         fprintf(stderr, "[ERROR] object_set_property: Failed to create property for key='%s'\n", key);
         return;
     }
+    object_set_property(obj, key, value);
+}
+
+// Delete an own property
+bool object_delete_property(Object* obj, const char* key)
+{
+    uint32_t slot;
+    if (!obj || !key || !object_find_slot(obj, key, &slot)) return false;
     
-    new_prop->next = obj->properties;
-    obj->properties = new_prop;
-    obj->property_count++;
+    if (obj->shape && slot == obj->shape->slot) {
+        // Removing the newest key just steps back to the parent shape
+        obj->shape = obj->shape->parent;
+        obj->slot_count--;
+    } else {
+        if (!object_to_dictionary(obj)) return false;
+        property_table_delete(obj->dictionary, key);
+        obj->slots[slot] = NIL_VAL;
+    }
+    obj->property_count--;
+    if (obj->is_prototype) {
+        object_cache_epoch++;
+    }
+    
+    if (obj->dictionary && obj->slot_count >= 8 && obj->slot_count > 2 * obj->property_count) {
+        dictionary_compact(obj);
+    }
+    return true;
 }
 
 // Check if property exists (including prototype chain)
@@ -243,19 +350,31 @@ bool object_has_property(Object* obj, const char* key)
 // Check if property exists on object itself
 bool object_has_own_property(Object* obj, const char* key)
 {
-    if (!obj) return false;
+    uint32_t slot;
+    return obj && object_find_slot(obj, key, &slot);
+}
+
+// Visit own properties
+void object_iterate_properties(Object* obj, PropertyIterator iterator, void* user_data)
+{
+    if (!obj || !iterator) return;
     
-    ObjectProperty* prop = obj->properties;
-    while (prop)
-    {
-        if (strcmp(prop->key, key) == 0)
-        {
-            return true;
+    if (obj->shape) {
+        const char* keys[SHAPE_MAX_SLOTS];
+        shape_collect_keys(obj->shape, keys);
+        for (uint32_t i = 0; i < obj->slot_count; i++) {
+            iterator(keys[i], &obj->slots[i], user_data);
         }
-        prop = prop->next;
+        return;
     }
     
-    return false;
+    PropertyTable* table = obj->dictionary;
+    for (size_t i = 0; i < table->capacity; i++) {
+        PropertyTableEntry* entry = &table->entries[i];
+        if (entry->key) {
+            iterator(entry->key, &obj->slots[entry->slot], user_data);
+        }
+    }
 }
 
 // Set prototype
@@ -264,6 +383,13 @@ void object_set_prototype(Object* obj, Object* prototype)
     if (obj)
     {
         obj->prototype = prototype;
+        mark_prototype(prototype);
+        if (prototype) {
+            gc_object_write(obj, OBJECT_VAL(prototype));
+        }
+        if (obj->is_prototype) {
+            object_cache_epoch++;
+        }
     }
 }
 
@@ -274,125 +400,93 @@ Object* object_get_prototype(Object* obj)
 }
 
 // Array-specific implementation
+// Arrays are ordinary objects (they keep their prototype and may carry named
+// properties) whose elements live in a dense vector; "length" is the element
+// count rather than a stored property.
+
+// Make room for `needed` elements, doubling the vector as it fills
+static bool ensure_element_capacity(Object* array, size_t needed)
+{
+    if (needed <= array->element_capacity) return true;
+    
+    size_t new_capacity = array->element_capacity < 8 ? 8 : array->element_capacity * 2;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
+    }
+    
+    TaggedValue* elements = OBJ_ALLOC(new_capacity * sizeof(TaggedValue), "array-elements");
+    if (!elements) return false;
+    if (array->elements) {
+        memcpy(elements, array->elements, array->element_count * sizeof(TaggedValue));
+        OBJ_FREE(array->elements, array->element_capacity * sizeof(TaggedValue));
+    }
+    array->elements = elements;
+    array->element_capacity = new_capacity;
+    return true;
+}
+
 Object* array_create(void)
+{
+    return array_create_with_capacity(0);
+}
+
+Object* array_create_with_capacity(size_t capacity)
 {
     Object* array = object_create_with_prototype(array_prototype);
     if (!array) return NULL;
     
     array->is_array = true;
-    
-    // Initialize length property
-    TaggedValue length_val = NUMBER_VAL(0);
-    object_set_property(array, "length", length_val);
+    if (capacity > 0) {
+        ensure_element_capacity(array, capacity);
+    }
     
     return array;
 }
 
-Object* array_create_with_capacity(size_t capacity)
-{
-    (void)capacity;
-    // For now, just create a regular array
-    // We can optimize with pre-allocated space later
-    return array_create();
-}
-
 void array_push(Object* array, TaggedValue value)
 {
     if (!array || !array->is_array) return;
+    if (!ensure_element_capacity(array, array->element_count + 1)) return;
     
-    // Get current length
-    TaggedValue* length_prop = object_get_property(array, "length");
-    if (!length_prop || length_prop->type != VAL_NUMBER) return;
-    
-    size_t length = (size_t)length_prop->as.number;
-    
-    // Set value at index
-    char index_str[32];
-    snprintf(index_str, sizeof(index_str), "%zu", length);
-    object_set_property(array, index_str, value);
-    
-    // Update length
-    TaggedValue new_length = NUMBER_VAL((double)(length + 1));
-    object_set_property(array, "length", new_length);
+    array->elements[array->element_count] = value;
+    gc_element_write(array, array->element_count++, value);
 }
 
 TaggedValue array_pop(Object* array)
 {
-    if (!array || !array->is_array) return NIL_VAL;
-    
-    // Get current length
-    TaggedValue* length_prop = object_get_property(array, "length");
-    if (!length_prop || length_prop->type != VAL_NUMBER) return NIL_VAL;
-    
-    size_t length = (size_t)length_prop->as.number;
-    if (length == 0) return NIL_VAL;
-    
-    // Get value at last index
-    char index_str[32];
-    snprintf(index_str, sizeof(index_str), "%zu", length - 1);
-    TaggedValue* value = object_get_property(array, index_str);
-    TaggedValue result = value ? *value : NIL_VAL;
+    if (!array || !array->is_array || array->element_count == 0) return NIL_VAL;
     
-    // Remove property
-    // TODO: Implement property removal
-    
-    // Update length
-    TaggedValue new_length = NUMBER_VAL((double)(length - 1));
-    object_set_property(array, "length", new_length);
-    
-    return result;
+    return array->elements[--array->element_count];
 }
 
-// Array implementation using the object system
-// Arrays store elements as properties with numeric string keys ("0", "1", "2", etc.)
-// This allows arrays to have methods and behave like objects while maintaining array semantics
-
 TaggedValue array_get(Object* array, size_t index)
 {
-    if (!array || !array->is_array) return NIL_VAL;
+    if (!array || !array->is_array || index >= array->element_count) return NIL_VAL;
     
-    // Convert numeric index to string key
-    char index_str[32];
-    snprintf(index_str, sizeof(index_str), "%zu", index);
-    TaggedValue* value = object_get_property(array, index_str);
-    
-    return value ? *value : NIL_VAL;
+    return array->elements[index];
 }
 
 void array_set(Object* array, size_t index, TaggedValue value)
 {
     if (!array || !array->is_array) return;
     
-    // Convert numeric index to string key
-    char index_str[32];
-    snprintf(index_str, sizeof(index_str), "%zu", index);
-    object_set_property(array, index_str, value);
-    
-    // Update length if necessary - arrays maintain a "length" property
-    // that tracks the highest index + 1
-    TaggedValue* length_prop = object_get_property(array, "length");
-    if (length_prop && length_prop->type == VAL_NUMBER)
-    {
-        size_t current_length = (size_t)length_prop->as.number;
-        if (index >= current_length)
-        {
-            TaggedValue new_length = NUMBER_VAL((double)(index + 1));
-            object_set_property(array, "length", new_length);
+    // Writing past the end grows the array, filling the gap with nil
+    if (index >= array->element_count) {
+        if (!ensure_element_capacity(array, index + 1)) return;
+        for (size_t i = array->element_count; i < index; i++) {
+            array->elements[i] = NIL_VAL;
         }
+        array->element_count = index + 1;
     }
+    array->elements[index] = value;
+    gc_element_write(array, index, value);
 }
 
 size_t array_length(Object* array)
 {
     if (!array || !array->is_array) return 0;
     
-    TaggedValue* length_prop = object_get_property(array, "length");
-    if (length_prop && length_prop->type == VAL_NUMBER)
-    {
-        return (size_t)length_prop->as.number;
-    }
-    
-    return 0;
+    return array->element_count;
 }
 
 // Initialize built-in prototypes
@@ -403,36 +497,31 @@ void init_builtin_prototypes(void)
         return;
     }
     
-    // Create Object.prototype
-    if (current_vm && current_vm->gc) {
-        object_prototype = GC_ALLOC(current_vm->gc, Object, "object-prototype");
-    } else {
-        object_prototype = OBJ_NEW(Object, "object-prototype");
-    }
+    // Create Object.prototype, which has no prototype
+    object_prototype = shared_prototype_create(NULL);
     if (!object_prototype) return;
-    
-    object_prototype->properties = NULL;
-    object_prototype->prototype = NULL;  // Object.prototype has no prototype
-    object_prototype->property_count = 0;
-    object_prototype->is_array = false;
+    object_prototype->is_prototype = true;
     
     // TODO: Add Object.prototype methods (toString, valueOf, etc.)
     
     // Create Array.prototype
-    array_prototype = object_create_with_prototype(object_prototype);
+    array_prototype = shared_prototype_create(object_prototype);
     // Array methods will be added by stdlib
     
     // Create String.prototype
-    string_prototype = object_create_with_prototype(object_prototype);
+    string_prototype = shared_prototype_create(object_prototype);
     // String methods will be added by stdlib
     
     // Create Function.prototype
-    function_prototype = object_create_with_prototype(object_prototype);
+    function_prototype = shared_prototype_create(object_prototype);
     // TODO: Add function methods (call, apply, bind)
     
     // Create Number.prototype
-    number_prototype = object_create_with_prototype(object_prototype);
+    number_prototype = shared_prototype_create(object_prototype);
     // Number methods will be added by stdlib
+    
+    // Prototype of StringBuilder objects, filled in by stdlib
+    string_builder_prototype = shared_prototype_create(object_prototype);
 }
 
 // Getters for built-in prototypes
@@ -461,6 +550,11 @@ Object* get_number_prototype(void)
     return number_prototype;
 }
 
+Object* get_string_builder_prototype(void)
+{
+    return string_builder_prototype;
+}
+
 // Struct type creation
 StructType* struct_type_create(const char* name, char** field_names, size_t field_count)
 {
@@ -569,7 +663,7 @@ StructInstance* struct_instance_create(StructType* type)
     // Initialize fields to nil
     for (size_t i = 0; i < type->field_count; i++)
     {
-        instance->fields[i].type = VAL_NIL;
+        instance->fields[i] = NIL_VAL;
     }
     
     return instance;
@@ -596,16 +690,16 @@ StructInstance* struct_instance_copy(StructInstance* instance)
         copy->fields[i] = instance->fields[i];
         
         // If field is a struct, recursively copy
-        if (instance->fields[i].type == VAL_STRUCT)
+        if (IS_STRUCT(instance->fields[i]))
         {
-            copy->fields[i].as.object = (void*)struct_instance_copy((StructInstance*)instance->fields[i].as.object);
-            if (!copy->fields[i].as.object) {
+            copy->fields[i] = STRUCT_VAL(struct_instance_copy(AS_STRUCT(instance->fields[i])));
+            if (!AS_STRUCT(copy->fields[i])) {
                 // Clean up partial copy
                 for (size_t j = 0; j < i; j++) {
-                    if (copy->fields[j].type == VAL_STRING) {
-                        STR_FREE((char*)copy->fields[j].as.string, strlen(copy->fields[j].as.string) + 1);
-                    } else if (copy->fields[j].type == VAL_STRUCT) {
-                        struct_instance_destroy((StructInstance*)copy->fields[j].as.object);
+                    if (IS_STRING(copy->fields[j])) {
+                        string_free(AS_STRING(copy->fields[j]));
+                    } else if (IS_STRUCT(copy->fields[j])) {
+                        struct_instance_destroy(AS_STRUCT(copy->fields[j]));
                     }
                 }
                 OBJ_FREE(copy->fields, SIZE_VAL_ARRAY(instance->type->field_count));
@@ -614,16 +708,16 @@ StructInstance* struct_instance_copy(StructInstance* instance)
             }
         }
         // If field is a string, duplicate it
-        else if (instance->fields[i].type == VAL_STRING)
+        else if (IS_STRING(instance->fields[i]))
         {
-            copy->fields[i].as.string = STR_DUP(instance->fields[i].as.string);
-            if (!copy->fields[i].as.string) {
+            copy->fields[i] = STRING_VAL(string_clone(AS_STRING(instance->fields[i])));
+            if (!AS_STRING(copy->fields[i])) {
                 // Clean up partial copy
                 for (size_t j = 0; j < i; j++) {
-                    if (copy->fields[j].type == VAL_STRING) {
-                        STR_FREE((char*)copy->fields[j].as.string, strlen(copy->fields[j].as.string) + 1);
-                    } else if (copy->fields[j].type == VAL_STRUCT) {
-                        struct_instance_destroy((StructInstance*)copy->fields[j].as.object);
+                    if (IS_STRING(copy->fields[j])) {
+                        string_free(AS_STRING(copy->fields[j]));
+                    } else if (IS_STRUCT(copy->fields[j])) {
+                        struct_instance_destroy(AS_STRUCT(copy->fields[j]));
                     }
                 }
                 OBJ_FREE(copy->fields, SIZE_VAL_ARRAY(instance->type->field_count));
@@ -645,13 +739,13 @@ void struct_instance_destroy(StructInstance* instance)
     if (instance->fields && instance->type) {
         for (size_t i = 0; i < instance->type->field_count; i++)
         {
-            if (instance->fields[i].type == VAL_STRING)
+            if (IS_STRING(instance->fields[i]))
             {
-                STR_FREE((char*)instance->fields[i].as.string, strlen(instance->fields[i].as.string) + 1);
+                string_free(AS_STRING(instance->fields[i]));
             }
-            else if (instance->fields[i].type == VAL_STRUCT)
+            else if (IS_STRUCT(instance->fields[i]))
             {
-                struct_instance_destroy((StructInstance*)instance->fields[i].as.object);
+                struct_instance_destroy(AS_STRUCT(instance->fields[i]));
             }
         }
         
@@ -689,27 +783,28 @@ void struct_instance_set_field(StructInstance* instance, const char* field_name,
         if (strcmp(instance->type->field_names[i], field_name) == 0)
         {
             // Clean up old value if needed
-            if (instance->fields[i].type == VAL_STRING)
+            if (IS_STRING(instance->fields[i]))
             {
-                STR_FREE((char*)instance->fields[i].as.string, strlen(instance->fields[i].as.string) + 1);
+                string_free(AS_STRING(instance->fields[i]));
             }
-            else if (instance->fields[i].type == VAL_STRUCT)
+            else if (IS_STRUCT(instance->fields[i]))
             {
-                struct_instance_destroy((StructInstance*)instance->fields[i].as.object);
+                struct_instance_destroy(AS_STRUCT(instance->fields[i]));
             }
             
             // Set new value
             instance->fields[i] = value;
             
             // Copy string if needed
-            if (value.type == VAL_STRING)
+            if (IS_STRING(value))
             {
-                instance->fields[i].as.string = STR_DUP(value.as.string);
+                const char* chars = string_chars(AS_STRING(value));
+                instance->fields[i] = chars ? STRING_VAL(string_clone(chars)) : NIL_VAL;
             }
             // Copy struct if needed (value semantics)
-            else if (value.type == VAL_STRUCT)
+            else if (IS_STRUCT(value))
             {
-                instance->fields[i].as.object = (void*)struct_instance_copy((StructInstance*)value.as.object);
+                instance->fields[i] = STRUCT_VAL(struct_instance_copy(AS_STRUCT(value)));
             }
             
             return;
@@ -730,27 +825,28 @@ void struct_instance_set_field_by_index(StructInstance* instance, size_t index,
     if (!instance || index >= instance->type->field_count) return;
     
     // Clean up old value if needed
-    if (instance->fields[index].type == VAL_STRING)
+    if (IS_STRING(instance->fields[index]))
     {
-        STR_FREE((char*)instance->fields[index].as.string, strlen(instance->fields[index].as.string) + 1);
+        string_free(AS_STRING(instance->fields[index]));
     }
-    else if (instance->fields[index].type == VAL_STRUCT)
+    else if (IS_STRUCT(instance->fields[index]))
     {
-        struct_instance_destroy((StructInstance*)instance->fields[index].as.object);
+        struct_instance_destroy(AS_STRUCT(instance->fields[index]));
     }
     
     // Set new value
     instance->fields[index] = value;
     
     // Copy string if needed
-    if (value.type == VAL_STRING)
+    if (IS_STRING(value))
     {
-        instance->fields[index].as.string = STR_DUP(value.as.string);
+        const char* chars = string_chars(AS_STRING(value));
+        instance->fields[index] = chars ? STRING_VAL(string_clone(chars)) : NIL_VAL;
     }
     // Copy struct if needed (value semantics)
-    else if (value.type == VAL_STRUCT)
+    else if (IS_STRUCT(value))
     {
-        instance->fields[index].as.object = (void*)struct_instance_copy((StructInstance*)value.as.object);
+        instance->fields[index] = STRUCT_VAL(struct_instance_copy(AS_STRUCT(value)));
     }
 }
 
@@ -770,7 +866,7 @@ Object* get_struct_prototype(const char* struct_name)
     }
     
     // Create new prototype
-    Object* proto = object_create_with_prototype(object_prototype);
+    Object* proto = shared_prototype_create(object_prototype);
     if (!proto) return NULL;
     
     // fprintf(stderr, "[DEBUG] Created new struct prototype for '%s'\n", struct_name);
@@ -794,4 +890,25 @@ Object* get_struct_prototype(const char* struct_name)
     struct_prototypes = new_entry;
     
     return proto;
+}
+
+// Visit the prototypes held in this file's statics
+void object_iterate_shared_prototypes(PrototypeVisitor visitor, void* user_data)
+{
+    Object* builtins[] = {
+        object_prototype, array_prototype, string_prototype,
+        function_prototype, number_prototype, string_builder_prototype
+    };
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++)
+    {
+        if (builtins[i])
+        {
+            visitor(builtins[i], user_data);
+        }
+    }
+    
+    for (StructPrototype* entry = struct_prototypes; entry; entry = entry->next)
+    {
+        visitor(entry->prototype, user_data);
+    }
 }
\ No newline at end of file
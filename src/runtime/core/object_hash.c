@@ -1,284 +1,167 @@
-#include "runtime/core/object.h"
-#include "runtime/core/vm.h"
+#include "runtime/core/object_hash.h"
 #include "utils/allocators.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdint.h>
 
 /**
- * Hash table-based object implementation for better performance.
+ * Name -> slot index table behind large shapes and dictionary-mode objects.
  * This implementation uses open addressing with linear probing.
  */
 
 #define INITIAL_CAPACITY 8
 #define MAX_LOAD_FACTOR 0.75
 
-typedef struct {
-    char* key;
-    TaggedValue value;
-    bool occupied;
-    bool deleted;
-} HashEntry;
-
-typedef struct {
-    HashEntry* entries;
-    size_t capacity;
-    size_t count;
-    size_t tombstones;
-} HashTable;
-
 // FNV-1a hash function
-static uint32_t hash_string(const char* str) {
+uint32_t property_key_hash(const char* key) {
     uint32_t hash = 2166136261u;
-    while (*str) {
-        hash ^= (uint8_t)*str++;
+    while (*key) {
+        hash ^= (uint8_t)*key++;
         hash *= 16777619u;
     }
     return hash;
 }
 
-static HashTable* hash_table_create(size_t initial_capacity) {
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    HashTable* table = OBJ_ALLOC(sizeof(HashTable), "hash-table");
+static size_t capacity_for(size_t expected) {
+    size_t capacity = INITIAL_CAPACITY;
+    while (capacity * MAX_LOAD_FACTOR < expected + 1) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+PropertyTable* property_table_create(size_t expected, bool owns_keys) {
+    PropertyTable* table = OBJ_NEW(PropertyTable, "property-table");
     if (!table) return NULL;
-    
-    table->capacity = initial_capacity;
+
+    table->capacity = capacity_for(expected);
     table->count = 0;
     table->tombstones = 0;
-    table->entries = OBJ_ALLOC_ZERO(initial_capacity * sizeof(HashEntry), "hash-entries");
+    table->owns_keys = owns_keys;
+    table->entries = OBJ_ALLOC_ZERO(table->capacity * sizeof(PropertyTableEntry), "property-table-entries");
     if (!table->entries) {
-        OBJ_FREE(table, sizeof(HashTable));
+        OBJ_FREE(table, sizeof(PropertyTable));
         return NULL;
     }
-    
+
     return table;
 }
 
-static void hash_table_destroy(HashTable* table) {
+void property_table_destroy(PropertyTable* table) {
     if (!table) return;
-    
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    for (size_t i = 0; i < table->capacity; i++) {
-        if (table->entries[i].occupied && !table->entries[i].deleted) {
-            STR_FREE(table->entries[i].key, strlen(table->entries[i].key) + 1);
+
+    if (table->owns_keys) {
+        for (size_t i = 0; i < table->capacity; i++) {
+            if (table->entries[i].key) {
+                STR_FREE((char*)table->entries[i].key, strlen(table->entries[i].key) + 1);
+            }
         }
     }
-    OBJ_FREE(table->entries, table->capacity * sizeof(HashEntry));
-    OBJ_FREE(table, sizeof(HashTable));
+    OBJ_FREE(table->entries, table->capacity * sizeof(PropertyTableEntry));
+    OBJ_FREE(table, sizeof(PropertyTable));
 }
 
-static HashEntry* find_entry(HashEntry* entries, size_t capacity, const char* key) {
-    uint32_t hash = hash_string(key);
-    size_t index = hash % capacity;
-    HashEntry* tombstone = NULL;
-    
+// Entry holding `key`, or the slot it should be inserted into
+static PropertyTableEntry* find_entry(PropertyTableEntry* entries, size_t capacity,
+                                      const char* key, uint32_t hash) {
+    size_t index = hash & (capacity - 1);
+    PropertyTableEntry* tombstone = NULL;
+
     for (;;) {
-        HashEntry* entry = &entries[index];
-        
-        if (!entry->occupied) {
-            // Empty entry - key not found
-            return tombstone != NULL ? tombstone : entry;
-        }
-        
-        if (entry->deleted) {
+        PropertyTableEntry* entry = &entries[index];
+
+        if (!entry->key) {
+            if (!entry->deleted) {
+                // Empty entry - key not found
+                return tombstone != NULL ? tombstone : entry;
+            }
             // Remember first tombstone
             if (tombstone == NULL) tombstone = entry;
-        } else if (strcmp(entry->key, key) == 0) {
+        } else if (entry->hash == hash && strcmp(entry->key, key) == 0) {
             // Found the key
             return entry;
         }
-        
+
         // Linear probing
-        index = (index + 1) % capacity;
+        index = (index + 1) & (capacity - 1);
     }
 }
 
-static void hash_table_resize(HashTable* table) {
-    size_t new_capacity = table->capacity * 2;
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    HashEntry* new_entries = OBJ_ALLOC_ZERO(new_capacity * sizeof(HashEntry), "hash-entries-resize");
-    if (!new_entries) return; // Keep current capacity on allocation failure
-    
-    // Rehash all entries
-    table->count = 0;
-    table->tombstones = 0;
-    
+static bool table_resize(PropertyTable* table, size_t new_capacity) {
+    PropertyTableEntry* new_entries = OBJ_ALLOC_ZERO(new_capacity * sizeof(PropertyTableEntry),
+                                                     "property-table-entries");
+    if (!new_entries) return false;
+
+    // Rehash all live entries; tombstones are dropped
     for (size_t i = 0; i < table->capacity; i++) {
-        HashEntry* entry = &table->entries[i];
-        if (entry->occupied && !entry->deleted) {
-            HashEntry* dest = find_entry(new_entries, new_capacity, entry->key);
-            dest->key = entry->key;
-            dest->value = entry->value;
-            dest->occupied = true;
-            dest->deleted = false;
-            table->count++;
+        PropertyTableEntry* entry = &table->entries[i];
+        if (entry->key) {
+            *find_entry(new_entries, new_capacity, entry->key, entry->hash) = *entry;
         }
     }
-    
-    OBJ_FREE(table->entries, table->capacity * sizeof(HashEntry));
+
+    OBJ_FREE(table->entries, table->capacity * sizeof(PropertyTableEntry));
     table->entries = new_entries;
     table->capacity = new_capacity;
+    table->tombstones = 0;
+    return true;
 }
 
-static bool hash_table_set(HashTable* table, const char* key, TaggedValue value) {
-    // Check if we need to resize
-    if (table->count + table->tombstones + 1 > table->capacity * MAX_LOAD_FACTOR) {
-        hash_table_resize(table);
-    }
-    
-    HashEntry* entry = find_entry(table->entries, table->capacity, key);
-    bool is_new_key = !entry->occupied || entry->deleted;
-    
-    if (is_new_key) {
-        if (entry->deleted) {
-            table->tombstones--;
-        }
-        table->count++;
-        Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-        entry->key = STR_DUP(key);
-        if (!entry->key) return false;
-    }
-    
-    entry->value = value;
-    entry->occupied = true;
-    entry->deleted = false;
-    
-    return is_new_key;
-}
+bool property_table_get(const PropertyTable* table, const char* key, uint32_t* slot) {
+    if (table->count == 0) return false;
 
-static TaggedValue* hash_table_get(HashTable* table, const char* key) {
-    if (table->count == 0) return NULL;
-    
-    HashEntry* entry = find_entry(table->entries, table->capacity, key);
-    if (!entry->occupied || entry->deleted) {
-        return NULL;
-    }
-    
-    return &entry->value;
-}
+    PropertyTableEntry* entry = find_entry(table->entries, table->capacity, key, property_key_hash(key));
+    if (!entry->key) return false;
 
-static bool hash_table_delete(HashTable* table, const char* key) {
-    if (table->count == 0) return false;
-    
-    HashEntry* entry = find_entry(table->entries, table->capacity, key);
-    if (!entry->occupied || entry->deleted) {
-        return false;
-    }
-    
-    // Mark as deleted (tombstone)
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    STR_FREE(entry->key, strlen(entry->key) + 1);
-    entry->deleted = true;
-    table->tombstones++;
-    table->count--;
-    
+    *slot = entry->slot;
     return true;
 }
 
-// Enhanced object structure with hash table
-typedef struct ObjectHash {
-    HashTable* properties;
-    Object* prototype;
-    bool is_array;
-} ObjectHash;
-
-// Create optimized object
-Object* object_create_optimized(void) {
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    ObjectHash* obj = OBJ_ALLOC(sizeof(ObjectHash), "object-hash");
-    if (!obj) return NULL;
-    
-    obj->properties = hash_table_create(INITIAL_CAPACITY);
-    if (!obj->properties) {
-        OBJ_FREE(obj, sizeof(ObjectHash));
-        return NULL;
+bool property_table_set(PropertyTable* table, const char* key, uint32_t slot) {
+    // Check if we need to resize
+    if (table->count + table->tombstones + 1 > table->capacity * MAX_LOAD_FACTOR) {
+        size_t new_capacity = capacity_for(table->count + 1);
+        if (!table_resize(table, new_capacity > table->capacity ? new_capacity : table->capacity)) {
+            return false;
+        }
     }
-    
-    obj->prototype = NULL;
-    obj->is_array = false;
-    return (Object*)obj;
-}
 
-// Get property with hash table
-TaggedValue* object_get_property_optimized(Object* obj, const char* key) {
-    if (!obj || !key) return NULL;
-    
-    ObjectHash* hash_obj = (ObjectHash*)obj;
-    TaggedValue* value = hash_table_get(hash_obj->properties, key);
-    
-    if (value) {
-        return value;
-    }
-    
-    // Check prototype chain
-    if (hash_obj->prototype) {
-        return object_get_property_optimized(hash_obj->prototype, key);
+    uint32_t hash = property_key_hash(key);
+    PropertyTableEntry* entry = find_entry(table->entries, table->capacity, key, hash);
+    if (entry->key) {
+        entry->slot = slot;
+        return false;
     }
-    
-    return NULL;
-}
-
-// Set property with hash table
-void object_set_property_optimized(Object* obj, const char* key, TaggedValue value) {
-    if (!obj || !key) return;
-    
-    ObjectHash* hash_obj = (ObjectHash*)obj;
-    hash_table_set(hash_obj->properties, key, value);
-}
 
-// Module export optimization: pre-sized hash table
-Object* create_module_export_object(size_t expected_exports) {
-    Allocator* alloc = allocators_get(ALLOC_SYSTEM_OBJECTS);
-    ObjectHash* obj = OBJ_ALLOC(sizeof(ObjectHash), "object-hash");
-    if (!obj) return NULL;
-    
-    // Pre-size the hash table to avoid resizing
-    size_t initial_size = 8;
-    while (initial_size < expected_exports / MAX_LOAD_FACTOR) {
-        initial_size *= 2;
+    const char* stored = key;
+    if (table->owns_keys) {
+        stored = STR_DUP(key);
+        if (!stored) return false;
     }
-    obj->properties = hash_table_create(initial_size);
-    if (!obj->properties) {
-        OBJ_FREE(obj, sizeof(ObjectHash));
-        return NULL;
+    if (entry->deleted) {
+        table->tombstones--;
     }
-    
-    obj->prototype = NULL;
-    obj->is_array = false;
-    return (Object*)obj;
+    entry->key = stored;
+    entry->hash = hash;
+    entry->slot = slot;
+    entry->deleted = false;
+    table->count++;
+    return true;
 }
 
-// Batch export optimization
-void object_set_properties_batch(Object* obj, const char** keys, TaggedValue* values, size_t count) {
-    if (!obj || !keys || !values || count == 0) return;
-    
-    ObjectHash* hash_obj = (ObjectHash*)obj;
-    
-    // Pre-resize if necessary
-    size_t required_capacity = (hash_obj->properties->count + count) / MAX_LOAD_FACTOR;
-    while (hash_obj->properties->capacity < required_capacity) {
-        hash_table_resize(hash_obj->properties);
-    }
-    
-    // Batch insert
-    for (size_t i = 0; i < count; i++) {
-        hash_table_set(hash_obj->properties, keys[i], values[i]);
-    }
-}
+bool property_table_delete(PropertyTable* table, const char* key) {
+    if (table->count == 0) return false;
 
-// Property iteration for export/import all
-typedef void (*PropertyIterator)(const char* key, TaggedValue* value, void* user_data);
+    PropertyTableEntry* entry = find_entry(table->entries, table->capacity, key, property_key_hash(key));
+    if (!entry->key) return false;
 
-void object_iterate_properties(Object* obj, PropertyIterator iterator, void* user_data) {
-    if (!obj || !iterator) return;
-    
-    ObjectHash* hash_obj = (ObjectHash*)obj;
-    HashTable* table = hash_obj->properties;
-    
-    for (size_t i = 0; i < table->capacity; i++) {
-        HashEntry* entry = &table->entries[i];
-        if (entry->occupied && !entry->deleted) {
-            iterator(entry->key, &entry->value, user_data);
-        }
+    // Mark as deleted (tombstone)
+    if (table->owns_keys) {
+        STR_FREE((char*)entry->key, strlen(entry->key) + 1);
     }
-}
\ No newline at end of file
+    entry->key = NULL;
+    entry->deleted = true;
+    table->tombstones++;
+    table->count--;
+
+    return true;
+}
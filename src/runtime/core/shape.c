@@ -0,0 +1,117 @@
+#include "runtime/core/shape.h"
+#include "runtime/core/object_hash.h"
+#include "utils/allocators.h"
+#include <string.h>
+
+static Shape root_shape;
+
+Shape* shape_root(void)
+{
+    return &root_shape;
+}
+
+static Shape* shape_create(Shape* parent, const char* key, uint32_t hash)
+{
+    Shape* shape = OBJ_ALLOC_ZERO(sizeof(Shape), "shape");
+    if (!shape) return NULL;
+
+    shape->key = STR_DUP(key);
+    if (!shape->key) {
+        OBJ_FREE(shape, sizeof(Shape));
+        return NULL;
+    }
+    shape->parent = parent;
+    shape->key_hash = hash;
+    shape->slot = parent->slot_count;
+    shape->slot_count = parent->slot_count + 1;
+    return shape;
+}
+
+// The transition entry for `key`: its child, or the empty entry it would go
+// in. The table is open-addressed by key hash and never full.
+static Shape** transition_entry(Shape** transitions, uint32_t capacity, const char* key, uint32_t hash)
+{
+    uint32_t mask = capacity - 1;
+    for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+        Shape* child = transitions[i];
+        if (!child || (child->key_hash == hash && strcmp(child->key, key) == 0)) {
+            return &transitions[i];
+        }
+    }
+}
+
+// Double the transition table, keeping it at most half full
+static bool grow_transitions(Shape* shape)
+{
+    uint32_t old_capacity = shape->transition_capacity;
+    uint32_t new_capacity = old_capacity < 4 ? 4 : old_capacity * 2;
+    Shape** transitions = OBJ_ALLOC_ZERO(new_capacity * sizeof(Shape*), "shape-transitions");
+    if (!transitions) return false;
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        Shape* child = shape->transitions[i];
+        if (child) {
+            *transition_entry(transitions, new_capacity, child->key, child->key_hash) = child;
+        }
+    }
+    if (shape->transitions) {
+        OBJ_FREE(shape->transitions, old_capacity * sizeof(Shape*));
+    }
+    shape->transitions = transitions;
+    shape->transition_capacity = new_capacity;
+    return true;
+}
+
+Shape* shape_add_key(Shape* shape, const char* key)
+{
+    uint32_t hash = property_key_hash(key);
+
+    // Reuse an existing transition
+    if (shape->transition_count > 0) {
+        Shape* child = *transition_entry(shape->transitions, shape->transition_capacity, key, hash);
+        if (child) return child;
+    }
+
+    if (shape->transition_count == SHAPE_MAX_TRANSITIONS) {
+        return NULL;
+    }
+    if (2 * (shape->transition_count + 1) > shape->transition_capacity && !grow_transitions(shape)) {
+        return NULL;
+    }
+
+    Shape* child = shape_create(shape, key, hash);
+    if (!child) return NULL;
+    *transition_entry(shape->transitions, shape->transition_capacity, key, hash) = child;
+    shape->transition_count++;
+    return child;
+}
+
+bool shape_lookup(Shape* shape, const char* key, uint32_t* slot)
+{
+    if (shape->slot_count <= SHAPE_LINEAR_LOOKUP) {
+        for (Shape* s = shape; s->key; s = s->parent) {
+            if (strcmp(s->key, key) == 0) {
+                *slot = s->slot;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (!shape->table) {
+        // Keys are borrowed from the chain, which outlives the table
+        PropertyTable* table = property_table_create(shape->slot_count, false);
+        if (!table) return false;
+        for (Shape* s = shape; s->key; s = s->parent) {
+            property_table_set(table, s->key, s->slot);
+        }
+        shape->table = table;
+    }
+    return property_table_get(shape->table, key, slot);
+}
+
+void shape_collect_keys(const Shape* shape, const char** keys)
+{
+    for (const Shape* s = shape; s->key; s = s->parent) {
+        keys[s->slot] = s->key;
+    }
+}
@@ -0,0 +1,66 @@
+#include "runtime/core/string_object.h"
+#include "utils/allocators.h"
+#include <string.h>
+
+uint32_t string_hash_bytes(const char* chars, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (uint8_t)chars[i];
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+char* string_alloc(size_t length) {
+    if (length > STRING_MAX_LENGTH) return NULL;
+    StringHeader* header = STR_ALLOC(sizeof(StringHeader) + length + 1);
+    if (!header) return NULL;
+    header->length = (uint32_t)length;
+    header->hash = 0;
+    header->flags = 0;
+    header->marked = 0;
+    header->pool = 0;
+    char* chars = (char*)(header + 1);
+    chars[length] = '\0';
+    return chars;
+}
+
+char* string_seal(char* chars) {
+    if (chars) {
+        STRING_HEADER(chars)->hash = string_hash_bytes(chars, string_length(chars));
+    }
+    return chars;
+}
+
+char* string_new(const char* chars, size_t length) {
+    char* string = string_alloc(length);
+    if (!string) return NULL;
+    memcpy(string, chars, length);
+    return string_seal(string);
+}
+
+char* string_copy(const char* chars) {
+    return string_new(chars, strlen(chars));
+}
+
+char* string_clone(const char* string) {
+    size_t length = string_length(string);
+    char* copy = string_alloc(length);
+    if (!copy) return NULL;
+    memcpy(copy, string, length);
+    STRING_HEADER(copy)->hash = string_hash(string);
+    return copy;
+}
+
+size_t string_allocation_size(const char* chars) {
+    const StringHeader* header = STRING_HEADER(chars);
+    if (header->flags & STRING_ROPE) {
+        return sizeof(StringHeader) + sizeof(StringRope);
+    }
+    return sizeof(StringHeader) + header->length + 1;
+}
+
+void string_free(char* chars) {
+    if (!chars) return;
+    STR_FREE(STRING_HEADER(chars), string_allocation_size(chars));
+}
@@ -7,21 +7,17 @@
 #define INITIAL_BUCKET_COUNT 32
 #define MAX_LOAD_FACTOR 0.75
 
-static uint32_t hash_string(const char* string, size_t length) {
-    uint32_t hash = 2166136261u;
-    for (size_t i = 0; i < length; i++) {
-        hash ^= (uint8_t)string[i];
-        hash *= 16777619;
-    }
-    return hash;
-}
-
 void string_pool_init(StringPool* pool) {
+    // Ids only need to differ between pools alive at the same time, and a
+    // pool frees its strings with it, so 32 bits will not wrap onto one
+    static uint32_t next_id = 0;
+    pool->id = ++next_id;
     pool->bucket_count = INITIAL_BUCKET_COUNT;
     Allocator* alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
     pool->buckets = MEM_ALLOC_ZERO(alloc, pool->bucket_count * sizeof(StringEntry*));
     pool->entry_count = 0;
     pool->all_strings = NULL;
+    pool->bytes = 0;
 }
 
 void string_pool_free(StringPool* pool) {
@@ -29,8 +25,7 @@ void string_pool_free(StringPool* pool) {
     StringEntry* current = pool->all_strings;
     while (current) {
         StringEntry* next = current->all_next;
-        // Strings use ALLOC_SYSTEM_STRINGS allocator
-        STR_FREE(current->string, strlen(current->string) + 1);
+        string_free(current->string);
         STR_FREE(current, sizeof(StringEntry));
         current = next;
     }
@@ -41,6 +36,30 @@ void string_pool_free(StringPool* pool) {
     pool->bucket_count = 0;
     pool->entry_count = 0;
     pool->all_strings = NULL;
+    pool->bytes = 0;
+}
+
+void string_pool_release(StringPool* pool) {
+    StringEntry* current = pool->all_strings;
+    while (current) {
+        StringEntry* next = current->all_next;
+        StringHeader* header = STRING_HEADER(current->string);
+        header->flags &= ~(STRING_INTERNED | STRING_ADOPTED);
+        header->marked = 0;
+        header->pool = 0;  // No pool's id, so no pool owns a rope either
+        if (header->flags & STRING_ROPE) {
+            STRING_ROPE_DATA(current->string)->pool = NULL;
+        }
+        STR_FREE(current, sizeof(StringEntry));
+        current = next;
+    }
+    
+    if (pool->buckets) {
+        memset(pool->buckets, 0, pool->bucket_count * sizeof(StringEntry*));
+    }
+    pool->entry_count = 0;
+    pool->all_strings = NULL;
+    pool->bytes = 0;
 }
 
 static StringEntry* find_entry(StringPool* pool, const char* string, size_t length, uint32_t hash) {
@@ -50,7 +69,8 @@ static StringEntry* find_entry(StringPool* pool, const char* string, size_t leng
     StringEntry* entry = pool->buckets[index];
     
     while (entry) {
-        if (entry->length == length && memcmp(entry->string, string, length) == 0) {
+        if (string_hash(entry->string) == hash && string_length(entry->string) == length &&
+            memcmp(entry->string, string, length) == 0) {
             return entry;
         }
         entry = entry->next;
@@ -71,9 +91,7 @@ static void resize_pool(StringPool* pool) {
         StringEntry* entry = pool->buckets[i];
         while (entry) {
             StringEntry* next = entry->next;
-            // Recompute hash since StringEntry doesn't store it
-            uint32_t hash = hash_string(entry->string, entry->length);
-            uint32_t new_index = hash % new_bucket_count;
+            uint32_t new_index = string_hash(entry->string) % new_bucket_count;
             entry->next = new_buckets[new_index];
             new_buckets[new_index] = entry;
             entry = next;
@@ -86,10 +104,78 @@ static void resize_pool(StringPool* pool) {
     pool->bucket_count = new_bucket_count;
 }
 
+// Put the string of `entry`, known not to be in the pool yet, in its bucket
+// and mark it interned
+static void intern_entry(StringPool* pool, StringEntry* entry) {
+    // Check if we need to resize
+    if (pool->entry_count >= pool->bucket_count * MAX_LOAD_FACTOR) {
+        resize_pool(pool);
+    }
+    
+    StringHeader* header = STRING_HEADER(entry->string);
+    header->flags = (uint8_t)((header->flags & ~STRING_ADOPTED) | STRING_INTERNED);
+    header->pool = pool->id;
+    
+    uint32_t index = header->hash % pool->bucket_count;
+    entry->next = pool->buckets[index];
+    pool->buckets[index] = entry;
+    pool->entry_count++;
+}
+
+// Add `string`, known not to be in the pool yet, and mark it interned
+static char* add_entry(StringPool* pool, char* string) {
+    Allocator* alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
+    StringEntry* entry = MEM_ALLOC(alloc, sizeof(StringEntry));
+    if (!entry) return NULL;
+    
+    entry->string = string;
+    intern_entry(pool, entry);
+    
+    // Add to all strings list
+    entry->all_next = pool->all_strings;
+    pool->all_strings = entry;
+    pool->bytes += string_allocation_size(string);
+    
+    return string;
+}
+
+void string_pool_adopt(StringPool* into, StringPool* from) {
+    StringEntry* entry = from->all_strings;
+    while (entry) {
+        StringEntry* next = entry->all_next;
+        StringHeader* header = STRING_HEADER(entry->string);
+        header->pool = into->id;
+        header->marked = 0;
+        
+        // Pointers to each string are held where it was made, so one equal
+        // to a string `into` has interned stays a copy of its own
+        if (header->flags & STRING_ROPE) {
+            STRING_ROPE_DATA(entry->string)->pool = into;
+        } else if (find_entry(into, entry->string, header->length, header->hash)) {
+            header->flags = (uint8_t)((header->flags & ~STRING_INTERNED) | STRING_ADOPTED);
+            entry->next = NULL;
+        } else {
+            intern_entry(into, entry);
+        }
+        
+        entry->all_next = into->all_strings;
+        into->all_strings = entry;
+        into->bytes += string_allocation_size(entry->string);
+        entry = next;
+    }
+    
+    if (from->buckets) {
+        memset(from->buckets, 0, from->bucket_count * sizeof(StringEntry*));
+    }
+    from->entry_count = 0;
+    from->all_strings = NULL;
+    from->bytes = 0;
+}
+
 char* string_pool_intern(StringPool* pool, const char* string, size_t length) {
     if (!string) return NULL;
     
-    uint32_t hash = hash_string(string, length);
+    uint32_t hash = string_hash_bytes(string, length);
     
     // Check if string already exists
     StringEntry* existing = find_entry(pool, string, length, hash);
@@ -97,39 +183,118 @@ char* string_pool_intern(StringPool* pool, const char* string, size_t length) {
         return existing->string;
     }
     
-    // Check if we need to resize
-    if (pool->entry_count >= pool->bucket_count * MAX_LOAD_FACTOR) {
-        resize_pool(pool);
+    char* copy = string_new(string, length);
+    if (!copy) return NULL;
+    char* interned = add_entry(pool, copy);
+    if (!interned) string_free(copy);
+    return interned;
+}
+
+char* string_pool_intern_string(StringPool* pool, const char* string) {
+    if (!string) return NULL;
+    if (string_is_rope(string)) {
+        string = string_flatten((char*)string);
+        if (!string) return NULL;
+    }
+    if (string_is_interned(string) && STRING_HEADER(string)->pool == pool->id) {
+        return (char*)string;
+    }
+    
+    StringEntry* existing = find_entry(pool, string, string_length(string), string_hash(string));
+    if (existing) {
+        return existing->string;
     }
     
-    // Create new entry
+    char* copy = string_clone(string);
+    if (!copy) return NULL;
+    char* interned = add_entry(pool, copy);
+    if (!interned) string_free(copy);
+    return interned;
+}
+
+char* string_pool_take(StringPool* pool, char* string) {
+    if (!string) return NULL;
+    if (string_is_interned(string)) return string;
+    
+    StringEntry* existing = find_entry(pool, string, string_length(string), string_hash(string));
+    if (existing) {
+        string_free(string);
+        return existing->string;
+    }
+    
+    char* interned = add_entry(pool, string);
+    if (!interned) string_free(string);
+    return interned;
+}
+
+char* string_pool_rope(StringPool* pool, const char* left, const char* right) {
+    size_t length = string_length(left) + string_length(right);
+    if (length > STRING_MAX_LENGTH) return NULL;
+    
     Allocator* alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
     StringEntry* entry = MEM_ALLOC(alloc, sizeof(StringEntry));
     if (!entry) return NULL;
-    
-    entry->string = MEM_ALLOC(alloc, length + 1);
-    if (!entry->string) {
+    StringHeader* header = STR_ALLOC(sizeof(StringHeader) + sizeof(StringRope));
+    if (!header) {
         STR_FREE(entry, sizeof(StringEntry));
         return NULL;
     }
     
-    memcpy(entry->string, string, length);
-    entry->string[length] = '\0';
-    entry->length = length;
-    entry->marked = false;
+    header->length = (uint32_t)length;
+    header->hash = 0;
+    header->flags = STRING_ROPE;
+    header->marked = 0;
+    header->pool = pool->id;
+    char* string = (char*)(header + 1);
+    StringRope* rope = STRING_ROPE_DATA(string);
+    rope->left = left;
+    rope->right = right;
+    rope->flat = NULL;
+    rope->pool = pool;
     
-    // Add to hash table
-    uint32_t index = hash % pool->bucket_count;
-    entry->next = pool->buckets[index];
-    pool->buckets[index] = entry;
-    
-    // Add to all strings list
+    // Without a hash it cannot be looked up, so it goes in no bucket
+    entry->string = string;
+    entry->next = NULL;
     entry->all_next = pool->all_strings;
     pool->all_strings = entry;
+    pool->bytes += string_allocation_size(string);
     
-    pool->entry_count++;
+    return string;
+}
+
+char* string_flatten(char* string) {
+    StringRope* rope = STRING_ROPE_DATA(string);
+    if (rope->flat) return rope->flat;
+    
+    size_t end = string_length(string);
+    char* flat = string_alloc(end);
+    if (!flat) return NULL;
     
-    return entry->string;
+    // Right halves from the back, down the chain to a flat left side or a
+    // rope flattened before
+    const char* part = string;
+    while (string_is_rope(part) && !STRING_ROPE_DATA(part)->flat) {
+        const StringRope* node = STRING_ROPE_DATA(part);
+        size_t length = string_length(node->right);
+        end -= length;
+        memcpy(flat + end, node->right, length);
+        part = node->left;
+    }
+    if (string_is_rope(part)) {
+        part = STRING_ROPE_DATA(part)->flat;
+    }
+    memcpy(flat, part, end);
+    string_seal(flat);
+    
+    if (rope->pool) {
+        flat = string_pool_take(rope->pool, flat);
+        // If marking has passed the rope, it will not come back for this
+        STRING_HEADER(flat)->marked |= STRING_HEADER(string)->marked;
+    }
+    rope->flat = flat;
+    rope->left = NULL;
+    rope->right = NULL;
+    return flat;
 }
 
 char* string_pool_intern_cstr(StringPool* pool, const char* string) {
@@ -142,11 +307,29 @@ char* string_pool_create(StringPool* pool, const char* string, size_t length) {
 }
 
 void string_pool_mark_sweep_begin(StringPool* pool) {
-    // Mark all strings as unreachable
-    StringEntry* entry = pool->all_strings;
-    while (entry) {
-        entry->marked = false;
-        entry = entry->all_next;
+    for (StringEntry* entry = pool->all_strings; entry; entry = entry->all_next) {
+        STRING_HEADER(entry->string)->marked = 0;
+    }
+}
+
+void string_pool_mark_rope(StringPool* pool, const char* string) {
+    // A loop, not recursion: an accumulator's chain is as long as the loop
+    // that built it ran
+    for (;;) {
+        const StringRope* rope = STRING_ROPE_DATA(string);
+        if (rope->flat) {
+            string_pool_mark(pool, rope->flat);
+            return;
+        }
+        string_pool_mark(pool, rope->right);
+        
+        StringHeader* left = STRING_HEADER(rope->left);
+        if (!string_is_owned_by(rope->left, pool->id) || left->marked) {
+            return;
+        }
+        left->marked = 1;
+        if (!(left->flags & STRING_ROPE)) return;
+        string = rope->left;
     }
 }
 
@@ -154,59 +337,46 @@ bool string_pool_contains(StringPool* pool, const char* string) {
     if (!string) return false;
     
     size_t length = strlen(string);
-    uint32_t hash = hash_string(string, length);
-    
-    return find_entry(pool, string, length, hash) != NULL;
+    return find_entry(pool, string, length, string_hash_bytes(string, length)) != NULL;
 }
 
-void string_pool_mark(StringPool* pool, char* string) {
-    if (!string) return;
-    
-    // Mark all strings that match this pointer
-    StringEntry* entry = pool->all_strings;
-    while (entry) {
-        if (entry->string == string) {
-            entry->marked = true;
-            return;
-        }
-        entry = entry->all_next;
-    }
-}
-
-void string_pool_sweep(StringPool* pool) {
+size_t string_pool_sweep(StringPool* pool) {
     StringEntry** current = &pool->all_strings;
+    size_t freed = 0;
     
     while (*current) {
         StringEntry* entry = *current;
+        StringHeader* header = STRING_HEADER(entry->string);
+        
+        if (header->marked) {
+            // Reset mark for next cycle
+            header->marked = 0;
+            current = &entry->all_next;
+            continue;
+        }
         
-        if (!entry->marked) {
-            // Remove from bucket chain
-            uint32_t hash = hash_string(entry->string, entry->length);
-            uint32_t index = hash % pool->bucket_count;
+        // Remove from bucket chain
+        if (header->flags & STRING_INTERNED) {
+            uint32_t index = header->hash % pool->bucket_count;
             StringEntry** bucket_ptr = &pool->buckets[index];
-            while (*bucket_ptr) {
-                if (*bucket_ptr == entry) {
-                    *bucket_ptr = entry->next;
-                    break;
-                }
+            while (*bucket_ptr != entry) {
                 bucket_ptr = &(*bucket_ptr)->next;
             }
-            
-            // Remove from all strings list
-            *current = entry->all_next;
-            
-            // Free the entry
-            StringEntry* unreached = entry;
-            STR_FREE(unreached->string, strlen(unreached->string) + 1);
-            STR_FREE(unreached, sizeof(StringEntry));
-            
+            *bucket_ptr = entry->next;
             pool->entry_count--;
-        } else {
-            // Reset mark for next cycle
-            entry->marked = false;
-            current = &entry->all_next;
         }
+        
+        // Remove from all strings list
+        *current = entry->all_next;
+        
+        size_t size = string_allocation_size(entry->string);
+        freed += size;
+        string_free(entry->string);
+        STR_FREE(entry, sizeof(StringEntry));
     }
+    
+    pool->bytes -= freed;
+    return freed;
 }
 
 size_t string_pool_count(StringPool* pool) {
@@ -219,7 +389,7 @@ size_t string_pool_memory_usage(StringPool* pool) {
     StringEntry* entry = pool->all_strings;
     while (entry) {
         total += sizeof(StringEntry);
-        total += entry->length + 1;
+        total += string_allocation_size(entry->string);
         entry = entry->all_next;
     }
     
@@ -4,6 +4,7 @@
 #include "runtime/modules/lifecycle/builtin_modules.h"
 #include "runtime/core/bootstrap.h"
 #include "runtime/core/gc.h"
+#include "runtime/core/shape.h"
 #include "stdlib/stdlib.h"
 #include "utils/logger.h"
 #include "utils/allocators.h"
@@ -32,6 +33,9 @@ static char g_vm_error_message[512];
 #define vm_has_error(vm) g_vm_has_error
 #define vm_error_message(vm) g_vm_error_message
 
+// Innermost frames printed in a runtime error's stack trace
+#define VM_TRACE_FRAMES 32
+
 #define GROW_CAPACITY(capacity) ((capacity) < 8 ? 8 : (capacity) * 2)
 
 // Bytecode allocator macros
@@ -69,7 +73,7 @@ static void object_hash_free(ObjectHash *hash) {
 
 // String creation helper
 static TaggedValue create_string_value(const char *str) {
-    return STRING_VAL(STR_DUP(str));
+    return STRING_VAL(string_copy(str));
 }
 
 // Built-in native functions
@@ -87,7 +91,7 @@ static TaggedValue native_typeof(int arg_count, TaggedValue *args) {
         return create_string_value("error: typeof expects 1 argument");
     }
 
-    switch (args[0].type) {
+    switch (VALUE_TYPE(args[0])) {
         case VAL_BOOL: return create_string_value("bool");
         case VAL_NIL: return create_string_value("nil");
         case VAL_NUMBER: return create_string_value("number");
@@ -125,6 +129,7 @@ static void bootstrap_init(VM *vm) {
     define_global(vm, "print", NATIVE_VAL(native_print));
     define_global(vm, "typeof", NATIVE_VAL(native_typeof));
     define_global(vm, "assert", NATIVE_VAL(native_assert));
+    stdlib_init_string_builder(vm);
 }
 
 void chunk_init(Chunk *chunk) {
@@ -132,9 +137,17 @@ void chunk_init(Chunk *chunk) {
     chunk->capacity = 0;
     chunk->code = NULL;
     chunk->lines = NULL;
+    chunk->max_stack = 0;
     chunk->constants.count = 0;
     chunk->constants.capacity = 0;
     chunk->constants.values = NULL;
+    chunk->global_cache = NULL;
+    chunk->global_cache_count = 0;
+    chunk->inline_caches = NULL;
+    chunk->inline_cache_count = 0;
+    chunk->inline_cache_capacity = 0;
+    chunk->inline_cache_index = NULL;
+    chunk->inline_cache_index_count = 0;
 }
 
 void chunk_free(Chunk *chunk) {
@@ -153,6 +166,15 @@ void chunk_free(Chunk *chunk) {
     if (chunk->constants.values) {
         BYTECODE_FREE(chunk->constants.values, chunk->constants.capacity * sizeof(TaggedValue));
     }
+    if (chunk->global_cache) {
+        BYTECODE_FREE(chunk->global_cache, chunk->global_cache_count * sizeof(GlobalCache));
+    }
+    if (chunk->inline_caches) {
+        BYTECODE_FREE(chunk->inline_caches, chunk->inline_cache_capacity * sizeof(InlineCache));
+    }
+    if (chunk->inline_cache_index) {
+        BYTECODE_FREE(chunk->inline_cache_index, chunk->inline_cache_index_count * sizeof(uint16_t));
+    }
 
     chunk_init(chunk);
 }
@@ -208,18 +230,58 @@ int chunk_add_constant(Chunk *chunk, TaggedValue value) {
 // Forward declaration
 void define_global(VM *vm, const char *name, TaggedValue value);
 
+// Value stacks carry nil guard slots below their base so a stray pop on an
+// empty stack reads nil instead of neighbouring heap memory
+#define VM_STACK_GUARD 1
+
+static TaggedValue *stack_alloc(size_t capacity) {
+    TaggedValue *base = VM_NEW_ARRAY(TaggedValue, capacity + VM_STACK_GUARD);
+    if (!base) {
+        return NULL;
+    }
+    for (size_t i = 0; i < VM_STACK_GUARD; i++) {
+        base[i] = NIL_VAL;
+    }
+    return base + VM_STACK_GUARD;
+}
+
+static void stack_free(TaggedValue *stack, size_t capacity) {
+    VM_FREE(stack - VM_STACK_GUARD, (capacity + VM_STACK_GUARD) * sizeof(TaggedValue));
+}
+
+// Where a new VM's global cache epoch starts: past every epoch a freed VM
+// reached, so one that reuses a freed VM's address cannot match its caches
+static uint32_t global_cache_epoch_floor = 1;
+
+static void global_cache_epoch_retire(uint32_t epoch) {
+    uint32_t floor = platform_atomic_load_u32(&global_cache_epoch_floor);
+    while (floor <= epoch && !platform_atomic_cas_u32(&global_cache_epoch_floor, floor, epoch + 1)) {
+        floor = platform_atomic_load_u32(&global_cache_epoch_floor);
+    }
+}
+
 void vm_init(VM *vm) {
+    vm->stack = stack_alloc(VM_STACK_INITIAL);
+    vm->stack_capacity = VM_STACK_INITIAL;
+    vm->stack_limit = VM_STACK_LIMIT;
     vm->stack_top = vm->stack;
+    vm->frames = VM_NEW_ARRAY(CallFrame, VM_FRAMES_INITIAL);
+    vm->frame_capacity = VM_FRAMES_INITIAL;
+    vm->frame_limit = VM_FRAMES_LIMIT;
     vm->frame_count = 0;
+    vm->retired_stacks = NULL;
+    vm->native_depth = 0;
     vm->globals.count = 0;
     vm->globals.capacity = 0;
     vm->globals.names = NULL;
     vm->globals.values = NULL;
+    vm->global_cache_epoch = platform_atomic_load_u32(&global_cache_epoch_floor);
     vm->struct_types.count = 0;
     vm->struct_types.capacity = 0;
     vm->struct_types.names = NULL;
     vm->struct_types.types = NULL;
     vm->open_upvalues = NULL;
+    vm->module_loader = NULL;
     vm->current_module = NULL;
     vm->debug_trace = false;
     string_pool_init(&vm->strings);
@@ -232,9 +294,14 @@ void vm_init(VM *vm) {
         .max_heap_size = 0,             // Unlimited
         .gc_threshold = 1024 * 1024,    // 1MB
         .incremental = false,
-        .incremental_step_size = 1024,
+        .max_pause_us = 1000,
         .stress_test = false,
-        .verbose = false
+        .verbose = false,
+        .generational = true,
+        .nursery_size = 256 * 1024,
+        .mark_threads = 1,
+        .fragmentation_threshold = 0.25,
+        .target_pause_us = 10000
     };
     vm->gc = gc_create(vm, &gc_config);
     
@@ -279,11 +346,26 @@ static void vm_print_internal(const char *message, const char *end, bool newline
 }
 
 void vm_free(VM *vm) {
-    // Destroy garbage collector (will collect all remaining objects)
+    vm_free_into(vm, NULL);
+}
+
+void vm_free_into(VM *vm, VM *importer) {
+    // A module's exports and globals outlive the VM that ran it, so the
+    // importer takes over its objects and strings. The collector goes
+    // first: it finishes any cycle the importer has in progress.
+    if (importer && importer->gc && vm->gc) {
+        gc_adopt(importer->gc, vm->gc);
+        string_pool_adopt(&importer->strings, &vm->strings);
+    }
+    
+    // Destroy garbage collector, freeing the objects the importer did not
+    // take over
     if (vm->gc) {
         gc_destroy(vm->gc);
         vm->gc = NULL;
     }
+    object_set_current_vm(NULL);
+    stdlib_set_vm(NULL);
     
     // Free global names and values
     for (size_t i = 0; i < vm->globals.count; i++) {
@@ -297,6 +379,7 @@ void vm_free(VM *vm) {
     if (vm->globals.values) {
         VM_FREE(vm->globals.values, vm->globals.capacity * sizeof(TaggedValue));
     }
+    global_cache_epoch_retire(vm->global_cache_epoch);
 
     // Free struct types
     for (size_t i = 0; i < vm->struct_types.count; i++) {
@@ -313,6 +396,25 @@ void vm_free(VM *vm) {
 
     string_pool_free(&vm->strings);
     object_hash_free(&vm_objects(vm));
+
+    while (vm->retired_stacks) {
+        RetiredStack *retired = vm->retired_stacks;
+        vm->retired_stacks = retired->next;
+        stack_free(retired->values, retired->capacity);
+        VM_FREE(retired, sizeof(RetiredStack));
+    }
+    stack_free(vm->stack, vm->stack_capacity);
+    VM_FREE(vm->frames, (size_t)vm->frame_capacity * sizeof(CallFrame));
+    vm->stack = vm->stack_top = NULL;
+    vm->frames = NULL;
+    vm->stack_capacity = 0;
+    vm->frame_capacity = 0;
+}
+
+void vm_set_stack_limits(VM *vm, size_t max_stack, int max_frames) {
+    // Never below what is already allocated, so live frames stay valid
+    vm->stack_limit = max_stack > vm->stack_capacity ? max_stack : vm->stack_capacity;
+    vm->frame_limit = max_frames > vm->frame_capacity ? max_frames : vm->frame_capacity;
 }
 
 // Initialize a new VM instance
@@ -384,6 +486,7 @@ static void close_upvalues(VM *vm, TaggedValue *last) {
         Upvalue *upvalue = vm->open_upvalues;
         upvalue->closed = *upvalue->location;
         upvalue->location = &upvalue->closed;
+        gc_upvalue_write(vm->gc, upvalue);
         vm->open_upvalues = upvalue->next;
     }
 }
@@ -396,7 +499,12 @@ static void vm_runtime_error(VM *vm, const char *format, ...) {
 
     // Print stack trace
     fprintf(stderr, "\n[Stack trace]\n");
+    int shown = 0;
     for (int i = vm->frame_count - 1; i >= 0; i--) {
+        if (shown++ == VM_TRACE_FRAMES && i > 0) {
+            fprintf(stderr, "  ... %d more frames\n", i + 1);
+            break;
+        }
         CallFrame *frame = &vm->frames[i];
         size_t instruction = frame->ip - frame->closure->function->chunk.code - 1;
         fprintf(stderr, "  at %s:%d\n", frame->closure->function->name,
@@ -421,6 +529,104 @@ static TaggedValue vm_peek(VM *vm, int distance) {
     return vm->stack_top[-1 - distance];
 }
 
+/**
+ * Move the value stack to a buffer of new_capacity slots, rebasing every
+ * pointer into it (stack_top, frame slots, open upvalues). A native call in
+ * progress still holds its args pointer into the old buffer, so in that case
+ * the old buffer is retired rather than freed.
+ */
+static bool vm_grow_stack(VM *vm, size_t new_capacity) {
+    TaggedValue *old_stack = vm->stack;
+    TaggedValue *new_stack = stack_alloc(new_capacity);
+    if (!new_stack) {
+        return false;
+    }
+
+    size_t used = (size_t)(vm->stack_top - old_stack);
+    memcpy(new_stack, old_stack, used * sizeof(TaggedValue));
+
+    vm->stack_top = new_stack + used;
+    for (int i = 0; i < vm->frame_count; i++) {
+        vm->frames[i].slots = new_stack + (vm->frames[i].slots - old_stack);
+    }
+    for (Upvalue *upvalue = vm->open_upvalues; upvalue != NULL; upvalue = upvalue->next) {
+        upvalue->location = new_stack + (upvalue->location - old_stack);
+    }
+
+    if (vm->native_depth > 0) {
+        RetiredStack *retired = VM_NEW(RetiredStack);
+        retired->values = old_stack;
+        retired->capacity = vm->stack_capacity;
+        retired->next = vm->retired_stacks;
+        vm->retired_stacks = retired;
+    } else {
+        stack_free(old_stack, vm->stack_capacity);
+    }
+
+    vm->stack = new_stack;
+    vm->stack_capacity = new_capacity;
+    return true;
+}
+
+// Make sure `needed` more values fit above stack_top, growing if allowed
+static bool vm_ensure_stack(VM *vm, size_t needed) {
+    size_t used = (size_t)(vm->stack_top - vm->stack);
+    if (used + needed <= vm->stack_capacity) {
+        return true;
+    }
+    if (used + needed > vm->stack_limit) {
+        return false;
+    }
+
+    size_t capacity = vm->stack_capacity;
+    while (capacity < used + needed) {
+        capacity *= 2;
+    }
+    if (capacity > vm->stack_limit) {
+        capacity = vm->stack_limit;
+    }
+    return vm_grow_stack(vm, capacity);
+}
+
+static bool vm_ensure_frames(VM *vm) {
+    if (vm->frame_count < vm->frame_capacity) {
+        return true;
+    }
+    if (vm->frame_count >= vm->frame_limit) {
+        return false;
+    }
+
+    int capacity = vm->frame_capacity * 2;
+    if (capacity > vm->frame_limit) {
+        capacity = vm->frame_limit;
+    }
+    CallFrame *frames = VM_NEW_ARRAY(CallFrame, capacity);
+    if (!frames) {
+        return false;
+    }
+    memcpy(frames, vm->frames, (size_t)vm->frame_count * sizeof(CallFrame));
+    VM_FREE(vm->frames, (size_t)vm->frame_capacity * sizeof(CallFrame));
+    vm->frames = frames;
+    vm->frame_capacity = capacity;
+    return true;
+}
+
+// The collector lets allocations past the heap limit through and flags
+// them; calls and loop back-edges are where the script is stopped
+static bool vm_heap_exhausted(VM *vm) {
+    if (!vm->gc || !vm->gc->heap_exhausted) {
+        return false;
+    }
+    vm->gc->heap_exhausted = false;
+    vm_runtime_error(vm, "Out of memory: heap limit of %zu bytes exceeded.", vm->gc->config.max_heap_size);
+    return true;
+}
+
+// Stack a frame running `function` needs above the arguments it was given
+static size_t frame_stack_needed(Function *function) {
+    return function->chunk.max_stack + VM_STACK_HEADROOM;
+}
+
 static void call_frame_push(VM *vm, CallFrame *frame) {
     vm->frames[vm->frame_count++] = *frame;
 }
@@ -431,10 +637,13 @@ static InterpretResult call_closure(VM *vm, Closure *closure, int arg_count) {
         return INTERPRET_RUNTIME_ERROR;
     }
 
-    if (vm->frame_count >= FRAMES_MAX) {
+    if (!vm_ensure_frames(vm) || !vm_ensure_stack(vm, frame_stack_needed(closure->function))) {
         vm_runtime_error(vm, "Stack overflow.");
         return INTERPRET_RUNTIME_ERROR;
     }
+    if (vm_heap_exhausted(vm)) {
+        return INTERPRET_RUNTIME_ERROR;
+    }
 
     CallFrame frame = {0};
     frame.closure = closure;
@@ -471,6 +680,7 @@ void define_global(VM *vm, const char *name, TaggedValue value) {
     vm->globals.names[vm->globals.count] = STR_DUP(name);
     vm->globals.values[vm->globals.count] = value;
     vm->globals.count++;
+    vm_invalidate_global_caches(vm);
 }
 
 // Undefine a global variable
@@ -484,119 +694,599 @@ void undefine_global(VM *vm, const char *name) {
                 vm->globals.values[j] = vm->globals.values[j + 1];
             }
             vm->globals.count--;
+            vm_invalidate_global_caches(vm);
             return;
         }
     }
 }
 
+// Slot caches bound under an older epoch fall back to a lookup by name
+void vm_invalidate_global_caches(VM *vm) {
+    if (vm) vm->global_cache_epoch++;
+}
+
+// Append a global to a module's table
+static void module_add_global(VM *vm, Module *module, const char *name, TaggedValue value) {
+    if (module->globals.count + 1 > module->globals.capacity) {
+        size_t old_capacity = module->globals.capacity;
+        size_t new_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
+
+        // Realloc pattern for names
+        char **new_names = VM_ALLOC(new_capacity * sizeof(char*));
+        if (module->globals.names) {
+            memcpy(new_names, module->globals.names, old_capacity * sizeof(char *));
+            MODULE_FREE(module->globals.names, old_capacity * sizeof(char*));
+        }
+        module->globals.names = new_names;
+
+        // Realloc pattern for values
+        TaggedValue *new_values = VM_ALLOC(new_capacity * sizeof(TaggedValue));
+        if (module->globals.values) {
+            memcpy(new_values, module->globals.values, old_capacity * sizeof(TaggedValue));
+            MODULE_FREE(module->globals.values, old_capacity * sizeof(TaggedValue));
+        }
+        module->globals.values = new_values;
+
+        module->globals.capacity = new_capacity;
+    }
+
+    module->globals.names[module->globals.count] = MODULE_DUP(name);
+    module->globals.values[module->globals.count] = value;
+    module->globals.count++;
+    vm_invalidate_global_caches(vm);
+}
+
+// Resolve a global for reading: current module first, then VM globals
+static TaggedValue *vm_find_global(VM *vm, const char *name, bool *module_owned) {
+    if (vm->current_module) {
+        for (size_t i = 0; i < vm->current_module->globals.count; i++) {
+            if (strcmp(vm->current_module->globals.names[i], name) == 0) {
+                *module_owned = true;
+                return &vm->current_module->globals.values[i];
+            }
+        }
+    }
+
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0) {
+            *module_owned = false;
+            return &vm->globals.values[i];
+        }
+    }
+    return NULL;
+}
+
+// Assign a global, creating it if needed. Inside a module this only ever
+// touches the module's own table.
+static TaggedValue *vm_store_global(VM *vm, const char *name, TaggedValue value, bool *module_owned) {
+    Module *module = vm->current_module;
+    size_t count = module ? module->globals.count : vm->globals.count;
+    char **names = module ? module->globals.names : vm->globals.names;
+    *module_owned = module != NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(names[i], name) == 0) {
+            TaggedValue *slot = module ? &module->globals.values[i] : &vm->globals.values[i];
+            *slot = value;
+            return slot;
+        }
+    }
+
+    if (module) {
+        module_add_global(vm, module, name, value);
+        return &module->globals.values[module->globals.count - 1];
+    }
+    define_global(vm, name, value);
+    return &vm->globals.values[vm->globals.count - 1];
+}
+
+// Cache entry for a global slot, growing the chunk's cache on first use
+static GlobalCache *chunk_global_cache(Chunk *chunk, uint16_t slot) {
+    if (slot >= chunk->global_cache_count) {
+        size_t old_count = chunk->global_cache_count;
+        size_t new_count = chunk->constants.count > slot ? chunk->constants.count : (size_t)slot + 1;
+
+        GlobalCache *new_cache = BYTECODE_ALLOC_ZERO(new_count * sizeof(GlobalCache));
+        if (chunk->global_cache) {
+            memcpy(new_cache, chunk->global_cache, old_count * sizeof(GlobalCache));
+            BYTECODE_FREE(chunk->global_cache, old_count * sizeof(GlobalCache));
+        }
+        chunk->global_cache = new_cache;
+        chunk->global_cache_count = new_count;
+    }
+    return &chunk->global_cache[slot];
+}
+
+static inline bool global_cache_valid(const GlobalCache *cache, VM *vm) {
+    return cache->epoch == vm->global_cache_epoch && cache->vm == vm &&
+           cache->module == vm->current_module;
+}
+
+// Inline cache for the instruction at `offset`, created on first use.
+// NULL once the chunk has run out of 16-bit cache indices.
+static InlineCache *chunk_inline_cache(Chunk *chunk, size_t offset) {
+    if (chunk->inline_cache_index_count < chunk->count) {
+        uint16_t *new_index = BYTECODE_ALLOC_ZERO(chunk->count * sizeof(uint16_t));
+        if (chunk->inline_cache_index) {
+            memcpy(new_index, chunk->inline_cache_index, chunk->inline_cache_index_count * sizeof(uint16_t));
+            BYTECODE_FREE(chunk->inline_cache_index, chunk->inline_cache_index_count * sizeof(uint16_t));
+        }
+        chunk->inline_cache_index = new_index;
+        chunk->inline_cache_index_count = chunk->count;
+    }
+
+    uint16_t index = chunk->inline_cache_index[offset];
+    if (index == 0) {
+        if (chunk->inline_cache_count >= UINT16_MAX) {
+            return NULL;
+        }
+        if (chunk->inline_cache_count == chunk->inline_cache_capacity) {
+            size_t old_capacity = chunk->inline_cache_capacity;
+            chunk->inline_cache_capacity = GROW_CAPACITY(old_capacity);
+
+            InlineCache *new_caches = BYTECODE_ALLOC_ZERO(chunk->inline_cache_capacity * sizeof(InlineCache));
+            if (chunk->inline_caches) {
+                memcpy(new_caches, chunk->inline_caches, old_capacity * sizeof(InlineCache));
+                BYTECODE_FREE(chunk->inline_caches, old_capacity * sizeof(InlineCache));
+            }
+            chunk->inline_caches = new_caches;
+        }
+        index = (uint16_t)++chunk->inline_cache_count;
+        chunk->inline_cache_index[offset] = index;
+    }
+    return &chunk->inline_caches[index - 1];
+}
+
+// Property lookup through an inline cache. `receiver` is NULL for strings
+// and numbers, whose lookups start directly at their builtin prototype.
+static TaggedValue *inline_cache_lookup(InlineCache *ic, Object *receiver, Object *proto, const char *name) {
+    if (ic->name != name) {
+        ic->name = name;
+        ic->count = 0;
+        ic->next_victim = 0;
+    }
+
+    // Dictionary-mode receivers have no shape to key on
+    Shape *shape = receiver ? receiver->shape : NULL;
+    bool cacheable = !receiver || shape;
+
+    for (uint8_t i = 0; cacheable && i < ic->count; i++) {
+        InlineCacheEntry *entry = &ic->entries[i];
+        if (entry->shape != shape) {
+            continue;
+        }
+        if (!entry->holder) {
+            ic->hits++;
+            return &receiver->slots[entry->slot];
+        }
+        if (entry->proto == proto && entry->epoch == object_cache_epoch) {
+            ic->hits++;
+            return &entry->holder->slots[entry->slot];
+        }
+    }
+    ic->misses++;
+
+    uint32_t slot = 0;
+    Object *holder = NULL;
+    if (receiver && object_find_slot(receiver, name, &slot)) {
+        holder = receiver;
+    } else {
+        for (Object *o = proto; o; o = o->prototype) {
+            if (object_find_slot(o, name, &slot)) {
+                holder = o;
+                break;
+            }
+        }
+    }
+    if (!holder || !cacheable) {
+        return holder ? &holder->slots[slot] : NULL;
+    }
+
+    InlineCacheEntry *entry = NULL;
+    for (uint8_t i = 0; i < ic->count && !entry; i++) {
+        if (ic->entries[i].holder && ic->entries[i].epoch != object_cache_epoch) {
+            entry = &ic->entries[i];
+        }
+    }
+    if (!entry) {
+        if (ic->count < INLINE_CACHE_WAYS) {
+            entry = &ic->entries[ic->count++];
+        } else {
+            entry = &ic->entries[ic->next_victim];
+            ic->next_victim = (uint8_t)((ic->next_victim + 1) % INLINE_CACHE_WAYS);
+        }
+    }
+    entry->shape = shape;
+    entry->proto = proto;
+    entry->holder = holder == receiver ? NULL : holder;
+    entry->slot = slot;
+    entry->epoch = object_cache_epoch;
+    return &holder->slots[slot];
+}
+
+// Cached lookup for the property instruction at `site` in the running chunk
+static TaggedValue *vm_cached_property(CallFrame *frame, uint8_t *site, Object *receiver,
+                                       Object *proto, const char *name) {
+    Chunk *chunk = &frame->closure->function->chunk;
+    InlineCache *ic = chunk_inline_cache(chunk, (size_t)(site - chunk->code));
+    if (!ic) {
+        return receiver ? object_get_property(receiver, name) : object_get_property(proto, name);
+    }
+    return inline_cache_lookup(ic, receiver, proto, name);
+}
+
+static inline void global_cache_bind(GlobalCache *cache, VM *vm, TaggedValue *value, bool module_owned) {
+    cache->value = value;
+    cache->vm = vm;
+    cache->module = vm->current_module;
+    cache->epoch = vm->global_cache_epoch;
+    cache->module_owned = module_owned;
+}
+
 // New helper function to convert a value to string
 static const char *value_to_string(VM *vm, TaggedValue value);
 
+// Intern the concatenation of two byte runs, built in place. NULL if memory
+// runs out or the result would be too long.
+static char *concat_strings(VM *vm, const char *a, size_t len_a, const char *b, size_t len_b) {
+    char *result = string_alloc(len_a + len_b);
+    if (!result) return NULL;
+    memcpy(result, a, len_a);
+    memcpy(result + len_a, b, len_b);
+    return string_pool_take(&vm->strings, string_seal(result));
+}
+
+// Below this length a copy of the left side costs about what a rope does
+#define ROPE_MIN_LENGTH 256
+
+// Join `count` string values. When the first is long the result is a rope
+// over it, so that `s = s + t` in a loop copies t but not s; the rest are
+// joined flat, in one allocation. NULL if memory runs out.
+static char *concat_values(VM *vm, const TaggedValue *operands, uint8_t count) {
+    StringPool *pool = &vm->strings;
+    const char *first = AS_STRING(operands[0]);
+    size_t first_length = string_length(first);
+    size_t rest_length = 0;
+    for (uint8_t i = 1; i < count; i++) {
+        rest_length += string_length(AS_STRING(operands[i]));
+    }
+
+    bool rope = first_length >= ROPE_MIN_LENGTH && rest_length > 0;
+    char *result = string_alloc(rope ? rest_length : first_length + rest_length);
+    if (!result) return NULL;
+    char *end = result;
+    for (uint8_t i = rope ? 1 : 0; i < count; i++) {
+        const char *part = string_chars(AS_STRING(operands[i]));
+        if (!part) {
+            string_free(result);
+            return NULL;
+        }
+        memcpy(end, part, string_length(part));
+        end += string_length(part);
+    }
+    result = string_pool_take(pool, string_seal(result));
+    if (!rope || !result) return result;
+
+    // A rope's halves must belong to its pool, to be marked through it
+    if (!string_is_owned_by(first, pool->id)) {
+        first = string_pool_intern_string(pool, first);
+        if (!first) return NULL;
+    }
+    return string_pool_rope(pool, first, result);
+}
+
 // Forward declare call_native
 static InterpretResult call_native(VM *vm, NativeFn native, int arg_count);
 
 // Forward declare the unified interpreter
-static InterpretResult vm_run_frame(VM *vm);
+static InterpretResult vm_run_frame(VM *vm, int exit_depth);
 
 // Value equality comparison
 bool values_equal(TaggedValue a, TaggedValue b) {
-    if (a.type != b.type) return false;
+    if (VALUE_TYPE(a) != VALUE_TYPE(b)) return false;
 
-    switch (a.type) {
+    switch (VALUE_TYPE(a)) {
         case VAL_BOOL: return AS_BOOL(a) == AS_BOOL(b);
         case VAL_NIL: return true;
         case VAL_NUMBER: return AS_NUMBER(a) == AS_NUMBER(b);
-        case VAL_STRING: return strcmp(AS_STRING(a), AS_STRING(b)) == 0;
+        case VAL_STRING: {
+            const char *string_a = AS_STRING(a);
+            const char *string_b = AS_STRING(b);
+            if (string_a == string_b) return true;
+            if (string_length(string_a) != string_length(string_b)) return false;
+            string_a = string_chars((char *)string_a);
+            string_b = string_chars((char *)string_b);
+            return string_a && string_b && string_equals(string_a, string_b);
+        }
         case VAL_FUNCTION: return AS_FUNCTION(a) == AS_FUNCTION(b);
         case VAL_NATIVE: return AS_NATIVE(a) == AS_NATIVE(b);
-        case VAL_OBJECT: return a.as.object == b.as.object;
+        case VAL_OBJECT: return AS_OBJECT(a) == AS_OBJECT(b);
         default: return false;
     }
 }
 
-// Unified interpreter loop - runs the current frame until it returns or errors
-static InterpretResult vm_run_frame(VM *vm) {
+bool values_flatten(TaggedValue *values, int count) {
+    for (int i = 0; i < count; i++) {
+        if (IS_STRING(values[i]) && string_is_rope(AS_STRING(values[i]))) {
+            char *chars = string_flatten(AS_STRING(values[i]));
+            if (!chars) return false;
+            values[i] = STRING_VAL(chars);
+        }
+    }
+    return true;
+}
+
+// The characters of a string value, or NULL with an error raised if a rope
+// has to be flattened and memory runs out
+static const char *vm_string_chars(VM *vm, TaggedValue value) {
+    const char *chars = string_chars(AS_STRING(value));
+    if (!chars) {
+        vm_runtime_error(vm, "Out of memory.");
+    }
+    return chars;
+}
+
+// Print the value stack and the instruction at ip (used by --trace)
+static void vm_trace_instruction(VM *vm, CallFrame *frame, uint8_t *ip) {
+    printf("          ");
+    for (TaggedValue* slot = vm->stack; slot < vm->stack_top; slot++)
+    {
+        printf("[ ");
+        print_value(*slot);
+        printf(" ]");
+    }
+    printf("\n");
+    disassemble_instruction(&frame->closure->function->chunk,
+                            (int)(ip - frame->closure->function->chunk.code));
+}
+
+/*
+ * Instruction dispatch.
+ *
+ * With SLANG_COMPUTED_GOTO (GCC/Clang only) every handler ends by jumping
+ * straight to the next handler through a label table, so each opcode gets
+ * its own indirect branch instead of sharing the one at the top of the
+ * switch. The switch is still there: it is the portable fallback, and in
+ * threaded mode a handler that ends with a plain `break` simply re-enters
+ * the loop and is dispatched again from the top.
+ *
+ * Tracing is decided once per call. In threaded mode a second table routes
+ * every opcode through the trace label, so the hot path carries no check.
+ */
+#if defined(SLANG_COMPUTED_GOTO) && (defined(__GNUC__) || defined(__clang__))
+#define VM_THREADED_DISPATCH 1
+#else
+#define VM_THREADED_DISPATCH 0
+#endif
+
+#if VM_THREADED_DISPATCH
+#define VM_CASE(op) case op: L_##op:
+#define VM_NEXT() do { instruction = *ip++; goto *dispatch[instruction]; } while (0)
+
+// Labels-as-values and range initializers are GNU extensions
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#pragma GCC diagnostic ignored "-Woverride-init"
+#else
+#define VM_CASE(op) case op:
+#define VM_NEXT() break
+#endif
+
+// Stack traces read frame->ip, so flush the cached ip before reporting
+#define vm_runtime_error(vm, ...) (frame->ip = ip, vm_runtime_error(vm, __VA_ARGS__))
+// The allocation profiler does too; instructions that allocate flush it first
+#define VM_SYNC_IP() (frame->ip = ip)
+
+// Rewrite the instruction being executed (its opcode byte is ip[-1]),
+// unless an earlier miss already made the site generic for good
+#define QUICKEN(op) (ip[-1] < OP_ADD_GENERIC ? (void)(ip[-1] = (uint8_t)(op)) : (void)0)
+
+/**
+ * Body of a quickened number-only instruction. Both operands are checked
+ * once; on a miss the site is rewritten to its sticky generic opcode and
+ * the instruction is dispatched again, so the generic handler raises any
+ * type error. A plain block rather than do/while, since VM_NEXT() is a
+ * `break` in switch dispatch.
+ */
+#define QUICK_BINARY(generic, value_type, op) \
+    { \
+        TaggedValue b = vm->stack_top[-1]; \
+        TaggedValue a = vm->stack_top[-2]; \
+        if (!IS_NUMBER(a) || !IS_NUMBER(b)) { \
+            QUICKEN(generic); \
+            ip--; \
+            VM_NEXT(); \
+        } \
+        vm->stack_top--; \
+        vm->stack_top[-1] = value_type(AS_NUMBER(a) op AS_NUMBER(b)); \
+    }
+
+// Unified interpreter loop - runs until the frame count drops back to
+// exit_depth (0 for a whole script) or an error occurs
+static InterpretResult vm_run_frame(VM *vm, int exit_depth) {
     CallFrame *frame = &vm->frames[vm->frame_count - 1];
+    // The instruction pointer lives in a local so it can stay in a register;
+    // it is written back to frame->ip whenever another frame may be pushed
+    // or a stack trace may be printed.
+    uint8_t *ip = frame->ip;
+    uint8_t instruction;
+
+#if VM_THREADED_DISPATCH
+    static void *const op_table[256] = {
+        [0 ... 255] = &&L_unknown,
+        [OP_CONSTANT] = &&L_OP_CONSTANT,
+        [OP_TRUE] = &&L_OP_TRUE,
+        [OP_FALSE] = &&L_OP_FALSE,
+        [OP_NIL] = &&L_OP_NIL,
+        [OP_POP] = &&L_OP_POP,
+        [OP_DUP] = &&L_OP_DUP,
+        [OP_SWAP] = &&L_OP_SWAP,
+        [OP_STRING_CONCAT] = &&L_OP_STRING_CONCAT,
+        [OP_STRING_INTERP] = &&L_OP_STRING_INTERP,
+        [OP_INTERN_STRING] = &&L_OP_INTERN_STRING,
+        [OP_CONSTANT_LONG] = &&L_OP_CONSTANT_LONG,
+        [OP_EQUAL] = &&L_OP_EQUAL,
+        [OP_NOT_EQUAL] = &&L_OP_NOT_EQUAL,
+        [OP_GREATER] = &&L_OP_GREATER,
+        [OP_GREATER_EQUAL] = &&L_OP_GREATER_EQUAL,
+        [OP_LESS] = &&L_OP_LESS,
+        [OP_LESS_EQUAL] = &&L_OP_LESS_EQUAL,
+        [OP_ADD] = &&L_OP_ADD,
+        [OP_ADD_CHAIN] = &&L_OP_ADD_CHAIN,
+        [OP_ARRAY_APPEND] = &&L_OP_ARRAY_APPEND,
+        [OP_EXPECT_STRING] = &&L_OP_EXPECT_STRING,
+        [OP_ADD_GENERIC] = &&L_OP_ADD_GENERIC,
+        [OP_SUBTRACT_GENERIC] = &&L_OP_SUBTRACT_GENERIC,
+        [OP_MULTIPLY_GENERIC] = &&L_OP_MULTIPLY_GENERIC,
+        [OP_GREATER_GENERIC] = &&L_OP_GREATER_GENERIC,
+        [OP_GREATER_EQUAL_GENERIC] = &&L_OP_GREATER_EQUAL_GENERIC,
+        [OP_LESS_GENERIC] = &&L_OP_LESS_GENERIC,
+        [OP_LESS_EQUAL_GENERIC] = &&L_OP_LESS_EQUAL_GENERIC,
+        [OP_SUBTRACT] = &&L_OP_SUBTRACT,
+        [OP_MULTIPLY] = &&L_OP_MULTIPLY,
+        [OP_DIVIDE] = &&L_OP_DIVIDE,
+        [OP_MODULO] = &&L_OP_MODULO,
+        [OP_POWER] = &&L_OP_POWER,
+        [OP_NEGATE] = &&L_OP_NEGATE,
+        [OP_NOT] = &&L_OP_NOT,
+        [OP_AND] = &&L_OP_AND,
+        [OP_OR] = &&L_OP_OR,
+        [OP_TO_STRING] = &&L_OP_TO_STRING,
+        [OP_JUMP] = &&L_OP_JUMP,
+        [OP_JUMP_IF_FALSE] = &&L_OP_JUMP_IF_FALSE,
+        [OP_JUMP_IF_TRUE] = &&L_OP_JUMP_IF_TRUE,
+        [OP_LOOP] = &&L_OP_LOOP,
+        [OP_GET_LOCAL] = &&L_OP_GET_LOCAL,
+        [OP_SET_LOCAL] = &&L_OP_SET_LOCAL,
+        [OP_GET_GLOBAL] = &&L_OP_GET_GLOBAL,
+        [OP_SET_GLOBAL] = &&L_OP_SET_GLOBAL,
+        [OP_DEFINE_GLOBAL] = &&L_OP_DEFINE_GLOBAL,
+        [OP_GET_GLOBAL_SLOT] = &&L_OP_GET_GLOBAL_SLOT,
+        [OP_SET_GLOBAL_SLOT] = &&L_OP_SET_GLOBAL_SLOT,
+        [OP_ARRAY] = &&L_OP_ARRAY,
+        [OP_BUILD_ARRAY] = &&L_OP_BUILD_ARRAY,
+        [OP_GET_SUBSCRIPT] = &&L_OP_GET_SUBSCRIPT,
+        [OP_SET_SUBSCRIPT] = &&L_OP_SET_SUBSCRIPT,
+        [OP_LENGTH] = &&L_OP_LENGTH,
+        [OP_METHOD_CALL] = &&L_OP_METHOD_CALL,
+        [OP_CALL] = &&L_OP_CALL,
+        [OP_TAIL_CALL] = &&L_OP_TAIL_CALL,
+        [OP_RETURN] = &&L_OP_RETURN,
+        [OP_CLOSURE] = &&L_OP_CLOSURE,
+        [OP_CLOSURE_LONG] = &&L_OP_CLOSURE_LONG,
+        [OP_GET_UPVALUE] = &&L_OP_GET_UPVALUE,
+        [OP_SET_UPVALUE] = &&L_OP_SET_UPVALUE,
+        [OP_CLOSE_UPVALUE] = &&L_OP_CLOSE_UPVALUE,
+        [OP_CREATE_OBJECT] = &&L_OP_CREATE_OBJECT,
+        [OP_GET_PROPERTY] = &&L_OP_GET_PROPERTY,
+        [OP_SET_PROPERTY] = &&L_OP_SET_PROPERTY,
+        [OP_ADD_NUM] = &&L_OP_ADD_NUM,
+        [OP_SUBTRACT_NUM] = &&L_OP_SUBTRACT_NUM,
+        [OP_MULTIPLY_NUM] = &&L_OP_MULTIPLY_NUM,
+        [OP_GREATER_NUM] = &&L_OP_GREATER_NUM,
+        [OP_GREATER_EQUAL_NUM] = &&L_OP_GREATER_EQUAL_NUM,
+        [OP_LESS_NUM] = &&L_OP_LESS_NUM,
+        [OP_LESS_EQUAL_NUM] = &&L_OP_LESS_EQUAL_NUM,
+        [OP_GET_LOCAL_PAIR] = &&L_OP_GET_LOCAL_PAIR,
+        [OP_GET_LOCAL_CONSTANT] = &&L_OP_GET_LOCAL_CONSTANT,
+        [OP_SET_LOCAL_POP] = &&L_OP_SET_LOCAL_POP,
+        [OP_JUMP_IF_FALSE_POP] = &&L_OP_JUMP_IF_FALSE_POP,
+        [OP_OBJECT_LITERAL] = &&L_OP_OBJECT_LITERAL,
+        [OP_LOAD_MODULE] = &&L_OP_LOAD_MODULE,
+        [OP_IMPORT_FROM] = &&L_OP_IMPORT_FROM,
+        [OP_MODULE_EXPORT] = &&L_OP_MODULE_EXPORT,
+        [OP_GET_OBJECT_PROTO] = &&L_OP_GET_OBJECT_PROTO,
+        [OP_GET_STRUCT_PROTO] = &&L_OP_GET_STRUCT_PROTO,
+    };
+    static void *const trace_table[256] = {
+        [0 ... 255] = &&L_trace,
+    };
+    void *const *dispatch = vm->debug_trace ? trace_table : op_table;
+#else
+    const bool trace = vm->debug_trace;
+#endif
 
     for (;;) {
-        if (vm->debug_trace) {
-            printf("          ");
-            for (TaggedValue* slot = vm->stack; slot < vm->stack_top; slot++)
-            {
-                printf("[ ");
-                print_value(*slot);
-                printf(" ]");
-            }
-            printf("\n");
-            disassemble_instruction(&frame->closure->function->chunk,
-                                    (int)(frame->ip - frame->closure->function->chunk.code));
+#if VM_THREADED_DISPATCH
+        VM_NEXT();
+
+    L_trace:
+        vm_trace_instruction(vm, frame, ip - 1);
+        goto *op_table[instruction];
+#else
+        if (trace) {
+            vm_trace_instruction(vm, frame, ip);
         }
+        instruction = *ip++;
+#endif
 
-        uint8_t instruction = *frame->ip++;
         switch (instruction) {
-            case OP_CONSTANT: {
-                uint8_t index = *frame->ip++;
+            VM_CASE(OP_CONSTANT) {
+                uint8_t index = *ip++;
                 TaggedValue constant = frame->closure->function->chunk.constants.values[index];
                 vm_push(vm, constant);
-                break;
+                VM_NEXT();
             }
 
-            case OP_TRUE:
+            VM_CASE(OP_TRUE)
                 vm_push(vm, BOOL_VAL(true));
-                break;
+                VM_NEXT();
 
-            case OP_FALSE:
+            VM_CASE(OP_FALSE)
                 vm_push(vm, BOOL_VAL(false));
-                break;
+                VM_NEXT();
 
-            case OP_NIL:
+            VM_CASE(OP_NIL)
                 vm_push(vm, NIL_VAL);
-                break;
+                VM_NEXT();
 
-            case OP_POP:
+            VM_CASE(OP_POP)
                 vm_pop(vm);
-                break;
+                VM_NEXT();
 
-            case OP_DUP: {
+            VM_CASE(OP_DUP) {
                 TaggedValue value = vm_peek(vm, 0);
                 vm_push(vm, value);
-                break;
+                VM_NEXT();
             }
 
-            case OP_SWAP: {
+            VM_CASE(OP_SWAP) {
                 TaggedValue a = vm_pop(vm);
                 TaggedValue b = vm_pop(vm);
                 vm_push(vm, a);
                 vm_push(vm, b);
-                break;
+                VM_NEXT();
             }
 
-            case OP_STRING_CONCAT: {
+            VM_CASE(OP_STRING_CONCAT) {
+                VM_SYNC_IP();
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
 
                 // Convert both values to strings using our existing value_to_string helper
-                const char* str_a = IS_STRING(a) ? AS_STRING(a) : value_to_string(vm, a);
-                const char* str_b = IS_STRING(b) ? AS_STRING(b) : value_to_string(vm, b);
-                
-                size_t len_a = strlen(str_a);
-                size_t len_b = strlen(str_b);
-                size_t total_len = len_a + len_b + 1;
-
-                char* buffer = STR_ALLOC(total_len);
-                strcpy(buffer, str_a);
-                strcat(buffer, str_b);
-
-                // Intern the string
-                const char* interned = string_pool_intern(&vm->strings, buffer, strlen(buffer));
-                STR_FREE(buffer, total_len);
-
-                vm_push(vm, STRING_VAL(interned));
-                break;
+                const char* str_a = IS_STRING(a) ? vm_string_chars(vm, a) : value_to_string(vm, a);
+                if (!str_a) return INTERPRET_RUNTIME_ERROR;
+                size_t len_a = IS_STRING(a) ? string_length(str_a) : strlen(str_a);
+                const char* str_b = IS_STRING(b) ? vm_string_chars(vm, b) : value_to_string(vm, b);
+                if (!str_b) return INTERPRET_RUNTIME_ERROR;
+                size_t len_b = IS_STRING(b) ? string_length(str_b) : strlen(str_b);
+
+                char* result = concat_strings(vm, str_a, len_a, str_b, len_b);
+                if (!result) {
+                    vm_runtime_error(vm, "Out of memory.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                vm_push(vm, STRING_VAL(result));
+                VM_NEXT();
             }
 
-            case OP_STRING_INTERP: {
-                uint8_t part_count = *frame->ip++;
+            VM_CASE(OP_STRING_INTERP) {
+                VM_SYNC_IP();
+                uint8_t part_count = *ip++;
+                if (!values_flatten(vm->stack_top - part_count, part_count)) {
+                    vm_runtime_error(vm, "Out of memory.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
                 size_t total_length = 0;
                 size_t* lengths = VM_ALLOC(sizeof(size_t) * part_count);
                 const char** parts = VM_ALLOC(sizeof(char*) * part_count);
@@ -606,17 +1296,21 @@ static InterpretResult vm_run_frame(VM *vm) {
                     TaggedValue val = vm_peek(vm, i);
                     const char* str = value_to_string(vm, val);
                     parts[part_count - 1 - i] = str;
-                    lengths[part_count - 1 - i] = strlen(str);
+                    lengths[part_count - 1 - i] = IS_STRING(val) ? string_length(str) : strlen(str);
                     total_length += lengths[part_count - 1 - i];
                 }
 
-                // Allocate result buffer
-                char* buffer = STR_ALLOC(total_length + 1);
-                char* ptr = buffer;
-
-                // Concatenate all parts
+                // Allocate the result and concatenate all parts into it
+                char* result = string_alloc(total_length);
+                if (!result) {
+                    VM_FREE(lengths, sizeof(size_t) * part_count);
+                    VM_FREE(parts, sizeof(char*) * part_count);
+                    vm_runtime_error(vm, "Out of memory.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                char* ptr = result;
                 for (int i = 0; i < part_count; i++) {
-                    strcpy(ptr, parts[i]);
+                    memcpy(ptr, parts[i], lengths[i]);
                     ptr += lengths[i];
                 }
 
@@ -626,150 +1320,223 @@ static InterpretResult vm_run_frame(VM *vm) {
                 }
 
                 // Intern and push result
-                const char* interned = string_pool_intern(&vm->strings, buffer, strlen(buffer));
-                STR_FREE(buffer, total_length + 1);
+                char* interned = string_pool_take(&vm->strings, string_seal(result));
                 VM_FREE(lengths, sizeof(size_t) * part_count);
                 VM_FREE(parts, sizeof(char*) * part_count);
+                if (!interned) {
+                    vm_runtime_error(vm, "Out of memory.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
 
                 vm_push(vm, STRING_VAL(interned));
-                break;
+                VM_NEXT();
             }
 
-            case OP_INTERN_STRING: {
+            VM_CASE(OP_INTERN_STRING) {
                 TaggedValue string_val = vm_pop(vm);
                 if (IS_STRING(string_val)) {
-                    const char* str = AS_STRING(string_val);
-                    const char* interned = string_pool_intern(&vm->strings, str, strlen(str));
+                    char* interned = string_pool_intern_string(&vm->strings, AS_STRING(string_val));
+                    if (!interned) {
+                        vm_runtime_error(vm, "Out of memory.");
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
                     vm_push(vm, STRING_VAL(interned));
                 } else {
                     vm_runtime_error(vm, "Can only intern strings");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_CONSTANT_LONG: {
-                uint16_t index = (uint16_t) (*frame->ip++) << 8;
-                index |= *frame->ip++;
+            VM_CASE(OP_CONSTANT_LONG) {
+                uint16_t index = (uint16_t) (*ip++) << 8;
+                index |= *ip++;
                 TaggedValue constant = frame->closure->function->chunk.constants.values[index];
                 vm_push(vm, constant);
-                break;
+                VM_NEXT();
             }
 
-            case OP_EQUAL: {
+            VM_CASE(OP_EQUAL) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 vm_push(vm, BOOL_VAL(values_equal(a, b)));
-                break;
+                VM_NEXT();
             }
 
-            case OP_NOT_EQUAL: {
+            VM_CASE(OP_NOT_EQUAL) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 vm_push(vm, BOOL_VAL(!values_equal(a, b)));
-                break;
+                VM_NEXT();
             }
 
-            case OP_GREATER: {
+            VM_CASE(OP_GREATER_GENERIC)
+            VM_CASE(OP_GREATER) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_GREATER_NUM);
                     vm_push(vm, BOOL_VAL(AS_NUMBER(a) > AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_GREATER_EQUAL: {
+            VM_CASE(OP_GREATER_EQUAL_GENERIC)
+            VM_CASE(OP_GREATER_EQUAL) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_GREATER_EQUAL_NUM);
                     vm_push(vm, BOOL_VAL(AS_NUMBER(a) >= AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_LESS: {
+            VM_CASE(OP_LESS_GENERIC)
+            VM_CASE(OP_LESS) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_LESS_NUM);
                     vm_push(vm, BOOL_VAL(AS_NUMBER(a) < AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_LESS_EQUAL: {
+            VM_CASE(OP_LESS_EQUAL_GENERIC)
+            VM_CASE(OP_LESS_EQUAL) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_LESS_EQUAL_NUM);
                     vm_push(vm, BOOL_VAL(AS_NUMBER(a) <= AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_ADD: {
+            VM_CASE(OP_ADD_GENERIC)
+            VM_CASE(OP_ADD) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_ADD_NUM);
                     vm_push(vm, NUMBER_VAL(AS_NUMBER(a) + AS_NUMBER(b)));
                 } else if (IS_STRING(a) && IS_STRING(b)) {
-                    const char *str_a = AS_STRING(a);
-                    const char *str_b = AS_STRING(b);
-                    size_t len_a = strlen(str_a);
-                    size_t len_b = strlen(str_b);
-                    size_t total_len = len_a + len_b + 1;
-
-                    char *buffer = STR_ALLOC(total_len);
-                    strcpy(buffer, str_a);
-                    strcat(buffer, str_b);
+                    VM_SYNC_IP();
+                    TaggedValue operands[2] = {a, b};
+                    char *result = concat_values(vm, operands, 2);
+                    if (!result) {
+                        vm_runtime_error(vm, "Out of memory.");
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    vm_push(vm, STRING_VAL(result));
+                } else {
+                    vm_runtime_error(vm, "Operands must be two numbers or two strings.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                VM_NEXT();
+            }
 
-                    const char *interned = string_pool_intern(&vm->strings, buffer, strlen(buffer));
-                    STR_FREE(buffer, total_len);
+            VM_CASE(OP_ADD_CHAIN) {
+                VM_SYNC_IP();
+                uint8_t count = *ip++;
+                TaggedValue *operands = vm->stack_top - count;
+                // OP_EXPECT_STRING saw to it that these are all strings: one
+                // allocation for the whole chain, no intermediates
+                char *result = concat_values(vm, operands, count);
+                if (!result) {
+                    vm_runtime_error(vm, "Out of memory.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                operands[0] = STRING_VAL(result);
+                vm->stack_top = operands + 1;
+                VM_NEXT();
+            }
 
-                    vm_push(vm, STRING_VAL(interned));
-                } else {
+            VM_CASE(OP_EXPECT_STRING) {
+                if (!IS_STRING(vm_peek(vm, 0))) {
                     vm_runtime_error(vm, "Operands must be two numbers or two strings.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_SUBTRACT: {
+            VM_CASE(OP_SUBTRACT_GENERIC)
+            VM_CASE(OP_SUBTRACT) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_SUBTRACT_NUM);
                     vm_push(vm, NUMBER_VAL(AS_NUMBER(a) - AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_MULTIPLY: {
+            VM_CASE(OP_MULTIPLY_GENERIC)
+            VM_CASE(OP_MULTIPLY) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
+                    QUICKEN(OP_MULTIPLY_NUM);
                     vm_push(vm, NUMBER_VAL(AS_NUMBER(a) * AS_NUMBER(b)));
                 } else {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_ADD_NUM) {
+                QUICK_BINARY(OP_ADD_GENERIC, NUMBER_VAL, +)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_SUBTRACT_NUM) {
+                QUICK_BINARY(OP_SUBTRACT_GENERIC, NUMBER_VAL, -)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_MULTIPLY_NUM) {
+                QUICK_BINARY(OP_MULTIPLY_GENERIC, NUMBER_VAL, *)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_GREATER_NUM) {
+                QUICK_BINARY(OP_GREATER_GENERIC, BOOL_VAL, >)
+                VM_NEXT();
             }
 
-            case OP_DIVIDE: {
+            VM_CASE(OP_GREATER_EQUAL_NUM) {
+                QUICK_BINARY(OP_GREATER_EQUAL_GENERIC, BOOL_VAL, >=)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_LESS_NUM) {
+                QUICK_BINARY(OP_LESS_GENERIC, BOOL_VAL, <)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_LESS_EQUAL_NUM) {
+                QUICK_BINARY(OP_LESS_EQUAL_GENERIC, BOOL_VAL, <=)
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_DIVIDE) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
@@ -782,10 +1549,10 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "Operands must be numbers.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_MODULO: {
+            VM_CASE(OP_MODULO) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
@@ -795,40 +1562,40 @@ static InterpretResult vm_run_frame(VM *vm) {
                         return INTERPRET_RUNTIME_ERROR;
                     }
                     vm_push(vm, NUMBER_VAL(fmod(AS_NUMBER(a), divisor)));
-                    break;
+                    VM_NEXT();
                 }
                 vm_runtime_error(vm, "Operands must be numbers.");
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            case OP_POWER: {
+            VM_CASE(OP_POWER) {
                 TaggedValue b = vm_pop(vm);
                 TaggedValue a = vm_pop(vm);
                 if (IS_NUMBER(a) && IS_NUMBER(b)) {
                     vm_push(vm, NUMBER_VAL(pow(AS_NUMBER(a), AS_NUMBER(b))));
-                    break;
+                    VM_NEXT();
                 }
                 vm_runtime_error(vm, "Operands must be numbers.");
                 return INTERPRET_RUNTIME_ERROR;
             }
 
-            case OP_NEGATE: {
+            VM_CASE(OP_NEGATE) {
                 if (!IS_NUMBER(vm_peek(vm, 0))) {
                     vm_runtime_error(vm, "Operand must be a number.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 TaggedValue value = vm_pop(vm);
                 vm_push(vm, NUMBER_VAL(-AS_NUMBER(value)));
-                break;
+                VM_NEXT();
             }
 
-            case OP_NOT: {
+            VM_CASE(OP_NOT) {
                 TaggedValue value = vm_pop(vm);
                 vm_push(vm, BOOL_VAL(is_falsey(value)));
-                break;
+                VM_NEXT();
             }
 
-            case OP_AND: {
+            VM_CASE(OP_AND) {
                 TaggedValue right = vm_pop(vm);
                 TaggedValue left = vm_pop(vm);
 
@@ -838,10 +1605,10 @@ static InterpretResult vm_run_frame(VM *vm) {
                 } else {
                     vm_push(vm, right);
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_OR: {
+            VM_CASE(OP_OR) {
                 TaggedValue right = vm_pop(vm);
                 TaggedValue left = vm_pop(vm);
 
@@ -851,263 +1618,267 @@ static InterpretResult vm_run_frame(VM *vm) {
                 } else {
                     vm_push(vm, right);
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_TO_STRING: {
+            VM_CASE(OP_TO_STRING) {
+                VM_SYNC_IP();
                 TaggedValue val = vm_pop(vm);
+                if (IS_STRING(val)) {
+                    vm_push(vm, val);
+                    VM_NEXT();
+                }
+                
+                // Interned, so that interpolation garbage is collected
+                char buffer[1024];
+                const char *text = buffer;
                 if (IS_NIL(val)) {
-                    vm_push(vm, STRING_VAL(STR_DUP("nil")));
+                    text = "nil";
                 } else if (IS_BOOL(val)) {
-                    vm_push(vm, STRING_VAL(STR_DUP(AS_BOOL(val) ? "true" : "false")));
+                    text = AS_BOOL(val) ? "true" : "false";
                 } else if (IS_NUMBER(val)) {
-                    char buffer[32];
                     double num = AS_NUMBER(val);
                     if (num == (int64_t) num) {
                         snprintf(buffer, sizeof(buffer), "%ld", (long) num);
                     } else {
                         snprintf(buffer, sizeof(buffer), "%.6g", num);
                     }
-                    vm_push(vm, STRING_VAL(STR_DUP(buffer)));
-                } else if (IS_STRING(val)) {
-                    vm_push(vm, val);
                 } else if (IS_NATIVE(val)) {
-                    vm_push(vm, STRING_VAL(STR_DUP("<native function>")));
+                    text = "<native function>";
                 } else if (IS_OBJECT(val)) {
                     Object *obj = AS_OBJECT(val);
                     Object *proto = object_get_prototype(obj);
-                    if (proto != NULL) {
-                        TaggedValue *name_val_ptr = object_get_property(proto, "__name__");
-                        if (name_val_ptr != NULL && IS_STRING(*name_val_ptr)) {
-                            size_t result_size = 1024;
-                            char *result = STR_ALLOC(result_size); // Initial buffer
-                            snprintf(result, result_size, "<%s instance>", AS_STRING(*name_val_ptr));
-                            const char *interned = string_pool_intern(&vm->strings, result, strlen(result));
-                            STR_FREE(result, result_size);
-                            vm_push(vm, STRING_VAL(interned));
-                            break;
-                        }
+                    TaggedValue *name_val_ptr = proto ? object_get_property(proto, "__name__") : NULL;
+                    if (name_val_ptr == NULL || !IS_STRING(*name_val_ptr)) {
+                        // Check for __struct_type__ property
+                        name_val_ptr = object_get_property(obj, "__struct_type__");
                     }
-
-                    // Check for __struct_type__ property
-                    TaggedValue *type_val_ptr = object_get_property(obj, "__struct_type__");
-                    if (type_val_ptr != NULL && IS_STRING(*type_val_ptr)) {
-                        char buffer[256];
-                        snprintf(buffer, sizeof(buffer), "<%s instance>", AS_STRING(*type_val_ptr));
-                        vm_push(vm, STRING_VAL(STR_DUP(buffer)));
+                    if (name_val_ptr != NULL && IS_STRING(*name_val_ptr)) {
+                        snprintf(buffer, sizeof(buffer), "<%s instance>", AS_STRING(*name_val_ptr));
                     } else {
-                        vm_push(vm, STRING_VAL(STR_DUP("<object>")));
+                        text = "<object>";
                     }
                 } else {
-                    vm_push(vm, STRING_VAL(STR_DUP("<unknown>")));
+                    text = "<unknown>";
                 }
-                break;
+                vm_push(vm, STRING_VAL(string_pool_intern(&vm->strings, text, strlen(text))));
+                VM_NEXT();
             }
 
             // OP_PRINT removed - handled by native print function
 
             // OP_PRINT_EXPR and OP_DEBUG not needed - removed from design
 
-            case OP_JUMP: {
-                uint16_t offset = (uint16_t) (*frame->ip++) << 8;
-                offset |= *frame->ip++;
-                frame->ip += offset;
-                break;
+            VM_CASE(OP_JUMP) {
+                uint16_t offset = (uint16_t) (*ip++) << 8;
+                offset |= *ip++;
+                ip += offset;
+                VM_NEXT();
             }
 
-            case OP_JUMP_IF_FALSE: {
-                uint16_t offset = (uint16_t) (*frame->ip++) << 8;
-                offset |= *frame->ip++;
+            VM_CASE(OP_JUMP_IF_FALSE) {
+                uint16_t offset = (uint16_t) (*ip++) << 8;
+                offset |= *ip++;
                 if (is_falsey(vm_peek(vm, 0))) {
-                    frame->ip += offset;
+                    ip += offset;
                 }
-                break;
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_JUMP_IF_FALSE_POP) {
+                // JUMP_IF_FALSE off; POP - the false branch skips the POP
+                // at the jump target, since the condition is already gone
+                uint16_t offset = (uint16_t) (ip[0] << 8) | ip[1];
+                if (is_falsey(vm_pop(vm))) {
+                    ip += 2 + offset + 1;
+                } else {
+                    ip += 3;
+                }
+                VM_NEXT();
             }
 
-            case OP_JUMP_IF_TRUE: {
-                uint16_t offset = (uint16_t) (*frame->ip++) << 8;
-                offset |= *frame->ip++;
+            VM_CASE(OP_JUMP_IF_TRUE) {
+                uint16_t offset = (uint16_t) (*ip++) << 8;
+                offset |= *ip++;
                 if (!is_falsey(vm_peek(vm, 0))) {
-                    frame->ip += offset;
+                    ip += offset;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_LOOP: {
-                uint16_t offset = (uint16_t) (*frame->ip++) << 8;
-                offset |= *frame->ip++;
-                frame->ip -= offset;
-                break;
+            VM_CASE(OP_LOOP) {
+                uint16_t offset = (uint16_t) (*ip++) << 8;
+                offset |= *ip++;
+                if (vm->gc) {
+                    // A loop that only builds strings never reaches
+                    // gc_alloc(), so back edges collect on their behalf
+                    if (vm->strings.bytes > vm->gc->next_string_threshold) {
+                        frame->ip = ip;
+                        gc_collect_strings(vm->gc);
+                    }
+                    if (vm->gc->heap_exhausted) {
+                        frame->ip = ip;
+                        vm_heap_exhausted(vm);
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                }
+                ip -= offset;
+                VM_NEXT();
             }
 
-            case OP_GET_LOCAL: {
-                uint8_t slot = *frame->ip++;
+            VM_CASE(OP_GET_LOCAL) {
+                uint8_t slot = *ip++;
                 vm_push(vm, frame->slots[slot]);
-                break;
+                VM_NEXT();
             }
 
-            case OP_SET_LOCAL: {
-                uint8_t slot = *frame->ip++;
+            VM_CASE(OP_SET_LOCAL) {
+                uint8_t slot = *ip++;
                 frame->slots[slot] = vm_peek(vm, 0);
-                break;
+                VM_NEXT();
             }
 
-            case OP_GET_GLOBAL: {
-                uint8_t name_index = *frame->ip++;
-                const char *name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
+            VM_CASE(OP_GET_LOCAL_PAIR) {
+                // GET_LOCAL a; GET_LOCAL b
+                vm_push(vm, frame->slots[ip[0]]);
+                vm_push(vm, frame->slots[ip[2]]);
+                ip += 3;
+                VM_NEXT();
+            }
 
-                // Look in current module first
-                if (vm->current_module) {
-                    for (size_t i = 0; i < vm->current_module->globals.count; i++) {
-                        if (strcmp(vm->current_module->globals.names[i], name) == 0) {
-                            vm_push(vm, vm->current_module->globals.values[i]);
-                            goto found_global;
-                        }
-                    }
-                }
+            VM_CASE(OP_GET_LOCAL_CONSTANT) {
+                // GET_LOCAL a; CONSTANT k
+                vm_push(vm, frame->slots[ip[0]]);
+                vm_push(vm, frame->closure->function->chunk.constants.values[ip[2]]);
+                ip += 3;
+                VM_NEXT();
+            }
 
-                // Then look in VM globals
-                for (size_t i = 0; i < vm->globals.count; i++) {
-                    if (strcmp(vm->globals.names[i], name) == 0) {
-                        vm_push(vm, vm->globals.values[i]);
-                        goto found_global;
-                    }
-                }
+            VM_CASE(OP_SET_LOCAL_POP) {
+                // SET_LOCAL a; POP
+                frame->slots[ip[0]] = vm_pop(vm);
+                ip += 2;
+                VM_NEXT();
+            }
 
-                vm_runtime_error(vm, "Undefined global variable '%s'.", name);
-                return INTERPRET_RUNTIME_ERROR;
+            VM_CASE(OP_GET_GLOBAL) {
+                uint16_t name_index = (uint16_t) (*ip++) << 8;
+                name_index |= *ip++;
+                const char *name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
+                bool module_owned;
+                TaggedValue *value = vm_find_global(vm, name, &module_owned);
 
-            found_global:
-                break;
+                if (!value) {
+                    vm_runtime_error(vm, "Undefined global variable '%s'.", name);
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                vm_push(vm, *value);
+                VM_NEXT();
             }
 
-            case OP_SET_GLOBAL: {
-                uint8_t name_index = *frame->ip++;
+            VM_CASE(OP_SET_GLOBAL) {
+                uint16_t name_index = (uint16_t) (*ip++) << 8;
+                name_index |= *ip++;
                 const char *name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
-                TaggedValue value = vm_peek(vm, 0);
+                bool module_owned;
+                vm_store_global(vm, name, vm_peek(vm, 0), &module_owned);
+                VM_NEXT();
+            }
 
-                // Check if we're setting a module-level global
-                if (vm->current_module) {
-                    // Check if it already exists in module
-                    for (size_t i = 0; i < vm->current_module->globals.count; i++) {
-                        if (strcmp(vm->current_module->globals.names[i], name) == 0) {
-                            vm->current_module->globals.values[i] = value;
-                            goto global_set;
-                        }
+            VM_CASE(OP_GET_GLOBAL_SLOT) {
+                uint16_t slot = (uint16_t) (*ip++) << 8;
+                slot |= *ip++;
+                Chunk *chunk = &frame->closure->function->chunk;
+                GlobalCache *cache = chunk_global_cache(chunk, slot);
+
+                if (!global_cache_valid(cache, vm)) {
+                    // Late binding: resolve by name once, then reuse the slot
+                    const char *name = AS_STRING(chunk->constants.values[slot]);
+                    bool module_owned;
+                    TaggedValue *value = vm_find_global(vm, name, &module_owned);
+                    if (!value) {
+                        vm_runtime_error(vm, "Undefined global variable '%s'.", name);
+                        return INTERPRET_RUNTIME_ERROR;
                     }
+                    global_cache_bind(cache, vm, value, module_owned);
+                }
+                vm_push(vm, *cache->value);
+                VM_NEXT();
+            }
 
-                    // Add to module globals
-                    if (vm->current_module->globals.count + 1 > vm->current_module->globals.capacity) {
-                        size_t old_capacity = vm->current_module->globals.capacity;
-                        size_t new_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
-
-                        // Realloc pattern for names
-                        char **new_names = VM_ALLOC(new_capacity * sizeof(char*));
-                        if (vm->current_module->globals.names) {
-                            memcpy(new_names, vm->current_module->globals.names, old_capacity * sizeof(char *));
-                            MODULE_FREE(vm->current_module->globals.names, old_capacity * sizeof(char*));
-                        }
-                        vm->current_module->globals.names = new_names;
-
-                        // Realloc pattern for values
-                        TaggedValue *new_values = VM_ALLOC(new_capacity * sizeof(TaggedValue));
-                        if (vm->current_module->globals.values) {
-                            memcpy(new_values, vm->current_module->globals.values, old_capacity * sizeof(TaggedValue));
-                            MODULE_FREE(vm->current_module->globals.values, old_capacity * sizeof(TaggedValue));
-                        }
-                        vm->current_module->globals.values = new_values;
+            VM_CASE(OP_SET_GLOBAL_SLOT) {
+                uint16_t slot = (uint16_t) (*ip++) << 8;
+                slot |= *ip++;
+                Chunk *chunk = &frame->closure->function->chunk;
+                GlobalCache *cache = chunk_global_cache(chunk, slot);
 
-                        vm->current_module->globals.capacity = new_capacity;
-                    }
-
-                    vm->current_module->globals.names[vm->current_module->globals.count] = MODULE_DUP(name);
-                    vm->current_module->globals.values[vm->current_module->globals.count] = value;
-                    vm->current_module->globals.count++;
+                // A read may have bound a VM global that a module-context
+                // write must shadow instead, so only trust writable bindings
+                if (global_cache_valid(cache, vm) && (cache->module_owned || !cache->module)) {
+                    *cache->value = vm_peek(vm, 0);
                 } else {
-                    // Setting global in VM
-                    for (size_t i = 0; i < vm->globals.count; i++) {
-                        if (strcmp(vm->globals.names[i], name) == 0) {
-                            vm->globals.values[i] = value;
-                            goto global_set;
-                        }
-                    }
-
-                    // Not found - define new global
-                    define_global(vm, name, value);
+                    const char *name = AS_STRING(chunk->constants.values[slot]);
+                    bool module_owned;
+                    TaggedValue *value = vm_store_global(vm, name, vm_peek(vm, 0), &module_owned);
+                    global_cache_bind(cache, vm, value, module_owned);
                 }
-
-            global_set:
-                break;
+                VM_NEXT();
             }
 
-            case OP_DEFINE_GLOBAL: {
-                uint8_t name_index = *frame->ip++;
+            VM_CASE(OP_DEFINE_GLOBAL) {
+                uint16_t name_index = (uint16_t) (*ip++) << 8;
+                name_index |= *ip++;
                 const char *name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
                 TaggedValue value = vm_pop(vm);
 
                 if (vm->current_module) {
                     // Module-level global
-                    if (vm->current_module->globals.count + 1 > vm->current_module->globals.capacity) {
-                        size_t old_capacity = vm->current_module->globals.capacity;
-                        size_t new_capacity = old_capacity < 8 ? 8 : old_capacity * 2;
-
-                        // Realloc pattern for names
-                        char **new_names = VM_ALLOC(new_capacity * sizeof(char*));
-                        if (vm->current_module->globals.names) {
-                            memcpy(new_names, vm->current_module->globals.names, old_capacity * sizeof(char *));
-                            MODULE_FREE(vm->current_module->globals.names, old_capacity * sizeof(char*));
-                        }
-                        vm->current_module->globals.names = new_names;
-
-                        // Realloc pattern for values
-                        TaggedValue *new_values = VM_ALLOC(new_capacity * sizeof(TaggedValue));
-                        if (vm->current_module->globals.values) {
-                            memcpy(new_values, vm->current_module->globals.values, old_capacity * sizeof(TaggedValue));
-                            MODULE_FREE(vm->current_module->globals.values, old_capacity * sizeof(TaggedValue));
-                        }
-                        vm->current_module->globals.values = new_values;
-
-                        vm->current_module->globals.capacity = new_capacity;
-                    }
-
-                    vm->current_module->globals.names[vm->current_module->globals.count] = MODULE_DUP(name);
-                    vm->current_module->globals.values[vm->current_module->globals.count] = value;
-                    vm->current_module->globals.count++;
+                    module_add_global(vm, vm->current_module, name, value);
                 } else {
                     // VM-level global
                     define_global(vm, name, value);
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_ARRAY:
-            case OP_BUILD_ARRAY: {
-                uint8_t count = *frame->ip++;
-                Object *array = array_create();  // Use array_create to get proper prototype
+            VM_CASE(OP_ARRAY)
+            VM_CASE(OP_BUILD_ARRAY) {
+                VM_SYNC_IP();
+                uint8_t count = *ip++;
+                Object *array = array_create_with_capacity(count);  // Gets the array prototype
 
-                // Pop values in reverse order and set as indexed properties
-                for (int i = count - 1; i >= 0; i--) {
-                    TaggedValue value = vm_pop(vm);
-                    char index_str[32];
-                    snprintf(index_str, sizeof(index_str), "%d", i);
-                    object_set_property(array, index_str, value);
+                // Elements are on the stack in order
+                for (int i = 0; i < count; i++) {
+                    array_push(array, vm->stack_top[i - count]);
                 }
-                
-                // Update length after adding elements
-                object_set_property(array, "length", NUMBER_VAL((double)count));
+                vm->stack_top -= count;
 
                 vm_push(vm, OBJECT_VAL(array));
-                break;
+                VM_NEXT();
             }
 
-            case OP_GET_SUBSCRIPT: {
+            VM_CASE(OP_ARRAY_APPEND) {
+                VM_SYNC_IP();
+                uint8_t count = *ip++;
+                Object *array = AS_OBJECT(vm->stack_top[-count - 1]);
+                for (int i = 0; i < count; i++) {
+                    array_push(array, vm->stack_top[i - count]);
+                }
+                vm->stack_top -= count;
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_GET_SUBSCRIPT) {
                 TaggedValue index = vm_pop(vm);
                 TaggedValue collection = vm_pop(vm);
 
                 if (IS_OBJECT(collection)) {
                     Object *obj = AS_OBJECT(collection);
                     
-                    if (IS_NUMBER(index)) {
+                    if (IS_NUMBER(index) && obj->is_array) {
+                        double i = AS_NUMBER(index);
+                        vm_push(vm, i >= 0 ? array_get(obj, (size_t)i) : NIL_VAL);
+                    } else if (IS_NUMBER(index)) {
                         // Array-like access using numeric index
                         char index_str[32];
                         snprintf(index_str, sizeof(index_str), "%d", (int)AS_NUMBER(index));
@@ -1115,7 +1886,8 @@ static InterpretResult vm_run_frame(VM *vm) {
                         vm_push(vm, value_ptr ? *value_ptr : NIL_VAL);
                     } else if (IS_STRING(index)) {
                         // Object property access
-                        const char *property_name = AS_STRING(index);
+                        const char *property_name = vm_string_chars(vm, index);
+                        if (!property_name) return INTERPRET_RUNTIME_ERROR;
                         TaggedValue *value_ptr = object_get_property(obj, property_name);
                         vm_push(vm, value_ptr ? *value_ptr : NIL_VAL);
                     } else {
@@ -1128,26 +1900,29 @@ static InterpretResult vm_run_frame(VM *vm) {
                         return INTERPRET_RUNTIME_ERROR;
                     }
 
-                    const char *str = AS_STRING(collection);
+                    const char *str = vm_string_chars(vm, collection);
+                    if (!str) return INTERPRET_RUNTIME_ERROR;
                     int i = (int) AS_NUMBER(index);
-                    size_t len = strlen(str);
+                    size_t len = string_length(str);
 
                     if (i < 0 || i >= (int) len) {
                         vm_runtime_error(vm, "String index %d out of bounds (length: %zu).", i, len);
                         return INTERPRET_RUNTIME_ERROR;
                     }
 
+                    VM_SYNC_IP();
                     char char_str[2] = {str[i], '\0'};
-                    const char *interned = string_pool_intern(&vm->strings, char_str, 2);
+                    char *interned = string_pool_intern(&vm->strings, char_str, 1);
                     vm_push(vm, STRING_VAL(interned));
                 } else {
                     vm_runtime_error(vm, "Cannot index into non-collection type.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_SET_SUBSCRIPT: {
+            VM_CASE(OP_SET_SUBSCRIPT) {
+                VM_SYNC_IP();
                 TaggedValue value = vm_pop(vm);
                 TaggedValue index = vm_pop(vm);
                 TaggedValue collection = vm_pop(vm);
@@ -1155,12 +1930,20 @@ static InterpretResult vm_run_frame(VM *vm) {
                 if (IS_OBJECT(collection)) {
                     Object *obj = AS_OBJECT(collection);
                     
-                    if (IS_NUMBER(index)) {
+                    if (IS_NUMBER(index) && obj->is_array) {
+                        double i = AS_NUMBER(index);
+                        if (i < 0) {
+                            vm_runtime_error(vm, "Array index %d out of bounds.", (int)i);
+                            return INTERPRET_RUNTIME_ERROR;
+                        }
+                        array_set(obj, (size_t)i, value);
+                        vm_push(vm, value);
+                    } else if (IS_NUMBER(index)) {
                         // Array-like access using numeric index
                         char index_str[32];
                         int idx = (int)AS_NUMBER(index);
                         snprintf(index_str, sizeof(index_str), "%d", idx);
-                        object_set_property(obj, index_str, value);
+                        object_set_keyed_property(obj, index_str, value);
                         
                         // Update length if necessary
                         TaggedValue *length_ptr = object_get_property(obj, "length");
@@ -1174,8 +1957,9 @@ static InterpretResult vm_run_frame(VM *vm) {
                         vm_push(vm, value);
                     } else if (IS_STRING(index)) {
                         // Object property access
-                        const char *property_name = AS_STRING(index);
-                        object_set_property(obj, property_name, value);
+                        const char *property_name = vm_string_chars(vm, index);
+                        if (!property_name) return INTERPRET_RUNTIME_ERROR;
+                        object_set_keyed_property(obj, property_name, value);
                         vm_push(vm, value);
                     } else {
                         vm_runtime_error(vm, "Index must be number or string.");
@@ -1185,15 +1969,17 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "Cannot set element on non-object type.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_LENGTH: {
+            VM_CASE(OP_LENGTH) {
                 TaggedValue value = vm_pop(vm);
                 if (IS_STRING(value)) {
-                    vm_push(vm, NUMBER_VAL((double)strlen(AS_STRING(value))));
+                    vm_push(vm, NUMBER_VAL((double)string_length(AS_STRING(value))));
+                } else if (IS_OBJECT(value) && AS_OBJECT(value)->is_array) {
+                    vm_push(vm, NUMBER_VAL((double)array_length(AS_OBJECT(value))));
                 } else if (IS_OBJECT(value)) {
-                    // Check for length property (arrays store their length as a property)
+                    // Check for length property
                     Object* obj = AS_OBJECT(value);
                     TaggedValue* len_ptr = object_get_property(obj, "length");
                     if (len_ptr != NULL) {
@@ -1206,102 +1992,164 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "Cannot get length of non-collection type.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
             // OP_ARRAY_PUSH removed - handled as a method on array prototype
 
-            case OP_METHOD_CALL: {
-                uint8_t arg_count = *frame->ip++;
-                uint8_t method_name_index = *frame->ip++;
+            VM_CASE(OP_METHOD_CALL) {
+                uint8_t *site = ip - 1;
+                uint8_t arg_count = *ip++;
+                uint16_t method_name_index = (uint16_t) (*ip++) << 8;
+                method_name_index |= *ip++;
                 const char* method_name = AS_STRING(frame->closure->function->chunk.constants.values[method_name_index]);
                 
                 // Get the receiver object (it's at position arg_count from top)
                 TaggedValue receiver = vm_peek(vm, arg_count);
                 
                 // Look up the method on the object or its prototype chain
-                TaggedValue method = NIL_VAL;
+                TaggedValue* method_ptr = NULL;
                 
                 if (IS_OBJECT(receiver)) {
                     Object* obj = AS_OBJECT(receiver);
-                    TaggedValue* method_ptr = object_get_property(obj, method_name);
-                    if (method_ptr) {
-                        method = *method_ptr;
-                    }
+                    method_ptr = vm_cached_property(frame, site, obj, obj->prototype, method_name);
                 } else if (IS_STRING(receiver)) {
                     // String methods from string prototype
                     Object* string_proto = get_string_prototype();
                     if (string_proto) {
-                        TaggedValue* method_ptr = object_get_property(string_proto, method_name);
-                        if (method_ptr) {
-                            method = *method_ptr;
-                        }
+                        method_ptr = vm_cached_property(frame, site, NULL, string_proto, method_name);
                     }
                 } else if (IS_NUMBER(receiver)) {
                     // Number methods from number prototype
                     Object* number_proto = get_number_prototype();
                     if (number_proto) {
-                        TaggedValue* method_ptr = object_get_property(number_proto, method_name);
-                        if (method_ptr) {
-                            method = *method_ptr;
-                        }
+                        method_ptr = vm_cached_property(frame, site, NULL, number_proto, method_name);
                     }
                 }
                 
+                TaggedValue method = method_ptr ? *method_ptr : NIL_VAL;
                 if (IS_NIL(method)) {
                     vm_runtime_error(vm, "Undefined method '%s'.", method_name);
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 
-                // Replace receiver with method on stack
-                vm->stack_top[-arg_count - 1] = method;
+                // Slide receiver and arguments up so the method sits below
+                // them; the receiver is passed as the first argument
+                TaggedValue *base = vm->stack_top - arg_count - 1;
+                vm_push(vm, NIL_VAL);
+                memmove(base + 1, base, (size_t)(arg_count + 1) * sizeof(TaggedValue));
+                *base = method;
                 
                 // Call the method
                 if (IS_CLOSURE(method)) {
                     Closure *closure = AS_CLOSURE(method);
-                    InterpretResult result = call_closure(vm, closure, arg_count);
+                    frame->ip = ip;
+                    InterpretResult result = call_closure(vm, closure, arg_count + 1);
                     if (result != INTERPRET_OK) {
                         return result;
                     }
                     frame = &vm->frames[vm->frame_count - 1];
+                    ip = frame->ip;
                 } else if (IS_NATIVE(method)) {
                     NativeFn native = AS_NATIVE(method);
-                    InterpretResult result = call_native(vm, native, arg_count);
+                    frame->ip = ip;
+                    InterpretResult result = call_native(vm, native, arg_count + 1);
                     if (result != INTERPRET_OK) {
                         return result;
                     }
+                    // A re-entrant call may have failed or moved the frame stack
+                    if (vm->frame_count == 0) {
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    frame = &vm->frames[vm->frame_count - 1];
                 } else {
                     vm_runtime_error(vm, "Invalid method type.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_CALL: {
-                uint8_t arg_count = *frame->ip++;
+            VM_CASE(OP_CALL) {
+                uint8_t arg_count = *ip++;
                 TaggedValue callee = vm_peek(vm, arg_count);
 
                 if (IS_CLOSURE(callee)) {
                     Closure *closure = AS_CLOSURE(callee);
+                    frame->ip = ip;
                     InterpretResult result = call_closure(vm, closure, arg_count);
                     if (result != INTERPRET_OK) {
                         return result;
                     }
                     frame = &vm->frames[vm->frame_count - 1];
+                    ip = frame->ip;
                 } else if (IS_NATIVE(callee)) {
                     NativeFn native = AS_NATIVE(callee);
+                    frame->ip = ip;
                     InterpretResult result = call_native(vm, native, arg_count);
                     if (result != INTERPRET_OK) {
                         return result;
                     }
+                    if (vm->frame_count == 0) {
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    frame = &vm->frames[vm->frame_count - 1];
                 } else {
                     vm_runtime_error(vm, "Can only call functions.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
+            }
+
+            VM_CASE(OP_TAIL_CALL) {
+                uint8_t arg_count = *ip++;
+                TaggedValue callee = vm_peek(vm, arg_count);
+
+                if (IS_CLOSURE(callee)) {
+                    Closure *closure = AS_CLOSURE(callee);
+                    if (arg_count != closure->function->arity) {
+                        frame->ip = ip;
+                        vm_runtime_error(vm, "Expected %d arguments but got %d.",
+                                         closure->function->arity, arg_count);
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    if (vm_heap_exhausted(vm)) {
+                        frame->ip = ip;
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+
+                    // Slide callee and arguments down over the returning frame
+                    close_upvalues(vm, frame->slots);
+                    TaggedValue *args = vm->stack_top - arg_count - 1;
+                    memmove(frame->slots, args, (size_t)(arg_count + 1) * sizeof(TaggedValue));
+                    vm->stack_top = frame->slots + arg_count + 1;
+
+                    frame->closure = closure;
+                    ip = closure->function->chunk.code;
+                    frame->ip = ip;
+                    if (!vm_ensure_stack(vm, frame_stack_needed(closure->function))) {
+                        vm_runtime_error(vm, "Stack overflow.");
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                } else if (IS_NATIVE(callee)) {
+                    // The OP_RETURN that follows returns the native's result
+                    NativeFn native = AS_NATIVE(callee);
+                    frame->ip = ip;
+                    InterpretResult result = call_native(vm, native, arg_count);
+                    if (result != INTERPRET_OK) {
+                        return result;
+                    }
+                    if (vm->frame_count == 0) {
+                        return INTERPRET_RUNTIME_ERROR;
+                    }
+                    frame = &vm->frames[vm->frame_count - 1];
+                } else {
+                    vm_runtime_error(vm, "Can only call functions.");
+                    return INTERPRET_RUNTIME_ERROR;
+                }
+                VM_NEXT();
             }
 
-            case OP_RETURN: {
+            VM_CASE(OP_RETURN) {
                 TaggedValue result = vm_pop(vm);
                 close_upvalues(vm, frame->slots);
                 vm->frame_count--;
@@ -1312,12 +2160,16 @@ static InterpretResult vm_run_frame(VM *vm) {
 
                 vm->stack_top = frame->slots;
                 vm_push(vm, result);
+                if (vm->frame_count == exit_depth) {
+                    return INTERPRET_OK; // Back in the native that called us
+                }
                 frame = &vm->frames[vm->frame_count - 1];
-                break;
+                ip = frame->ip;
+                VM_NEXT();
             }
 
-            case OP_CLOSURE: {
-                uint8_t function_index = *frame->ip++;
+            VM_CASE(OP_CLOSURE) {
+                uint8_t function_index = *ip++;
                 Function *function = AS_FUNCTION(frame->closure->function->chunk.constants.values[function_index]);
                 Closure *closure = BYTECODE_NEW(Closure);
                 closure->function = function;
@@ -1326,8 +2178,8 @@ static InterpretResult vm_run_frame(VM *vm) {
                 if (closure->upvalue_count > 0) {
                     closure->upvalues = BYTECODE_NEW_ARRAY(Upvalue*, closure->upvalue_count);
                     for (int i = 0; i < closure->upvalue_count; i++) {
-                        uint8_t is_local = *frame->ip++;
-                        uint8_t index = *frame->ip++;
+                        uint8_t is_local = *ip++;
+                        uint8_t index = *ip++;
                         if (is_local) {
                             closure->upvalues[i] = capture_upvalue(vm, frame->slots + index);
                         } else {
@@ -1350,15 +2202,15 @@ static InterpretResult vm_run_frame(VM *vm) {
                     closure->upvalues = NULL;
                 }
 
-                vm_push(vm, (TaggedValue){VAL_CLOSURE, {.closure = closure}});
-                break;
+                vm_push(vm, CLOSURE_VAL(closure));
+                VM_NEXT();
             }
 
-            case OP_CLOSURE_LONG: {
+            VM_CASE(OP_CLOSURE_LONG) {
                 // Read 24-bit constant index
-                uint32_t function_index = (*frame->ip++) << 16;
-                function_index |= (*frame->ip++) << 8;
-                function_index |= *frame->ip++;
+                uint32_t function_index = (*ip++) << 16;
+                function_index |= (*ip++) << 8;
+                function_index |= *ip++;
                 
                 Function *function = AS_FUNCTION(frame->closure->function->chunk.constants.values[function_index]);
                 Closure *closure = BYTECODE_NEW(Closure);
@@ -1368,8 +2220,8 @@ static InterpretResult vm_run_frame(VM *vm) {
                 if (closure->upvalue_count > 0) {
                     closure->upvalues = BYTECODE_NEW_ARRAY(Upvalue*, closure->upvalue_count);
                     for (int i = 0; i < closure->upvalue_count; i++) {
-                        uint8_t is_local = *frame->ip++;
-                        uint8_t index = *frame->ip++;
+                        uint8_t is_local = *ip++;
+                        uint8_t index = *ip++;
                         if (is_local) {
                             closure->upvalues[i] = capture_upvalue(vm, frame->slots + index);
                         } else {
@@ -1392,12 +2244,12 @@ static InterpretResult vm_run_frame(VM *vm) {
                     closure->upvalues = NULL;
                 }
 
-                vm_push(vm, (TaggedValue){VAL_CLOSURE, {.closure = closure}});
-                break;
+                vm_push(vm, CLOSURE_VAL(closure));
+                VM_NEXT();
             }
 
-            case OP_GET_UPVALUE: {
-                uint8_t slot = *frame->ip++;
+            VM_CASE(OP_GET_UPVALUE) {
+                uint8_t slot = *ip++;
                 if (slot >= frame->closure->upvalue_count) {
                     vm_runtime_error(vm, "Invalid upvalue index %d (closure has %d upvalues).",
                                      slot, frame->closure->upvalue_count);
@@ -1409,11 +2261,11 @@ static InterpretResult vm_run_frame(VM *vm) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 vm_push(vm, *upvalue->location);
-                break;
+                VM_NEXT();
             }
 
-            case OP_SET_UPVALUE: {
-                uint8_t slot = *frame->ip++;
+            VM_CASE(OP_SET_UPVALUE) {
+                uint8_t slot = *ip++;
                 if (slot >= frame->closure->upvalue_count) {
                     vm_runtime_error(vm, "Invalid upvalue index %d (closure has %d upvalues).",
                                      slot, frame->closure->upvalue_count);
@@ -1425,25 +2277,28 @@ static InterpretResult vm_run_frame(VM *vm) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
                 *upvalue->location = vm_peek(vm, 0);
-                break;
+                gc_upvalue_write(vm->gc, upvalue);
+                VM_NEXT();
             }
 
-            case OP_CLOSE_UPVALUE: {
+            VM_CASE(OP_CLOSE_UPVALUE) {
                 close_upvalues(vm, vm->stack_top - 1);
                 vm_pop(vm);
-                break;
+                VM_NEXT();
             }
 
             // OP_STRUCT and OP_CONSTRUCT removed - use OP_DEFINE_STRUCT and OP_CREATE_STRUCT instead
 
-            case OP_CREATE_OBJECT: {
+            VM_CASE(OP_CREATE_OBJECT) {
+                VM_SYNC_IP();
                 // Create an empty object
                 Object* obj = object_create();
                 vm_push(vm, OBJECT_VAL(obj));
-                break;
+                VM_NEXT();
             }
 
-            case OP_GET_PROPERTY: {
+            VM_CASE(OP_GET_PROPERTY) {
+                uint8_t *site = ip - 1;
                 TaggedValue name_val = vm_pop(vm);
                 TaggedValue object_val = vm_pop(vm);
 
@@ -1452,21 +2307,26 @@ static InterpretResult vm_run_frame(VM *vm) {
                     return INTERPRET_RUNTIME_ERROR;
                 }
 
-                const char *property_name = AS_STRING(name_val);
+                const char *property_name = vm_string_chars(vm, name_val);
+                if (!property_name) return INTERPRET_RUNTIME_ERROR;
 
-                if (IS_OBJECT(object_val)) {
+                if (IS_OBJECT(object_val) && AS_OBJECT(object_val)->is_array &&
+                    strcmp(property_name, "length") == 0) {
+                    // Shadows the prototype's length() method, as the stored length property used to
+                    vm_push(vm, NUMBER_VAL((double)array_length(AS_OBJECT(object_val))));
+                } else if (IS_OBJECT(object_val)) {
                     Object *obj = AS_OBJECT(object_val);
-                    TaggedValue *value_ptr = object_get_property(obj, property_name);
+                    TaggedValue *value_ptr = vm_cached_property(frame, site, obj, obj->prototype, property_name);
                     if (value_ptr) {
                         vm_push(vm, *value_ptr);
                     } else {
                         vm_push(vm, NIL_VAL);
                     }
                 } else if (IS_STRING(object_val)) {
-                    // Handle string properties
+                    // Handle string properties; the length needs no flattening
                     const char *str = AS_STRING(object_val);
                     if (strcmp(property_name, "length") == 0) {
-                        vm_push(vm, NUMBER_VAL((double)strlen(str)));
+                        vm_push(vm, NUMBER_VAL((double)string_length(str)));
                     } else if (strcmp(property_name, "substring") == 0) {
                         vm_push(vm, NIL_VAL); // TODO: native_string_substring not implemented
                     } else if (strcmp(property_name, "indexOf") == 0) {
@@ -1494,7 +2354,7 @@ static InterpretResult vm_run_frame(VM *vm) {
                     // Handle number properties by looking them up on Number.prototype
                     Object* number_proto = get_number_prototype();
                     if (number_proto) {
-                        TaggedValue* method = object_get_property(number_proto, property_name);
+                        TaggedValue* method = vm_cached_property(frame, site, NULL, number_proto, property_name);
                         if (method) {
                             vm_push(vm, *method);
                         } else {
@@ -1507,10 +2367,11 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "Only objects have properties.");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_SET_PROPERTY: {
+            VM_CASE(OP_SET_PROPERTY) {
+                VM_SYNC_IP();
                 TaggedValue value = vm_pop(vm);
                 TaggedValue name_val = vm_pop(vm);
                 TaggedValue object_val = vm_pop(vm);
@@ -1526,14 +2387,16 @@ static InterpretResult vm_run_frame(VM *vm) {
                 }
 
                 Object *obj = AS_OBJECT(object_val);
-                const char *property_name = AS_STRING(name_val);
+                const char *property_name = vm_string_chars(vm, name_val);
+                if (!property_name) return INTERPRET_RUNTIME_ERROR;
                 object_set_property(obj, property_name, value);
                 vm_push(vm, value);
-                break;
+                VM_NEXT();
             }
 
-            case OP_OBJECT_LITERAL: {
-                uint8_t property_count = *frame->ip++;
+            VM_CASE(OP_OBJECT_LITERAL) {
+                VM_SYNC_IP();
+                uint8_t property_count = *ip++;
                 Object* obj = object_create();
 
                 // Properties are on the stack as: value, key, value, key, ...
@@ -1546,23 +2409,26 @@ static InterpretResult vm_run_frame(VM *vm) {
                         return INTERPRET_RUNTIME_ERROR;
                     }
 
-                    object_set_property(obj, AS_STRING(key), value);
+                    const char *name = vm_string_chars(vm, key);
+                    if (!name) return INTERPRET_RUNTIME_ERROR;
+                    object_set_property(obj, name, value);
                 }
 
                 vm_push(vm, OBJECT_VAL(obj));
-                break;
+                VM_NEXT();
             }
 
             // OP_IMPORT and OP_EXPORT removed - use OP_LOAD_MODULE, OP_IMPORT_FROM, OP_MODULE_EXPORT instead
 
-            case OP_LOAD_MODULE: {
-                uint8_t path_index = *frame->ip++;
+            VM_CASE(OP_LOAD_MODULE) {
+                uint8_t path_index = *ip++;
                 const char* module_path = AS_STRING(frame->closure->function->chunk.constants.values[path_index]);
                 
                 // Load the module through the module loader
                 if (vm->module_loader) {
                     // Detect native modules by $ prefix
                     bool is_native = (module_path[0] == '$');
+                    frame->ip = ip;
                     Module* module = module_load(vm->module_loader, module_path, is_native);
                     if (module) {
                         // Ensure module is initialized
@@ -1587,14 +2453,14 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "No module loader available");
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_IMPORT_FROM: {
+            VM_CASE(OP_IMPORT_FROM) {
                 // Stack: [module_object]
                 // Bytecode: OP_IMPORT_FROM <name_index>
                 TaggedValue module_val = vm_pop(vm);
-                uint8_t name_index = *frame->ip++;
+                uint8_t name_index = *ip++;
                 const char* import_name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
                 
                 if (!IS_OBJECT(module_val)) {
@@ -1611,27 +2477,28 @@ static InterpretResult vm_run_frame(VM *vm) {
                     vm_runtime_error(vm, "Module does not export '%s'", import_name);
                     return INTERPRET_RUNTIME_ERROR;
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_MODULE_EXPORT: {
+            VM_CASE(OP_MODULE_EXPORT) {
                 // Stack: [value]
-                // Bytecode: OP_MODULE_EXPORT <name_index>
+                // Bytecode: OP_MODULE_EXPORT <name_index:16>
                 TaggedValue value = vm_peek(vm, 0); // Don't pop, leave on stack
-                uint8_t name_index = *frame->ip++;
+                uint16_t name_index = (uint16_t) (*ip++) << 8;
+                name_index |= *ip++;
                 const char* export_name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
                 
                 if (vm->current_module) {
                     // Add to module exports
                     module_export(vm->current_module, export_name, value);
                 }
-                break;
+                VM_NEXT();
             }
 
-            case OP_GET_OBJECT_PROTO: {
+            VM_CASE(OP_GET_OBJECT_PROTO) {
                 // Get the prototype for a built-in type to register extension methods
                 // Stack: [] -> [prototype]
-                uint8_t type_id = *frame->ip++;
+                uint8_t type_id = *ip++;
                 Object* prototype = NULL;
                 
                 switch (type_id) {
@@ -1665,13 +2532,13 @@ static InterpretResult vm_run_frame(VM *vm) {
                 }
                 
                 vm_push(vm, OBJECT_VAL(prototype));
-                break;
+                VM_NEXT();
             }
             
-            case OP_GET_STRUCT_PROTO: {
+            VM_CASE(OP_GET_STRUCT_PROTO) {
                 // Get the prototype for a struct type to register extension methods
                 // Stack: [] -> [prototype]
-                uint8_t name_index = *frame->ip++;
+                uint8_t name_index = *ip++;
                 const char* struct_name = AS_STRING(frame->closure->function->chunk.constants.values[name_index]);
                 
                 // Get or create the struct prototype
@@ -1682,16 +2549,29 @@ static InterpretResult vm_run_frame(VM *vm) {
                 }
                 
                 vm_push(vm, OBJECT_VAL(prototype));
-                break;
+                VM_NEXT();
             }
 
             default:
+#if VM_THREADED_DISPATCH
+            L_unknown:
+#endif
                 vm_runtime_error(vm, "Unknown opcode %d.", instruction);
                 return INTERPRET_RUNTIME_ERROR;
         }
     }
 }
 
+#if VM_THREADED_DISPATCH
+#pragma GCC diagnostic pop
+#endif
+#undef VM_CASE
+#undef VM_NEXT
+#undef vm_runtime_error
+#undef QUICKEN
+#undef VM_SYNC_IP
+#undef QUICK_BINARY
+
 // Original vm_interpret for compatibility
 InterpretResult vm_interpret(VM *vm, Chunk *chunk) {
     // Create a dummy function to wrap the chunk
@@ -1702,24 +2582,43 @@ InterpretResult vm_interpret(VM *vm, Chunk *chunk) {
         .upvalue_count = 0,
         .module = NULL
     };
-    return vm_interpret_function(vm, &main_func);
+    InterpretResult result = vm_interpret_function(vm, &main_func);
+
+    // Runtime caches are allocated lazily on the copy; hand them back
+    *chunk = main_func.chunk;
+    return result;
 }
 
 InterpretResult vm_interpret_function(VM *vm, Function *function) {
-    Closure closure;
-    closure.function = function;
-    closure.upvalues = NULL;
-    closure.upvalue_count = 0;
+    // Room for the closure and everything the code pushes
+    if (!vm_ensure_stack(vm, frame_stack_needed(function) + 1)) {
+        vm_runtime_error(vm, "Stack overflow.");
+        return INTERPRET_RUNTIME_ERROR;
+    }
 
-    vm_push(vm, (TaggedValue){VAL_CLOSURE, {.closure = &closure}});
+    // Only the frame and stack slot 0 refer to it, and both are gone once
+    // the script finishes (function may be the caller's stack copy)
+    Closure *closure = BYTECODE_NEW(Closure);
+    closure->function = function;
+    closure->upvalues = NULL;
+    closure->upvalue_count = 0;
+
+    vm_push(vm, CLOSURE_VAL(closure));
 
     CallFrame *frame = &vm->frames[vm->frame_count];
-    frame->closure = &closure;
+    frame->closure = closure;
     frame->ip = function->chunk.code;
     frame->slots = vm->stack;
     vm->frame_count = 1;
 
-    return vm_run_frame(vm);
+    InterpretResult result = vm_run_frame(vm, 0);
+
+    // An early exit can leave the closure in a stack slot the collector
+    // would still trace, so drop the slots before freeing it
+    vm->stack_top = vm->stack;
+    vm->frame_count = 0;
+    BYTECODE_FREE(closure, sizeof(Closure));
+    return result;
 }
 
 Function *function_new(const char *name) {
@@ -1748,9 +2647,15 @@ static InterpretResult call_native(VM *vm, NativeFn native, int arg_count) {
     // For array methods, we need to include the array itself as an argument
     TaggedValue *args = vm->stack_top - arg_count;
     TaggedValue result = NIL_VAL;
+    if (!values_flatten(args, arg_count)) {
+        vm_runtime_error(vm, "Out of memory.");
+        return INTERPRET_RUNTIME_ERROR;
+    }
 
-    // Call the native function
+    // Call the native function; it may re-enter the VM and grow the stack
+    vm->native_depth++;
     result = native(arg_count, args);
+    vm->native_depth--;
 
     // Pop arguments and function
     vm->stack_top -= arg_count + 1;
@@ -1765,7 +2670,7 @@ static const char *value_to_string(VM *vm, TaggedValue value) {
     static char buffer[256]; // Static buffer for simple conversions
 
     if (IS_STRING(value)) {
-        return AS_STRING(value);
+        return string_chars(AS_STRING(value));  // Callers flatten ropes first
     } else if (IS_NUMBER(value)) {
         double num = AS_NUMBER(value);
         if (num == (int64_t) num) {
@@ -1794,7 +2699,7 @@ static const char *value_to_string(VM *vm, TaggedValue value) {
 
 // CLI helper functions
 void vm_push_string(VM *vm, const char *str) {
-    const char *interned = string_pool_intern(&vm->strings, str, strlen(str));
+    char *interned = string_pool_intern(&vm->strings, str, strlen(str));
     vm_push(vm, STRING_VAL(interned));
 }
 
@@ -1850,6 +2755,7 @@ TaggedValue vm_call_value(VM *vm, TaggedValue callee, int arg_count, TaggedValue
     } else if (IS_NATIVE(callee)) {
         // Direct native call
         NativeFn native = AS_NATIVE(callee);
+        if (!values_flatten(args, arg_count)) return NIL_VAL;
         return native(arg_count, args);
     } else {
         // Not callable
@@ -1864,7 +2770,11 @@ TaggedValue vm_call_function(VM *vm, Function *function, int arg_count, TaggedVa
     closure.function = function;
     closure.upvalue_count = 0;
     closure.upvalues = NULL;
-    vm_push(vm, (TaggedValue){VAL_CLOSURE, {.closure = &closure}});
+    if (!vm_ensure_stack(vm, (size_t)arg_count + 1)) {
+        vm_runtime_error(vm, "Stack overflow.");
+        return NIL_VAL;
+    }
+    vm_push(vm, CLOSURE_VAL(&closure));
 
     // Push arguments onto stack
     for (int i = 0; i < arg_count; i++) {
@@ -1878,7 +2788,7 @@ TaggedValue vm_call_function(VM *vm, Function *function, int arg_count, TaggedVa
 
     // Run the interpreter until this function returns
     int initial_frame_count = vm->frame_count - 1;
-    InterpretResult result = vm_run_frame(vm);
+    InterpretResult result = vm_run_frame(vm, initial_frame_count);
     
     // The result should be on top of the stack
     if (result == INTERPRET_OK && vm->frame_count == initial_frame_count) {
@@ -1891,7 +2801,11 @@ TaggedValue vm_call_function(VM *vm, Function *function, int arg_count, TaggedVa
 // Helper to call a closure
 TaggedValue vm_call_closure(VM *vm, Closure *closure, int arg_count, TaggedValue *args) {
     // Push the closure onto the stack
-    vm_push(vm, (TaggedValue){VAL_CLOSURE, {.closure = closure}});
+    if (!vm_ensure_stack(vm, (size_t)arg_count + 1)) {
+        vm_runtime_error(vm, "Stack overflow.");
+        return NIL_VAL;
+    }
+    vm_push(vm, CLOSURE_VAL(closure));
 
     // Push arguments onto stack
     for (int i = 0; i < arg_count; i++) {
@@ -1905,7 +2819,7 @@ TaggedValue vm_call_closure(VM *vm, Closure *closure, int arg_count, TaggedValue
 
     // Run the interpreter until this function returns
     int initial_frame_count = vm->frame_count - 1;
-    InterpretResult result = vm_run_frame(vm);
+    InterpretResult result = vm_run_frame(vm, initial_frame_count);
     
     // The result should be on top of the stack
     if (result == INTERPRET_OK && vm->frame_count == initial_frame_count) {
@@ -1921,9 +2835,9 @@ static void print_object(TaggedValue value) {
     if (IS_OBJECT(value)) {
         Object *obj = AS_OBJECT(value);
         
-        // Check if this is an array-like object (has length property)
-        TaggedValue *length_ptr = object_get_property(obj, "length");
-        if (length_ptr && IS_NUMBER(*length_ptr)) {
+        // Check if this is an array or array-like object (has length property)
+        TaggedValue *length_ptr = obj->is_array ? NULL : object_get_property(obj, "length");
+        if (obj->is_array || (length_ptr && IS_NUMBER(*length_ptr))) {
             snprintf(buffer, sizeof(buffer), "[");
             vm_print_internal(buffer, "", false);
 
@@ -1935,12 +2849,7 @@ static void print_object(TaggedValue value) {
             vm_print_internal("{", "", false);
 
             bool first = true;
-            size_t count = 0;
-            for (size_t i = 0; i < obj->property_count; i++) {
-                if (obj->properties[i].value->type != VAL_NIL) {
-                    count++;
-                }
-            }
+            size_t count = obj->property_count;
             // TODO: Implement object_get_keys
             const char **keys = NULL; // object_get_keys(obj, &count);
             if (keys == NULL) {
@@ -2000,7 +2909,8 @@ void print_value(TaggedValue value) {
     } else if (IS_NIL(value)) {
         vm_print_internal("nil", "", false);
     } else if (IS_STRING(value)) {
-        vm_print_internal(AS_STRING(value), "", false);
+        const char *chars = string_chars(AS_STRING(value));
+        vm_print_internal(chars ? chars : "<out of memory>", "", false);
     } else {
         print_object(value);
     }
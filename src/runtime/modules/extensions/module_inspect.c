@@ -152,8 +152,8 @@ ExportInfo* module_get_exports(Module* module, size_t* count) {
         exports[i].visibility = module->exports.visibility[i];
         
         TaggedValue value = module->exports.values[i];
-        exports[i].type = value.type;
-        exports[i].type_name = value_type_to_string(value.type);
+        exports[i].type = VALUE_TYPE(value);
+        exports[i].type_name = value_type_to_string(VALUE_TYPE(value));
         
         // Determine if constant (simple heuristic: uppercase name)
         exports[i].is_constant = (exports[i].name[0] >= 'A' && exports[i].name[0] <= 'Z');
@@ -358,7 +358,7 @@ char* module_to_json(Module* module, bool include_exports, bool include_stats) {
         for (size_t i = 0; i < module->exports.count; i++) {
             if (i > 0) APPEND(",");
             APPEND("{\"name\":\"%s\",", module->exports.names[i]);
-            APPEND("\"type\":\"%s\",", value_type_to_string(module->exports.values[i].type));
+            APPEND("\"type\":\"%s\",", value_type_to_string(VALUE_TYPE(module->exports.values[i])));
             APPEND("\"visibility\":%d}", module->exports.visibility[i]);
         }
         APPEND("]");
@@ -479,7 +479,7 @@ void module_print_info(Module* module, bool verbose) {
         for (size_t i = 0; i < module->exports.count; i++) {
             fprintf(stderr, "    - %s (%s)\n", 
                    module->exports.names[i],
-                   value_type_to_string(module->exports.values[i].type));
+                   value_type_to_string(VALUE_TYPE(module->exports.values[i])));
         }
     }
     
@@ -1,5 +1,6 @@
 #include "runtime/core/vm.h"
 #include "runtime/core/object.h"
+#include "runtime/core/gc.h"
 #include "runtime/modules/loader/module_loader.h"
 #include "runtime/modules/extensions/module_inspect.h"
 #include "utils/allocators.h"
@@ -21,13 +22,11 @@ static TaggedValue native_current_module(int arg_count, TaggedValue* args) {
         return NIL_VAL;
     }
     
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    
     // Return module as an object with metadata
     Object* mod_obj = object_create();
-    object_set_property(mod_obj, "path", STRING_VAL(STRINGS_STRDUP(g_vm->current_module->path)));
+    object_set_property(mod_obj, "path", STRING_VAL(string_copy(g_vm->current_module->path)));
     object_set_property(mod_obj, "version", 
-        g_vm->current_module->version ? STRING_VAL(STRINGS_STRDUP(g_vm->current_module->version)) : NIL_VAL);
+        g_vm->current_module->version ? STRING_VAL(string_copy(g_vm->current_module->version)) : NIL_VAL);
     object_set_property(mod_obj, "is_native", BOOL_VAL(g_vm->current_module->is_native));
     object_set_property(mod_obj, "is_lazy", BOOL_VAL(g_vm->current_module->chunk != NULL));
     // Store module pointer as a number (cast to uintptr_t)
@@ -41,7 +40,6 @@ static TaggedValue native_loaded_modules(int arg_count, TaggedValue* args) {
         return OBJECT_VAL(array_create());
     }
     
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
     Allocator* alloc = allocators_get(ALLOC_SYSTEM_MODULES);
     
     size_t count;
@@ -49,17 +47,21 @@ static TaggedValue native_loaded_modules(int arg_count, TaggedValue* args) {
     
     Object* array = array_create_with_capacity(count);
     
+    // object_create() may collect, and only this frame knows the array
+    GarbageCollector* gc = g_vm->gc;
+    gc_push_temp_root(gc, OBJECT_VAL(array));
     for (size_t i = 0; i < count; i++) {
         Module* mod = modules[i];
         Object* mod_obj = object_create();
-        object_set_property(mod_obj, "path", STRING_VAL(STRINGS_STRDUP(mod->path)));
+        object_set_property(mod_obj, "path", STRING_VAL(string_copy(mod->path)));
         object_set_property(mod_obj, "version", 
-            mod->version ? STRING_VAL(STRINGS_STRDUP(mod->version)) : NIL_VAL);
+            mod->version ? STRING_VAL(string_copy(mod->version)) : NIL_VAL);
         object_set_property(mod_obj, "is_native", BOOL_VAL(mod->is_native));
         object_set_property(mod_obj, "is_lazy", BOOL_VAL(mod->chunk != NULL));
         object_set_property(mod_obj, "_internal", NUMBER_VAL((double)(uintptr_t)mod));
         array_push(array, OBJECT_VAL(mod_obj));
     }
+    gc_pop_temp_root(gc);
     
     MODULES_FREE(modules, count * sizeof(Module*));
     return OBJECT_VAL(array);
@@ -71,8 +73,6 @@ static TaggedValue native_module_exports(int arg_count, TaggedValue* args) {
         return OBJECT_VAL(array_create());
     }
     
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    
     Object* mod_obj = AS_OBJECT(args[0]);
     TaggedValue* internal = object_get_property(mod_obj, "_internal");
     if (!internal || !IS_NUMBER(*internal)) {
@@ -85,14 +85,17 @@ static TaggedValue native_module_exports(int arg_count, TaggedValue* args) {
     
     Object* array = array_create_with_capacity(count);
     
+    GarbageCollector* gc = g_vm ? g_vm->gc : NULL;
+    gc_push_temp_root(gc, OBJECT_VAL(array));
     for (size_t i = 0; i < count; i++) {
         Object* exp_obj = object_create();
-        object_set_property(exp_obj, "name", STRING_VAL(STRINGS_STRDUP(exports[i].name)));
-        object_set_property(exp_obj, "type", STRING_VAL(STRINGS_STRDUP(exports[i].type_name)));
+        object_set_property(exp_obj, "name", STRING_VAL(string_copy(exports[i].name)));
+        object_set_property(exp_obj, "type", STRING_VAL(string_copy(exports[i].type_name)));
         object_set_property(exp_obj, "is_function", BOOL_VAL(exports[i].is_function));
         object_set_property(exp_obj, "is_constant", BOOL_VAL(exports[i].is_constant));
         array_push(array, OBJECT_VAL(exp_obj));
     }
+    gc_pop_temp_root(gc);
     
     module_exports_free(exports, count);
     return OBJECT_VAL(array);
@@ -101,20 +104,17 @@ static TaggedValue native_module_exports(int arg_count, TaggedValue* args) {
 // __module_state__(module): Get module state as string
 static TaggedValue native_module_state(int arg_count, TaggedValue* args) {
     if (arg_count != 1 || !IS_OBJECT(args[0])) {
-        Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-        return STRING_VAL(STRINGS_STRDUP("unknown"));
+        return STRING_VAL(string_copy("unknown"));
     }
     
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    
     Object* mod_obj = AS_OBJECT(args[0]);
     TaggedValue* internal = object_get_property(mod_obj, "_internal");
     if (!internal || !IS_NUMBER(*internal)) {
-        return STRING_VAL(STRINGS_STRDUP("unknown"));
+        return STRING_VAL(string_copy("unknown"));
     }
     
     Module* module = (Module*)(uintptr_t)AS_NUMBER(*internal);
-    return STRING_VAL(STRINGS_STRDUP(module_state_to_string(module->state)));
+    return STRING_VAL(string_copy(module_state_to_string(module->state)));
 }
 
 // __module_stats__(module): Get module statistics
@@ -163,13 +163,13 @@ static TaggedValue native_module_info(int arg_count, TaggedValue* args) {
             }
             
             char* json = module_to_json(module, include_exports, include_stats);
-            TaggedValue result = STRING_VAL(json);
+            TaggedValue result = STRING_VAL(string_copy(json));
+            module_json_free(json);
             return result;
         }
     }
     
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    return STRING_VAL(STRINGS_STRDUP("{}"));
+    return STRING_VAL(string_copy("{}"));
 }
 
 // Register module introspection natives
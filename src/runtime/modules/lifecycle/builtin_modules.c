@@ -245,11 +245,11 @@ void builtin_math_init(void) {
 }
 
 // String module implementation
-static TaggedValue string_length(int arg_count, TaggedValue* args) {
+static TaggedValue string_lengthOf(int arg_count, TaggedValue* args) {
     if (arg_count != 1 || !IS_STRING(args[0])) {
         return NIL_VAL;
     }
-    return NUMBER_VAL((double)strlen(AS_STRING(args[0])));
+    return NUMBER_VAL((double)string_length(AS_STRING(args[0])));
 }
 
 static TaggedValue string_charAt(int arg_count, TaggedValue* args) {
@@ -259,16 +259,13 @@ static TaggedValue string_charAt(int arg_count, TaggedValue* args) {
     
     const char* str = AS_STRING(args[0]);
     int index = (int)AS_NUMBER(args[1]);
-    size_t len = strlen(str);
+    size_t len = string_length(str);
     
     if (index < 0 || index >= (int)len) {
         return NIL_VAL;
     }
     
-    char result[2] = {str[index], '\0'};
-    // Strings use string allocator
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    return STRING_VAL(MEM_STRDUP(str_alloc, result));
+    return STRING_VAL(string_new(str + index, 1));
 }
 
 static TaggedValue string_substring(int arg_count, TaggedValue* args) {
@@ -278,12 +275,11 @@ static TaggedValue string_substring(int arg_count, TaggedValue* args) {
     
     const char* str = AS_STRING(args[0]);
     int start = (int)AS_NUMBER(args[1]);
-    size_t len = strlen(str);
+    size_t len = string_length(str);
     
     if (start < 0) start = 0;
     if (start >= (int)len) {
-        Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-        return STRING_VAL(MEM_STRDUP(str_alloc, ""));
+        return STRING_VAL(string_new("", 0));
     }
     
     int end = len;
@@ -293,15 +289,7 @@ static TaggedValue string_substring(int arg_count, TaggedValue* args) {
         if (end < start) end = start;
     }
     
-    int sub_len = end - start;
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_ALLOC(str_alloc, sub_len + 1);
-    if (result) {
-        memcpy(result, str + start, sub_len);
-        result[sub_len] = '\0';
-    }
-    
-    return STRING_VAL(result);
+    return STRING_VAL(string_new(str + start, (size_t)(end - start)));
 }
 
 static TaggedValue string_toUpperCase(int arg_count, TaggedValue* args) {
@@ -310,18 +298,15 @@ static TaggedValue string_toUpperCase(int arg_count, TaggedValue* args) {
     }
     
     const char* str = AS_STRING(args[0]);
-    size_t len = strlen(str);
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_ALLOC(str_alloc, len + 1);
+    size_t len = string_length(str);
+    char* result = string_alloc(len);
+    if (!result) return NIL_VAL;
     
-    if (result) {
-        for (size_t i = 0; i < len; i++) {
-            result[i] = (str[i] >= 'a' && str[i] <= 'z') ? str[i] - 32 : str[i];
-        }
-        result[len] = '\0';
+    for (size_t i = 0; i < len; i++) {
+        result[i] = (str[i] >= 'a' && str[i] <= 'z') ? str[i] - 32 : str[i];
     }
     
-    return STRING_VAL(result);
+    return STRING_VAL(string_seal(result));
 }
 
 static TaggedValue string_toLowerCase(int arg_count, TaggedValue* args) {
@@ -330,22 +315,19 @@ static TaggedValue string_toLowerCase(int arg_count, TaggedValue* args) {
     }
     
     const char* str = AS_STRING(args[0]);
-    size_t len = strlen(str);
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_ALLOC(str_alloc, len + 1);
+    size_t len = string_length(str);
+    char* result = string_alloc(len);
+    if (!result) return NIL_VAL;
     
-    if (result) {
-        for (size_t i = 0; i < len; i++) {
-            result[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] + 32 : str[i];
-        }
-        result[len] = '\0';
+    for (size_t i = 0; i < len; i++) {
+        result[i] = (str[i] >= 'A' && str[i] <= 'Z') ? str[i] + 32 : str[i];
     }
     
-    return STRING_VAL(result);
+    return STRING_VAL(string_seal(result));
 }
 
 void builtin_string_init(void) {
-    register_export("length", string_length);
+    register_export("length", string_lengthOf);
     register_export("charAt", string_charAt);
     register_export("substring", string_substring);
     register_export("toUpperCase", string_toUpperCase);
@@ -408,8 +390,7 @@ static TaggedValue io_readLine(int arg_count, TaggedValue* args) {
         if (len > 0 && buffer[len-1] == '\n') {
             buffer[len-1] = '\0';
         }
-        Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-        return STRING_VAL(MEM_STRDUP(str_alloc, buffer));
+        return STRING_VAL(string_copy(buffer));
     }
     
     return NIL_VAL;
@@ -60,6 +60,7 @@ void module_unload(Module* module, VM* vm) {
         }
         free(module->globals.names);
         free(module->globals.values);
+        vm_invalidate_global_caches(vm);
     }
     
     // Free module scope
@@ -56,6 +56,7 @@
 #include "lexer/lexer.h"
 #include "parser/parser.h"
 #include "codegen/compiler.h"
+#include "codegen/stack_depth.h"
 #include "ast/ast.h"
 #include "runtime/modules/lifecycle/builtin_modules.h"
 #include "debug/debug.h"
@@ -68,6 +69,7 @@
 #include "runtime/modules/extensions/module_hooks.h"
 #include "runtime/modules/extensions/module_inspect.h"
 #include "runtime/modules/loader/module_cache.h"
+#include "stdlib/stdlib.h"
 
 // Include common module macros
 #include "runtime/modules/module_allocator_macros.h"
@@ -91,6 +93,52 @@ static uint32_t hash_string(const char* key) {
     return hash;
 }
 
+// Context for copying a module object's properties into module->exports
+typedef struct {
+    Module* module;
+    int prop_count;
+    bool mark_public;
+} ExportCollector;
+
+static void collect_module_export(const char* key, TaggedValue* value, void* user_data) {
+    ExportCollector* collector = (ExportCollector*)user_data;
+    Module* module = collector->module;
+    collector->prop_count++;
+    MODULE_DEBUG("Found property: %s\n", key);
+    
+    // If the property is a function, ensure it has a reference to this module
+    if (IS_FUNCTION(*value)) {
+        AS_FUNCTION(*value)->module = module;
+    }
+    
+    // Add to exports array
+    if (module->exports.count >= module->exports.capacity) {
+        size_t old_capacity = module->exports.capacity;
+        module->exports.capacity *= 2;
+        
+        char** new_names = MODULES_NEW_ARRAY(char*, module->exports.capacity);
+        memcpy(new_names, module->exports.names, old_capacity * sizeof(char*));
+        MODULES_FREE(module->exports.names, old_capacity * sizeof(char*));
+        module->exports.names = new_names;
+        
+        TaggedValue* new_values = MODULES_NEW_ARRAY(TaggedValue, module->exports.capacity);
+        memcpy(new_values, module->exports.values, old_capacity * sizeof(TaggedValue));
+        MODULES_FREE(module->exports.values, old_capacity * sizeof(TaggedValue));
+        module->exports.values = new_values;
+        
+        uint8_t* new_visibility = MODULES_NEW_ARRAY_ZERO(uint8_t, module->exports.capacity);
+        memcpy(new_visibility, module->exports.visibility, old_capacity * sizeof(uint8_t));
+        MODULES_FREE(module->exports.visibility, old_capacity * sizeof(uint8_t));
+        module->exports.visibility = new_visibility;
+    }
+    module->exports.names[module->exports.count] = STRINGS_STRDUP(key);
+    module->exports.values[module->exports.count] = *value;
+    if (collector->mark_public) {
+        module->exports.visibility[module->exports.count] = 1; // Public
+    }
+    module->exports.count++;
+}
+
 // Module scope functions
 ModuleScope* module_scope_create(void) {
     ModuleScope* scope = MODULES_NEW_ZERO(ModuleScope);
@@ -399,13 +447,14 @@ static Module* module_load_from_bundle(ModuleLoader* loader, const char* archive
             module->globals.names[i] = STRINGS_STRDUP(module_vm.globals.names[i]);
             module->globals.values[i] = module_vm.globals.values[i];
         }
+        vm_invalidate_global_caches(loader->vm);
         
         // fprintf(stderr, "[DEBUG] Preserved %zu module globals\n", module->globals.count);
     }
     
     // Clean up
     module_vm.module_loader = NULL; // Don't free the shared loader
-    vm_free(&module_vm);
+    vm_free_into(&module_vm, vm);
     
     if (result != INTERPRET_OK) {
         fprintf(stderr, "Failed to execute module: %s (result: %d)\n", module_name, result);
@@ -420,46 +469,9 @@ static Module* module_load_from_bundle(ModuleLoader* loader, const char* archive
         // Extract exports from module object
         if (module->module_object) {
             MODULE_DEBUG("Extracting exports from module object\n");
-            ObjectProperty* prop = module->module_object->properties;
-            int prop_count = 0;
-            while (prop) {
-                prop_count++;
-                MODULE_DEBUG("Found property: %s\n", prop->key);
-                // If the property is a function, ensure it has a reference to this module
-                if (prop->value && IS_FUNCTION(*prop->value)) {
-                    AS_FUNCTION(*prop->value)->module = module;
-                }
-                // Add to exports array
-                if (module->exports.count >= module->exports.capacity) {
-                    size_t old_capacity = module->exports.capacity;
-                    module->exports.capacity *= 2;
-                    
-                    // Realloc names array
-                    char** new_names = MODULES_NEW_ARRAY(char*, module->exports.capacity);
-                    memcpy(new_names, module->exports.names, old_capacity * sizeof(char*));
-                    MODULES_FREE(module->exports.names, old_capacity * sizeof(char*));
-                    module->exports.names = new_names;
-                    
-                    // Realloc values array
-                    TaggedValue* new_values = MODULES_NEW_ARRAY(TaggedValue, module->exports.capacity);
-                    memcpy(new_values, module->exports.values, old_capacity * sizeof(TaggedValue));
-                    MODULES_FREE(module->exports.values, old_capacity * sizeof(TaggedValue));
-                    module->exports.values = new_values;
-                    
-                    // Realloc visibility array
-                    uint8_t* new_visibility = MODULES_NEW_ARRAY(uint8_t, module->exports.capacity);
-                    memcpy(new_visibility, module->exports.visibility, old_capacity * sizeof(uint8_t));
-                    MODULES_FREE(module->exports.visibility, old_capacity * sizeof(uint8_t));
-                    module->exports.visibility = new_visibility;
-                }
-                module->exports.names[module->exports.count] = STRINGS_STRDUP(prop->key);
-                module->exports.values[module->exports.count] = *prop->value;
-                module->exports.visibility[module->exports.count] = 1; // Public
-                module->exports.count++;
-                
-                prop = prop->next;
-            }
-            MODULE_DEBUG("Total properties extracted: %d, exports count: %zu\n", prop_count, module->exports.count);
+            ExportCollector collector = {module, 0, true};
+            object_iterate_properties(module->module_object, collect_module_export, &collector);
+            MODULE_DEBUG("Total properties extracted: %d, exports count: %zu\n", collector.prop_count, module->exports.count);
         }
         
         // Check hooks result after exports are processed
@@ -549,60 +561,31 @@ bool ensure_module_initialized(Module* module, VM* vm) {
                 module->globals.names[i] = STRINGS_STRDUP(module_vm.globals.names[i]);
                 module->globals.values[i] = module_vm.globals.values[i];
             }
+            vm_invalidate_global_caches(vm);
             
             // Extract exports from module object
             if (module->module_object) {
-                ObjectProperty* prop = module->module_object->properties;
-                while (prop) {
-                    if (prop->value && IS_FUNCTION(*prop->value)) {
-                        AS_FUNCTION(*prop->value)->module = module;
-                    }
-                    if (module->exports.count >= module->exports.capacity) {
-                        size_t old_capacity = module->exports.capacity;
-                        module->exports.capacity *= 2;
-                        
-                        // Realloc arrays
-                        char** new_names = MODULES_NEW_ARRAY(char*, module->exports.capacity);
-                        memcpy(new_names, module->exports.names, old_capacity * sizeof(char*));
-                        MODULES_FREE(module->exports.names, old_capacity * sizeof(char*));
-                        module->exports.names = new_names;
-                        
-                        TaggedValue* new_values = MODULES_NEW_ARRAY(TaggedValue, module->exports.capacity);
-                        memcpy(new_values, module->exports.values, old_capacity * sizeof(TaggedValue));
-                        MODULES_FREE(module->exports.values, old_capacity * sizeof(TaggedValue));
-                        module->exports.values = new_values;
-                        
-                        uint8_t* new_visibility = MODULES_NEW_ARRAY(uint8_t, module->exports.capacity);
-                        memcpy(new_visibility, module->exports.visibility, old_capacity * sizeof(uint8_t));
-                        MODULES_FREE(module->exports.visibility, old_capacity * sizeof(uint8_t));
-                        module->exports.visibility = new_visibility;
-                    }
-                    module->exports.names[module->exports.count] = STRINGS_STRDUP(prop->key);
-                    module->exports.values[module->exports.count] = *prop->value;
-                    module->exports.visibility[module->exports.count] = 1;
-                    module->exports.count++;
-                    prop = prop->next;
-                }
+                ExportCollector collector = {module, 0, true};
+                object_iterate_properties(module->module_object, collect_module_export, &collector);
             }
             
             module->state = MODULE_STATE_LOADED;
             
-            // Execute module initialization hooks
+            // Execute module initialization hooks, then the first-use hooks
+            // of lazy-loaded modules
             if (!module_execute_init_hooks(module, vm)) {
                 fprintf(stderr, "Module init hooks failed for: %s\n", module->path);
                 module->state = MODULE_STATE_ERROR;
-                return false;
+            } else {
+                module_execute_first_use_hooks(module, vm);
             }
-            
-            // Execute first-use hooks for lazy-loaded modules
-            module_execute_first_use_hooks(module, vm);
         } else {
             module->state = MODULE_STATE_ERROR;
         }
         
         // Clean up
         module_vm.module_loader = NULL;
-        vm_free(&module_vm);
+        vm_free_into(&module_vm, vm);
         
         // Don't need the chunk anymore
         Allocator* bc_alloc = allocators_get(ALLOC_SYSTEM_BYTECODE);
@@ -1053,49 +1036,48 @@ static bool load_compiled_module(ModuleLoader* loader, Module* module, ModuleMet
                     offset += sizeof(uint32_t);
                     
                     for (size_t i = 0; i < const_count; i++) {
-                        TaggedValue value;
+                        TaggedValue value = NIL_VAL;
                         
                         // Read type
-                        memcpy(&value.type, bytecode + offset, sizeof(ValueType));
+                        ValueType type;
+                        memcpy(&type, bytecode + offset, sizeof(ValueType));
                         offset += sizeof(ValueType);
                         
                         // Read value based on type
-                        switch (value.type) {
+                        switch (type) {
                             case VAL_STRING: {
                                 // Read string length
                                 uint32_t string_len;
                                 memcpy(&string_len, bytecode + offset, sizeof(uint32_t));
                                 offset += sizeof(uint32_t);
                                 
-                                // Read string data
-                                if (string_len > 0) {
-                                    char* str = MODULES_ALLOC(string_len + 1);
-                                    memcpy(str, bytecode + offset, string_len);
-                                    str[string_len] = '\0';
-                                    offset += string_len;
-                                    
-                                    // Intern the string
-                                    value.as.string = string_pool_intern(&loader->vm->strings, str, string_len);
-                                    MODULES_FREE(str, string_len + 1);
-                                } else {
-                                    value.as.string = string_pool_intern(&loader->vm->strings, "", 0);
-                                }
+                                // Read string data. Constants belong to the
+                                // chunk, so they stay out of the VM's pool,
+                                // whose unreachable strings are collected.
+                                value = STRING_VAL(string_new((const char*)bytecode + offset, string_len));
+                                offset += string_len;
                                 break;
                             }
-                            case VAL_NUMBER:
-                                memcpy(&value.as.number, bytecode + offset, sizeof(double));
+                            case VAL_NUMBER: {
+                                double number;
+                                memcpy(&number, bytecode + offset, sizeof(double));
                                 offset += sizeof(double);
+                                value = NUMBER_VAL(number);
                                 break;
-                            case VAL_BOOL:
-                                memcpy(&value.as.boolean, bytecode + offset, sizeof(bool));
+                            }
+                            case VAL_BOOL: {
+                                bool boolean;
+                                memcpy(&boolean, bytecode + offset, sizeof(bool));
                                 offset += sizeof(bool);
+                                value = BOOL_VAL(boolean);
                                 break;
+                            }
                             case VAL_NIL:
                                 // No data for nil
                                 break;
                             default:
-                                // For other types, read the raw value
-                                memcpy(&value.as, bytecode + offset, sizeof(Value));
+                                // Other types were written as a raw Value; the
+                                // pointer is meaningless in this process, so skip it
                                 offset += sizeof(Value);
                                 break;
                         }
@@ -1122,6 +1104,7 @@ static bool load_compiled_module(ModuleLoader* loader, Module* module, ModuleMet
                     define_global(vm, "__module_exports__", OBJECT_VAL(module->module_object));
                     
                     // Execute bytecode
+                    chunk_measure_stack(chunk);
                     InterpretResult result;
                     // Skip empty chunks (just return)
                     if (chunk->count <= 2) {
@@ -1790,7 +1773,7 @@ skip_cache:
         if (result != INTERPRET_OK) {
             fprintf(stderr, "Failed to execute module: %s (result=%d)\n", absolute_path, result);
             module->state = MODULE_STATE_ERROR;
-            vm_free(&module_vm);
+            vm_free_into(&module_vm, vm);
         } else {
             // Success - module executed successfully
             // The exports are now in module->module_object via OP_MODULE_EXPORT
@@ -1801,46 +1784,10 @@ skip_cache:
                 if (getenv("SWIFTLANG_DEBUG")) {
                     printf("DEBUG: Extracting exports from module object\n");
                 }
-                ObjectProperty* prop = module->module_object->properties;
-                int prop_count = 0;
-                while (prop) {
-                    prop_count++;
-                    if (getenv("SWIFTLANG_DEBUG")) {
-                        printf("DEBUG: Found property: %s\n", prop->key);
-                    }
-                    // If the property is a function, ensure it has a reference to this module
-                    if (prop->value && IS_FUNCTION(*prop->value)) {
-                        AS_FUNCTION(*prop->value)->module = module;
-                    }
-                    // Add to exports array
-                    if (module->exports.count >= module->exports.capacity) {
-                        size_t old_capacity = module->exports.capacity;
-                        module->exports.capacity *= 2;
-                        
-                        char** new_names = MODULES_NEW_ARRAY(char*, module->exports.capacity);
-                        memcpy(new_names, module->exports.names, old_capacity * sizeof(char*));
-                        MODULES_FREE(module->exports.names, old_capacity * sizeof(char*));
-                        module->exports.names = new_names;
-                        
-                        TaggedValue* new_values = MODULES_NEW_ARRAY(TaggedValue, module->exports.capacity);
-                        memcpy(new_values, module->exports.values, old_capacity * sizeof(TaggedValue));
-                        MODULES_FREE(module->exports.values, old_capacity * sizeof(TaggedValue));
-                        module->exports.values = new_values;
-                    }
-                    module->exports.names[module->exports.count] = STRINGS_STRDUP(prop->key);
-                    module->exports.values[module->exports.count] = *prop->value;
-                    
-                    // If exporting a function, ensure it has a reference to this module
-                    if (IS_FUNCTION(module->exports.values[module->exports.count])) {
-                        AS_FUNCTION(module->exports.values[module->exports.count])->module = module;
-                    }
-                    
-                    module->exports.count++;
-                    
-                    prop = prop->next;
-                }
+                ExportCollector collector = {module, 0, false};
+                object_iterate_properties(module->module_object, collect_module_export, &collector);
                 if (getenv("SWIFTLANG_DEBUG")) {
-                    printf("DEBUG: Total properties extracted: %d, exports count: %zu\n", prop_count, module->exports.count);
+                    printf("DEBUG: Total properties extracted: %d, exports count: %zu\n", collector.prop_count, module->exports.count);
                 }
             } else {
                 if (getenv("SWIFTLANG_DEBUG")) {
@@ -1860,15 +1807,19 @@ skip_cache:
                 module->globals.names[i] = STRINGS_STRDUP(module_vm.globals.names[i]);
                 module->globals.values[i] = module_vm.globals.values[i];
             }
+            vm_invalidate_global_caches(loader->vm);
             
             // Clean up module VM - but don't destroy the shared module loader!
             module_vm.module_loader = NULL;  // Prevent vm_free from destroying it
-            vm_free(&module_vm);
+            vm_free_into(&module_vm, vm);
         }
         
-        // Restore VM state
+        // Restore VM state; the module VM took over the allocation and
+        // stdlib bindings, and freeing it cleared them
         vm->frame_count = saved_frame_count;
         vm->stack_top = saved_stack_top;
+        object_set_current_vm(vm);
+        stdlib_set_vm(vm);
         vm->current_module_path = saved_module_path;
         vm->chunk = saved_chunk;
         
@@ -1,4 +1,5 @@
 #include "stdlib/stdlib.h"
+#include "runtime/core/gc.h"
 #include "runtime/modules/extensions/module_inspect.h"
 #include "utils/allocators.h"
 #include <string.h>
@@ -63,12 +64,11 @@ static TaggedValue object_toString_method(int arg_count, TaggedValue* args) {
     if (arg_count < 1) return NIL_VAL;
     
     TaggedValue self = args[0];
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
     
     if (IS_NIL(self)) {
-        return STRING_VAL(MEM_STRDUP(str_alloc, "nil"));
+        return STRING_VAL(string_copy("nil"));
     } else if (IS_BOOL(self)) {
-        return STRING_VAL(MEM_STRDUP(str_alloc, AS_BOOL(self) ? "true" : "false"));
+        return STRING_VAL(string_copy(AS_BOOL(self) ? "true" : "false"));
     } else if (IS_NUMBER(self)) {
         char buffer[32];
         double num = AS_NUMBER(self);
@@ -77,22 +77,22 @@ static TaggedValue object_toString_method(int arg_count, TaggedValue* args) {
         } else {
             snprintf(buffer, sizeof(buffer), "%.14g", num);
         }
-        return STRING_VAL(MEM_STRDUP(str_alloc, buffer));
+        return STRING_VAL(string_copy(buffer));
     } else if (IS_STRING(self)) {
         return self; // Strings return themselves
     } else if (IS_OBJECT(self)) {
         Object* obj = AS_OBJECT(self);
         if (obj->is_array) {
             // For arrays, create a string representation
-            return STRING_VAL(MEM_STRDUP(str_alloc, "[Array]"));
+            return STRING_VAL(string_copy("[Array]"));
         } else {
-            return STRING_VAL(MEM_STRDUP(str_alloc, "[Object]"));
+            return STRING_VAL(string_copy("[Object]"));
         }
     } else if (IS_FUNCTION(self) || IS_CLOSURE(self) || IS_NATIVE(self)) {
-        return STRING_VAL(MEM_STRDUP(str_alloc, "[Function]"));
+        return STRING_VAL(string_copy("[Function]"));
     }
     
-    return STRING_VAL(MEM_STRDUP(str_alloc, "[Unknown]"));
+    return STRING_VAL(string_copy("[Unknown]"));
 }
 
 static TaggedValue object_valueOf_method(int arg_count, TaggedValue* args) {
@@ -112,15 +112,7 @@ static TaggedValue object_hasOwnProperty_method(int arg_count, TaggedValue* args
     const char* prop_name = AS_STRING(args[1]);
     
     // Check if the property exists directly on this object (not prototype)
-    ObjectProperty* prop = obj->properties;
-    while (prop != NULL) {
-        if (strcmp(prop->key, prop_name) == 0) {
-            return BOOL_VAL(true);
-        }
-        prop = prop->next;
-    }
-    
-    return BOOL_VAL(false);
+    return BOOL_VAL(object_has_own_property(obj, prop_name));
 }
 
 // Object prototype methods
@@ -213,7 +205,7 @@ static TaggedValue function_call_method(int arg_count, TaggedValue* args) {
     TaggedValue result;
     if (IS_NATIVE(func)) {
         NativeFn native = AS_NATIVE(func);
-        result = native(func_arg_count + 1, func_args);
+        result = values_flatten(func_args, func_arg_count + 1) ? native(func_arg_count + 1, func_args) : NIL_VAL;
     } else {
         // For user-defined functions, we'd need VM integration
         // For now, return nil
@@ -267,7 +259,7 @@ static TaggedValue function_apply_method(int arg_count, TaggedValue* args) {
     TaggedValue result;
     if (IS_NATIVE(func)) {
         NativeFn native = AS_NATIVE(func);
-        result = native(func_arg_count + 1, func_args);
+        result = values_flatten(func_args, func_arg_count + 1) ? native(func_arg_count + 1, func_args) : NIL_VAL;
     } else {
         // For user-defined functions, we'd need VM integration
         result = NIL_VAL;
@@ -350,6 +342,10 @@ TaggedValue array_map_method(int arg_count, TaggedValue* args) {
     size_t length = array_length(array);
     Object* result = array_create();
     
+    // The callbacks may collect, and only this frame knows the result
+    GarbageCollector* gc = g_vm ? g_vm->gc : NULL;
+    gc_push_temp_root(gc, OBJECT_VAL(result));
+    
     // Call callback for each element
     for (size_t i = 0; i < length; i++) {
         TaggedValue element = array_get(array, i);
@@ -370,7 +366,7 @@ TaggedValue array_map_method(int arg_count, TaggedValue* args) {
         } else if (IS_NATIVE(callback)) {
             // Native callbacks get all 3 args (element, index, array)
             NativeFn native = AS_NATIVE(callback);
-            mapped = native(3, callback_args);
+            mapped = values_flatten(callback_args, 3) ? native(3, callback_args) : NIL_VAL;
         } else {
             mapped = element; // Can't call without VM
         }
@@ -378,6 +374,7 @@ TaggedValue array_map_method(int arg_count, TaggedValue* args) {
         array_push(result, mapped);
     }
     
+    gc_pop_temp_root(gc);
     return OBJECT_VAL(result);
 }
 
@@ -394,6 +391,8 @@ TaggedValue array_filter_method(int arg_count, TaggedValue* args) {
     
     size_t length = array_length(array);
     Object* result = array_create();
+    GarbageCollector* gc = g_vm ? g_vm->gc : NULL;
+    gc_push_temp_root(gc, OBJECT_VAL(result));
     
     // Call callback for each element
     for (size_t i = 0; i < length; i++) {
@@ -416,7 +415,7 @@ TaggedValue array_filter_method(int arg_count, TaggedValue* args) {
         } else if (IS_NATIVE(callback)) {
             // Native callbacks get all 3 args (element, index, array)
             NativeFn native = AS_NATIVE(callback);
-            should_include = native(3, callback_args);
+            should_include = values_flatten(callback_args, 3) ? native(3, callback_args) : NIL_VAL;
         } else {
             // fprintf(stderr, "[DEBUG] No VM available for filter callback\n");
             should_include = BOOL_VAL(false); // Can't call without VM
@@ -427,6 +426,7 @@ TaggedValue array_filter_method(int arg_count, TaggedValue* args) {
         }
     }
     
+    gc_pop_temp_root(gc);
     return OBJECT_VAL(result);
 }
 
@@ -475,7 +475,7 @@ TaggedValue array_reduce_method(int arg_count, TaggedValue* args) {
         } else if (IS_NATIVE(callback)) {
             // Native callbacks get all 4 args
             NativeFn native = AS_NATIVE(callback);
-            accumulator = native(4, callback_args);
+            accumulator = values_flatten(callback_args, 4) ? native(4, callback_args) : NIL_VAL;
         } else {
             return accumulator; // Can't call without VM
         }
@@ -488,8 +488,7 @@ TaggedValue array_reduce_method(int arg_count, TaggedValue* args) {
 TaggedValue string_length_method(int arg_count, TaggedValue* args) {
     if (arg_count < 1 || !IS_STRING(args[0])) return NIL_VAL;
     
-    const char* str = AS_STRING(args[0]);
-    return NUMBER_VAL((double)strlen(str));
+    return NUMBER_VAL((double)string_length(AS_STRING(args[0])));
 }
 
 TaggedValue string_charAt_method(int arg_count, TaggedValue* args) {
@@ -498,14 +497,11 @@ TaggedValue string_charAt_method(int arg_count, TaggedValue* args) {
     const char* str = AS_STRING(args[0]);
     int index = (int)AS_NUMBER(args[1]);
     
-    if (index < 0 || index >= (int)strlen(str)) {
-        Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-        return STRING_VAL(MEM_STRDUP(str_alloc, ""));
+    if (index < 0 || index >= (int)string_length(str)) {
+        return STRING_VAL(string_new("", 0));
     }
     
-    char result[2] = { str[index], '\0' };
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    return STRING_VAL(MEM_STRDUP(str_alloc, result));
+    return STRING_VAL(string_new(str + index, 1));
 }
 
 TaggedValue string_indexOf_method(int arg_count, TaggedValue* args) {
@@ -527,12 +523,11 @@ TaggedValue string_substring_method(int arg_count, TaggedValue* args) {
     
     const char* str = AS_STRING(args[0]);
     int start = (int)AS_NUMBER(args[1]);
-    int len = strlen(str);
+    int len = (int)string_length(str);
     
     if (start < 0) start = 0;
     if (start >= len) {
-        Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-        return STRING_VAL(MEM_STRDUP(str_alloc, ""));
+        return STRING_VAL(string_new("", 0));
     }
     
     int end = len;
@@ -542,47 +537,37 @@ TaggedValue string_substring_method(int arg_count, TaggedValue* args) {
         if (end > len) end = len;
     }
     
-    int result_len = end - start;
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_ALLOC(str_alloc, result_len + 1);
-    if (result) {
-        memcpy(result, str + start, result_len);
-        result[result_len] = '\0';
-    }
-    
-    return STRING_VAL(result);
+    return STRING_VAL(string_new(str + start, (size_t)(end - start)));
 }
 
 TaggedValue string_toUpperCase_method(int arg_count, TaggedValue* args) {
     if (arg_count < 1 || !IS_STRING(args[0])) return NIL_VAL;
     
     const char* str = AS_STRING(args[0]);
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_STRDUP(str_alloc, str);
+    size_t length = string_length(str);
+    char* result = string_alloc(length);
+    if (!result) return NIL_VAL;
     
-    if (result) {
-        for (char* p = result; *p; p++) {
-            *p = toupper((unsigned char)*p);
-        }
+    for (size_t i = 0; i < length; i++) {
+        result[i] = (char)toupper((unsigned char)str[i]);
     }
     
-    return STRING_VAL(result);
+    return STRING_VAL(string_seal(result));
 }
 
 TaggedValue string_toLowerCase_method(int arg_count, TaggedValue* args) {
     if (arg_count < 1 || !IS_STRING(args[0])) return NIL_VAL;
     
     const char* str = AS_STRING(args[0]);
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_STRDUP(str_alloc, str);
+    size_t length = string_length(str);
+    char* result = string_alloc(length);
+    if (!result) return NIL_VAL;
     
-    if (result) {
-        for (char* p = result; *p; p++) {
-            *p = tolower((unsigned char)*p);
-        }
+    for (size_t i = 0; i < length; i++) {
+        result[i] = (char)tolower((unsigned char)str[i]);
     }
     
-    return STRING_VAL(result);
+    return STRING_VAL(string_seal(result));
 }
 
 TaggedValue string_split_method(int arg_count, TaggedValue* args) {
@@ -600,11 +585,8 @@ TaggedValue string_split_method(int arg_count, TaggedValue* args) {
     
     // Empty delimiter = split each character
     if (strlen(delimiter) == 0) {
-        for (const char* p = str; *p; p++) {
-            char char_str[2];
-            char_str[0] = *p;
-            char_str[1] = '\0';
-            array_push(result, STRING_VAL(MEM_STRDUP(str_alloc, char_str)));
+        for (size_t i = 0; i < string_length(str); i++) {
+            array_push(result, STRING_VAL(string_new(str + i, 1)));
         }
         return OBJECT_VAL(result);
     }
@@ -616,7 +598,7 @@ TaggedValue string_split_method(int arg_count, TaggedValue* args) {
     char* token = strtok(str_copy, delimiter);
     
     while (token != NULL) {
-        array_push(result, STRING_VAL(MEM_STRDUP(str_alloc, token)));
+        array_push(result, STRING_VAL(string_copy(token)));
         token = strtok(NULL, delimiter);
     }
     
@@ -636,23 +618,147 @@ TaggedValue string_trim_method(int arg_count, TaggedValue* args) {
     }
     
     // Find last non-whitespace
-    const char* end = str + strlen(str) - 1;
+    const char* end = str + string_length(str) - 1;
     while (end > start && isspace((unsigned char)*end)) {
         end--;
     }
     
     // Create trimmed string
     size_t len = end - start + 1;
-    Allocator* str_alloc = allocators_get(ALLOC_SYSTEM_STRINGS);
-    char* result = MEM_ALLOC(str_alloc, len + 1);
-    if (result) {
-        memcpy(result, start, len);
-        result[len] = '\0';
+    return STRING_VAL(string_new(start, len));
+}
+
+// StringBuilder. Pieces are collected in an array and joined lazily: the
+// first toString() copies each byte once and leaves the result as the only
+// piece, so building a string of n bytes costs O(n) instead of the O(n^2)
+// of repeated +.
+#define BUILDER_PARTS "_parts"
+#define BUILDER_LENGTH "_length"
+
+static Object* builder_self(int arg_count, TaggedValue* args) {
+    if (arg_count < 1 || !IS_OBJECT(args[0])) return NULL;
+    Object* self = AS_OBJECT(args[0]);
+    return self->prototype == get_string_builder_prototype() ? self : NULL;
+}
+
+static size_t builder_length(Object* self) {
+    TaggedValue* length = object_get_property(self, BUILDER_LENGTH);
+    return length && IS_NUMBER(*length) ? (size_t)AS_NUMBER(*length) : 0;
+}
+
+// Strings the builder makes go to the pool of the running VM, like the
+// results of +, so that the string collector frees them once nothing holds
+// them any more
+static char* builder_own(char* string) {
+    VM* vm = object_get_current_vm();
+    return vm && string ? string_pool_take(&vm->strings, string) : string;
+}
+
+static TaggedValue string_builder_new(int arg_count, TaggedValue* args) {
+    (void)arg_count;
+    (void)args;
+    // The parts array is made by the first append(), once the builder is on
+    // the VM stack: allocating it here could collect the unrooted builder
+    Object* builder = object_create_with_prototype(get_string_builder_prototype());
+    return builder ? OBJECT_VAL(builder) : NIL_VAL;
+}
+
+static TaggedValue string_builder_append_method(int arg_count, TaggedValue* args) {
+    Object* self = builder_self(arg_count, args);
+    if (!self || arg_count < 2) return NIL_VAL;
+    
+    // Made before the piece: creating it may collect, and the piece is not
+    // reachable until it is pushed
+    TaggedValue* parts = object_get_property(self, BUILDER_PARTS);
+    if (!parts || !IS_OBJECT(*parts)) {
+        Object* array = array_create();
+        if (!array) return NIL_VAL;
+        object_set_property(self, BUILDER_PARTS, OBJECT_VAL(array));
+        parts = object_get_property(self, BUILDER_PARTS);
+    }
+    
+    // A converted piece is held only here while the push may grow the
+    // parts array, so it is rooted until it is in the array
+    TaggedValue piece = args[1];
+    GarbageCollector* gc = NULL;
+    if (!IS_STRING(piece)) {
+        piece = object_toString_method(1, &args[1]);
+        if (!IS_STRING(piece)) return NIL_VAL;
+        piece = STRING_VAL(builder_own(AS_STRING(piece)));
+        VM* vm = object_get_current_vm();
+        gc = vm ? vm->gc : NULL;
+        gc_push_temp_root(gc, piece);
+    }
+    array_push(AS_OBJECT(*parts), piece);
+    gc_pop_temp_root(gc);
+    
+    size_t length = builder_length(self) + string_length(AS_STRING(piece));
+    object_set_property(self, BUILDER_LENGTH, NUMBER_VAL((double)length));
+    return args[0];
+}
+
+static TaggedValue string_builder_toString_method(int arg_count, TaggedValue* args) {
+    Object* self = builder_self(arg_count, args);
+    if (!self) return NIL_VAL;
+    
+    TaggedValue* parts = object_get_property(self, BUILDER_PARTS);
+    if (!parts || !IS_OBJECT(*parts) || array_length(AS_OBJECT(*parts)) == 0) {
+        return STRING_VAL(builder_own(string_new("", 0)));
+    }
+    
+    Object* array = AS_OBJECT(*parts);
+    size_t count = array_length(array);
+    if (count == 1) return array_get(array, 0);
+    
+    char* result = string_alloc(builder_length(self));
+    if (!result) return NIL_VAL;
+    char* end = result;
+    for (size_t i = 0; i < count; i++) {
+        const char* part = AS_STRING(array_get(array, i));
+        memcpy(end, part, string_length(part));
+        end += string_length(part);
     }
+    result = builder_own(string_seal(result));
     
+    // Keep the joined string as the only piece for the next toString()
+    while (array_length(array) > 1) {
+        array_pop(array);
+    }
+    array_set(array, 0, STRING_VAL(result));
     return STRING_VAL(result);
 }
 
+static TaggedValue string_builder_length_method(int arg_count, TaggedValue* args) {
+    Object* self = builder_self(arg_count, args);
+    return self ? NUMBER_VAL((double)builder_length(self)) : NIL_VAL;
+}
+
+static TaggedValue string_builder_clear_method(int arg_count, TaggedValue* args) {
+    Object* self = builder_self(arg_count, args);
+    if (!self) return NIL_VAL;
+    
+    TaggedValue* parts = object_get_property(self, BUILDER_PARTS);
+    if (parts && IS_OBJECT(*parts)) {
+        Object* array = AS_OBJECT(*parts);
+        while (array_length(array) > 0) {
+            array_pop(array);
+        }
+    }
+    object_set_property(self, BUILDER_LENGTH, NUMBER_VAL(0));
+    return args[0];
+}
+
+void stdlib_init_string_builder(VM* vm) {
+    Object* proto = get_string_builder_prototype();
+    if (!proto) return;
+    
+    object_set_property(proto, "append", NATIVE_VAL(string_builder_append_method));
+    object_set_property(proto, "toString", NATIVE_VAL(string_builder_toString_method));
+    object_set_property(proto, "length", NATIVE_VAL(string_builder_length_method));
+    object_set_property(proto, "clear", NATIVE_VAL(string_builder_clear_method));
+    define_global(vm, "StringBuilder", NATIVE_VAL(string_builder_new));
+}
+
 TaggedValue array_count_method(int arg_count, TaggedValue* args) {
     if (arg_count < 1 || !IS_OBJECT(args[0])) return NIL_VAL;
     
@@ -37,7 +37,7 @@ void allocators_init(const AllocatorConfig* config) {
         g_allocators.config.enable_trace = false;
         g_allocators.config.enable_stats = true;
         g_allocators.config.arena_size = 64 * 1024;  // 64KB
-        g_allocators.config.object_pool_size = 256;
+        g_allocators.config.object_pool_size = 4 * 1024;  // 4KB
     }
     
     // Initialize memory system
@@ -56,14 +56,14 @@ void allocators_init(const AllocatorConfig* config) {
                 break;
                 
             case ALLOC_SYSTEM_OBJECTS:
-                // Objects of various sizes - use platform for now
-                // TODO: Could use freelist for common object sizes
-                base = mem_create_platform_allocator();
+                // Many small blocks of a few recurring sizes, freed one by one
+                base = mem_create_size_class_allocator(g_allocators.config.object_pool_size);
                 break;
                 
             case ALLOC_SYSTEM_STRINGS:
-                // Strings are immutable - arena is perfect
-                base = mem_create_arena_allocator(g_allocators.config.arena_size * 4);
+                // Mostly short strings, freed one by one as the collector
+                // sweeps the string pool
+                base = mem_create_size_class_allocator(g_allocators.config.arena_size);
                 break;
                 
             case ALLOC_SYSTEM_BYTECODE:
@@ -105,6 +105,7 @@ void allocators_shutdown(void) {
     
     // Destroy allocators
     for (int i = 0; i < ALLOC_SYSTEM_COUNT; i++) {
+        allocators_set_hook((AllocatorSystem)i, NULL, NULL);
         if (g_allocators.allocators[i]) {
             mem_destroy(g_allocators.allocators[i]);
             g_allocators.allocators[i] = NULL;
@@ -129,6 +130,26 @@ Allocator* allocators_get(AllocatorSystem system) {
     return mem_get_default_allocator();
 }
 
+void allocators_set_hook(AllocatorSystem system, MemAllocHook hook, void* user_data) {
+    if (system < 0 || system >= ALLOC_SYSTEM_COUNT) return;
+    if (!g_allocators.initialized) {
+        allocators_init(NULL);
+    }
+    
+    Allocator* current = g_allocators.allocators[system];
+    Allocator* backing = mem_hook_allocator_backing(current);
+    if (backing) {
+        mem_destroy(current);
+        g_allocators.allocators[system] = current = backing;
+    }
+    if (hook) {
+        Allocator* hooked = mem_create_hook_allocator(current, hook, user_data);
+        if (hooked) {
+            g_allocators.allocators[system] = hooked;
+        }
+    }
+}
+
 void allocators_print_stats(void) {
     printf("\n=== Memory Allocator Statistics ===\n");
     
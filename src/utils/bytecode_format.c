@@ -1,4 +1,5 @@
 #include "utils/bytecode_format.h"
+#include "runtime/core/string_object.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -165,7 +166,7 @@ bool bytecode_serialize(Chunk* chunk, uint8_t** output, size_t* output_size) {
         } else if (IS_STRING(constant)) {
             bytecode_write_u8(buffer, 3);
             const char* str = AS_STRING(constant);
-            bytecode_write_string(buffer, str, strlen(str));
+            bytecode_write_string(buffer, str, string_length(str));
         } else if (IS_FUNCTION(constant)) {
             // Serialize the entire function including its bytecode
             bytecode_write_u8(buffer, 5);
@@ -192,7 +193,7 @@ bool bytecode_serialize(Chunk* chunk, uint8_t** output, size_t* output_size) {
             bytecode_write_u8(buffer, 4);
         } else {
             // Unknown type
-            fprintf(stderr, "[WARNING] Unknown constant type %d, writing as NIL\n", constant.type);
+            fprintf(stderr, "[WARNING] Unknown constant type %d, writing as NIL\n", VALUE_TYPE(constant));
             bytecode_write_u8(buffer, 0); // Write as NIL
         }
     }
@@ -296,7 +297,8 @@ bool bytecode_deserialize(const uint8_t* input, size_t input_size, Chunk* chunk)
                     size_t len;
                     char* str = bytecode_read_string(&buffer, &len);
                     if (!str) return false;
-                    chunk_add_constant(chunk, STRING_VAL(str));
+                    chunk_add_constant(chunk, STRING_VAL(string_new(str, len)));
+                    free(str);
                 }
                 break;
             
@@ -38,10 +38,13 @@
 #include "ast/ast_printer.h"
 #include "utils/bytecode_format.h"
 #include "utils/allocators.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/alloc_profiler.h"
+#include "runtime/core/heap_snapshot.h"
 #include "miniz.h"
 
-// Define MAX_INPUT for REPL input buffer
-#define MAX_INPUT 1024
+// Size of the REPL input buffer (MAX_INPUT is taken by <limits.h>)
+#define REPL_MAX_INPUT 1024
 
 // Global CLI configuration
 CLIConfig g_cli_config = {
@@ -49,7 +52,10 @@ CLIConfig g_cli_config = {
     .log_modules = LOG_MODULE_ALL,
     .log_colors = true,
     .stack_size = 256 * 1024,  // 256KB default stack
-    .heap_size = 16 * 1024 * 1024,  // 16MB default heap
+    .heap_size = 0,  // Unlimited heap
+    .gc_pause_ms = 10,
+    .heap_top = 10,
+    .alloc_rate = 512 * 1024,
     .jobs = 1,
     .format = "zip"
 };
@@ -214,6 +220,17 @@ static const Command commands[] = {
                 "  --save           Update manifest.json\n"
                 "  --dry-run        Show what would be updated"
     },
+    {
+        .name = "heap",
+        .description = "Analyze a heap snapshot",
+        .handler = cli_cmd_heap,
+        .usage = "heap <snapshot> [options]",
+        .help = "Report what keeps memory alive in a snapshot saved by --heap-snapshot:\n"
+                "retained size by type, then the largest retainers with the path of\n"
+                "objects that must go before each can be freed.\n"
+                "Options:\n"
+                "  --top <n>        Entries in each list (default: 10)"
+    },
     {
         .name = "cache",
         .description = "Manage module cache",
@@ -265,6 +282,11 @@ static struct option long_options[] = {
     {"stack-size", required_argument, 0, 0},
     {"heap-size", required_argument, 0, 0},
     {"gc-stress", no_argument, 0, 0},
+    {"gc-pause", required_argument, 0, 0},
+    {"gc-stats", optional_argument, 0, 0},
+    {"heap-snapshot", required_argument, 0, 0},
+    {"alloc-profile", required_argument, 0, 0},
+    {"alloc-rate", required_argument, 0, 0},
     
     // Other options
     {"quiet", no_argument, 0, 'q'},
@@ -289,6 +311,7 @@ static struct option long_options[] = {
     {"sign", no_argument, 0, 0},
     {"depth", required_argument, 0, 0},
     {"json", no_argument, 0, 0},
+    {"top", required_argument, 0, 0},
     
     {0, 0, 0, 0}
 };
@@ -363,6 +386,18 @@ void cli_print_help(const char* program_name) {
     printf("  -M, --module-path <dir> Add module search path\n");
     printf("\n");
     
+    printf(COLOR_BOLD "Runtime Options:\n" COLOR_RESET);
+    printf("  --heap-size <mb>        Stop scripts whose live heap outgrows this (default: unlimited)\n");
+    printf("  --gc-pause <ms>         Pause goal the collector sizes itself for; 0 fixes the sizes (default: 10)\n");
+    printf("  --gc-stress             Collect on every allocation\n");
+    printf("  --gc-stats[=json]       Report collector statistics at exit; json also streams\n");
+    printf("                          one line per collection to stderr\n");
+    printf("  --heap-snapshot <file>  Save the reachable heap at exit, for the heap command\n");
+    printf("  --alloc-profile <file>  Sample where the script allocates; pprof format, or folded\n");
+    printf("                          stacks if the file ends in .folded or .txt\n");
+    printf("  --alloc-rate <bytes>    Mean bytes between samples; 0 records all (default: 524288)\n");
+    printf("\n");
+    
     printf(COLOR_BOLD "Examples:\n" COLOR_RESET);
     printf("  %s init                           # Initialize project\n", program_name);
     printf("  %s new myapp                      # Create new project\n", program_name);
@@ -455,9 +490,29 @@ void cli_parse_args(int argc, char* argv[]) {
                 else if (strcmp(name, "stack-size") == 0) {
                     g_cli_config.stack_size = atoi(optarg) * 1024;
                 } else if (strcmp(name, "heap-size") == 0) {
-                    g_cli_config.heap_size = atoi(optarg) * 1024 * 1024;
+                    g_cli_config.heap_size = (size_t)atoi(optarg) * 1024 * 1024;
                 } else if (strcmp(name, "gc-stress") == 0) {
                     g_cli_config.gc_stress_test = true;
+                } else if (strcmp(name, "gc-pause") == 0) {
+                    g_cli_config.gc_pause_ms = (uint32_t)atoi(optarg);
+                } else if (strcmp(name, "gc-stats") == 0) {
+                    g_cli_config.gc_stats = optarg ? optarg : "text";
+                    if (strcmp(g_cli_config.gc_stats, "text") != 0 &&
+                        strcmp(g_cli_config.gc_stats, "json") != 0) {
+                        cli_print_error("Unknown --gc-stats format: %s (expected text or json)", optarg);
+                        exit(1);
+                    }
+                } else if (strcmp(name, "heap-snapshot") == 0) {
+                    g_cli_config.heap_snapshot = optarg;
+                } else if (strcmp(name, "alloc-profile") == 0) {
+                    g_cli_config.alloc_profile = optarg;
+                } else if (strcmp(name, "alloc-rate") == 0) {
+                    g_cli_config.alloc_rate = (size_t)strtoull(optarg, NULL, 10);
+                }
+                
+                // Command options
+                else if (strcmp(name, "top") == 0) {
+                    g_cli_config.heap_top = atoi(optarg) > 0 ? (size_t)atoi(optarg) : 1;
                 }
                 break;
             }
@@ -1272,6 +1327,70 @@ static bool needs_more_input(const char* input) {
     return brace_count > 0 || paren_count > 0 || in_string || in_char;
 }
 
+static void print_gc_event(const GCEvent* event, void* user_data) {
+    gc_write_event_json((FILE*)user_data, event);
+}
+
+static AllocProfiler* g_alloc_profiler = NULL;
+
+// Apply the runtime options to a fresh VM's collector. `script_path` names
+// the file allocation profiles attribute top-level code to.
+static void configure_gc(VM* vm, const char* script_path) {
+    if (!vm->gc) return;
+    gc_set_target_pause(vm->gc, g_cli_config.gc_pause_ms * 1000);
+    gc_set_max_heap(vm->gc, g_cli_config.heap_size);
+    if (g_cli_config.gc_stress_test) {
+        vm->gc->config.stress_test = true;
+    }
+    if (g_cli_config.gc_stats && strcmp(g_cli_config.gc_stats, "json") == 0) {
+        gc_set_event_callback(vm->gc, print_gc_event, stderr);
+    }
+    if (g_cli_config.alloc_profile) {
+        g_alloc_profiler = alloc_profiler_create(vm, g_cli_config.alloc_rate, script_path);
+    }
+}
+
+static void write_alloc_profile(void) {
+    const char* path = g_cli_config.alloc_profile;
+    alloc_profiler_stop(g_alloc_profiler);
+    
+    const char* ext = strrchr(path, '.');
+    bool folded = ext && (strcmp(ext, ".folded") == 0 || strcmp(ext, ".txt") == 0);
+    FILE* out = fopen(path, folded ? "w" : "wb");
+    bool ok = out && (folded ? alloc_profiler_write_folded(g_alloc_profiler, out)
+                             : alloc_profiler_write_pprof(g_alloc_profiler, out));
+    if (out && fclose(out) != 0) ok = false;
+    if (!ok) {
+        cli_print_error("Failed to write allocation profile: %s", path);
+    }
+    alloc_profiler_destroy(g_alloc_profiler);
+    g_alloc_profiler = NULL;
+}
+
+// --gc-stats report, --heap-snapshot and --alloc-profile, before the VM is
+// freed
+static void report_gc(VM* vm) {
+    if (!vm->gc) return;
+    if (g_alloc_profiler) {
+        write_alloc_profile();
+    }
+    if (g_cli_config.heap_snapshot) {
+        HeapSnapshot* snapshot = heap_snapshot_take(vm->gc);
+        if (!snapshot || !heap_snapshot_write(snapshot, g_cli_config.heap_snapshot)) {
+            cli_print_error("Failed to write heap snapshot: %s", g_cli_config.heap_snapshot);
+        }
+        heap_snapshot_free(snapshot);
+    }
+    if (!g_cli_config.gc_stats) return;
+    if (strcmp(g_cli_config.gc_stats, "json") == 0) {
+        // Collections while the VM is torn down are not the program's
+        gc_set_event_callback(vm->gc, NULL, NULL);
+        gc_write_stats_json(vm->gc, stderr);
+    } else {
+        gc_print_stats(vm->gc);
+    }
+}
+
 void cli_run_repl(void) {
     #define MAX_LINE 1024
     #define MAX_INPUT_SIZE 8192
@@ -1280,6 +1399,7 @@ void cli_run_repl(void) {
     
     VM vm;
     vm_init(&vm);
+    configure_gc(&vm, "<repl>");
     
     cli_print_banner();
     printf("SwiftLang REPL v0.1.0\n");
@@ -1366,9 +1486,24 @@ void cli_run_repl(void) {
     }
     
 exit_repl:
+    report_gc(&vm);
     vm_free(&vm);
 }
 
+// Disassemble a script chunk and the functions in its constant table
+static void print_program_bytecode(Chunk* chunk, const char* path) {
+    disassemble_chunk(chunk, path);
+    
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        if (IS_FUNCTION(chunk->constants.values[i])) {
+            Function* func = AS_FUNCTION(chunk->constants.values[i]);
+            printf("\n== Function: %s ==\n", func->name);
+            disassemble_chunk(&func->chunk, func->name);
+        }
+    }
+    printf("\n");
+}
+
 int cli_run_file(const char* path) {
     LOG_INFO(LOG_MODULE_CLI, "Running file: %s", path);
     
@@ -1426,17 +1561,7 @@ int cli_run_file(const char* path) {
     // Debug: disassemble bytecode
     if (g_cli_config.debug_bytecode) {
         printf("\n=== Bytecode ===\n");
-        disassemble_chunk(&chunk, path);
-        
-        // Also disassemble function chunks
-        for (size_t i = 0; i < chunk.constants.count; i++) {
-            if (IS_FUNCTION(chunk.constants.values[i])) {
-                Function* func = AS_FUNCTION(chunk.constants.values[i]);
-                printf("\n== Function: %s ==\n", func->name);
-                disassemble_chunk(&func->chunk, func->name);
-            }
-        }
-        printf("\n");
+        print_program_bytecode(&chunk, path);
     }
     
     // Save bytecode if requested
@@ -1464,6 +1589,8 @@ int cli_run_file(const char* path) {
     // Create VM and run
     VM vm;
     vm_init(&vm);
+    configure_gc(&vm, path);
+    vm.debug_trace = g_cli_config.debug_trace;
     ModuleLoader* loader = module_loader_create(&vm);
     vm.module_loader = loader;
     
@@ -1503,6 +1630,23 @@ int cli_run_file(const char* path) {
     LOG_DEBUG(LOG_MODULE_CLI, "Starting VM execution");
     InterpretResult result = vm_interpret(&vm, &chunk);
     
+    // Debug: quickened instructions and inline cache counters gathered
+    // during the run
+    if (g_cli_config.debug_bytecode) {
+        printf("\n=== Bytecode After Run ===\n");
+        print_program_bytecode(&chunk, path);
+        
+        printf("\n=== Inline Caches ===\n");
+        disassemble_inline_caches(&chunk, path);
+        for (size_t i = 0; i < chunk.constants.count; i++) {
+            if (IS_FUNCTION(chunk.constants.values[i])) {
+                Function* func = AS_FUNCTION(chunk.constants.values[i]);
+                disassemble_inline_caches(&func->chunk, func->name);
+            }
+        }
+    }
+    
+    report_gc(&vm);
     chunk_free(&chunk);
     program_destroy(program);
     parser_destroy(parser);
@@ -1523,6 +1667,7 @@ int cli_run_bundle(const char* bundle_path) {
     // Create VM
     VM vm;
     vm_init(&vm);
+    configure_gc(&vm, bundle_path);
     ModuleLoader* loader = module_loader_create(&vm);
     vm.module_loader = loader;
     
@@ -1551,6 +1696,7 @@ int cli_run_bundle(const char* bundle_path) {
     Module* module = module_load(loader, bundle_path, false);
     if (!module) {
         cli_print_error("Failed to load bundle: %s", bundle_path);
+        report_gc(&vm);
         module_loader_destroy(loader);
         vm_free(&vm);
         return 1;
@@ -1559,6 +1705,7 @@ int cli_run_bundle(const char* bundle_path) {
     // Ensure module is initialized (this executes the module's bytecode)
     if (!ensure_module_initialized(module, &vm)) {
         cli_print_error("Failed to initialize module");
+        report_gc(&vm);
         module_loader_destroy(loader);
         vm_free(&vm);
         return 1;
@@ -1593,6 +1740,7 @@ int cli_run_bundle(const char* bundle_path) {
     }
     
     // Cleanup
+    report_gc(&vm);
     module_loader_destroy(loader);
     vm_free(&vm);
     
@@ -2305,6 +2453,23 @@ int cli_cmd_update(int argc, char* argv[]) {
     return 0;
 }
 
+int cli_cmd_heap(int argc, char* argv[]) {
+    if (argc < 2) {
+        cli_print_error("Snapshot file required");
+        cli_print_info("Usage: swiftlang heap <snapshot> [--top <n>]");
+        return 1;
+    }
+    
+    HeapSnapshot* snapshot = heap_snapshot_read(argv[1]);
+    if (!snapshot) {
+        cli_print_error("Cannot read heap snapshot: %s", argv[1]);
+        return 1;
+    }
+    heap_snapshot_report(snapshot, stdout, g_cli_config.heap_top);
+    heap_snapshot_free(snapshot);
+    return 0;
+}
+
 int cli_cmd_cache(int argc, char* argv[]) {
     if (argc < 1) {
         cli_print_error("Cache command required");
@@ -370,15 +370,20 @@ CompilerOptions* compiler_options_from_module(const char* module_name,
     }
     
     // Add platform-specific defines
-    options->defines = malloc(sizeof(char*) * 2);
+    options->defines = malloc(sizeof(char*) * 3);
     options->defines[0] = strdup("SWIFTLANG_MODULE");
     options->define_count = 1;
     
     if (platform == PLATFORM_MACOS) {
-        options->defines[1] = strdup("GL_SILENCE_DEPRECATION");
-        options->define_count = 2;
+        options->defines[options->define_count++] = strdup("GL_SILENCE_DEPRECATION");
     }
     
+#ifdef SLANG_NAN_BOXING
+    // Natives exchange TaggedValues with this runtime, so they must see the
+    // same layout through runtime/core/vm.h
+    options->defines[options->define_count++] = strdup("SLANG_NAN_BOXING");
+#endif
+    
     return options;
 }
 
@@ -3,6 +3,7 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <stdint.h>
 
 // Freelist node
 typedef struct FreeNode {
@@ -21,6 +22,7 @@ typedef struct {
     size_t blocks_per_chunk;
     FreeNode* free_list;
     BlockHeader* chunks;
+    size_t chunk_count;
     AllocatorStats stats;
 } FreelistAllocatorData;
 
@@ -37,6 +39,7 @@ static bool allocate_chunk(FreelistAllocatorData* data) {
     chunk->size = chunk_size;
     chunk->next = data->chunks;
     data->chunks = chunk;
+    data->chunk_count++;
     
     // Add blocks to free list
     char* block_ptr = (char*)(chunk + 1);
@@ -53,18 +56,8 @@ static bool allocate_chunk(FreelistAllocatorData* data) {
     return true;
 }
 
-// Freelist allocator functions
-static void* freelist_alloc(Allocator* allocator, size_t size, AllocFlags flags, const char* file, int line, const char* tag) {
-    (void)file; (void)line; (void)tag; // Unused in freelist allocator
-    
-    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
-    
-    // Freelist only allocates fixed-size blocks
-    if (size > data->block_size) {
-        return NULL;
-    }
-    
-    // Get block from free list
+// Pop a block, growing the list by a chunk when it runs dry
+static void* freelist_take(FreelistAllocatorData* data, AllocFlags flags) {
     if (!data->free_list) {
         if (!allocate_chunk(data)) {
             return NULL;
@@ -90,6 +83,32 @@ static void* freelist_alloc(Allocator* allocator, size_t size, AllocFlags flags,
     return node;
 }
 
+static void freelist_give(FreelistAllocatorData* data, void* ptr) {
+    // Add block back to free list
+    FreeNode* node = (FreeNode*)ptr;
+    node->next = data->free_list;
+    data->free_list = node;
+    
+    // Update stats
+    data->stats.total_freed += data->block_size;
+    data->stats.current_usage -= data->block_size;
+    data->stats.free_count++;
+}
+
+// Freelist allocator functions
+static void* freelist_alloc(Allocator* allocator, size_t size, AllocFlags flags, const char* file, int line, const char* tag) {
+    (void)file; (void)line; (void)tag; // Unused in freelist allocator
+    
+    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
+    
+    // Freelist only allocates fixed-size blocks
+    if (size > data->block_size) {
+        return NULL;
+    }
+    
+    return freelist_take(data, flags);
+}
+
 static void* freelist_realloc(Allocator* allocator, void* ptr, size_t old_size, size_t new_size, const char* file, int line, const char* tag) {
     FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
     
@@ -116,22 +135,10 @@ static void freelist_free(Allocator* allocator, void* ptr, size_t size, const ch
     
     if (!ptr) return;
     
-    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
-    
-    // Add block back to free list
-    FreeNode* node = (FreeNode*)ptr;
-    node->next = data->free_list;
-    data->free_list = node;
-    
-    // Update stats
-    data->stats.total_freed += data->block_size;
-    data->stats.current_usage -= data->block_size;
-    data->stats.free_count++;
+    freelist_give((FreelistAllocatorData*)allocator->data, ptr);
 }
 
-static void freelist_reset(Allocator* allocator) {
-    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
-    
+static void freelist_reset_data(FreelistAllocatorData* data) {
     // Rebuild free list from all chunks
     data->free_list = NULL;
     
@@ -155,18 +162,29 @@ static void freelist_reset(Allocator* allocator) {
     data->stats.free_count = data->stats.allocation_count;
 }
 
-static void freelist_destroy(Allocator* allocator) {
-    if (!allocator) return;
-    
-    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
-    
-    // Free all chunks
+static void freelist_reset(Allocator* allocator) {
+    freelist_reset_data((FreelistAllocatorData*)allocator->data);
+}
+
+static void freelist_free_chunks(FreelistAllocatorData* data) {
     BlockHeader* chunk = data->chunks;
     while (chunk) {
         BlockHeader* next = chunk->next;
         free(chunk);
         chunk = next;
     }
+    data->chunks = NULL;
+    data->chunk_count = 0;
+    data->free_list = NULL;
+}
+
+static void freelist_destroy(Allocator* allocator) {
+    if (!allocator) return;
+    
+    FreelistAllocatorData* data = (FreelistAllocatorData*)allocator->data;
+    
+    // Free all chunks
+    freelist_free_chunks(data);
     
     free(data);
     free(allocator);
@@ -263,4 +281,211 @@ Allocator* mem_create_freelist_allocator(size_t block_size, size_t initial_block
     allocator->data = data;
     
     return allocator;
-}
\ No newline at end of file
+}
+
+// Size-class allocator: one block list per class, platform fallback above the largest
+static const size_t size_classes[] = { 16, 32, 48, 64, 80, 96, 128, 160, 192, 256 };
+#define SIZE_CLASS_COUNT (sizeof(size_classes) / sizeof(size_classes[0]))
+#define SIZE_CLASS_MAX 256
+#define SIZE_CLASS_GRANULE 16
+#define SIZE_CLASS_MIN_BLOCKS 8
+
+typedef struct {
+    FreelistAllocatorData classes[SIZE_CLASS_COUNT];
+    uint8_t class_of[SIZE_CLASS_MAX / SIZE_CLASS_GRANULE + 1];  // Indexed by granules
+    Allocator* large;
+} SizeClassAllocatorData;
+
+// Blocks are found again from the size passed to free, so callers must free with
+// the size they allocated (any size in the same class works)
+static FreelistAllocatorData* size_class_for(SizeClassAllocatorData* data, size_t size) {
+    if (size > SIZE_CLASS_MAX) return NULL;
+    size_t granules = (size + SIZE_CLASS_GRANULE - 1) / SIZE_CLASS_GRANULE;
+    return &data->classes[data->class_of[granules]];
+}
+
+static void* size_class_alloc(Allocator* allocator, size_t size, AllocFlags flags, const char* file, int line, const char* tag) {
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    FreelistAllocatorData* size_class = size_class_for(data, size);
+    if (!size_class) {
+        return data->large->alloc(data->large, size, flags, file, line, tag);
+    }
+    return freelist_take(size_class, flags);
+}
+
+static void size_class_free(Allocator* allocator, void* ptr, size_t size, const char* file, int line) {
+    if (!ptr) return;
+    
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    FreelistAllocatorData* size_class = size_class_for(data, size);
+    if (!size_class) {
+        data->large->free(data->large, ptr, size, file, line);
+        return;
+    }
+    freelist_give(size_class, ptr);
+}
+
+static void* size_class_realloc(Allocator* allocator, void* ptr, size_t old_size, size_t new_size, const char* file, int line, const char* tag) {
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    if (!ptr) {
+        return size_class_alloc(allocator, new_size, ALLOC_FLAG_NONE, file, line, tag);
+    }
+    
+    if (new_size == 0) {
+        size_class_free(allocator, ptr, old_size, file, line);
+        return NULL;
+    }
+    
+    FreelistAllocatorData* old_class = size_class_for(data, old_size);
+    FreelistAllocatorData* new_class = size_class_for(data, new_size);
+    
+    // Still fits its block
+    if (old_class && old_class == new_class) {
+        return ptr;
+    }
+    
+    // Both large: let the platform allocator grow in place if it can
+    if (!old_class && !new_class) {
+        return data->large->realloc(data->large, ptr, old_size, new_size, file, line, tag);
+    }
+    
+    void* new_ptr = size_class_alloc(allocator, new_size, ALLOC_FLAG_NONE, file, line, tag);
+    if (!new_ptr) return NULL;
+    
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    size_class_free(allocator, ptr, old_size, file, line);
+    return new_ptr;
+}
+
+static void size_class_reset(Allocator* allocator) {
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        freelist_reset_data(&data->classes[i]);
+    }
+    data->large->reset(data->large);
+}
+
+static void size_class_destroy(Allocator* allocator) {
+    if (!allocator) return;
+    
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        freelist_free_chunks(&data->classes[i]);
+    }
+    data->large->destroy(data->large);
+    
+    free(data);
+    free(allocator);
+}
+
+// Totals over every class plus the large-object fallback. total_allocated counts
+// the chunks taken from the system, not the blocks handed out.
+static AllocatorStats size_class_get_stats(Allocator* allocator) {
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    
+    AllocatorStats total = data->large->get_stats(data->large);
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        AllocatorStats* stats = &data->classes[i].stats;
+        total.total_allocated += stats->total_allocated;
+        total.total_freed += stats->total_freed;
+        total.current_usage += stats->current_usage;
+        total.peak_usage += stats->peak_usage;
+        total.allocation_count += stats->allocation_count;
+        total.free_count += stats->free_count;
+    }
+    return total;
+}
+
+static char* size_class_format_stats(Allocator* allocator) {
+    SizeClassAllocatorData* data = (SizeClassAllocatorData*)allocator->data;
+    AllocatorStats large = data->large->get_stats(data->large);
+    
+    size_t capacity = 2048;
+    char* buffer = malloc(capacity);
+    if (!buffer) return NULL;
+    
+    int len = snprintf(buffer, capacity,
+        "=== Size-Class Allocator Stats ===\n"
+        "Class    Chunks  Used Blocks  Peak Usage    Allocations\n");
+    
+    size_t chunks = 0;
+    for (size_t i = 0; i < SIZE_CLASS_COUNT && len > 0 && (size_t)len < capacity; i++) {
+        FreelistAllocatorData* size_class = &data->classes[i];
+        chunks += size_class->chunk_count;
+        if (size_class->stats.allocation_count == 0) continue;
+        
+        len += snprintf(buffer + len, capacity - len,
+            "%-8zu %-7zu %-12zu %-13zu %zu\n",
+            size_class->block_size,
+            size_class->chunk_count,
+            size_class->stats.current_usage / size_class->block_size,
+            size_class->stats.peak_usage,
+            size_class->stats.allocation_count);
+    }
+    
+    if (len > 0 && (size_t)len < capacity) {
+        snprintf(buffer + len, capacity - len,
+            "Large (>%d): %zu allocations, %zu bytes in use\n"
+            "System allocations: %zu (%zu chunks)\n"
+            "==================================",
+            SIZE_CLASS_MAX,
+            large.allocation_count,
+            large.current_usage,
+            chunks + large.allocation_count,
+            chunks);
+    }
+    
+    return buffer;
+}
+
+// Create size-class allocator
+Allocator* mem_create_size_class_allocator(size_t chunk_size) {
+    Allocator* allocator = calloc(1, sizeof(Allocator));
+    if (!allocator) return NULL;
+    
+    SizeClassAllocatorData* data = calloc(1, sizeof(SizeClassAllocatorData));
+    if (!data) {
+        free(allocator);
+        return NULL;
+    }
+    
+    data->large = mem_create_platform_allocator();
+    if (!data->large) {
+        free(data);
+        free(allocator);
+        return NULL;
+    }
+    
+    size_t current = 0;
+    for (size_t granules = 0; granules <= SIZE_CLASS_MAX / SIZE_CLASS_GRANULE; granules++) {
+        while (size_classes[current] < granules * SIZE_CLASS_GRANULE) {
+            current++;
+        }
+        data->class_of[granules] = (uint8_t)current;
+    }
+    
+    // Chunks are about `chunk_size` bytes whatever the class, but never hold too few
+    // blocks to be worth a malloc
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; i++) {
+        size_t blocks = chunk_size / size_classes[i];
+        data->classes[i].block_size = size_classes[i];
+        data->classes[i].blocks_per_chunk = blocks < SIZE_CLASS_MIN_BLOCKS ? SIZE_CLASS_MIN_BLOCKS : blocks;
+    }
+    
+    allocator->type = ALLOCATOR_SIZE_CLASS;
+    allocator->alloc = size_class_alloc;
+    allocator->realloc = size_class_realloc;
+    allocator->free = size_class_free;
+    allocator->reset = size_class_reset;
+    allocator->destroy = size_class_destroy;
+    allocator->get_stats = size_class_get_stats;
+    allocator->format_stats = size_class_format_stats;
+    allocator->data = data;
+    
+    return allocator;
+}
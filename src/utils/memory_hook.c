@@ -0,0 +1,84 @@
+#include "utils/memory.h"
+#include <stdlib.h>
+
+typedef struct {
+    Allocator* backing;
+    MemAllocHook hook;
+    void* user_data;
+} HookAllocatorData;
+
+static void* hook_alloc(Allocator* allocator, size_t size, AllocFlags flags, const char* file, int line, const char* tag) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    data->hook(size, tag, data->user_data);
+    return data->backing->alloc(data->backing, size, flags, file, line, tag);
+}
+
+static void* hook_realloc(Allocator* allocator, void* ptr, size_t old_size, size_t new_size, const char* file, int line, const char* tag) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    if (new_size > old_size) {
+        data->hook(new_size, tag, data->user_data);
+    }
+    return data->backing->realloc(data->backing, ptr, old_size, new_size, file, line, tag);
+}
+
+static void hook_free(Allocator* allocator, void* ptr, size_t size, const char* file, int line) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    data->backing->free(data->backing, ptr, size, file, line);
+}
+
+static void hook_reset(Allocator* allocator) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    if (data->backing->reset) {
+        data->backing->reset(data->backing);
+    }
+}
+
+static void hook_destroy(Allocator* allocator) {
+    if (!allocator) return;
+    free(allocator->data);
+    free(allocator);
+}
+
+static AllocatorStats hook_get_stats(Allocator* allocator) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    return mem_get_stats(data->backing);
+}
+
+static char* hook_format_stats(Allocator* allocator) {
+    HookAllocatorData* data = (HookAllocatorData*)allocator->data;
+    return mem_format_stats(data->backing);
+}
+
+Allocator* mem_create_hook_allocator(Allocator* backing_allocator, MemAllocHook hook, void* user_data) {
+    if (!backing_allocator || !hook) return NULL;
+    
+    Allocator* allocator = calloc(1, sizeof(Allocator));
+    if (!allocator) return NULL;
+    
+    HookAllocatorData* data = calloc(1, sizeof(HookAllocatorData));
+    if (!data) {
+        free(allocator);
+        return NULL;
+    }
+    
+    data->backing = backing_allocator;
+    data->hook = hook;
+    data->user_data = user_data;
+    
+    allocator->type = ALLOCATOR_HOOK;
+    allocator->alloc = hook_alloc;
+    allocator->realloc = hook_realloc;
+    allocator->free = hook_free;
+    allocator->reset = hook_reset;
+    allocator->destroy = hook_destroy;
+    allocator->get_stats = hook_get_stats;
+    allocator->format_stats = hook_format_stats;
+    allocator->data = data;
+    
+    return allocator;
+}
+
+Allocator* mem_hook_allocator_backing(Allocator* allocator) {
+    if (!allocator || allocator->type != ALLOCATOR_HOOK) return NULL;
+    return ((HookAllocatorData*)allocator->data)->backing;
+}
@@ -5,8 +5,32 @@
 #include "utils/test_macros.h"
 #include "parser/parser.h"
 #include "codegen/compiler.h"
+#include "codegen/superinstructions.h"
 #include "runtime/core/vm.h"
+#include "runtime/core/alloc_profiler.h"
+#include "runtime/core/gc.h"
 #include "debug/debug.h"
+#include "utils/allocators.h"
+#include "stdlib/stdlib.h"
+
+// Value of a numeric script global, or -1 if it is missing
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
+static const char* global_string(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_STRING(vm->globals.values[i])) {
+            return string_chars(AS_STRING(vm->globals.values[i]));
+        }
+    }
+    return NULL;
+}
 
 DEFINE_TEST(simple_arithmetic) {
     const char* source = "1 + 2 * 3;"; // Should evaluate to 7
@@ -276,6 +300,842 @@ DEFINE_TEST(scoped_variables) {
     parser_destroy(parser);
 }
 
+DEFINE_TEST(global_slots) {
+    // Slot caches must survive the globals table growing between accesses
+    const char* source =
+        "var total = 0;"
+        "var i = 0;"
+        "while (i < 10) { total = total + i; i = i + 1; }"
+        "var g0 = 1; var g1 = 1; var g2 = 1; var g3 = 1; var g4 = 1;"
+        "var g5 = 1; var g6 = 1; var g7 = 1; var g8 = 1; var g9 = 1;"
+        "var g10 = 1; var g11 = 1; var g12 = 1; var g13 = 1; var g14 = 1;"
+        "i = 0;"
+        "while (i < 5) { total = total + g14; i = i + 1; }";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "global_slots");
+    TEST_ASSERT(suite, !parser->had_error, "global_slots");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "global_slots");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "global_slots");
+    
+    TEST_ASSERT(suite, global_number(&vm, "total") == 50, "global_slots");
+    
+    // Reads of names that were never defined still fail at runtime
+    Parser* missing_parser = parser_create("var y = missing + 1;");
+    ProgramNode* missing_program = parser_parse_program(missing_parser);
+    Chunk missing_chunk;
+    chunk_init(&missing_chunk);
+    TEST_ASSERT(suite, compile(missing_program, &missing_chunk), "global_slots");
+    result = vm_interpret(&vm, &missing_chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_RUNTIME_ERROR, result, "global_slots");
+    
+    // Each VM invalidates only its own slot caches, and one created after
+    // another is freed starts past the epochs the freed one used
+    uint32_t epoch = vm.global_cache_epoch;
+    VM other;
+    vm_init(&other);
+    define_global(&other, "elsewhere", NUMBER_VAL(1));
+    TEST_ASSERT(suite, vm.global_cache_epoch == epoch, "global_slots");
+    uint32_t other_epoch = other.global_cache_epoch;
+    vm_free(&other);
+    VM next;
+    vm_init(&next);
+    TEST_ASSERT(suite, next.global_cache_epoch > other_epoch, "global_slots");
+    vm_free(&next);
+    
+    // Clean up
+    vm_free(&vm);
+    chunk_free(&missing_chunk);
+    chunk_free(&chunk);
+    program_destroy(missing_program);
+    parser_destroy(missing_parser);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(inline_caches) {
+    // One call site sees two receiver types and goes polymorphic
+    const char* source =
+        "func Number.tag() { return 1 }"
+        "func String.tag() { return 10 }"
+        "func probe(x) { return x.tag() }"
+        "var first = probe(1) + probe(2) + probe(3);"
+        "var second = probe(\"a\") + probe(4);";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "inline_caches");
+    TEST_ASSERT(suite, !parser->had_error, "inline_caches");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "inline_caches");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "inline_caches");
+    TEST_ASSERT(suite, global_number(&vm, "first") == 3, "inline_caches");
+    TEST_ASSERT(suite, global_number(&vm, "second") == 11, "inline_caches");
+    
+    InlineCache* ic = NULL;
+    for (size_t i = 0; i < chunk.constants.count; i++) {
+        TaggedValue constant = chunk.constants.values[i];
+        if (IS_FUNCTION(constant) && strcmp(AS_FUNCTION(constant)->name, "probe") == 0) {
+            Chunk* probe = &AS_FUNCTION(constant)->chunk;
+            ic = probe->inline_cache_count == 1 ? &probe->inline_caches[0] : NULL;
+        }
+    }
+    TEST_ASSERT_NOT_NULL(suite, ic, "inline_caches");
+    TEST_ASSERT(suite, ic && ic->count == 2, "inline_caches");
+    TEST_ASSERT(suite, ic && ic->hits == 3 && ic->misses == 2, "inline_caches");
+    
+    // Clean up
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(dense_arrays) {
+    const char* source =
+        "var a = [1, 2];"
+        "a.push(3);"
+        "a.push(4);"
+        "var popped = a.pop();"
+        "a[6] = 7;"
+        "var len = a.length;"
+        "var count = a.count();"
+        "var holes = a[4] == nil && a[5] == nil && a[99] == nil;"
+        "var sum = a[0] + a[1] + a[2] + a[6];";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "dense_arrays");
+    TEST_ASSERT(suite, !parser->had_error, "dense_arrays");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "dense_arrays");
+    
+    VM vm;
+    vm_init(&vm);
+    stdlib_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "dense_arrays");
+    TEST_ASSERT(suite, global_number(&vm, "popped") == 4, "dense_arrays");
+    TEST_ASSERT(suite, global_number(&vm, "len") == 7, "dense_arrays");
+    TEST_ASSERT(suite, global_number(&vm, "count") == 7, "dense_arrays");
+    TEST_ASSERT(suite, global_number(&vm, "sum") == 13, "dense_arrays");
+    
+    bool holes = false;
+    for (size_t i = 0; i < vm.globals.count; i++) {
+        if (strcmp(vm.globals.names[i], "holes") == 0) {
+            holes = IS_BOOL(vm.globals.values[i]) && AS_BOOL(vm.globals.values[i]);
+        }
+    }
+    TEST_ASSERT(suite, holes, "dense_arrays");
+    
+    // Clean up
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(deep_recursion) {
+    // map() re-enters the VM and grows the stack under its own arguments
+    const char* source =
+        "func depth(n) {"
+        "    if n == 0 { return 0 }"
+        "    return 1 + depth(n - 1)"
+        "}"
+        "var deep = depth(5000);"
+        "var mapped = [10, 3000].map(depth);"
+        "var total = mapped[0] + mapped[1];";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "deep_recursion");
+    TEST_ASSERT(suite, !parser->had_error, "deep_recursion");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "deep_recursion");
+    
+    VM vm;
+    vm_init(&vm);
+    stdlib_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "deep_recursion");
+    TEST_ASSERT(suite, global_number(&vm, "deep") == 5000, "deep_recursion");
+    TEST_ASSERT(suite, global_number(&vm, "total") == 3010, "deep_recursion");
+    TEST_ASSERT(suite, vm.frame_capacity > VM_FRAMES_INITIAL, "deep_recursion");
+    vm_free(&vm);
+    
+    // A configured frame limit turns runaway recursion into an error
+    Chunk limited_chunk;
+    chunk_init(&limited_chunk);
+    TEST_ASSERT(suite, compile(program, &limited_chunk), "deep_recursion");
+    
+    VM limited;
+    vm_init(&limited);
+    vm_set_stack_limits(&limited, VM_STACK_LIMIT, 100);
+    result = vm_interpret(&limited, &limited_chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_RUNTIME_ERROR, result, "deep_recursion");
+    TEST_ASSERT(suite, limited.frame_capacity <= 100, "deep_recursion");
+    
+    // Clean up
+    vm_free(&limited);
+    chunk_free(&limited_chunk);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+// Chunk of the function constant called `name`
+static Chunk* function_chunk(Chunk* chunk, const char* name) {
+    for (size_t i = 0; i < chunk->constants.count; i++) {
+        TaggedValue constant = chunk->constants.values[i];
+        if (IS_FUNCTION(constant) && strcmp(AS_FUNCTION(constant)->name, name) == 0) {
+            return &AS_FUNCTION(constant)->chunk;
+        }
+    }
+    return NULL;
+}
+
+static bool chunk_has_opcode(Chunk* chunk, uint8_t op) {
+    return chunk && memchr(chunk->code, op, chunk->count) != NULL;
+}
+
+DEFINE_TEST(quickening) {
+    // count() stays numeric; join() sees numbers first, then strings
+    const char* source =
+        "func count(n) {"
+        "    var i = 0;"
+        "    while i < n { i = i + 1 }"
+        "    return i"
+        "}"
+        "func join(a, b) { return a + b }"
+        "var counted = count(50);"
+        "var sum = join(1, 2);"
+        "var text = join(\"a\", \"b\");"
+        "var again = join(3, 4);";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "quickening");
+    TEST_ASSERT(suite, !parser->had_error, "quickening");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "quickening");
+    
+    Chunk* count = function_chunk(&chunk, "count");
+    Chunk* join = function_chunk(&chunk, "join");
+    TEST_ASSERT(suite, chunk_has_opcode(count, OP_LESS), "quickening");
+    TEST_ASSERT(suite, !chunk_has_opcode(count, OP_LESS_NUM), "quickening");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "quickening");
+    TEST_ASSERT(suite, global_number(&vm, "counted") == 50, "quickening");
+    TEST_ASSERT(suite, global_number(&vm, "sum") == 3, "quickening");
+    
+    const char* text = NULL;
+    for (size_t i = 0; i < vm.globals.count; i++) {
+        if (strcmp(vm.globals.names[i], "text") == 0 && IS_STRING(vm.globals.values[i])) {
+            text = AS_STRING(vm.globals.values[i]);
+        }
+    }
+    TEST_ASSERT(suite, text && strcmp(text, "ab") == 0, "quickening");
+    
+    TEST_ASSERT(suite, global_number(&vm, "again") == 7, "quickening");
+    
+    // The loop sites were specialized; the string call made join()'s add
+    // generic, and the numbers after it did not specialize it again
+    TEST_ASSERT(suite, chunk_has_opcode(count, OP_LESS_NUM), "quickening");
+    TEST_ASSERT(suite, chunk_has_opcode(count, OP_ADD_NUM), "quickening");
+    TEST_ASSERT(suite, chunk_has_opcode(join, OP_ADD_GENERIC), "quickening");
+    TEST_ASSERT(suite, !chunk_has_opcode(join, OP_ADD_NUM), "quickening");
+    
+    // Clean up
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(superinstructions) {
+    const char* source =
+        "func pick(a, b) {"
+        "    var r = 0;"
+        "    if a < b { r = a } else { r = b }"
+        "    return r"
+        "}"
+        "func sumTo(n) {"
+        "    var s = 0;"
+        "    var i = 0;"
+        "    while i < n { s = s + i; i = i + 1 }"
+        "    return s"
+        "}"
+        "var lo = pick(3, 9);"
+        "var hi = pick(9, 3);"
+        "var total = sumTo(100);";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "superinstructions");
+    TEST_ASSERT(suite, !parser->had_error, "superinstructions");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "superinstructions");
+    
+    Chunk* sum_to = function_chunk(&chunk, "sumTo");
+    TEST_ASSERT_NOT_NULL(suite, sum_to, "superinstructions");
+    TEST_ASSERT(suite, chunk_has_opcode(sum_to, OP_GET_LOCAL_PAIR), "superinstructions");
+    TEST_ASSERT(suite, chunk_has_opcode(sum_to, OP_GET_LOCAL_CONSTANT), "superinstructions");
+    TEST_ASSERT(suite, chunk_has_opcode(sum_to, OP_SET_LOCAL_POP), "superinstructions");
+    TEST_ASSERT(suite, chunk_has_opcode(sum_to, OP_JUMP_IF_FALSE_POP), "superinstructions");
+    
+    // Fused instructions keep the original layout, so the chunk still
+    // decodes end to end
+    size_t offset = 0;
+    while (sum_to && offset < sum_to->count) {
+        size_t length = chunk_instruction_length(sum_to, offset);
+        if (length == 0) break;
+        offset += length;
+    }
+    TEST_ASSERT(suite, sum_to && offset == sum_to->count, "superinstructions");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "superinstructions");
+    TEST_ASSERT(suite, global_number(&vm, "lo") == 3, "superinstructions");
+    TEST_ASSERT(suite, global_number(&vm, "hi") == 3, "superinstructions");
+    TEST_ASSERT(suite, global_number(&vm, "total") == 4950, "superinstructions");
+    
+    // Clean up
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(tail_calls) {
+    // Self and mutual recursion far deeper than the frame limit below, plus a
+    // tail call made while a local is still captured by a closure
+    const char* source =
+        "func count(n, acc) {"
+        "    if n == 0 { return acc }"
+        "    return count(n - 1, acc + 1)"
+        "}"
+        "func isEven(n) {"
+        "    if n == 0 { return true }"
+        "    return isOdd(n - 1)"
+        "}"
+        "func isOdd(n) {"
+        "    if n == 0 { return false }"
+        "    return isEven(n - 1)"
+        "}"
+        "func apply(f, x) { return f(x) }"
+        "func addBase(base) {"
+        "    var add = { x in x + base };"
+        "    return apply(add, 1)"
+        "}"
+        "var counted = count(100000, 0);"
+        "var even = 0;"
+        "if isEven(10000) { even = 1 }"
+        "var added = addBase(41);";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "tail_calls");
+    TEST_ASSERT(suite, !parser->had_error, "tail_calls");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "tail_calls");
+    TEST_ASSERT(suite, chunk_has_opcode(function_chunk(&chunk, "count"), OP_TAIL_CALL), "tail_calls");
+    TEST_ASSERT(suite, chunk_has_opcode(function_chunk(&chunk, "isOdd"), OP_TAIL_CALL), "tail_calls");
+    
+    VM vm;
+    vm_init(&vm);
+    vm_set_stack_limits(&vm, VM_STACK_LIMIT, 16);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "tail_calls");
+    TEST_ASSERT(suite, global_number(&vm, "counted") == 100000, "tail_calls");
+    TEST_ASSERT(suite, global_number(&vm, "even") == 1, "tail_calls");
+    TEST_ASSERT(suite, global_number(&vm, "added") == 42, "tail_calls");
+    
+    // A tail-recursive loop that keeps what it allocates is stopped at the
+    // heap limit, as a loop would be
+    Parser* alloc_parser = parser_create(
+        "func grow(items, n) {"
+        "    items.push({ \"n\": n })"
+        "    return grow(items, n + 1)"
+        "}"
+        "grow([], 0);");
+    ProgramNode* alloc_program = parser_parse_program(alloc_parser);
+    Chunk alloc_chunk;
+    chunk_init(&alloc_chunk);
+    TEST_ASSERT(suite, compile(alloc_program, &alloc_chunk), "tail_calls");
+    TEST_ASSERT(suite, chunk_has_opcode(function_chunk(&alloc_chunk, "grow"), OP_TAIL_CALL), "tail_calls");
+    
+    VM limited;
+    vm_init(&limited);
+    gc_set_max_heap(limited.gc, 256 * 1024);
+    result = vm_interpret(&limited, &alloc_chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_RUNTIME_ERROR, result, "tail_calls");
+    TEST_ASSERT(suite, gc_get_stats(limited.gc).heap_limit_exceeded > 0, "tail_calls");
+    
+    // Clean up
+    vm_free(&limited);
+    chunk_free(&alloc_chunk);
+    program_destroy(alloc_program);
+    parser_destroy(alloc_parser);
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(string_building) {
+    // A + chain with a string literal is joined in one step; StringBuilder
+    // does the same across statements. Numeric chains still add.
+    const char* source =
+        "var name = \"x\";"
+        "var line = \"name: \" + name + \", n=\" + \"1\";"
+        "var sum = 1 + 2 + 3;"
+        "var chained = 0;"
+        "if line == \"name: x, n=1\" { chained = 1 }"
+        "var sb = StringBuilder();"
+        "var i = 0;"
+        "while i < 100 {"
+        "    sb.append(\"ab\").append(i);"
+        "    i = i + 1"
+        "}"
+        "var built = sb.length();"
+        "var text = sb.toString();"
+        "var same = 0;"
+        "if text == sb.toString() { same = 1 }"
+        "var length = text.length;"
+        "var digits = StringBuilder().append(42).toString();";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "string_building");
+    TEST_ASSERT(suite, !parser->had_error, "string_building");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    
+    bool compiled = compile(program, &chunk);
+    TEST_ASSERT(suite, compiled, "string_building");
+    TEST_ASSERT(suite, chunk_has_opcode(&chunk, OP_ADD_CHAIN), "string_building");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "string_building");
+    TEST_ASSERT(suite, global_number(&vm, "chained") == 1, "string_building");
+    TEST_ASSERT(suite, global_number(&vm, "sum") == 6, "string_building");
+    // 100 * "ab" plus the digits of 0..99
+    TEST_ASSERT(suite, global_number(&vm, "built") == 390, "string_building");
+    TEST_ASSERT(suite, global_number(&vm, "length") == 390, "string_building");
+    TEST_ASSERT(suite, global_number(&vm, "same") == 1, "string_building");
+    // What the builder makes is owned by the pool, to be collected
+    const char* text = global_string(&vm, "text");
+    const char* digits = global_string(&vm, "digits");
+    TEST_ASSERT(suite, text && string_is_interned(text), "string_building");
+    TEST_ASSERT(suite, digits && string_is_interned(digits) && strcmp(digits, "42") == 0,
+                "string_building");
+    
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(string_chain_order) {
+    // Past its first string literal a + chain is joined in one step, but a
+    // piece that is not a string still fails before the next one runs, and
+    // whatever comes ahead of the literal is added pairwise as usual
+    const char* source =
+        "var called = 0;"
+        "func mark() { called = 1; return \"!\" }"
+        "var a = 1;"
+        "var s = \"x\";"
+        "var tail = s + s + \"-\" + s + mark();"
+        "called = 0;"
+        "var line = \"n=\" + a + mark() + \"?\";";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "string_chain_order");
+    TEST_ASSERT(suite, !parser->had_error, "string_chain_order");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "string_chain_order");
+    TEST_ASSERT(suite, chunk_has_opcode(&chunk, OP_ADD_CHAIN), "string_chain_order");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_RUNTIME_ERROR, result, "string_chain_order");
+    const char* tail = global_string(&vm, "tail");
+    TEST_ASSERT(suite, tail && strcmp(tail, "xx-x!") == 0, "string_chain_order");
+    TEST_ASSERT(suite, chunk_has_opcode(&chunk, OP_EXPECT_STRING), "string_chain_order");
+    // "n=" + 1 fails; mark() must not have been called
+    TEST_ASSERT(suite, global_number(&vm, "called") == 0, "string_chain_order");
+    
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(string_collection) {
+    // Each iteration interns a new line and drops the last one; a couple of
+    // megabytes of them must set off collections that leave the reachable
+    // strings intact
+    const char* source =
+        "var i = 0\n"
+        "var first = \"kept ${i}\"\n"
+        "var line = \"\"\n"
+        "var total = 0\n"
+        "while i < 50000 {\n"
+        "    line = \"line ${i} of some text long enough to add up\"\n"
+        "    total = total + line.length\n"
+        "    i = i + 1\n"
+        "}\n"
+        "var ok = 0\n"
+        "if first == \"kept 0\" && line == \"line 49999 of some text long enough to add up\" { ok = 1 }\n";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "string_collection");
+    TEST_ASSERT(suite, !parser->had_error, "string_collection");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "string_collection");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "string_collection");
+    TEST_ASSERT(suite, global_number(&vm, "ok") == 1, "string_collection");
+    TEST_ASSERT(suite, vm.gc != NULL, "string_collection");
+    if (vm.gc) {
+        GCStats stats = gc_get_stats(vm.gc);
+        TEST_ASSERT(suite, stats.strings_freed > 0, "string_collection");
+        TEST_ASSERT(suite, vm.strings.bytes <= 2 * vm.gc->config.gc_threshold, "string_collection");
+    }
+    
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(string_accumulation) {
+    // Appending to a long string makes a rope rather than copying it, so
+    // these loops allocate about as much as they end up holding. Copying
+    // on every append would be some 2 GB for the global alone.
+    const char* source =
+        "var text = \"\"\n"
+        "var i = 0\n"
+        "while i < 20000 {\n"
+        "    text = text + \"0123456789\"\n"
+        "    i = i + 1\n"
+        "}\n"
+        "var length = text.length\n"
+        "func build(n) {\n"
+        "    var local = \"\"\n"
+        "    var j = 0\n"
+        "    while j < n {\n"
+        "        local = local + \"ab\" + \"c\"\n"
+        "        j = j + 1\n"
+        "    }\n"
+        "    return local\n"
+        "}\n"
+        "var built = build(20000)\n"
+        "var ok = 0\n"
+        "if built == build(20000) && built.length == 60000 { ok = 1 }\n";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "string_accumulation");
+    TEST_ASSERT(suite, !parser->had_error, "string_accumulation");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "string_accumulation");
+    
+    VM vm;
+    vm_init(&vm);
+    
+    Allocator* strings = allocators_get(ALLOC_SYSTEM_STRINGS);
+    size_t allocated = mem_get_stats(strings).total_allocated;
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    allocated = mem_get_stats(strings).total_allocated - allocated;
+    
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "string_accumulation");
+    TEST_ASSERT(suite, global_number(&vm, "length") == 200000, "string_accumulation");
+    TEST_ASSERT(suite, global_number(&vm, "ok") == 1, "string_accumulation");
+    TEST_ASSERT(suite, allocated > 0 && allocated < 64 * 200000, "string_accumulation");
+    
+    const char* text = global_string(&vm, "text");
+    TEST_ASSERT(suite, text && strncmp(text + 199990, "0123456789", 11) == 0, "string_accumulation");
+    
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
+DEFINE_TEST(large_literals) {
+    // More elements than a frame gets as headroom, and than fit in one
+    // OP_ARRAY, at the top level, in a function and nested; the names after
+    // them need constant slots beyond the literals' 600 values
+    enum { COUNT = 600 };
+    char elements[16 * COUNT];
+    char strings[16 * COUNT];
+    size_t capacity = 2 * sizeof(elements) + sizeof(strings) + 256;
+    char* source = malloc(capacity);
+    TEST_ASSERT_NOT_NULL(suite, source, "large_literals");
+    size_t length = 0;
+    size_t string_length = 0;
+    for (int i = 0; i < COUNT; i++) {
+        length += snprintf(elements + length, sizeof(elements) - length,
+                           i ? ", %d" : "%d", i);
+        string_length += snprintf(strings + string_length, sizeof(strings) - string_length,
+                                  i ? ", \"s%d\"" : "\"s%d\"", i);
+    }
+    snprintf(source, capacity,
+             "var top = [%s]\n"
+             "func local() {\n"
+             "    var values = [%s]\n"
+             "    return values.length + values[%d]\n"
+             "}\n"
+             "var sum = local()\n"
+             "var nested = [[1, 2], [%s]]\n"
+             "var last = nested[1][%d]\n"
+             "var count = top.length\n",
+             elements, elements, COUNT - 1, strings, COUNT - 1);
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "large_literals");
+    TEST_ASSERT(suite, !parser->had_error, "large_literals");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "large_literals");
+    
+    VM vm;
+    vm_init(&vm);
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "large_literals");
+    TEST_ASSERT(suite, global_number(&vm, "count") == COUNT, "large_literals");
+    TEST_ASSERT(suite, global_number(&vm, "sum") == 2 * COUNT - 1, "large_literals");
+    const char* last = global_string(&vm, "last");
+    TEST_ASSERT(suite, last && strcmp(last, "s599") == 0, "large_literals");
+    
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+    free(source);
+}
+
+DEFINE_TEST(large_module) {
+    // A thousand functions and five hundred exports give the script chunk
+    // thousands of constants; every name has to keep its own
+    FILE* file = fopen(SLANG_SOURCE_DIR "/large_module_1000.swift", "rb");
+    TEST_ASSERT_NOT_NULL(suite, file, "large_module");
+    if (!file) return;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    char* source = malloc((size_t)size + 1);
+    TEST_ASSERT_NOT_NULL(suite, source, "large_module");
+    size_t length = fread(source, 1, (size_t)size, file);
+    source[length] = '\0';
+    fclose(file);
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "large_module");
+    TEST_ASSERT(suite, !parser->had_error, "large_module");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "large_module");
+    TEST_ASSERT(suite, chunk.constants.count > 2000, "large_module");
+    
+    VM vm;
+    vm_init(&vm);
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "large_module");
+    
+    // The first and last definitions are both reachable by name
+    Parser* call_parser = parser_create(
+        "var first = privateHelper0(7)\n"
+        "var last = publicFunction499(3, 4)\n"
+        "var helper = privateHelper499(2)\n");
+    ProgramNode* call_program = parser_parse_program(call_parser);
+    Chunk call_chunk;
+    chunk_init(&call_chunk);
+    TEST_ASSERT(suite, compile(call_program, &call_chunk), "large_module");
+    result = vm_interpret(&vm, &call_chunk);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "large_module");
+    TEST_ASSERT(suite, global_number(&vm, "first") == 7, "large_module");
+    TEST_ASSERT(suite, global_number(&vm, "last") == 34, "large_module");
+    TEST_ASSERT(suite, global_number(&vm, "helper") == 1000, "large_module");
+    
+    vm_free(&vm);
+    chunk_free(&call_chunk);
+    chunk_free(&chunk);
+    program_destroy(call_program);
+    parser_destroy(call_parser);
+    program_destroy(program);
+    parser_destroy(parser);
+    free(source);
+}
+
+DEFINE_TEST(constant_overflow) {
+    // Struct names still take a one-byte index; running out of them must
+    // fail the compile rather than point later names at constant 0
+    enum { COUNT = 300 };
+    char* source = malloc(COUNT * 40);
+    TEST_ASSERT_NOT_NULL(suite, source, "constant_overflow");
+    size_t length = 0;
+    for (int i = 0; i < COUNT; i++) {
+        length += snprintf(source + length, COUNT * 40 - length,
+                           "struct S%d { var a: Number }\n", i);
+    }
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "constant_overflow");
+    TEST_ASSERT(suite, !parser->had_error, "constant_overflow");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, !compile(program, &chunk), "constant_overflow");
+    
+    // The next compile starts clean
+    Parser* small_parser = parser_create("var x = 1;");
+    ProgramNode* small_program = parser_parse_program(small_parser);
+    Chunk small_chunk;
+    chunk_init(&small_chunk);
+    TEST_ASSERT(suite, compile(small_program, &small_chunk), "constant_overflow");
+    
+    chunk_free(&small_chunk);
+    chunk_free(&chunk);
+    program_destroy(small_program);
+    parser_destroy(small_parser);
+    program_destroy(program);
+    parser_destroy(parser);
+    free(source);
+}
+
+DEFINE_TEST(alloc_profile) {
+    // Every allocation recorded, so the object literal's line must show up
+    // under both calls on the stack
+    const char* source =
+        "func makePair(n) {\n"
+        "    var tag = \"pair\" + \"!\"\n"
+        "    return { \"first\": n, \"second\": tag }\n"
+        "}\n"
+        "func build(count) {\n"
+        "    var last = nil\n"
+        "    var i = 0\n"
+        "    while i < count { last = makePair(i); i = i + 1 }\n"
+        "    return last\n"
+        "}\n"
+        "var result = build(100)\n";
+    
+    Parser* parser = parser_create(source);
+    ProgramNode* program = parser_parse_program(parser);
+    TEST_ASSERT_NOT_NULL(suite, program, "alloc_profile");
+    TEST_ASSERT(suite, !parser->had_error, "alloc_profile");
+    
+    Chunk chunk;
+    chunk_init(&chunk);
+    TEST_ASSERT(suite, compile(program, &chunk), "alloc_profile");
+    
+    VM vm;
+    vm_init(&vm);
+    AllocProfiler* profiler = alloc_profiler_create(&vm, 0, "profile.swift");
+    TEST_ASSERT_NOT_NULL(suite, profiler, "alloc_profile");
+    InterpretResult result = vm_interpret(&vm, &chunk);
+    alloc_profiler_stop(profiler);
+    TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "alloc_profile");
+    
+    FILE* out = tmpfile();
+    TEST_ASSERT_NOT_NULL(suite, out, "alloc_profile");
+    TEST_ASSERT(suite, alloc_profiler_write_folded(profiler, out), "alloc_profile");
+    char folded[4096] = {0};
+    rewind(out);
+    size_t read = fread(folded, 1, sizeof(folded) - 1, out);
+    folded[read] = '\0';
+    TEST_ASSERT(suite, strstr(folded, "<script>:11;build:8;makePair:3;[object] ") != NULL, "alloc_profile");
+    TEST_ASSERT(suite, strstr(folded, "build:8;makePair:2;[string] ") != NULL, "alloc_profile");
+    
+    // A profile.proto message starts with its first sample_type field
+    rewind(out);
+    TEST_ASSERT(suite, alloc_profiler_write_pprof(profiler, out), "alloc_profile");
+    rewind(out);
+    TEST_ASSERT_EQUAL_INT(suite, 0x0a, fgetc(out), "alloc_profile");
+    fclose(out);
+    
+    alloc_profiler_destroy(profiler);
+    vm_free(&vm);
+    chunk_free(&chunk);
+    program_destroy(program);
+    parser_destroy(parser);
+}
+
 // Define test suite
 TEST_SUITE(integration)
     TEST_CASE(simple_arithmetic, "Simple Arithmetic")
@@ -287,6 +1147,21 @@ TEST_SUITE(integration)
     TEST_CASE(multiline_strings, "Multi-line Strings")
     TEST_CASE(multiline_string_with_interpolation, "Multi-line String with Interpolation")
     TEST_CASE(scoped_variables, "Scoped Variables")
+    TEST_CASE(global_slots, "Global Slots")
+    TEST_CASE(inline_caches, "Inline Caches")
+    TEST_CASE(dense_arrays, "Dense Arrays")
+    TEST_CASE(deep_recursion, "Deep Recursion")
+    TEST_CASE(quickening, "Quickening")
+    TEST_CASE(superinstructions, "Superinstructions")
+    TEST_CASE(tail_calls, "Tail Calls")
+    TEST_CASE(string_building, "String Building")
+    TEST_CASE(string_chain_order, "String Chain Order")
+    TEST_CASE(string_collection, "String Collection")
+    TEST_CASE(string_accumulation, "String Accumulation")
+    TEST_CASE(large_literals, "Large Literals")
+    TEST_CASE(large_module, "Large Module")
+    TEST_CASE(constant_overflow, "Constant Overflow")
+    TEST_CASE(alloc_profile, "Allocation Profile")
 END_TEST_SUITE(integration)
 
 // Optional standalone runner
@@ -1,16 +1,28 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "utils/test_framework.h"
 #include "utils/test_macros.h"
 #include "parser/parser.h"
 #include "codegen/compiler.h"
 #include "runtime/core/vm.h"
 
+// Value of a numeric script global, or -1 if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
 DEFINE_TEST(array_index_assignment) {
     const char* source = 
         "var array = [1, 6, 4];\n"
         "array[0] = array[1];\n"
-        "array[0];\n";
+        "let result = array[0];\n";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -27,9 +39,7 @@ DEFINE_TEST(array_index_assignment) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_index_assignment");
     
     // Check that array[0] now equals 6
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_index_assignment");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 6.0, "array_index_assignment");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 6.0, "array_index_assignment");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -42,7 +52,7 @@ DEFINE_TEST(array_multi_assignment) {
         "var arr = [1, 2, 3, 4, 5];\n"
         "arr[1] = 10;\n"
         "arr[3] = 20;\n"
-        "arr[1] + arr[3];\n";
+        "let result = arr[1] + arr[3];\n";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -59,9 +69,7 @@ DEFINE_TEST(array_multi_assignment) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_multi_assignment");
     
     // Check result - should be 30
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_multi_assignment");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 30.0, "array_multi_assignment");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 30.0, "array_multi_assignment");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -75,7 +83,7 @@ DEFINE_TEST(array_assign_from_expression) {
         "var x = 5;\n"
         "var y = 10;\n"
         "arr[1] = x + y;\n"
-        "arr[1];\n";
+        "let result = arr[1];\n";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -92,9 +100,7 @@ DEFINE_TEST(array_assign_from_expression) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_assign_from_expression");
     
     // Check result - should be 15
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_assign_from_expression");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 15.0, "array_assign_from_expression");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 15.0, "array_assign_from_expression");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -6,11 +6,22 @@
 #include "runtime/core/vm.h"
 #include "codegen/compiler.h"
 
+// Value of a numeric script global, or -1 if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
 DEFINE_TEST(array_map_lambda) {
     const char* source = 
         "let nums = [1, 2, 3, 4, 5]\n"
         "let doubled = nums.map({ x in x * 2 })\n"
-        "doubled.length";
+        "let result = doubled.length";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -29,9 +40,7 @@ DEFINE_TEST(array_map_lambda) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_map_lambda - execution");
     
     // Check result - length should be 5
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_map_lambda - result is number");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 5.0, "array_map_lambda - correct length");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 5.0, "array_map_lambda - correct length");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -44,7 +53,7 @@ DEFINE_TEST(array_map_values) {
         "let nums = [1, 2, 3]\n"
         "let doubled = nums.map({ x in x * 2 })\n"
         "let sum = doubled.reduce({ acc, x in acc + x }, 0)\n"
-        "sum";
+        "let result = sum";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -63,9 +72,7 @@ DEFINE_TEST(array_map_values) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_map_values - execution");
     
     // Check result - sum should be 12 (2+4+6)
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_map_values - result is number");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 12.0, "array_map_values - correct sum");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 12.0, "array_map_values - correct sum");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -77,7 +84,7 @@ DEFINE_TEST(array_filter_lambda) {
     const char* source = 
         "let nums = [1, 2, 3, 4, 5, 6]\n"
         "let evens = nums.filter({ x in x % 2 == 0 })\n"
-        "evens.length";
+        "let result = evens.length";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -96,9 +103,7 @@ DEFINE_TEST(array_filter_lambda) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_filter_lambda - execution");
     
     // Check result - should have 3 even numbers (2, 4, 6)
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_filter_lambda - result is number");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 3.0, "array_filter_lambda - correct count");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "array_filter_lambda - correct count");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -110,7 +115,7 @@ DEFINE_TEST(array_reduce_lambda) {
     const char* source = 
         "let nums = [1, 2, 3, 4, 5]\n"
         "let sum = nums.reduce({ acc, x in acc + x }, 0)\n"
-        "sum";
+        "let result = sum";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -129,9 +134,7 @@ DEFINE_TEST(array_reduce_lambda) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_reduce_lambda - execution");
     
     // Check result - sum should be 15
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_reduce_lambda - result is number");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 15.0, "array_reduce_lambda - correct sum");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 15.0, "array_reduce_lambda - correct sum");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -145,8 +148,7 @@ DEFINE_TEST(array_nested_hof) {
         "let result = nums\n"
         "    .map({ x in x * 2 })\n"
         "    .filter({ x in x > 5 })\n"
-        "    .reduce({ acc, x in acc + x }, 0)\n"
-        "result";
+        "    .reduce({ acc, x in acc + x }, 0)\n";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -165,9 +167,7 @@ DEFINE_TEST(array_nested_hof) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_nested_hof - execution");
     
     // Check result - should be 24 (6+8+10)
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_nested_hof - result is number");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 24.0, "array_nested_hof - correct sum");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 24.0, "array_nested_hof - correct sum");
     
     vm_free(&vm);
     chunk_free(&chunk);
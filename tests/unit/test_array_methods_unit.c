@@ -10,8 +10,19 @@
 #include "runtime/core/vm.h"
 #include "utils/error.h"
 
+// Value of a numeric script global, or -1 if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
 DEFINE_TEST(array_length) {
-    const char* source = "let arr = [1, 2, 3]; arr.length;";
+    const char* source = "let arr = [1, 2, 3]; let result = arr.length;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -33,9 +44,7 @@ DEFINE_TEST(array_length) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_length");
     
     // Check result
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_length");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 3.0, "array_length");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "array_length");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -49,7 +58,7 @@ DEFINE_TEST(array_push) {
     const char* source = 
         "let arr = [1, 2];"
         "arr.push(3);"
-        "arr.length;";
+        "let result = arr.length;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -71,9 +80,7 @@ DEFINE_TEST(array_push) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_push");
     
     // Check result - length should be 3
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_push");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 3.0, "array_push");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "array_push");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -87,7 +94,7 @@ DEFINE_TEST(array_pop) {
     const char* source = 
         "let arr = [1, 2, 3];"
         "let popped = arr.pop();"
-        "popped;";
+        "let result = popped;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -109,9 +116,7 @@ DEFINE_TEST(array_pop) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_pop");
     
     // Check result - should be 3
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_pop");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 3.0, "array_pop");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "array_pop");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -126,7 +131,7 @@ DEFINE_TEST(array_access_and_push) {
         "let arr = [];"
         "arr.push(10);"
         "arr.push(20);"
-        "arr[0] + arr[1];";
+        "let result = arr[0] + arr[1];";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -148,9 +153,7 @@ DEFINE_TEST(array_access_and_push) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_access_and_push");
     
     // Check result - should be 30
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_access_and_push");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 30.0, "array_access_and_push");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 30.0, "array_access_and_push");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -193,7 +196,7 @@ DEFINE_TEST(array_map_native) {
     const char* source = 
         "let arr = [1, 2, 3];"
         "let doubled = arr.map(test_double);"
-        "doubled.length;";
+        "let result = doubled.length;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -220,9 +223,7 @@ DEFINE_TEST(array_map_native) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_map_native");
     
     // Check result - length should be 3
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_map_native");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 3.0, "array_map_native");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "array_map_native");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -238,7 +239,7 @@ DEFINE_TEST(array_filter_native) {
     const char* source = 
         "let arr = [1, 2, 3, 4, 5];"
         "let evens = arr.filter(test_is_even);"
-        "evens.length;";
+        "let result = evens.length;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -265,9 +266,7 @@ DEFINE_TEST(array_filter_native) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_filter_native");
     
     // Check result - length should be 2 (2 and 4 are even)
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_filter_native");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 2.0, "array_filter_native");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 2.0, "array_filter_native");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -283,7 +282,7 @@ DEFINE_TEST(array_reduce_native) {
     const char* source = 
         "let arr = [1, 2, 3, 4];"
         "let sum = arr.reduce(test_sum, 0);"
-        "sum;";
+        "let result = sum;";
     
     Parser* parser = parser_create(source);
     ProgramNode* program = parser_parse_program(parser);
@@ -310,9 +309,7 @@ DEFINE_TEST(array_reduce_native) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "array_reduce_native");
     
     // Check result - sum should be 10
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "array_reduce_native");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 10.0, "array_reduce_native");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 10.0, "array_reduce_native");
     
     vm_free(&vm);
     chunk_free(&chunk);
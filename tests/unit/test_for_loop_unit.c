@@ -11,6 +11,17 @@
 #include "ast/ast.h"
 #include "utils/error.h"
 
+// Value of a numeric script global, or -1 if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
 DEFINE_TEST(for_in_array) {
     const char* source = 
         "var sum = 0;"
@@ -45,9 +56,7 @@ DEFINE_TEST(for_in_array) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "for_in_array");
     
     // Check result - should be 15
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "for_in_array");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 15.0, "for_in_array");
+    TEST_ASSERT(suite, global_number(&vm, "sum") == 15.0, "for_in_array");
     
     // Cleanup
     vm_free(&vm);
@@ -92,9 +101,7 @@ DEFINE_TEST(for_in_empty_array) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "for_in_empty_array");
     
     // Check result - should be 0
-    TaggedValue top = vm_pop(&vm);
-    TEST_ASSERT(suite, IS_NUMBER(top), "for_in_empty_array");
-    TEST_ASSERT(suite, AS_NUMBER(top) == 0.0, "for_in_empty_array");
+    TEST_ASSERT(suite, global_number(&vm, "count") == 0.0, "for_in_empty_array");
     
     // Cleanup
     vm_free(&vm);
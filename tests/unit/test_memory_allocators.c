@@ -1,4 +1,5 @@
 #include "utils/test_framework.h"
+#include "utils/test_macros.h"
 #include "utils/memory.h"
 #include "utils/alloc.h"
 #include <stdio.h>
@@ -6,7 +7,7 @@
 #include <stdlib.h>
 
 // Test platform allocator
-static void test_platform_allocator(TestSuite* suite) {
+DEFINE_TEST(platform_allocator) {
     Allocator* alloc = mem_create_platform_allocator();
     TEST_ASSERT(suite, alloc != NULL, "Platform allocator creation");
     
@@ -50,7 +51,7 @@ static void test_platform_allocator(TestSuite* suite) {
 }
 
 // Test arena allocator
-static void test_arena_allocator(TestSuite* suite) {
+DEFINE_TEST(arena_allocator) {
     Allocator* arena = mem_create_arena_allocator(1024);
     TEST_ASSERT(suite, arena != NULL, "Arena allocator creation");
     
@@ -81,7 +82,7 @@ static void test_arena_allocator(TestSuite* suite) {
 }
 
 // Test freelist allocator
-static void test_freelist_allocator(TestSuite* suite) {
+DEFINE_TEST(freelist_allocator) {
     Allocator* freelist = mem_create_freelist_allocator(64, 10);
     TEST_ASSERT(suite, freelist != NULL, "Freelist allocator creation");
     
@@ -112,8 +113,58 @@ static void test_freelist_allocator(TestSuite* suite) {
     mem_destroy(freelist);
 }
 
+// Test size-class allocator
+DEFINE_TEST(size_class_allocator) {
+    Allocator* pool = mem_create_size_class_allocator(4096);
+    TEST_ASSERT(suite, pool != NULL, "Size-class allocator creation");
+    
+    // Sizes in the same class share blocks
+    void* small = MEM_ALLOC(pool, 40);
+    TEST_ASSERT(suite, small != NULL, "Size-class allocation");
+    SLANG_MEM_FREE(pool, small, 40);
+    void* reused = MEM_ALLOC(pool, 48);
+    TEST_ASSERT(suite, reused == small, "Freed block reused by its class");
+    
+    // A block grows in place up to its class size, then moves
+    void* grown = MEM_REALLOC(pool, reused, 48, 48);
+    TEST_ASSERT(suite, grown == reused, "Realloc within class keeps block");
+    memset(grown, 0xAB, 48);
+    void* moved = MEM_REALLOC(pool, grown, 48, 200);
+    TEST_ASSERT(suite, moved != NULL && moved != grown, "Realloc across classes moves");
+    TEST_ASSERT(suite, ((unsigned char*)moved)[47] == 0xAB, "Realloc keeps contents");
+    
+    // Zeroed blocks come back zeroed even after reuse
+    SLANG_MEM_FREE(pool, moved, 200);
+    unsigned char* zeroed = MEM_ALLOC_ZERO(pool, 192);
+    TEST_ASSERT(suite, zeroed != NULL && zeroed[47] == 0, "Zeroed reuse");
+    SLANG_MEM_FREE(pool, zeroed, 192);
+    
+    // Requests above the largest class fall through to the platform allocator
+    void* large = MEM_ALLOC(pool, 4096);
+    TEST_ASSERT(suite, large != NULL, "Large allocation");
+    SLANG_MEM_FREE(pool, large, 4096);
+    
+    // Many objects of one size take few system allocations
+    void* blocks[1000];
+    for (int i = 0; i < 1000; i++) {
+        blocks[i] = MEM_ALLOC(pool, 80);
+    }
+    AllocatorStats stats = mem_get_stats(pool);
+    TEST_ASSERT(suite, stats.total_allocated < 1000 * 80 * 2, "Blocks carved from chunks");
+    TEST_ASSERT_EQUAL_INT(suite, 1000 * 80, stats.current_usage, "Size-class usage");
+    for (int i = 0; i < 1000; i++) {
+        SLANG_MEM_FREE(pool, blocks[i], 80);
+    }
+    
+    stats = mem_get_stats(pool);
+    TEST_ASSERT_EQUAL_INT(suite, 0, stats.current_usage, "Size-class usage after frees");
+    TEST_ASSERT_EQUAL_INT(suite, stats.allocation_count, stats.free_count, "Size-class alloc/free balance");
+    
+    mem_destroy(pool);
+}
+
 // Test trace allocator
-static void test_trace_allocator(TestSuite* suite) {
+DEFINE_TEST(trace_allocator) {
     // Create trace allocator with platform backing
     Allocator* platform = mem_create_platform_allocator();
     Allocator* trace = mem_create_trace_allocator(platform);
@@ -156,7 +207,7 @@ static void test_trace_allocator(TestSuite* suite) {
 }
 
 // Test memory migration helpers
-static void test_migration_helpers(TestSuite* suite) {
+DEFINE_TEST(migration_helpers) {
     // Set up trace allocator as default
     Allocator* platform = mem_create_platform_allocator();
     Allocator* trace = mem_create_trace_allocator(platform);
@@ -202,7 +253,7 @@ static void test_migration_helpers(TestSuite* suite) {
 }
 
 // Test arena scope helper
-static void test_arena_scope(TestSuite* suite) {
+DEFINE_TEST(arena_scope) {
     // Track allocations before arena
     Allocator* trace = mem_create_trace_allocator(mem_create_platform_allocator());
     set_allocator(trace);
@@ -233,24 +284,12 @@ static void test_arena_scope(TestSuite* suite) {
     mem_destroy(trace);
 }
 
-// Export test functions for test framework
-void memory_allocators_register_tests(TestSuite* suite) {
-    RUN_TEST(suite, test_platform_allocator);
-    RUN_TEST(suite, test_arena_allocator);
-    RUN_TEST(suite, test_freelist_allocator);
-    RUN_TEST(suite, test_trace_allocator);
-    RUN_TEST(suite, test_migration_helpers);
-    RUN_TEST(suite, test_arena_scope);
-}
-
-// Standalone test runner
-int main(void) {
-    TestSuite* suite = test_suite_create("Memory Allocators");
-    memory_allocators_register_tests(suite);
-    test_suite_print_results(suite);
-    
-    bool all_passed = (suite->failed == 0);
-    test_suite_destroy(suite);
-    
-    return all_passed ? 0 : 1;
-}
\ No newline at end of file
+TEST_SUITE(memory_allocators_unit)
+    TEST_CASE(platform_allocator, "Platform Allocator")
+    TEST_CASE(arena_allocator, "Arena Allocator")
+    TEST_CASE(freelist_allocator, "Freelist Allocator")
+    TEST_CASE(size_class_allocator, "Size Class Allocator")
+    TEST_CASE(trace_allocator, "Trace Allocator")
+    TEST_CASE(migration_helpers, "Migration Helpers")
+    TEST_CASE(arena_scope, "Arena Scope")
+END_TEST_SUITE(memory_allocators_unit)
@@ -1,13 +1,25 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "utils/test_framework.h"
 #include "utils/test_macros.h"
 #include "parser/parser.h"
 #include "codegen/compiler.h"
 #include "runtime/core/vm.h"
 
+// Value of a numeric script global, or -1 if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static double global_number(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_NUMBER(vm->globals.values[i])) {
+            return AS_NUMBER(vm->globals.values[i]);
+        }
+    }
+    return -1;
+}
+
 DEFINE_TEST(basic_modulo) {
-    const char* source = "5 % 2;";
+    const char* source = "var result = 5 % 2;";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -23,11 +35,7 @@ DEFINE_TEST(basic_modulo) {
     InterpretResult result = vm_interpret(&vm, &chunk);
     
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "basic_modulo");
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "basic_modulo");
-    
-    TaggedValue value = *(vm.stack_top - 1);
-    TEST_ASSERT(suite, IS_NUMBER(value), "basic_modulo");
-    TEST_ASSERT(suite, AS_NUMBER(value) == 1.0, "basic_modulo");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 1.0, "basic_modulo");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -36,7 +44,7 @@ DEFINE_TEST(basic_modulo) {
 }
 
 DEFINE_TEST(modulo_zero_remainder) {
-    const char* source = "10 % 5;";
+    const char* source = "var result = 10 % 5;";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -52,11 +60,7 @@ DEFINE_TEST(modulo_zero_remainder) {
     InterpretResult result = vm_interpret(&vm, &chunk);
     
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "modulo_zero_remainder");
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "modulo_zero_remainder");
-    
-    TaggedValue value = *(vm.stack_top - 1);
-    TEST_ASSERT(suite, IS_NUMBER(value), "modulo_zero_remainder");
-    TEST_ASSERT(suite, AS_NUMBER(value) == 0.0, "modulo_zero_remainder");
+    TEST_ASSERT(suite, global_number(&vm, "result") == 0.0, "modulo_zero_remainder");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -65,7 +69,7 @@ DEFINE_TEST(modulo_zero_remainder) {
 }
 
 DEFINE_TEST(modulo_negative) {
-    const char* source = "-7 % 3;";
+    const char* source = "var result = -7 % 3;";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -81,11 +85,7 @@ DEFINE_TEST(modulo_negative) {
     InterpretResult result = vm_interpret(&vm, &chunk);
     
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "modulo_negative");
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "modulo_negative");
-    
-    TaggedValue value = *(vm.stack_top - 1);
-    TEST_ASSERT(suite, IS_NUMBER(value), "modulo_negative");
-    TEST_ASSERT(suite, AS_NUMBER(value) == -1.0, "modulo_negative");
+    TEST_ASSERT(suite, global_number(&vm, "result") == -1.0, "modulo_negative");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -94,7 +94,7 @@ DEFINE_TEST(modulo_negative) {
 }
 
 DEFINE_TEST(modulo_expression) {
-    const char* source = "(10 + 5) % (2 + 2);";
+    const char* source = "var result = (10 + 5) % (2 + 2);";
     
     Parser* parser = parser_create(source);
     ProgramNode* ast = parser_parse_program(parser);
@@ -110,11 +110,7 @@ DEFINE_TEST(modulo_expression) {
     InterpretResult result = vm_interpret(&vm, &chunk);
     
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "modulo_expression");
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "modulo_expression");
-    
-    TaggedValue value = *(vm.stack_top - 1);
-    TEST_ASSERT(suite, IS_NUMBER(value), "modulo_expression");
-    TEST_ASSERT(suite, AS_NUMBER(value) == 3.0, "modulo_expression"); // 15 % 4 = 3
+    TEST_ASSERT(suite, global_number(&vm, "result") == 3.0, "modulo_expression"); // 15 % 4 = 3
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -6,13 +6,15 @@
 #include "utils/test_macros.h"
 #include "runtime/core/object.h"
 #include "runtime/core/vm.h"
+#include "runtime/core/shape.h"
 
 // Test object creation and destruction
 DEFINE_TEST(create_destroy_object)
 {
     Object* obj = object_create();
     TEST_ASSERT(suite, obj != NULL, "create_destroy_object");
-    TEST_ASSERT(suite, obj->properties == NULL, "create_destroy_object");
+    TEST_ASSERT(suite, obj->shape == shape_root(), "create_destroy_object");
+    TEST_ASSERT(suite, obj->slot_count == 0, "create_destroy_object");
     TEST_ASSERT(suite, obj->property_count == 0, "create_destroy_object");
     TEST_ASSERT(suite, obj->is_array == false, "create_destroy_object");
     
@@ -25,29 +27,31 @@ DEFINE_TEST(set_get_property)
     Object* obj = object_create();
     
     // Set a string property
-    TaggedValue str_val = {.type = VAL_STRING, .as.string = "Hello"};
+    char* hello = string_copy("Hello");
+    TaggedValue str_val = STRING_VAL(hello);
     object_set_property(obj, "greeting", str_val);
     
     // Set a number property
-    TaggedValue num_val = {.type = VAL_NUMBER, .as.number = 42.0};
+    TaggedValue num_val = NUMBER_VAL(42.0);
     object_set_property(obj, "answer", num_val);
     
     // Get properties back
     TaggedValue* greeting = object_get_property(obj, "greeting");
     TEST_ASSERT(suite, greeting != NULL, "set_get_property");
-    TEST_ASSERT(suite, greeting->type == VAL_STRING, "set_get_property");
-    TEST_ASSERT(suite, strcmp(greeting->as.string, "Hello") == 0, "set_get_property");
+    TEST_ASSERT(suite, IS_STRING(*greeting), "set_get_property");
+    TEST_ASSERT(suite, strcmp(AS_STRING(*greeting), "Hello") == 0, "set_get_property");
     
     TaggedValue* answer = object_get_property(obj, "answer");
     TEST_ASSERT(suite, answer != NULL, "set_get_property");
-    TEST_ASSERT(suite, answer->type == VAL_NUMBER, "set_get_property");
-    TEST_ASSERT(suite, answer->as.number == 42.0, "set_get_property");
+    TEST_ASSERT(suite, IS_NUMBER(*answer), "set_get_property");
+    TEST_ASSERT(suite, AS_NUMBER(*answer) == 42.0, "set_get_property");
     
     // Test non-existent property
     TaggedValue* nonexistent = object_get_property(obj, "doesnotexist");
     TEST_ASSERT(suite, nonexistent == NULL, "set_get_property");
     
     object_destroy(obj);
+    string_free(hello);
 }
 
 // Test property overwriting
@@ -56,18 +60,18 @@ DEFINE_TEST(overwrite_property)
     Object* obj = object_create();
     
     // Set initial value
-    TaggedValue val1 = {.type = VAL_NUMBER, .as.number = 10.0};
+    TaggedValue val1 = NUMBER_VAL(10.0);
     object_set_property(obj, "value", val1);
     
     TaggedValue* result = object_get_property(obj, "value");
-    TEST_ASSERT(suite, result->as.number == 10.0, "overwrite_property");
+    TEST_ASSERT(suite, AS_NUMBER(*result) == 10.0, "overwrite_property");
     
     // Overwrite with new value
-    TaggedValue val2 = {.type = VAL_NUMBER, .as.number = 20.0};
+    TaggedValue val2 = NUMBER_VAL(20.0);
     object_set_property(obj, "value", val2);
     
     result = object_get_property(obj, "value");
-    TEST_ASSERT(suite, result->as.number == 20.0, "overwrite_property");
+    TEST_ASSERT(suite, AS_NUMBER(*result) == 20.0, "overwrite_property");
     TEST_ASSERT(suite, obj->property_count == 1, "overwrite_property"); // Should still be 1
     
     object_destroy(obj);
@@ -82,7 +86,7 @@ DEFINE_TEST(multiple_properties)
     for (int i = 0; i < 10; i++) {
         char key[32];
         snprintf(key, sizeof(key), "prop%d", i);
-        TaggedValue val = {.type = VAL_NUMBER, .as.number = (double)i};
+        TaggedValue val = NUMBER_VAL((double)i);
         object_set_property(obj, key, val);
     }
     
@@ -94,8 +98,8 @@ DEFINE_TEST(multiple_properties)
         snprintf(key, sizeof(key), "prop%d", i);
         TaggedValue* val = object_get_property(obj, key);
         TEST_ASSERT(suite, val != NULL, "multiple_properties");
-        TEST_ASSERT(suite, val->type == VAL_NUMBER, "multiple_properties");
-        TEST_ASSERT(suite, val->as.number == (double)i, "multiple_properties");
+        TEST_ASSERT(suite, IS_NUMBER(*val), "multiple_properties");
+        TEST_ASSERT(suite, AS_NUMBER(*val) == (double)i, "multiple_properties");
     }
     
     object_destroy(obj);
@@ -106,7 +110,8 @@ DEFINE_TEST(object_with_prototype)
 {
     // Create prototype object
     Object* proto = object_create();
-    TaggedValue proto_val = {.type = VAL_STRING, .as.string = "inherited"};
+    char* inherited = string_copy("inherited");
+    TaggedValue proto_val = STRING_VAL(inherited);
     object_set_property(proto, "inherited_prop", proto_val);
     
     // Create object with prototype
@@ -114,21 +119,24 @@ DEFINE_TEST(object_with_prototype)
     TEST_ASSERT(suite, obj->prototype == proto, "object_with_prototype");
     
     // Set own property
-    TaggedValue own_val = {.type = VAL_STRING, .as.string = "own"};
+    char* own_text = string_copy("own");
+    TaggedValue own_val = STRING_VAL(own_text);
     object_set_property(obj, "own_prop", own_val);
     
     // Test own property
     TaggedValue* own_result = object_get_property(obj, "own_prop");
     TEST_ASSERT(suite, own_result != NULL, "object_with_prototype");
-    TEST_ASSERT(suite, strcmp(own_result->as.string, "own") == 0, "object_with_prototype");
+    TEST_ASSERT(suite, strcmp(AS_STRING(*own_result), "own") == 0, "object_with_prototype");
     
     // Test inherited property
     TaggedValue* inherited_result = object_get_property(obj, "inherited_prop");
     TEST_ASSERT(suite, inherited_result != NULL, "object_with_prototype");
-    TEST_ASSERT(suite, strcmp(inherited_result->as.string, "inherited") == 0, "object_with_prototype");
+    TEST_ASSERT(suite, strcmp(AS_STRING(*inherited_result), "inherited") == 0, "object_with_prototype");
     
     object_destroy(obj);
     object_destroy(proto);
+    string_free(own_text);
+    string_free(inherited);
 }
 
 // Test property shadowing
@@ -136,22 +144,22 @@ DEFINE_TEST(property_shadowing)
 {
     // Create prototype with a property
     Object* proto = object_create();
-    TaggedValue proto_val = {.type = VAL_NUMBER, .as.number = 100.0};
+    TaggedValue proto_val = NUMBER_VAL(100.0);
     object_set_property(proto, "value", proto_val);
     
     // Create object with same property name
     Object* obj = object_create_with_prototype(proto);
-    TaggedValue obj_val = {.type = VAL_NUMBER, .as.number = 200.0};
+    TaggedValue obj_val = NUMBER_VAL(200.0);
     object_set_property(obj, "value", obj_val);
     
     // Object's own property should shadow prototype's
     TaggedValue* result = object_get_property(obj, "value");
     TEST_ASSERT(suite, result != NULL, "property_shadowing");
-    TEST_ASSERT(suite, result->as.number == 200.0, "property_shadowing");
+    TEST_ASSERT(suite, AS_NUMBER(*result) == 200.0, "property_shadowing");
     
     // Prototype should still have original value
     TaggedValue* proto_result = object_get_property(proto, "value");
-    TEST_ASSERT(suite, proto_result->as.number == 100.0, "property_shadowing");
+    TEST_ASSERT(suite, AS_NUMBER(*proto_result) == 100.0, "property_shadowing");
     
     object_destroy(obj);
     object_destroy(proto);
@@ -162,30 +170,36 @@ DEFINE_TEST(deep_prototype_chain)
 {
     // Create a chain: obj -> proto1 -> proto2
     Object* proto2 = object_create();
-    TaggedValue val2 = {.type = VAL_STRING, .as.string = "from proto2"};
+    char* text2 = string_copy("from proto2");
+    TaggedValue val2 = STRING_VAL(text2);
     object_set_property(proto2, "deep_prop", val2);
     
     Object* proto1 = object_create_with_prototype(proto2);
-    TaggedValue val1 = {.type = VAL_STRING, .as.string = "from proto1"};
+    char* text1 = string_copy("from proto1");
+    TaggedValue val1 = STRING_VAL(text1);
     object_set_property(proto1, "mid_prop", val1);
     
     Object* obj = object_create_with_prototype(proto1);
-    TaggedValue val0 = {.type = VAL_STRING, .as.string = "from obj"};
+    char* text0 = string_copy("from obj");
+    TaggedValue val0 = STRING_VAL(text0);
     object_set_property(obj, "own_prop", val0);
     
     // Test access to all levels
     TaggedValue* own = object_get_property(obj, "own_prop");
-    TEST_ASSERT(suite, own != NULL && strcmp(own->as.string, "from obj") == 0, "deep_prototype_chain");
+    TEST_ASSERT(suite, own != NULL && strcmp(AS_STRING(*own), "from obj") == 0, "deep_prototype_chain");
     
     TaggedValue* mid = object_get_property(obj, "mid_prop");
-    TEST_ASSERT(suite, mid != NULL && strcmp(mid->as.string, "from proto1") == 0, "deep_prototype_chain");
+    TEST_ASSERT(suite, mid != NULL && strcmp(AS_STRING(*mid), "from proto1") == 0, "deep_prototype_chain");
     
     TaggedValue* deep = object_get_property(obj, "deep_prop");
-    TEST_ASSERT(suite, deep != NULL && strcmp(deep->as.string, "from proto2") == 0, "deep_prototype_chain");
+    TEST_ASSERT(suite, deep != NULL && strcmp(AS_STRING(*deep), "from proto2") == 0, "deep_prototype_chain");
     
     object_destroy(obj);
     object_destroy(proto1);
     object_destroy(proto2);
+    string_free(text0);
+    string_free(text1);
+    string_free(text2);
 }
 
 // Test nil and boolean values
@@ -194,27 +208,27 @@ DEFINE_TEST(nil_and_bool_properties)
     Object* obj = object_create();
     
     // Set nil property
-    TaggedValue nil_val = {.type = VAL_NIL};
+    TaggedValue nil_val = NIL_VAL;
     object_set_property(obj, "nil_prop", nil_val);
     
     // Set boolean properties
-    TaggedValue true_val = {.type = VAL_BOOL, .as.boolean = true};
+    TaggedValue true_val = BOOL_VAL(true);
     object_set_property(obj, "true_prop", true_val);
     
-    TaggedValue false_val = {.type = VAL_BOOL, .as.boolean = false};
+    TaggedValue false_val = BOOL_VAL(false);
     object_set_property(obj, "false_prop", false_val);
     
     // Test retrieval
     TaggedValue* nil_result = object_get_property(obj, "nil_prop");
-    TEST_ASSERT(suite, nil_result != NULL && nil_result->type == VAL_NIL, "nil_and_bool_properties");
+    TEST_ASSERT(suite, nil_result != NULL && IS_NIL(*nil_result), "nil_and_bool_properties");
     
     TaggedValue* true_result = object_get_property(obj, "true_prop");
-    TEST_ASSERT(suite, true_result != NULL && true_result->type == VAL_BOOL, "nil_and_bool_properties");
-    TEST_ASSERT(suite, true_result->as.boolean == true, "nil_and_bool_properties");
+    TEST_ASSERT(suite, true_result != NULL && IS_BOOL(*true_result), "nil_and_bool_properties");
+    TEST_ASSERT(suite, AS_BOOL(*true_result) == true, "nil_and_bool_properties");
     
     TaggedValue* false_result = object_get_property(obj, "false_prop");
-    TEST_ASSERT(suite, false_result != NULL && false_result->type == VAL_BOOL, "nil_and_bool_properties");
-    TEST_ASSERT(suite, false_result->as.boolean == false, "nil_and_bool_properties");
+    TEST_ASSERT(suite, false_result != NULL && IS_BOOL(*false_result), "nil_and_bool_properties");
+    TEST_ASSERT(suite, AS_BOOL(*false_result) == false, "nil_and_bool_properties");
     
     object_destroy(obj);
 }
@@ -223,11 +237,11 @@ DEFINE_TEST(nil_and_bool_properties)
 DEFINE_TEST(has_property_check)
 {
     Object* proto = object_create();
-    TaggedValue proto_val = {.type = VAL_NUMBER, .as.number = 1.0};
+    TaggedValue proto_val = NUMBER_VAL(1.0);
     object_set_property(proto, "inherited", proto_val);
     
     Object* obj = object_create_with_prototype(proto);
-    TaggedValue obj_val = {.type = VAL_NUMBER, .as.number = 2.0};
+    TaggedValue obj_val = NUMBER_VAL(2.0);
     object_set_property(obj, "own", obj_val);
     
     // Test has_property
@@ -244,6 +258,229 @@ DEFINE_TEST(has_property_check)
     object_destroy(proto);
 }
 
+// Test the bookkeeping inline caches rely on
+DEFINE_TEST(lookup_cache_invalidation)
+{
+    Object* proto = object_create();
+    Object* obj = object_create_with_prototype(proto);
+    TEST_ASSERT(suite, proto->is_prototype, "lookup_cache_invalidation");
+    TEST_ASSERT(suite, !obj->is_prototype, "lookup_cache_invalidation");
+    
+    object_set_property(obj, "own", NUMBER_VAL(1.0));
+    
+    // Adding to an ordinary object leaves cached lookups alone...
+    uint32_t epoch = object_cache_epoch;
+    object_set_property(obj, "other", NUMBER_VAL(2.0));
+    TEST_ASSERT(suite, object_cache_epoch == epoch, "lookup_cache_invalidation");
+    
+    // ...adding a key to a prototype does not
+    object_set_property(proto, "method", NUMBER_VAL(3.0));
+    TEST_ASSERT(suite, object_cache_epoch != epoch, "lookup_cache_invalidation");
+    
+    // ...and neither does deleting one
+    epoch = object_cache_epoch;
+    object_delete_property(proto, "method");
+    TEST_ASSERT(suite, object_cache_epoch != epoch, "lookup_cache_invalidation");
+    
+    epoch = object_cache_epoch;
+    object_destroy(obj);
+    TEST_ASSERT(suite, object_cache_epoch != epoch, "lookup_cache_invalidation");
+    object_destroy(proto);
+}
+
+// Test that objects built the same way share a shape
+DEFINE_TEST(shape_transitions)
+{
+    Object* a = object_create();
+    Object* b = object_create();
+    Object* c = object_create();
+    
+    object_set_property(a, "x", NUMBER_VAL(1.0));
+    object_set_property(a, "y", NUMBER_VAL(2.0));
+    object_set_property(b, "x", NUMBER_VAL(3.0));
+    object_set_property(b, "y", NUMBER_VAL(4.0));
+    object_set_property(c, "y", NUMBER_VAL(5.0));
+    object_set_property(c, "x", NUMBER_VAL(6.0));
+    
+    TEST_ASSERT(suite, a->shape == b->shape, "shape_transitions");
+    TEST_ASSERT(suite, a->shape != c->shape, "shape_transitions");
+    TEST_ASSERT(suite, a->shape->slot_count == 2, "shape_transitions");
+    TEST_ASSERT(suite, a->shape->parent->parent == shape_root(), "shape_transitions");
+    
+    // Overwriting keeps the shape
+    Shape* shape = b->shape;
+    object_set_property(b, "x", NUMBER_VAL(7.0));
+    TEST_ASSERT(suite, b->shape == shape, "shape_transitions");
+    TEST_ASSERT(suite, AS_NUMBER(*object_get_property(b, "x")) == 7.0, "shape_transitions");
+    TEST_ASSERT(suite, AS_NUMBER(*object_get_property(a, "x")) == 1.0, "shape_transitions");
+    
+    object_destroy(a);
+    object_destroy(b);
+    object_destroy(c);
+}
+
+// Test that keys from data cannot grow the transition tree without bound
+DEFINE_TEST(shape_fan_out)
+{
+    enum { COUNT = SHAPE_MAX_TRANSITIONS + 1 };
+    Object** objects = malloc(COUNT * sizeof(Object*));
+    TEST_ASSERT_NOT_NULL(suite, objects, "shape_fan_out");
+    char key[32];
+    
+    for (int i = 0; i < COUNT; i++) {
+        objects[i] = object_create();
+        object_set_property(objects[i], "fan_out_base", NUMBER_VAL(0.0));
+        snprintf(key, sizeof(key), "fan%d", i);
+        object_set_property(objects[i], key, NUMBER_VAL((double)i));
+    }
+    Shape* base = objects[0]->shape->parent;
+    TEST_ASSERT(suite, base->transition_count == SHAPE_MAX_TRANSITIONS, "shape_fan_out");
+    TEST_ASSERT(suite, objects[COUNT - 2]->shape != NULL, "shape_fan_out");
+    TEST_ASSERT(suite, objects[COUNT - 1]->shape == NULL, "shape_fan_out");
+    
+    // Every transition is still found, and the overflow reads back too
+    for (int i = 0; i < COUNT; i++) {
+        snprintf(key, sizeof(key), "fan%d", i);
+        TaggedValue* value = object_get_property(objects[i], key);
+        TEST_ASSERT(suite, value && AS_NUMBER(*value) == (double)i, "shape_fan_out");
+        object_destroy(objects[i]);
+    }
+    free(objects);
+    
+    // A computed key makes no transition at all
+    Object* keyed = object_create();
+    object_set_property(keyed, "fan_out_base", NUMBER_VAL(0.0));
+    object_set_keyed_property(keyed, "fan_out_base", NUMBER_VAL(1.0));
+    TEST_ASSERT(suite, keyed->shape == base, "shape_fan_out");
+    object_set_keyed_property(keyed, "fan_out_keyed", NUMBER_VAL(2.0));
+    TEST_ASSERT(suite, keyed->shape == NULL, "shape_fan_out");
+    TEST_ASSERT(suite, base->transition_count == SHAPE_MAX_TRANSITIONS, "shape_fan_out");
+    TEST_ASSERT(suite, AS_NUMBER(*object_get_property(keyed, "fan_out_keyed")) == 2.0, "shape_fan_out");
+    object_destroy(keyed);
+}
+
+// Test the switch to dictionary mode
+DEFINE_TEST(dictionary_mode)
+{
+    Object* big = object_create();
+    char key[32];
+    
+    for (int i = 0; i < SHAPE_MAX_SLOTS; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        object_set_property(big, key, NUMBER_VAL((double)i));
+    }
+    TEST_ASSERT(suite, big->shape != NULL, "dictionary_mode");
+    
+    // One key too many leaves the shape tree
+    object_set_property(big, "last", NUMBER_VAL(-1.0));
+    TEST_ASSERT(suite, big->shape == NULL && big->dictionary != NULL, "dictionary_mode");
+    TEST_ASSERT(suite, big->property_count == SHAPE_MAX_SLOTS + 1, "dictionary_mode");
+    for (int i = 0; i < SHAPE_MAX_SLOTS; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        TaggedValue* val = object_get_property(big, key);
+        TEST_ASSERT(suite, val != NULL && AS_NUMBER(*val) == (double)i, "dictionary_mode");
+    }
+    
+    // Deleting a key that is not the newest one also leaves the tree
+    Object* small = object_create();
+    object_set_property(small, "a", NUMBER_VAL(1.0));
+    object_set_property(small, "b", NUMBER_VAL(2.0));
+    TEST_ASSERT(suite, object_delete_property(small, "a"), "dictionary_mode");
+    TEST_ASSERT(suite, small->shape == NULL, "dictionary_mode");
+    TEST_ASSERT(suite, object_get_property(small, "a") == NULL, "dictionary_mode");
+    TEST_ASSERT(suite, AS_NUMBER(*object_get_property(small, "b")) == 2.0, "dictionary_mode");
+    TEST_ASSERT(suite, !object_delete_property(small, "a"), "dictionary_mode");
+    
+    object_destroy(big);
+    object_destroy(small);
+}
+
+// Test deleting properties
+DEFINE_TEST(delete_property)
+{
+    Object* obj = object_create();
+    object_set_property(obj, "a", NUMBER_VAL(1.0));
+    Shape* after_a = obj->shape;
+    object_set_property(obj, "b", NUMBER_VAL(2.0));
+    
+    // Deleting the newest key steps back to the parent shape
+    TEST_ASSERT(suite, object_delete_property(obj, "b"), "delete_property");
+    TEST_ASSERT(suite, obj->shape == after_a, "delete_property");
+    TEST_ASSERT(suite, !object_has_own_property(obj, "b"), "delete_property");
+    TEST_ASSERT(suite, obj->property_count == 1, "delete_property");
+    
+    // Churn through many keys in dictionary mode; holes get compacted
+    char key[32];
+    for (int i = 0; i < 100; i++) {
+        snprintf(key, sizeof(key), "tmp%d", i);
+        object_set_property(obj, key, NUMBER_VAL((double)i));
+        object_delete_property(obj, "a");
+        object_set_property(obj, "a", NUMBER_VAL((double)i));
+        object_delete_property(obj, key);
+    }
+    TEST_ASSERT(suite, obj->property_count == 1, "delete_property");
+    TEST_ASSERT(suite, obj->slot_count < 16, "delete_property");
+    TEST_ASSERT(suite, AS_NUMBER(*object_get_property(obj, "a")) == 99.0, "delete_property");
+    
+    object_destroy(obj);
+}
+
+static void sum_properties(const char* key, TaggedValue* value, void* user_data)
+{
+    (void)key;
+    *(double*)user_data += AS_NUMBER(*value);
+}
+
+// Test own-property iteration in both storage modes
+DEFINE_TEST(iterate_properties)
+{
+    Object* obj = object_create();
+    object_set_property(obj, "a", NUMBER_VAL(1.0));
+    object_set_property(obj, "b", NUMBER_VAL(2.0));
+    object_set_property(obj, "c", NUMBER_VAL(4.0));
+    
+    double sum = 0;
+    object_iterate_properties(obj, sum_properties, &sum);
+    TEST_ASSERT(suite, sum == 7.0, "iterate_properties");
+    
+    object_delete_property(obj, "a");
+    sum = 0;
+    object_iterate_properties(obj, sum_properties, &sum);
+    TEST_ASSERT(suite, sum == 6.0, "iterate_properties");
+    
+    object_destroy(obj);
+}
+
+// Test dense array storage
+DEFINE_TEST(array_storage)
+{
+    Object* array = array_create();
+    TEST_ASSERT(suite, array->is_array, "array_storage");
+    TEST_ASSERT(suite, array_length(array) == 0, "array_storage");
+    
+    for (int i = 0; i < 100; i++) {
+        array_push(array, NUMBER_VAL((double)i));
+    }
+    TEST_ASSERT(suite, array_length(array) == 100, "array_storage");
+    TEST_ASSERT(suite, AS_NUMBER(array_get(array, 42)) == 42.0, "array_storage");
+    TEST_ASSERT(suite, IS_NIL(array_get(array, 100)), "array_storage");
+    
+    // Elements are not properties
+    TEST_ASSERT(suite, array->property_count == 0, "array_storage");
+    TEST_ASSERT(suite, !object_has_own_property(array, "length"), "array_storage");
+    
+    TEST_ASSERT(suite, AS_NUMBER(array_pop(array)) == 99.0, "array_storage");
+    TEST_ASSERT(suite, array_length(array) == 99, "array_storage");
+    
+    // Setting past the end fills the gap with nil
+    array_set(array, 120, BOOL_VAL(true));
+    TEST_ASSERT(suite, array_length(array) == 121, "array_storage");
+    TEST_ASSERT(suite, IS_NIL(array_get(array, 110)), "array_storage");
+    TEST_ASSERT(suite, IS_BOOL(array_get(array, 120)), "array_storage");
+    
+    object_destroy(array);
+}
+
 // Define test suite
 TEST_SUITE(object_unit)
     TEST_CASE(create_destroy_object, "Create and Destroy Object")
@@ -255,4 +492,11 @@ TEST_SUITE(object_unit)
     TEST_CASE(deep_prototype_chain, "Deep Prototype Chain")
     TEST_CASE(nil_and_bool_properties, "Nil and Bool Properties")
     TEST_CASE(has_property_check, "Has Property Check")
+    TEST_CASE(lookup_cache_invalidation, "Lookup Cache Invalidation")
+    TEST_CASE(shape_transitions, "Shape Transitions")
+    TEST_CASE(shape_fan_out, "Shape Fan-Out")
+    TEST_CASE(dictionary_mode, "Dictionary Mode")
+    TEST_CASE(delete_property, "Delete Property")
+    TEST_CASE(iterate_properties, "Iterate Properties")
+    TEST_CASE(array_storage, "Array Storage")
 END_TEST_SUITE(object_unit)
\ No newline at end of file
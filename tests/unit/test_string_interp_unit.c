@@ -11,6 +11,18 @@
 #include "utils/error.h"
 #include "ast/ast.h"
 #include "runtime/modules/lifecycle/builtin_modules.h"
+#include "runtime/core/string_pool.h"
+
+// Value of a string script global, or NULL if it is missing. The stack is
+// empty once a script has run, so results are read from globals.
+static const char* global_string(VM* vm, const char* name) {
+    for (size_t i = 0; i < vm->globals.count; i++) {
+        if (strcmp(vm->globals.names[i], name) == 0 && IS_STRING(vm->globals.values[i])) {
+            return string_chars(AS_STRING(vm->globals.values[i]));
+        }
+    }
+    return NULL;
+}
 
 DEFINE_TEST(simple_interpolation) {
     const char* source = 
@@ -42,10 +54,7 @@ DEFINE_TEST(simple_interpolation) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "simple_interpolation");
     
     // Check result
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "simple_interpolation");
-    TaggedValue result_val = vm.stack_top[-1];
-    TEST_ASSERT(suite, IS_STRING(result_val), "simple_interpolation");
-    TEST_ASSERT_EQUAL_STRING(suite, "Hello, World!", AS_STRING(result_val), "simple_interpolation");
+    TEST_ASSERT_EQUAL_STRING(suite, "Hello, World!", global_string(&vm, "greeting"), "simple_interpolation");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -85,10 +94,7 @@ DEFINE_TEST(expression_interpolation) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "expression_interpolation");
     
     // Check result
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "expression_interpolation");
-    TaggedValue result_val = vm.stack_top[-1];
-    TEST_ASSERT(suite, IS_STRING(result_val), "expression_interpolation");
-    TEST_ASSERT_EQUAL_STRING(suite, "The sum of 10 and 20 is 30", AS_STRING(result_val), "expression_interpolation");
+    TEST_ASSERT_EQUAL_STRING(suite, "The sum of 10 and 20 is 30", global_string(&vm, "result"), "expression_interpolation");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -128,10 +134,7 @@ DEFINE_TEST(mixed_interpolation) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "mixed_interpolation");
     
     // Check result
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "mixed_interpolation");
-    TaggedValue result_val = vm.stack_top[-1];
-    TEST_ASSERT(suite, IS_STRING(result_val), "mixed_interpolation");
-    TEST_ASSERT_EQUAL_STRING(suite, "Alice is 25 years old and will be 26 next year", AS_STRING(result_val), "mixed_interpolation");
+    TEST_ASSERT_EQUAL_STRING(suite, "Alice is 25 years old and will be 26 next year", global_string(&vm, "msg"), "mixed_interpolation");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -172,10 +175,7 @@ DEFINE_TEST(nested_interpolation) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "nested_interpolation");
     
     // Check result
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "nested_interpolation");
-    TaggedValue result_val = vm.stack_top[-1];
-    TEST_ASSERT(suite, IS_STRING(result_val), "nested_interpolation");
-    TEST_ASSERT_EQUAL_STRING(suite, "The expression 'x + y' evaluates to 15", AS_STRING(result_val), "nested_interpolation");
+    TEST_ASSERT_EQUAL_STRING(suite, "The expression 'x + y' evaluates to 15", global_string(&vm, "result"), "nested_interpolation");
     
     vm_free(&vm);
     chunk_free(&chunk);
@@ -215,10 +215,7 @@ DEFINE_TEST(type_conversion) {
     TEST_ASSERT_EQUAL_INT(suite, INTERPRET_OK, result, "type_conversion");
     
     // Check result
-    TEST_ASSERT(suite, vm.stack_top > vm.stack, "type_conversion");
-    TaggedValue result_val = vm.stack_top[-1];
-    TEST_ASSERT(suite, IS_STRING(result_val), "type_conversion");
-    TEST_ASSERT_EQUAL_STRING(suite, "Value: 42, Bool: true", AS_STRING(result_val), "type_conversion");
+    TEST_ASSERT_EQUAL_STRING(suite, "Value: 42, Bool: true", global_string(&vm, "s"), "type_conversion");
     
     vm_free(&vm);
     chunk_free(&chunk);
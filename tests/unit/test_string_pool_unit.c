@@ -257,7 +257,227 @@ DEFINE_TEST(special_characters)
     string_pool_free(&pool);
 }
 
+// Interned strings carry their length and hash in the header
+DEFINE_TEST(string_header)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* str = string_pool_intern(&pool, "null\0byte", 9);
+    TEST_ASSERT(suite, string_length(str) == 9, "string_header");
+    TEST_ASSERT(suite, string_hash(str) == string_hash_bytes("null\0byte", 9), "string_header");
+    TEST_ASSERT(suite, string_is_interned(str), "string_header");
+    
+    char* plain = string_copy("plain");
+    TEST_ASSERT(suite, string_length(plain) == 5, "string_header");
+    TEST_ASSERT(suite, !string_is_interned(plain), "string_header");
+    TEST_ASSERT(suite, string_pool_intern_string(&pool, plain) != plain, "string_header");
+    TEST_ASSERT(suite, string_pool_intern_string(&pool, str) == str, "string_header");
+    string_free(plain);
+    
+    string_pool_free(&pool);
+}
+
+// string_pool_take keeps a new string and frees a duplicate
+DEFINE_TEST(take_string)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* built = string_alloc(4);
+    memcpy(built, "abcd", 4);
+    char* taken = string_pool_take(&pool, string_seal(built));
+    TEST_ASSERT(suite, taken == built, "take_string");
+    TEST_ASSERT(suite, string_is_interned(taken), "take_string");
+    
+    char* again = string_pool_take(&pool, string_new("abcd", 4));
+    TEST_ASSERT(suite, again == taken, "take_string");
+    TEST_ASSERT(suite, pool.entry_count == 1, "take_string");
+    
+    string_pool_free(&pool);
+}
+
+// Interned strings compare by pointer, but only within one pool
+DEFINE_TEST(string_equality)
+{
+    StringPool pool;
+    StringPool other;
+    string_pool_init(&pool);
+    string_pool_init(&other);
+    
+    char* abc = string_pool_intern(&pool, "abc", 3);
+    char* abd = string_pool_intern(&pool, "abd", 3);
+    char* other_abc = string_pool_intern(&other, "abc", 3);
+    char* plain_abc = string_copy("abc");
+    
+    TEST_ASSERT(suite, string_equals(abc, abc), "string_equality");
+    TEST_ASSERT(suite, !string_equals(abc, abd), "string_equality");
+    TEST_ASSERT(suite, string_equals(abc, other_abc), "string_equality");
+    TEST_ASSERT(suite, string_equals(plain_abc, abc), "string_equality");
+    TEST_ASSERT(suite, !string_equals(plain_abc, abd), "string_equality");
+    TEST_ASSERT(suite, string_pool_intern_string(&pool, other_abc) == abc, "string_equality");
+    
+    string_free(plain_abc);
+    string_pool_free(&other);
+    string_pool_free(&pool);
+}
+
+// Test that a sweep frees what it says and keeps the survivors findable
+DEFINE_TEST(sweep_accounting)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* kept = string_pool_intern(&pool, "kept", 4);
+    string_pool_intern(&pool, "dropped", 7);
+    size_t dropped_size = sizeof(StringHeader) + 7 + 1;
+    size_t before = pool.bytes;
+    TEST_ASSERT(suite, before == 2 * sizeof(StringHeader) + 4 + 7 + 2, "sweep_accounting");
+    
+    // Strings of another pool are not this pool's to mark
+    StringPool other;
+    string_pool_init(&other);
+    char* foreign = string_pool_intern(&other, "kept", 4);
+    string_pool_mark(&pool, foreign);
+    TEST_ASSERT(suite, STRING_HEADER(foreign)->marked == 0, "sweep_accounting");
+    
+    string_pool_mark(&pool, kept);
+    TEST_ASSERT(suite, string_pool_sweep(&pool) == dropped_size, "sweep_accounting");
+    TEST_ASSERT(suite, pool.bytes == before - dropped_size, "sweep_accounting");
+    TEST_ASSERT(suite, STRING_HEADER(kept)->marked == 0, "sweep_accounting");
+    TEST_ASSERT(suite, string_pool_intern(&pool, "kept", 4) == kept, "sweep_accounting");
+    TEST_ASSERT(suite, !string_pool_contains(&pool, "dropped"), "sweep_accounting");
+    
+    // Marks do not carry over to the next cycle
+    TEST_ASSERT(suite, string_pool_sweep(&pool) > 0, "sweep_accounting");
+    TEST_ASSERT(suite, pool.entry_count == 0 && pool.bytes == 0, "sweep_accounting");
+    
+    string_pool_free(&other);
+    string_pool_free(&pool);
+}
+
+// Test that released strings outlive the pool
+DEFINE_TEST(release)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* str = string_pool_intern(&pool, "survivor", 8);
+    string_pool_release(&pool);
+    
+    TEST_ASSERT(suite, pool.entry_count == 0, "release");
+    TEST_ASSERT(suite, pool.bytes == 0, "release");
+    TEST_ASSERT(suite, !string_is_interned(str), "release");
+    TEST_ASSERT(suite, strcmp(str, "survivor") == 0, "release");
+    
+    // The pool is empty but still usable
+    char* again = string_pool_intern(&pool, "survivor", 8);
+    TEST_ASSERT(suite, again != str, "release");
+    TEST_ASSERT(suite, string_equals(again, str), "release");
+    
+    string_free(str);
+    string_pool_free(&pool);
+}
+
+// Test that adopted strings move to the other pool, interned there unless
+// it has an equal one
+DEFINE_TEST(adopt)
+{
+    StringPool into, from;
+    string_pool_init(&into);
+    string_pool_init(&from);
+    
+    char* existing = string_pool_intern(&into, "shared", 6);
+    char* shared = string_pool_intern(&from, "shared", 6);
+    char* only = string_pool_intern(&from, "only", 4);
+    char* rope = string_pool_rope(&from, only, shared);
+    size_t bytes = into.bytes + from.bytes;
+    
+    string_pool_adopt(&into, &from);
+    TEST_ASSERT(suite, from.all_strings == NULL && from.entry_count == 0 && from.bytes == 0, "adopt");
+    TEST_ASSERT(suite, into.bytes == bytes, "adopt");
+    TEST_ASSERT(suite, into.entry_count == 2, "adopt");
+    
+    TEST_ASSERT(suite, string_pool_intern(&into, "only", 4) == only, "adopt");
+    TEST_ASSERT(suite, string_pool_intern(&into, "shared", 6) == existing, "adopt");
+    TEST_ASSERT(suite, !string_is_interned(shared), "adopt");
+    TEST_ASSERT(suite, string_is_owned_by(shared, into.id), "adopt");
+    TEST_ASSERT(suite, string_equals(shared, existing), "adopt");
+    TEST_ASSERT(suite, string_is_owned_by(rope, into.id), "adopt");
+    TEST_ASSERT(suite, strcmp(string_chars(rope), "onlyshared") == 0, "adopt");
+    
+    // The copy is swept like any other string of the pool
+    string_pool_mark(&into, existing);
+    string_pool_mark(&into, only);
+    string_pool_sweep(&into);
+    TEST_ASSERT(suite, into.entry_count == 2, "adopt");
+    TEST_ASSERT(suite, into.bytes == string_allocation_size(existing) + string_allocation_size(only),
+                "adopt");
+    
+    string_pool_free(&from);
+    string_pool_free(&into);
+}
+
 // Define test suite
+// Test that a rope reads as its halves joined, and flattens only once
+DEFINE_TEST(rope_flatten)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* left = string_pool_intern(&pool, "ab", 2);
+    char* rope = string_pool_rope(&pool, left, string_pool_intern(&pool, "cd", 2));
+    rope = string_pool_rope(&pool, rope, string_pool_intern(&pool, "ef", 2));
+    TEST_ASSERT(suite, string_is_rope(rope), "rope_flatten");
+    TEST_ASSERT(suite, string_length(rope) == 6, "rope_flatten");
+    TEST_ASSERT(suite, pool.entry_count == 3, "rope_flatten");
+    
+    // Equal ropes can coexist, so they are owned but not interned
+    TEST_ASSERT(suite, !string_is_interned(rope), "rope_flatten");
+    TEST_ASSERT(suite, string_is_owned_by(rope, pool.id), "rope_flatten");
+    
+    char* flat = string_chars(rope);
+    TEST_ASSERT(suite, !string_is_rope(flat), "rope_flatten");
+    TEST_ASSERT(suite, strcmp(flat, "abcdef") == 0, "rope_flatten");
+    TEST_ASSERT(suite, string_length(flat) == 6, "rope_flatten");
+    TEST_ASSERT(suite, string_chars(rope) == flat, "rope_flatten");
+    
+    // The characters are interned like any other string of the pool
+    TEST_ASSERT(suite, string_pool_intern(&pool, "abcdef", 6) == flat, "rope_flatten");
+    TEST_ASSERT(suite, string_chars(left) == left, "rope_flatten");
+    
+    string_pool_free(&pool);
+}
+
+// Test that a marked rope keeps its halves, and its characters once flat
+DEFINE_TEST(rope_mark_sweep)
+{
+    StringPool pool;
+    string_pool_init(&pool);
+    
+    char* rope = string_pool_intern(&pool, "a", 1);
+    for (int i = 0; i < 1000; i++) {
+        rope = string_pool_rope(&pool, rope, string_pool_intern(&pool, "b", 1));
+    }
+    string_pool_intern(&pool, "dropped", 7);
+    size_t before = pool.bytes;
+    
+    string_pool_mark(&pool, rope);
+    TEST_ASSERT(suite, string_pool_sweep(&pool) == sizeof(StringHeader) + 7 + 1, "rope_mark_sweep");
+    TEST_ASSERT(suite, pool.bytes == before - (sizeof(StringHeader) + 7 + 1), "rope_mark_sweep");
+    TEST_ASSERT(suite, string_length(rope) == 1001, "rope_mark_sweep");
+    
+    // Once flat, the chain is garbage and only the characters stay
+    char* flat = string_chars(rope);
+    string_pool_mark(&pool, rope);
+    string_pool_sweep(&pool);
+    TEST_ASSERT(suite, pool.entry_count == 1, "rope_mark_sweep");
+    TEST_ASSERT(suite, pool.bytes == string_allocation_size(rope) + string_allocation_size(flat), "rope_mark_sweep");
+    TEST_ASSERT(suite, flat[0] == 'a' && flat[1000] == 'b' && flat[1001] == '\0', "rope_mark_sweep");
+    
+    string_pool_free(&pool);
+}
+
 TEST_SUITE(string_pool_unit)
     TEST_CASE(init_and_free, "Init and Free")
     TEST_CASE(intern_string, "Intern String")
@@ -270,4 +490,12 @@ TEST_SUITE(string_pool_unit)
     TEST_CASE(mark_sweep_none_marked, "Mark Sweep None Marked")
     TEST_CASE(pool_resize, "Pool Resize")
     TEST_CASE(special_characters, "Special Characters")
+    TEST_CASE(string_header, "String Header")
+    TEST_CASE(take_string, "Take String")
+    TEST_CASE(string_equality, "String Equality")
+    TEST_CASE(sweep_accounting, "Sweep Accounting")
+    TEST_CASE(release, "Release")
+    TEST_CASE(adopt, "Adopt")
+    TEST_CASE(rope_flatten, "Rope Flatten")
+    TEST_CASE(rope_mark_sweep, "Rope Mark Sweep")
 END_TEST_SUITE(string_pool_unit)
\ No newline at end of file
@@ -1,10 +1,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "utils/test_framework.h"
 #include "utils/test_macros.h"
 #include "runtime/core/vm.h"
 #include "runtime/core/object.h"
+#include "runtime/core/gc.h"
+#include "runtime/core/heap_snapshot.h"
 
 DEFINE_TEST(stack_operations) {
     VM vm;
@@ -113,10 +116,10 @@ DEFINE_TEST(string_operations) {
     VM vm;
     vm_init(&vm);
     
-    // Test string values on stack
-    // Note: STRING_VAL expects char*, not const char*
-    char str1[] = "Hello";
-    char str2[] = "World";
+    // Test string values on stack. A string value needs a header, so the
+    // literals are copied into runtime strings.
+    char* str1 = string_copy("Hello");
+    char* str2 = string_copy("World");
     
     vm_push(&vm, STRING_VAL(str1));
     vm_push(&vm, STRING_VAL(str2));
@@ -130,9 +133,585 @@ DEFINE_TEST(string_operations) {
     TEST_ASSERT(suite, strcmp(AS_STRING(world), "World") == 0, "string_operations");
     
     vm_free(&vm);
+    string_free(str1);
+    string_free(str2);
+}
+
+// Value constructors and accessors must round-trip in both value representations
+DEFINE_TEST(value_representation) {
+    char text[] = "boxed";
+    Object object = {0};
+    Closure closure = {0};
+    Function function = {0};
+    
+    TaggedValue values[] = {
+        NUMBER_VAL(-1.5), BOOL_VAL(true), BOOL_VAL(false), NIL_VAL,
+        STRING_VAL(text), OBJECT_VAL(&object), CLOSURE_VAL(&closure), FUNCTION_VAL(&function)
+    };
+    ValueType expected[] = {
+        VAL_NUMBER, VAL_BOOL, VAL_BOOL, VAL_NIL,
+        VAL_STRING, VAL_OBJECT, VAL_CLOSURE, VAL_FUNCTION
+    };
+    for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+        TEST_ASSERT(suite, VALUE_TYPE(values[i]) == expected[i], "value_representation");
+    }
+    
+    TEST_ASSERT(suite, AS_NUMBER(values[0]) == -1.5, "value_representation");
+    TEST_ASSERT(suite, AS_BOOL(values[1]) && !AS_BOOL(values[2]), "value_representation");
+    TEST_ASSERT(suite, AS_STRING(values[4]) == text, "value_representation");
+    TEST_ASSERT(suite, AS_OBJECT(values[5]) == &object, "value_representation");
+    TEST_ASSERT(suite, AS_CLOSURE(values[6]) == &closure, "value_representation");
+    TEST_ASSERT(suite, AS_FUNCTION(values[7]) == &function, "value_representation");
+    TEST_ASSERT(suite, !IS_OBJECT(values[4]) && !IS_STRING(values[5]), "value_representation");
+    
+    // Special doubles stay numbers
+    TaggedValue nan_val = NUMBER_VAL(NAN);
+    TaggedValue inf_val = NUMBER_VAL(-INFINITY);
+    volatile double zero = 0.0;
+    TaggedValue computed_nan = NUMBER_VAL(zero / zero);  // sign bit set on x86
+    TEST_ASSERT(suite, IS_NUMBER(nan_val) && isnan(AS_NUMBER(nan_val)), "value_representation");
+    TEST_ASSERT(suite, IS_NUMBER(inf_val) && isinf(AS_NUMBER(inf_val)), "value_representation");
+    TEST_ASSERT(suite, IS_NUMBER(computed_nan), "value_representation");
+    
+    TEST_ASSERT(suite, values_equal(NUMBER_VAL(2), NUMBER_VAL(2.0)), "value_representation");
+    TEST_ASSERT(suite, !values_equal(NIL_VAL, BOOL_VAL(false)), "value_representation");
+    
+#ifdef SLANG_NAN_BOXING
+    TEST_ASSERT(suite, sizeof(TaggedValue) == 8, "value_representation");
+#endif
 }
 
 // Define test suite
+DEFINE_TEST(gc_collect_unreachable) {
+    VM vm;
+    vm_init(&vm);
+    
+    // A chain reachable from a global, plus garbage hanging off nothing
+    Object* head = object_create();
+    define_global(&vm, "head", OBJECT_VAL(head));
+    Object* tail = head;
+    for (int i = 0; i < 100; i++) {
+        Object* next = object_create();
+        object_set_property(tail, "next", OBJECT_VAL(next));
+        tail = next;
+        object_create();
+    }
+    
+    // The header sits right in front of the object it describes
+    GCObjectHeader* header = GC_HEADER(tail);
+    TEST_ASSERT(suite, header->owner == vm.gc, "gc_collect_unreachable");
+    TEST_ASSERT(suite, header->is_object, "gc_collect_unreachable");
+    TEST_ASSERT(suite, GC_PAYLOAD(header) == (void*)tail, "gc_collect_unreachable");
+    
+    size_t freed_before = gc_get_stats(vm.gc).objects_freed;
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - freed_before == 100, "gc_collect_unreachable");
+    
+    // Everything on the chain survived
+    int length = 0;
+    for (Object* obj = head; obj; length++) {
+        TaggedValue* next = object_get_property(obj, "next");
+        obj = next && IS_OBJECT(*next) ? AS_OBJECT(*next) : NULL;
+    }
+    TEST_ASSERT(suite, length == 101, "gc_collect_unreachable");
+    
+    undefine_global(&vm, "head");
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - freed_before == 201, "gc_collect_unreachable");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_minor_collection) {
+    VM vm;
+    vm_init(&vm);
+    
+    Object* holder = object_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    TEST_ASSERT(suite, GC_HEADER(holder)->generation == GC_YOUNG, "gc_minor_collection");
+    
+    // Surviving a minor collection promotes it
+    gc_collect_minor(vm.gc);
+    TEST_ASSERT(suite, GC_HEADER(holder)->generation == GC_OLD, "gc_minor_collection");
+    
+    // The only reference to the young child lives in an old object, so the
+    // next minor collection has to find it through the remembered set
+    Object* child = object_create();
+    object_set_property(holder, "child", OBJECT_VAL(child));
+    TEST_ASSERT(suite, GC_HEADER(holder)->remembered, "gc_minor_collection");
+    for (int i = 0; i < 10; i++) {
+        object_create();
+    }
+    
+    GCStats before = gc_get_stats(vm.gc);
+    gc_collect_minor(vm.gc);
+    GCStats after = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, after.objects_freed - before.objects_freed == 10, "gc_minor_collection");
+    TEST_ASSERT(suite, after.objects_promoted - before.objects_promoted == 1, "gc_minor_collection");
+    TEST_ASSERT(suite, after.collections == before.collections, "gc_minor_collection");
+    TEST_ASSERT(suite, GC_HEADER(child)->generation == GC_OLD, "gc_minor_collection");
+    TEST_ASSERT(suite, !GC_HEADER(holder)->remembered, "gc_minor_collection");
+    
+    TaggedValue* value = object_get_property(holder, "child");
+    TEST_ASSERT(suite, value && IS_OBJECT(*value) && AS_OBJECT(*value) == child, "gc_minor_collection");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_incremental_marking) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_incremental(vm.gc, true);
+    
+    // With no pause budget every step stops at the first clock check
+    gc_set_max_pause(vm.gc, 0);
+    
+    size_t freed_before = gc_get_stats(vm.gc).objects_freed;
+    Object* head = object_create();
+    define_global(&vm, "head", OBJECT_VAL(head));
+    Object* tail = head;
+    for (int i = 0; i < 2000; i++) {
+        Object* next = object_create();
+        object_set_property(tail, "next", OBJECT_VAL(next));
+        tail = next;
+        if (i % 4 == 0) {
+            object_create();
+        }
+    }
+    
+    // Only a C local refers to it until it is stored into the traced head
+    Object* late = object_create();
+    
+    gc_incremental_step(vm.gc);
+    while (vm.gc->phase == GC_PHASE_MARK && GC_HEADER(head)->color != GC_BLACK) {
+        gc_incremental_step(vm.gc);
+    }
+    TEST_ASSERT(suite, vm.gc->phase == GC_PHASE_MARK, "gc_incremental_marking");
+    TEST_ASSERT(suite, GC_HEADER(late)->color == GC_WHITE, "gc_incremental_marking");
+    
+    object_set_property(head, "late", OBJECT_VAL(late));
+    TEST_ASSERT(suite, GC_HEADER(late)->color == GC_GRAY, "gc_incremental_marking");
+    
+    while (!gc_incremental_step(vm.gc)) {}
+    GCStats stats = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, vm.gc->phase == GC_PHASE_NONE, "gc_incremental_marking");
+    TEST_ASSERT(suite, stats.objects_freed - freed_before == 500, "gc_incremental_marking");
+    TEST_ASSERT(suite, stats.incremental_steps > 1, "gc_incremental_marking");
+    
+    TaggedValue* value = object_get_property(head, "late");
+    TEST_ASSERT(suite, value && IS_OBJECT(*value) && AS_OBJECT(*value) == late, "gc_incremental_marking");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_parallel_marking) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_mark_threads(vm.gc, 4);
+    TEST_ASSERT(suite, vm.gc->config.mark_threads == 4, "gc_parallel_marking");
+    
+    // Rows of objects sharing one child, with garbage in between, so the
+    // markers have plenty to steal and race on
+    size_t freed_before = gc_get_stats(vm.gc).objects_freed;
+    Object* shared = object_create();
+    Object* root = array_create();
+    define_global(&vm, "root", OBJECT_VAL(root));
+    for (int i = 0; i < 50; i++) {
+        Object* row = array_create();
+        array_push(root, OBJECT_VAL(row));
+        for (int j = 0; j < 100; j++) {
+            Object* obj = object_create();
+            object_set_property(obj, "shared", OBJECT_VAL(shared));
+            array_push(row, OBJECT_VAL(obj));
+            object_create();
+        }
+    }
+    
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - freed_before == 5000, "gc_parallel_marking");
+    TEST_ASSERT(suite, GC_HEADER(shared)->color == GC_WHITE, "gc_parallel_marking");
+    
+    Object* row = AS_OBJECT(array_get(root, 49));
+    Object* last = AS_OBJECT(array_get(row, 99));
+    TaggedValue* value = object_get_property(last, "shared");
+    TEST_ASSERT(suite, value && IS_OBJECT(*value) && AS_OBJECT(*value) == shared, "gc_parallel_marking");
+    
+    undefine_global(&vm, "root");
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - freed_before == 10052, "gc_parallel_marking");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_lazy_sweep) {
+    VM vm;
+    vm_init(&vm);
+    
+    // Old-generation garbage: promoted while reachable, then dropped
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    for (int i = 0; i < 1000; i++) {
+        array_push(holder, OBJECT_VAL(object_create()));
+    }
+    gc_collect_minor(vm.gc);
+    undefine_global(&vm, "holder");
+    
+    // A collection triggered by allocation returns before sweeping it
+    GCStats before = gc_get_stats(vm.gc);
+    gc_set_threshold(vm.gc, 0);
+    object_create();
+    TEST_ASSERT(suite, vm.gc->phase == GC_PHASE_SWEEP, "gc_lazy_sweep");
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).collections == before.collections + 1, "gc_lazy_sweep");
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - before.objects_freed < 1001, "gc_lazy_sweep");
+    
+    // Later allocations finish it
+    int allocations = 0;
+    while (vm.gc->phase == GC_PHASE_SWEEP) {
+        object_create();
+        allocations++;
+    }
+    GCStats after = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, allocations > 1, "gc_lazy_sweep");
+    TEST_ASSERT(suite, after.objects_freed - before.objects_freed == 1001, "gc_lazy_sweep");
+    TEST_ASSERT(suite, after.lazy_sweep_steps - before.lazy_sweep_steps == (size_t)allocations, "gc_lazy_sweep");
+    TEST_ASSERT(suite, after.objects_swept > before.objects_swept, "gc_lazy_sweep");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_explicit_roots) {
+    VM vm;
+    vm_init(&vm);
+    gc_collect(vm.gc);
+    
+    // Held only by C: a registered variable and a temporary root
+    TaggedValue held = OBJECT_VAL(object_create());
+    gc_add_root(vm.gc, &held);
+    Object* temp = object_create();
+    gc_push_temp_root(vm.gc, OBJECT_VAL(temp));
+    
+    size_t freed_before = gc_get_stats(vm.gc).objects_freed;
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed == freed_before, "gc_explicit_roots");
+    TEST_ASSERT(suite, GC_HEADER(temp)->generation == GC_OLD, "gc_explicit_roots");
+    
+    // A registered root is read at every collection, not when it is added
+    held = OBJECT_VAL(object_create());
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed == freed_before + 1, "gc_explicit_roots");
+    
+    gc_pop_temp_root(vm.gc);
+    gc_remove_root(vm.gc, &held);
+    TEST_ASSERT(suite, vm.gc->root_count == 0 && vm.gc->temp_root_count == 0, "gc_explicit_roots");
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed == freed_before + 3, "gc_explicit_roots");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_block_recycling) {
+    VM vm;
+    vm_init(&vm);
+    
+    // Old objects spread over many blocks, three in four of which then die
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    for (int i = 0; i < 20000; i++) {
+        Object* object = object_create();
+        object_set_property(object, "i", NUMBER_VAL(i));
+        array_push(holder, OBJECT_VAL(object));
+    }
+    gc_collect_minor(vm.gc);
+    
+    Object* kept = array_create();
+    define_global(&vm, "kept", OBJECT_VAL(kept));
+    for (size_t i = 0; i < array_length(holder); i += 4) {
+        array_push(kept, array_get(holder, i));
+    }
+    undefine_global(&vm, "holder");
+    gc_collect(vm.gc);
+    
+    GCStats stats = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, stats.blocks_recycled > 0, "gc_block_recycling");
+    TEST_ASSERT(suite, vm.gc->recycle_blocks != NULL, "gc_block_recycling");
+    
+    // New objects fill the holes instead of taking new blocks
+    size_t blocks = vm.gc->block_count;
+    double fragmentation = gc_fragmentation(vm.gc);
+    for (int i = 0; i < 1000; i++) {
+        array_push(kept, OBJECT_VAL(object_create()));
+    }
+    TEST_ASSERT(suite, vm.gc->block_count == blocks, "gc_block_recycling");
+    TEST_ASSERT(suite, gc_fragmentation(vm.gc) < fragmentation, "gc_block_recycling");
+    
+    // ... and leave the survivors around them intact
+    for (size_t i = 0; i < 5000; i++) {
+        TaggedValue* value = object_get_property(AS_OBJECT(array_get(kept, i)), "i");
+        TEST_ASSERT(suite, value && IS_NUMBER(*value) && AS_NUMBER(*value) == (double)(i * 4),
+                    "gc_block_recycling");
+    }
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_adopt) {
+    VM vm;
+    vm_init(&vm);
+    Object* holder = object_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    
+    // A module's VM, with an export stored where the importer sees it and
+    // some garbage
+    VM module_vm;
+    vm_init(&module_vm);
+    Object* exported = object_create();
+    object_set_property(exported, "answer", NUMBER_VAL(42));
+    object_set_property(holder, "exported", OBJECT_VAL(exported));
+    for (int i = 0; i < 100; i++) {
+        object_create();
+    }
+    size_t count = vm.gc->object_count + module_vm.gc->object_count;
+    
+    vm_free_into(&module_vm, &vm);
+    object_set_current_vm(&vm);
+    TEST_ASSERT(suite, GC_HEADER(exported)->owner == vm.gc, "gc_adopt");
+    TEST_ASSERT(suite, GC_HEADER(exported)->generation == GC_OLD, "gc_adopt");
+    TEST_ASSERT(suite, vm.gc->object_count == count, "gc_adopt");
+    
+    // The importer collects the garbage and keeps the export
+    size_t freed_before = gc_get_stats(vm.gc).objects_freed;
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, gc_get_stats(vm.gc).objects_freed - freed_before >= 100, "gc_adopt");
+    TaggedValue* value = object_get_property(exported, "answer");
+    TEST_ASSERT(suite, value && IS_NUMBER(*value) && AS_NUMBER(*value) == 42, "gc_adopt");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_nursery_adaptation) {
+    VM vm;
+    vm_init(&vm);
+    gc_set_target_pause(vm.gc, 1000000);
+    size_t base = vm.gc->config.nursery_size;
+    
+    // Everything survives: the nursery doubles, and once that turns out not
+    // to change anything, goes back and stays put
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 200; i++) {
+            array_push(holder, OBJECT_VAL(object_create()));
+        }
+        gc_collect_minor(vm.gc);
+        TEST_ASSERT(suite, vm.gc->config.nursery_size == (round == 0 ? base * 2 : base),
+                    "gc_nursery_adaptation");
+    }
+    TEST_ASSERT(suite, vm.gc->nursery_settled, "gc_nursery_adaptation");
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, !vm.gc->nursery_settled, "gc_nursery_adaptation");
+    
+    // A minor collection over the goal shrinks it
+    gc_set_target_pause(vm.gc, 1);
+    for (int i = 0; i < 2000; i++) {
+        object_create();
+    }
+    gc_collect_minor(vm.gc);
+    TEST_ASSERT(suite, vm.gc->config.nursery_size < base, "gc_nursery_adaptation");
+    
+    // ... and a full one switches to incremental marking in steps within it
+    gc_set_threshold(vm.gc, 1);
+    size_t collections = gc_get_stats(vm.gc).collections;
+    while (gc_get_stats(vm.gc).collections == collections) {
+        array_push(holder, OBJECT_VAL(object_create()));
+    }
+    TEST_ASSERT(suite, vm.gc->config.incremental && vm.gc->config.max_pause_us == 1,
+                "gc_nursery_adaptation");
+    
+    vm_free(&vm);
+}
+
+DEFINE_TEST(gc_heap_limit) {
+    VM vm;
+    vm_init(&vm);
+    size_t limit = 256 * 1024;
+    gc_set_max_heap(vm.gc, limit);
+    TEST_ASSERT(suite, vm.gc->config.nursery_size <= limit / 4, "gc_heap_limit");
+    TEST_ASSERT(suite, vm.gc->next_gc_threshold < limit, "gc_heap_limit");
+    
+    // Garbage never takes the heap over the limit
+    for (int i = 0; i < 20000; i++) {
+        object_create();
+        TEST_ASSERT(suite, vm.gc->bytes_allocated <= limit, "gc_heap_limit");
+    }
+    TEST_ASSERT(suite, !vm.gc->heap_exhausted, "gc_heap_limit");
+    
+    // Live objects do, after an emergency collection fails to make room
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    while (!vm.gc->heap_exhausted) {
+        array_push(holder, OBJECT_VAL(object_create()));
+    }
+    GCStats stats = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, stats.emergency_collections > 0, "gc_heap_limit");
+    TEST_ASSERT(suite, stats.heap_limit_exceeded == 1, "gc_heap_limit");
+    
+    // Until they die
+    undefine_global(&vm, "holder");
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, !vm.gc->heap_exhausted && vm.gc->bytes_allocated <= limit, "gc_heap_limit");
+    
+    vm_free(&vm);
+}
+
+typedef struct {
+    GCEvent events[16];
+    size_t count;
+} EventLog;
+
+static void log_gc_event(const GCEvent* event, void* user_data) {
+    EventLog* log = user_data;
+    if (log->count < 16) {
+        log->events[log->count] = *event;
+    }
+    log->count++;
+}
+
+DEFINE_TEST(gc_telemetry) {
+    // Percentiles are read off bucket bounds, exact for short pauses
+    GCPauseHistogram histogram = {0};
+    histogram.counts[3] = 98;
+    histogram.counts[10] = 2;
+    histogram.count = 100;
+    histogram.max_us = 10;
+    TEST_ASSERT(suite, gc_pause_percentile(&histogram, 50.0) == 3, "gc_telemetry");
+    TEST_ASSERT(suite, gc_pause_percentile(&histogram, 98.0) == 3, "gc_telemetry");
+    TEST_ASSERT(suite, gc_pause_percentile(&histogram, 99.0) == 10, "gc_telemetry");
+    
+    VM vm;
+    vm_init(&vm);
+    EventLog log = {0};
+    gc_set_event_callback(vm.gc, log_gc_event, &log);
+    
+    Object* holder = array_create();
+    define_global(&vm, "holder", OBJECT_VAL(holder));
+    for (int i = 0; i < 100; i++) {
+        array_push(holder, OBJECT_VAL(object_create()));
+        object_create();
+    }
+    gc_collect_minor(vm.gc);
+    TEST_ASSERT(suite, log.count == 1 && log.events[0].kind == GC_EVENT_MINOR, "gc_telemetry");
+    TEST_ASSERT(suite, log.events[0].objects_freed == 100, "gc_telemetry");
+    TEST_ASSERT(suite, log.events[0].bytes_promoted == log.events[0].heap_after, "gc_telemetry");
+    TEST_ASSERT(suite, log.events[0].heap_before - log.events[0].heap_after == log.events[0].bytes_freed,
+                "gc_telemetry");
+    
+    // A full cycle is one event however many pauses it takes
+    undefine_global(&vm, "holder");
+    gc_set_incremental(vm.gc, true);
+    while (!gc_incremental_step(vm.gc)) {}
+    TEST_ASSERT(suite, log.count == 2 && log.events[1].kind == GC_EVENT_INCREMENTAL, "gc_telemetry");
+    TEST_ASSERT(suite, log.events[1].objects_freed >= 101, "gc_telemetry");
+    TEST_ASSERT(suite, log.events[1].pauses >= 1 && log.events[1].pause_us <= log.events[1].duration_us,
+                "gc_telemetry");
+    
+    gc_set_incremental(vm.gc, false);
+    gc_collect(vm.gc);
+    TEST_ASSERT(suite, log.count == 3 && log.events[2].kind == GC_EVENT_FULL && log.events[2].pauses == 1,
+                "gc_telemetry");
+    
+    GCStats stats = gc_get_stats(vm.gc);
+    TEST_ASSERT(suite, stats.minor_pauses.count == 1, "gc_telemetry");
+    TEST_ASSERT(suite, stats.full_pauses.count == log.events[1].pauses + 1, "gc_telemetry");
+    TEST_ASSERT(suite, gc_pause_percentile(&stats.full_pauses, 99.0) <= stats.full_pauses.max_us,
+                "gc_telemetry");
+    
+    gc_set_event_callback(vm.gc, NULL, NULL);
+    vm_free(&vm);
+}
+
+// Node an edge named `name` leads to from `from`, or UINT32_MAX
+static uint32_t snapshot_child(const HeapSnapshot* snapshot, uint32_t from, const char* name) {
+    for (size_t i = 0; i < snapshot->edge_count; i++) {
+        const SnapshotEdge* edge = &snapshot->edges[i];
+        if (edge->from == from && edge->kind == SNAPSHOT_EDGE_NAMED &&
+            strcmp(snapshot->strings[edge->label], name) == 0) {
+            return edge->to;
+        }
+    }
+    return UINT32_MAX;
+}
+
+DEFINE_TEST(heap_snapshot) {
+    VM vm;
+    vm_init(&vm);
+    
+    // a = [x, y], b = {y, z}: y is shared, so only the roots dominate it
+    Object* a = array_create();
+    Object* b = object_create();
+    Object* y = object_create();
+    define_global(&vm, "a", OBJECT_VAL(a));
+    define_global(&vm, "b", OBJECT_VAL(b));
+    array_push(a, OBJECT_VAL(object_create()));
+    array_push(a, OBJECT_VAL(y));
+    object_set_property(b, "y", OBJECT_VAL(y));
+    object_set_property(b, "z", OBJECT_VAL(object_create()));
+    object_set_property(b, "self", OBJECT_VAL(b));
+    object_create();  // Garbage is not in the snapshot
+    
+    HeapSnapshot* snapshot = heap_snapshot_take(vm.gc);
+    TEST_ASSERT(suite, snapshot != NULL, "heap_snapshot");
+    uint32_t globals = snapshot_child(snapshot, 0, "globals");
+    uint32_t na = snapshot_child(snapshot, globals, "a");
+    uint32_t nb = snapshot_child(snapshot, globals, "b");
+    uint32_t ny = snapshot_child(snapshot, nb, "y");
+    uint32_t nz = snapshot_child(snapshot, nb, "z");
+    TEST_ASSERT(suite, na != UINT32_MAX && nb != UINT32_MAX && ny != UINT32_MAX && nz != UINT32_MAX,
+                "heap_snapshot");
+    TEST_ASSERT(suite, snapshot->nodes[na].kind == SNAPSHOT_ARRAY, "heap_snapshot");
+    TEST_ASSERT(suite, snapshot_child(snapshot, nb, "self") == nb, "heap_snapshot");
+    
+    HeapDominators* dominators = heap_snapshot_dominators(snapshot);
+    TEST_ASSERT(suite, dominators->idom[ny] == globals && dominators->idom[nz] == nb, "heap_snapshot");
+    TEST_ASSERT(suite, dominators->retained[nb] ==
+                snapshot->nodes[nb].self_size + snapshot->nodes[nz].self_size, "heap_snapshot");
+    TEST_ASSERT(suite, dominators->retained[na] + dominators->retained[nb] + snapshot->nodes[ny].self_size ==
+                dominators->retained[globals], "heap_snapshot");
+    uint64_t total = 0;
+    for (size_t i = 0; i < snapshot->node_count; i++) total += snapshot->nodes[i].self_size;
+    TEST_ASSERT(suite, dominators->retained[0] == total, "heap_snapshot");
+    
+    // The file holds the same graph
+    const char* path = "test_heap_snapshot.bin";
+    TEST_ASSERT(suite, heap_snapshot_write(snapshot, path), "heap_snapshot");
+    HeapSnapshot* loaded = heap_snapshot_read(path);
+    TEST_ASSERT(suite, loaded != NULL, "heap_snapshot");
+    TEST_ASSERT(suite, loaded->node_count == snapshot->node_count &&
+                loaded->edge_count == snapshot->edge_count &&
+                loaded->heap_bytes == snapshot->heap_bytes, "heap_snapshot");
+    const SnapshotEdge* last = &loaded->edges[loaded->edge_count - 1];
+    const SnapshotEdge* expected = &snapshot->edges[snapshot->edge_count - 1];
+    TEST_ASSERT(suite, last->from == expected->from && last->to == expected->to &&
+                last->kind == expected->kind && last->label == expected->label &&
+                loaded->nodes[nz].self_size == snapshot->nodes[nz].self_size &&
+                strcmp(loaded->strings[loaded->nodes[globals].name], "globals") == 0, "heap_snapshot");
+    
+    // A truncated file is rejected rather than half read
+    char bytes[65536];
+    FILE* file = fopen(path, "rb");
+    size_t size = fread(bytes, 1, sizeof(bytes), file);
+    fclose(file);
+    file = fopen(path, "wb");
+    fwrite(bytes, 1, size - 1, file);
+    fclose(file);
+    TEST_ASSERT(suite, size < sizeof(bytes) && heap_snapshot_read(path) == NULL, "heap_snapshot");
+    remove(path);
+    
+    heap_snapshot_free(loaded);
+    heap_dominators_free(dominators);
+    heap_snapshot_free(snapshot);
+    vm_free(&vm);
+}
+
 TEST_SUITE(vm_unit)
     TEST_CASE(stack_operations, "Stack Operations")
     TEST_CASE(arithmetic_operations, "Arithmetic Operations")
@@ -140,6 +719,19 @@ TEST_SUITE(vm_unit)
     TEST_CASE(logical_operations, "Logical Operations")
     TEST_CASE(nil_operations, "Nil Operations")
     TEST_CASE(string_operations, "String Operations")
+    TEST_CASE(value_representation, "Value Representation")
+    TEST_CASE(gc_collect_unreachable, "GC Collects Unreachable Objects")
+    TEST_CASE(gc_minor_collection, "GC Minor Collection")
+    TEST_CASE(gc_incremental_marking, "GC Incremental Marking")
+    TEST_CASE(gc_parallel_marking, "GC Parallel Marking")
+    TEST_CASE(gc_lazy_sweep, "GC Lazy Sweep")
+    TEST_CASE(gc_explicit_roots, "GC Explicit Roots")
+    TEST_CASE(gc_block_recycling, "GC Block Recycling")
+    TEST_CASE(gc_adopt, "GC Adopt")
+    TEST_CASE(gc_nursery_adaptation, "GC Nursery Adaptation")
+    TEST_CASE(gc_heap_limit, "GC Heap Limit")
+    TEST_CASE(gc_telemetry, "GC Telemetry")
+    TEST_CASE(heap_snapshot, "Heap Snapshot")
 END_TEST_SUITE(vm_unit)
 
 // Optional standalone runner